@@ -17,28 +17,52 @@
 #ifndef __OPEN_VIDEO_INTELLIGENCE_ACCUMULATOR_H__
 #define __OPEN_VIDEO_INTELLIGENCE_ACCUMULATOR_H__
 
-#include "IPluginProcess.h"
+#include "DetectionStore.h"
 #include "IPluginRender.h"
+#include "RunStore.h"
 
 namespace ovi {
 
-using DetectedData = std::map<std::string, Details>;
+class StreamingDataAnalyzer;
 
-struct RawData {
-	double frameNumber {};
-	bool include {};
-	DetectedData detected;
+struct AccumulatedData {
+	RunStore runs;
+	DetectionStore detections;
+
+	size_t frames() const;
 };
 
 class Accumulator
 {
 public:
-	void append(double frameNumber, bool include, const DetectedData& detected = {});
+	/* spills the detections as configured in the core category */
+	Accumulator();
+	Accumulator(size_t memoryBudget, const std::string& spillDir);
+
+	void append(double frameNumber, bool include, const DetectedData& detected = {}) {
+		append(frameNumber, 1, include, detected);
+	}
+	void append(double firstFrame, size_t frames, bool include, const DetectedData& detected = {});
+	/* rewrites the include flags of the frames after the restored ones,
+	 * which detaches the streaming analyzer */
 	void update(const Details& detected);
-	const std::vector<RawData>& accumulated();
+	const AccumulatedData& accumulated();
+
+	/* the first run changed since the previous call */
+	size_t takeChangedRun();
+	/* replaces the runs from 'fromRun' and adds the detections, as saved by a checkpoint */
+	void restore(size_t fromRun, const std::vector<FrameRun>& runs, const std::vector<DetectedData>& detections);
+
+	/* feeds the accumulated and the appended frames to the analyzer until finish() */
+	void setStreamingAnalyzer(std::shared_ptr<StreamingDataAnalyzer> analyzer);
+	void finish();
 
 private:
-	std::vector<RawData> _rawdata;
+	AccumulatedData _data;
+	std::string _spillDir;	// of the runs, empty to keep them in memory
+	size_t _changedRun {};
+	size_t _resumedFrames {};	// restored from a checkpoint, before the frames analyzed now
+	std::shared_ptr<StreamingDataAnalyzer> _analyzer;
 };
 
 }
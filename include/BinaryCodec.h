@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_BINARY_CODEC_H__
+#define __OPEN_VIDEO_INTELLIGENCE_BINARY_CODEC_H__
+
+#include <string.h>
+#include <string>
+
+#include "DetectionStore.h"
+#include "Exception.h"
+
+namespace ovi {
+
+/* tags of the detail variant in the serialized form */
+enum BinaryDetailType : uint8_t {
+	BINARY_DETAIL_RECT,
+	BINARY_DETAIL_RECT_TAG,
+	BINARY_DETAIL_DOUBLE,
+	BINARY_DETAIL_BOOL,
+};
+
+/* FNV-1a of a serialized record, to tell a torn or corrupted one */
+inline uint32_t checksum(const char* data, size_t size)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= static_cast<uint8_t>(data[i]);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/* serializes into a buffer in the host byte order */
+class BinaryWriter {
+public:
+	template<typename T>
+	void put(const T& value) {
+		_buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	void put(const std::string& value) {
+		put(static_cast<uint32_t>(value.size()));
+		_buffer.append(value);
+	}
+
+	void put(const Details& details) {
+		put(static_cast<uint32_t>(details.size()));
+		for (const auto& item : details)
+			std::visit(*this, item);
+	}
+
+	void put(const DetectedData& detected) {
+		put(static_cast<uint32_t>(detected.size()));
+		for (const auto& [ id, details ] : detected) {
+			put(static_cast<int32_t>(id));
+			put(details);
+		}
+	}
+
+	void operator()(const OVIRect& rect) {
+		put(BINARY_DETAIL_RECT);
+		putRect(rect);
+	}
+
+	void operator()(const OVIRectTag& rectTag) {
+		put(BINARY_DETAIL_RECT_TAG);
+		putRect(rectTag);
+		put(rectTag.tag);
+	}
+
+	void operator()(const double& value) {
+		put(BINARY_DETAIL_DOUBLE);
+		put(value);
+	}
+
+	void operator()(const bool& value) {
+		put(BINARY_DETAIL_BOOL);
+		put(static_cast<uint8_t>(value));
+	}
+
+	std::string& buffer() { return _buffer; }
+
+private:
+	template<typename Rect>
+	void putRect(const Rect& rect) {
+		put(rect.x);
+		put(rect.y);
+		put(rect.width);
+		put(rect.height);
+	}
+
+	std::string _buffer;
+};
+
+/* reads what BinaryWriter wrote, throws at the end of the buffer */
+class BinaryReader {
+public:
+	explicit BinaryReader(const std::string& buffer)
+		: _pos(buffer.data()), _end(buffer.data() + buffer.size()) {}
+
+	template<typename T>
+	T get() {
+		T value;
+		need(sizeof(T));
+		memcpy(&value, _pos, sizeof(T));
+		_pos += sizeof(T);
+		return value;
+	}
+
+	std::string getString() {
+		auto len = get<uint32_t>();
+		need(len);
+		std::string value(_pos, len);
+		_pos += len;
+		return value;
+	}
+
+	Details getDetails() {
+		Details details(get<uint32_t>());
+		for (auto& item : details)
+			item = getDetail();
+
+		return details;
+	}
+
+	DetectedData getDetected() {
+		DetectedData detected(get<uint32_t>());
+		for (auto& [ id, details ] : detected) {
+			id = static_cast<PluginId>(get<int32_t>());
+			details = getDetails();
+		}
+
+		return detected;
+	}
+
+private:
+	void need(size_t size) {
+		if (static_cast<size_t>(_end - _pos) < size)
+			throw Exception(OVI_ERROR_INVALID_OPERATION, "truncated record");
+	}
+
+	template<typename Rect>
+	Rect getRect() {
+		Rect rect;
+		rect.x = get<double>();
+		rect.y = get<double>();
+		rect.width = get<double>();
+		rect.height = get<double>();
+		return rect;
+	}
+
+	Details::value_type getDetail() {
+		auto type = get<uint8_t>();
+		switch (type) {
+		case BINARY_DETAIL_RECT:
+			return getRect<OVIRect>();
+		case BINARY_DETAIL_RECT_TAG: {
+			auto rectTag = getRect<OVIRectTag>();
+			rectTag.tag = getString();
+			return rectTag;
+		}
+		case BINARY_DETAIL_DOUBLE:
+			return get<double>();
+		case BINARY_DETAIL_BOOL:
+			return get<uint8_t>() != 0;
+		default:
+			throw Exception(OVI_ERROR_INVALID_OPERATION, "unknown detail type: " + std::to_string(type));
+		}
+	}
+
+	const char* _pos;
+	const char* _end;
+};
+
+}
+
+#endif // __OPEN_VIDEO_INTELLIGENCE_BINARY_CODEC_H__
@@ -96,6 +96,18 @@ private:
 	ovi_state_changed_cb _callback {};
 };
 
+class RenderCallback : public AbstractCallback
+{
+public:
+	RenderCallback(void* handle, ovi_render_cb cb, void* userData);
+	virtual ~RenderCallback() = default;
+
+	void invoke(VariantData data1, VariantData data2) override;
+
+private:
+	ovi_render_cb _callback {};
+};
+
 } // ovi
 
 #ifdef __cplusplus
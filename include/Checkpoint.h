@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_CHECKPOINT_H__
+#define __OPEN_VIDEO_INTELLIGENCE_CHECKPOINT_H__
+
+#include <string>
+
+#include "Accumulator.h"
+
+namespace ovi {
+
+//{ last analyzed frame number and pts of each stream, -1 when there is none }
+struct CheckpointPosition {
+	int videoFrame { -1 };
+	double videoPts { -1.0 };
+	int audioFrame { -1 };
+	double audioPts { -1.0 };
+};
+
+/* Journal of the analysis progress in a sidecar file.
+ * Each save appends the runs changed and the detections added since the
+ * previous one, with the position. A torn record at the end is ignored,
+ * and the journal is only used by an analysis with the same fingerprint. */
+class Checkpoint
+{
+public:
+	Checkpoint(const std::string& path, const std::string& fingerprint);
+	~Checkpoint();
+
+	/* replays the journal into an empty accumulator, false if there is nothing to resume */
+	bool restore(Accumulator& accumulator, CheckpointPosition* position);
+	void save(Accumulator& accumulator, const CheckpointPosition& position);
+
+	const std::string& path() const { return _path; }
+
+private:
+	void create();
+
+	std::string _path;
+	std::string _fingerprint;
+	int _fd { -1 };
+	size_t _savedDetections {};
+};
+
+}
+
+#endif // __OPEN_VIDEO_INTELLIGENCE_CHECKPOINT_H__
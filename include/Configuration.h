@@ -27,10 +27,25 @@ namespace ovi {
 
 /* categories */
 const std::string CATEGORY_CORE = "core";
+const std::string CATEGORY_PYTHON = "python";
 
 /* core items */
 const std::string CORE_LOG_LEVEL = "log_level";
 const std::string CORE_LOG_PATH = "log_path";
+const std::string CORE_PLUGIN_REGISTRY_CACHE = "plugin_registry_cache";
+const std::string CORE_PLUGIN_POOL_MAX_IDLE = "plugin_pool_max_idle";
+const std::string CORE_PLUGIN_POOL_IDLE_TIMEOUT = "plugin_pool_idle_timeout";
+const std::string CORE_ACCUMULATOR_BUDGET_MB = "accumulator_budget_mb";
+const std::string CORE_ACCUMULATOR_SPILL_DIR = "accumulator_spill_dir";
+const std::string CORE_CHECKPOINT_INTERVAL = "checkpoint_interval";
+const std::string CORE_RESULT_CACHE_DIR = "result_cache_dir";
+const std::string CORE_TRACK_TOLERANCE = "track_tolerance";
+const std::string CORE_TRACK_GAP = "track_gap";
+const std::string CORE_RENDER_WORKERS = "render_workers";
+
+/* python items */
+const std::string PYTHON_WORKER_PROCESSES = "worker_processes";
+const std::string PYTHON_INTERPRETER = "interpreter";
 
 class Configuration
 {
@@ -56,6 +71,22 @@ public:
 #endif
 	}
 
+	double get(const std::string& category, const std::string& item, double defaultValue)
+	{
+		if (!validateParameters(category, item))
+			return defaultValue;
+
+#ifdef OVI_ENABLE_INIPARSER
+		std::string key = category + ":" + item;
+		double value = iniparser_getdouble(_dict, key.c_str(), defaultValue);
+		log(key, value);
+
+		return value;
+#else
+		return defaultValue;
+#endif
+	}
+
 	std::string get(const std::string& category, const std::string& item, const std::string& defaultValue)
 	{
 		if (!validateParameters(category, item))
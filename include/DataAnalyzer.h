@@ -17,6 +17,9 @@
 #ifndef __OPEN_VIDEO_INTELLIGENCE_DATA_ANALYZER_H__
 #define __OPEN_VIDEO_INTELLIGENCE_DATA_ANALYZER_H__
 
+#include <atomic>
+#include <functional>
+
 #include "Accumulator.h"
 
 namespace ovi {
@@ -27,14 +30,16 @@ struct Detected {
 	Details list;
 };
 
-using SortedCollection = std::map<std::string, std::vector<Detected>>;
+using SortedCollection = std::map<PluginId, std::vector<Detected>>;
 
-//{ Time range(start, duration), { Plugin UID, { frame number, plugin's detected list }}}
+//{ Time range(start, duration), { Plugin ID, { frame number, plugin's detected list }}}
 struct TimeRangeWithMetadata {
 	TimeRange timeRange;
 	SortedCollection collection;
 };
 
+using TimeRangeCallback = std::function<void(TimeRangeWithMetadata&&)>;
+
 class DataAnalyzer
 {
 public:
@@ -43,18 +48,49 @@ public:
 
 	//You can set how much to ignore FALSE between TRUE.
 	void setCorrectionValue(double framerate);
-	void analyzeRawData(const std::vector<RawData>& inputData);
+	void analyzeRawData(const AccumulatedData& inputData);
+	/* passes the time ranges to the callback one by one instead of keeping them in result().
+	 * A range holds only its own detections, read from the store as the runs are scanned. */
+	void analyzeRawData(const AccumulatedData& inputData, const TimeRangeCallback& callback);
 	const std::vector<TimeRangeWithMetadata>& result() const;
 
 private:
-	bool canSkip(const std::vector<RawData>& inputData, size_t i, size_t* skip);
-	SortedCollection sort(const std::vector<RawData>& input);
+	bool canSkip(const AccumulatedData& inputData, size_t run, size_t offset, size_t* skip) const;
 
 	double _frameCount {};
-	std::vector<RawData> _rawdata;
 	std::vector<TimeRangeWithMetadata> _timeRange;
 };
 
+/* Same analysis as DataAnalyzer, fed as the frames are accumulated.
+ * A time range is passed to the callback as soon as it is followed by
+ * the correction value of excluded frames, or by finish(). */
+class StreamingDataAnalyzer
+{
+public:
+	using RangeCallback = TimeRangeCallback;
+
+	StreamingDataAnalyzer(double framerate, RangeCallback callback);
+	~StreamingDataAnalyzer() = default;
+
+	void append(double firstFrame, size_t frames, bool include, const DetectedData& detected);
+	void finish();
+	bool finished() const { return _finished; }
+
+private:
+	void collect(double firstFrame, size_t frames, const DetectedData& detected);
+	void emit();
+
+	size_t _frameCount {};
+	RangeCallback _callback;
+
+	bool _before {};
+	double _start { -1.0 };
+	double _duration { 1.0 };
+	size_t _gap {};	// excluded frames since the last included one
+	SortedCollection _collection;
+	std::atomic<bool> _finished {};
+};
+
 }
 
 #endif // __OPEN_VIDEO_INTELLIGENCE_DATA_ANALYZER_H__
@@ -22,13 +22,16 @@
 #include "Accumulator.h"
 #include "AvSynchronizer.h"
 #include "Callback.h"
+#include "Checkpoint.h"
 #include "FramePack.h"
 #include "OutcomeCache.h"
+#include "ResultCache.h"
 #include "ThreadRunner.h"
 
 #include <string>
 #include <thread>
 #include <atomic>
+#include <chrono>
 
 namespace ovi {
 
@@ -44,13 +47,20 @@ public:
 	~DataFlow();
 
 	void setProgressCallback(void* handle, ovi_progress_cb callback, void* userData);
+	/* 'position' is where the analysis resumed from */
+	void setResultCache(std::shared_ptr<ResultCache> resultCache);
+	void setCheckpoint(std::shared_ptr<Checkpoint> checkpoint, const CheckpointPosition& position,
+					std::chrono::seconds interval);
 
 private:
 	void worker() override;
 	void appendResult(const FramePack* vFrame, std::vector<FramePackPtr>& aFrames, const DetectedData& detected);
 	void updateAllResult(const Details& detected);
-	Outcome processPlugin(const std::string& uid, FramePack* vFrame, std::vector<FramePackPtr>& aFrames);
+	Outcome process(PluginId id, const Plugin& plugin, FramePack* vFrame, std::vector<FramePackPtr>& aFrames);
+	Outcome processPlugin(const Plugin& plugin, FramePack* vFrame, std::vector<FramePackPtr>& aFrames);
 	void invokeProgressCb(std::string progress);
+	void saveCheckpoint(const FramePack* vFrame, const std::vector<FramePackPtr>& aFrames);
+	void saveCheckpoint();
 
 	std::shared_ptr<AvSynchronizer> _avSynchronizer;
 	std::shared_ptr<LogicAnalyzer> _logicAnalyzer;
@@ -63,6 +73,13 @@ private:
 	OutcomeCache _outcomeCache;
 
 	size_t _skipFrames;
+
+	std::shared_ptr<ResultCache> _resultCache;
+	std::shared_ptr<Checkpoint> _checkpoint;
+	std::chrono::seconds _checkpointInterval {};
+	std::chrono::steady_clock::time_point _checkpointTime;
+	CheckpointPosition _position;
+	bool _positionSaved { true };
 };
 
 }
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_DETECTION_STORE_H__
+#define __OPEN_VIDEO_INTELLIGENCE_DETECTION_STORE_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "IPluginProcess.h"
+#include "PluginLoader.h"
+
+namespace ovi {
+
+/* details of the effects of a frame, in the order they are detected */
+using DetectedData = std::vector<std::pair<PluginId, Details>>;
+
+/* Append-only store of detected data, referred to by index.
+ * Over the memory budget, the detections are moved to a temporary file as
+ * columnar blocks (detection, plugin id, detail type, payload) and read
+ * back through a memory mapping. Copies share the same store. */
+class DetectionStore
+{
+public:
+	DetectionStore();
+	/* budget 0 keeps everything in memory */
+	DetectionStore(size_t memoryBudget, const std::string& spillDir);
+
+	int add(const DetectedData& detected);
+	size_t size() const;
+	bool spilled() const;
+	/* of the detections in memory, kept under the budget */
+	size_t residentBytes() const;
+	/* spilled to the file */
+	size_t blocks() const;
+
+	/* random access, decodes the whole block of the detection */
+	DetectedData at(int index) const;
+
+	/* reads detections in increasing index order, keeping one block in memory */
+	class Cursor
+	{
+	public:
+		explicit Cursor(const DetectionStore& store);
+
+		const DetectedData& at(int index);
+
+	private:
+		const DetectionStore& _store;
+		int _blockFirst { -1 };
+		std::vector<DetectedData> _block;
+	};
+
+	Cursor cursor() const { return Cursor(*this); }
+
+private:
+	struct Impl;
+
+	std::shared_ptr<Impl> _impl;
+};
+
+}
+
+#endif // __OPEN_VIDEO_INTELLIGENCE_DETECTION_STORE_H__
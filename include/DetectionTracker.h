@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_DETECTION_TRACKER_H__
+#define __OPEN_VIDEO_INTELLIGENCE_DETECTION_TRACKER_H__
+
+#include <string>
+#include <vector>
+
+#include "IPluginProcess.h"
+
+namespace ovi {
+
+struct TrackKey {
+	double frame {};
+	OVIRect rect;
+};
+
+/* an object from its first to its last frame, the frames between two keys are interpolated */
+struct DetectionTrack {
+	bool tagged {};
+	std::string tag;
+	std::vector<TrackKey> keys;
+};
+
+/* Links the rectangles detected in successive frames into tracks, by overlap.
+ * Only the key frames are kept: the rectangles of the others are within
+ * the tolerance (pixels) of the linear interpolation between the keys. */
+class DetectionTracker
+{
+public:
+	/* a track ends when its object is not detected in more than maxGap successive frames,
+	 * the frames it is not detected in are interpolated like the others */
+	DetectionTracker(double tolerance, double maxGap);
+
+	/* frames in increasing order, the details other than rectangles are ignored */
+	void add(double frame, const Details& details);
+	std::vector<DetectionTrack> tracks();
+
+private:
+	struct Active {
+		DetectionTrack track;
+		TrackKey last;	// of the current segment, not yet a key
+		double low[4];	// slopes from the last key allowed by the frames of the segment
+		double high[4];
+	};
+
+	void add(double frame, const OVIRect& rect, bool tagged, const std::string& tag, std::vector<bool>& matched);
+	void extend(Active& active, const TrackKey& next);
+	void close(Active& active);
+
+	double _tolerance {};
+	double _maxGap {};
+	std::vector<Active> _active;
+	std::vector<DetectionTrack> _finished;
+};
+
+}
+
+#endif // __OPEN_VIDEO_INTELLIGENCE_DETECTION_TRACKER_H__
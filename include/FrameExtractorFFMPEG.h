@@ -38,6 +38,7 @@ public:
 	FramePackPtr frame(double framerate, int64_t duration);
 	AVFrame* decode();
 	size_t frameNum() const;
+	void seek(int frameNum, double pts);
 
 private:
 	AVPacket* readFrame();
@@ -48,8 +49,10 @@ private:
 	AVMediaType _mediaType {};
 	int _streamId {};
 	size_t _frameNum {};
+	int64_t _frameOffset {};	// of the frame numbers after a seek
 	AVRational _time_base {};
 	bool _eof {};
+	AVFrame* _pending {};	// decoded by seek()
 
 	std::unique_ptr<IFramePacker> _packer;
 };
@@ -69,6 +72,9 @@ public:
 	FramePackPtr nextVideo() const override;
 	FramePackPtr nextAudio() const override;
 
+	void seekVideo(int frameNum, double pts) override;
+	void seekAudio(int frameNum, double pts) override;
+
 	MediaInfoPtr mediaInfo() const override;
 
 private:
@@ -30,6 +30,10 @@ public:
 	virtual FramePackPtr nextVideo() const = 0;
 	virtual FramePackPtr nextAudio() const = 0;
 
+	/* continues with the frame after the given one */
+	virtual void seekVideo(int frameNum, double pts) = 0;
+	virtual void seekAudio(int frameNum, double pts) = 0;
+
 	virtual MediaInfoPtr mediaInfo() const = 0;
 };
 
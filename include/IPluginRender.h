@@ -28,6 +28,13 @@ public:
 	virtual void validateEffectAttrs(const std::map<std::string, std::string>& attrs) {};
 	virtual MetaForm effectMetaForm(const std::string& effectName) {return METAFORM_NONE;};
 	virtual void render(timelineRetainer otioTimeline) = 0;
+
+	/* Streaming render: the clips are handed over one by one while the analysis is going on,
+	 * then render() gets the whole timeline to produce the output. discardClips() drops
+	 * the clips handed over so far when the streamed clips turn out to be outdated. */
+	virtual bool streamable() { return false; }
+	virtual void renderClip(clipRetainer clip) {};
+	virtual void discardClips() {};
 };
 
 #endif /* __OPEN_VIDEO_INTELLIGENCE_IPLUGIN_RENDER_H__ */
@@ -22,11 +22,14 @@
 namespace ovi {
 
 #define OVI_EOP "OVI_EOP"  // End of Plugin
+constexpr PluginId OVI_EOP_ID = -1;
 
 class LogicAnalyzer;
 
 bool validate_logic(const std::vector<std::string>& request, const PluginManager* pluginManager);
-bool validate_link(const LogicAnalyzer* logicAnalyzer, const PluginManager* pluginManager, const std::string& renderId);
+/* the effects linked, or only the ones given, against the render */
+bool validate_link(const LogicAnalyzer* logicAnalyzer, const PluginManager* pluginManager, const std::string& renderId,
+				const std::vector<std::string>& effects = {});
 
 class PluginNode;
 class PluginPipeline;
@@ -36,15 +39,17 @@ using PluginPipelinePtr = std::shared_ptr<PluginPipeline>;
 class PluginNode
 {
 public:
-	explicit PluginNode(const std::string& id, bool cut = true);
+	explicit PluginNode(PluginId id, bool cut = true);
 	~PluginNode();
 
 	void reset() { _pos = 0; _include = true; }
 	bool post(bool include);
-	void push(const std::string& plugin) { _plugins.push_back(plugin); }
+	void push(PluginId plugin) { _plugins.push_back(plugin); }
+	const std::vector<PluginId>& plugins() const { return _plugins; }
+	bool cut() const { return _cut; }
 	void dump();
 
-	std::string pop();
+	PluginId pop();
 
 private:
 	// LCOV_EXCL_START
@@ -56,7 +61,7 @@ private:
 	}
 	// LCOV_EXCL_STOP
 
-	std::vector<std::string> _plugins {};
+	std::vector<PluginId> _plugins {};
 	size_t _pos {}; // point to the current plugin
 	bool _include;
 	bool _cut;
@@ -70,10 +75,11 @@ public:
 
 	void reset();
 	void push(PluginNodePtr plugin);
-	std::string pop(bool include);
+	PluginId pop(bool include);
 	PluginNodePtr current() const;
 	void setEssential();
 	bool isEssential() const { return _essential; }
+	const std::vector<PluginNodePtr>& nodes() const { return _pipeline; }
 	void dump() const;
 
 private:
@@ -82,6 +88,16 @@ private:
 	bool _essential {};
 };
 
+/* A plugin to run, and where to go on with its result */
+struct LogicInstruction {
+	PluginId plugin {};
+	bool cut {};
+	bool first {};	// the first plugin of a node, the rest of the node depends on it
+	int next {};	// detected
+	int skip {};	// the first plugin of an uncut node is not detected
+	int fail {};	// a cut plugin is not detected
+};
+
 class LogicAnalyzer
 {
 public:
@@ -89,17 +105,25 @@ public:
 	~LogicAnalyzer();
 
 	void reset();
-	std::string nextPlugin(bool result);
+	PluginId nextPluginId(bool result);
+	const std::string& nextPlugin(bool result);
 	bool include() const { return _include; }
 	const std::vector<std::string>& expression() const { return _expression; }
+	const std::vector<PluginPipelinePtr>& pipelines() const { return _pipelines; }
 
 private:
 	void runAnalysis(std::vector<std::string> expression, const PluginManager* pluginManager);
+	void compile();
 	void dump() const;
 
+	static constexpr int PROGRAM_START = 0;
+	static constexpr int PROGRAM_END = -1;
+
+	const PluginManager* _pluginManager {};
 	std::vector<std::string> _expression {};
 	std::vector<PluginPipelinePtr> _pipelines;
-	size_t _pos {}; // point to the current pipeline
+	std::vector<LogicInstruction> _program;
+	int _pc { PROGRAM_START }; // point to the instruction of the last plugin
 	bool _include {};
 };
 
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_MODEL_CACHE_H__
+#define __OPEN_VIDEO_INTELLIGENCE_MODEL_CACHE_H__
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace ovi {
+
+/* Read-only bytes of a model file, mapped into memory */
+class MappedModel
+{
+public:
+	explicit MappedModel(const std::string& path);
+	~MappedModel();
+	MappedModel(const MappedModel&) = delete;
+	void operator=(const MappedModel&) = delete;
+
+	const void* data() const { return _data; }
+	size_t size() const { return _size; }
+
+private:
+	void* _data {};
+	size_t _size {};
+};
+
+/* Objects built from one loaded model, for models which can not be used concurrently,
+ * e.g. OpenCV classifiers. Each use leases an object, which is built only when all the
+ * others are leased, and the objects are kept for the next uses. */
+template<typename T>
+class ModelPool
+{
+public:
+	using Builder = std::function<std::unique_ptr<T>()>;
+
+	explicit ModelPool(Builder builder) : _builder(std::move(builder)) {}
+	ModelPool(const ModelPool&) = delete;
+	void operator=(const ModelPool&) = delete;
+
+	class Lease
+	{
+	public:
+		Lease(const ModelPool& pool, std::unique_ptr<T> object) : _pool(pool), _object(std::move(object)) {}
+		~Lease() { _pool.release(std::move(_object)); }
+		Lease(const Lease&) = delete;
+		void operator=(const Lease&) = delete;
+
+		T& operator*() const { return *_object; }
+		T* operator->() const { return _object.get(); }
+
+	private:
+		const ModelPool& _pool;
+		std::unique_ptr<T> _object;
+	};
+
+	Lease lease() const {
+		std::lock_guard<std::mutex> locker(_lock);
+
+		if (_idle.empty()) {
+			/* under the lock, the builder reads the shared model */
+			_built++;
+			return Lease(*this, _builder());
+		}
+
+		auto object = std::move(_idle.back());
+		_idle.pop_back();
+		return Lease(*this, std::move(object));
+	}
+
+	size_t built() const {
+		std::lock_guard<std::mutex> locker(_lock);
+		return _built;
+	}
+
+private:
+	void release(std::unique_ptr<T> object) const {
+		std::lock_guard<std::mutex> locker(_lock);
+		_idle.push_back(std::move(object));
+	}
+
+	Builder _builder;
+	mutable std::mutex _lock;
+	mutable std::vector<std::unique_ptr<T>> _idle;
+	mutable size_t _built {};
+};
+
+/* Loads each model once per process and shares it between plugin instances.
+ * A model lives as long as any instance holds its handle.
+ * The model is destroyed by the code of the plugin which loaded it, so a plugin must
+ * release its handles before its library is unloaded, e.g. when its instances are
+ * destroyed, and a key must not be shared by the models of different plugin libraries. */
+class ModelCache
+{
+public:
+	static ModelCache& instance() {
+		/* never destroyed, plugins may release models during static destruction */
+		static ModelCache* _instance = new ModelCache();
+		return *_instance;
+	}
+
+	/* returns the model cached for the key, or the one made by the loader.
+	 * The model must be safe for concurrent use through a const reference. */
+	template<typename T>
+	std::shared_ptr<const T> get(const std::string& key, const std::function<std::shared_ptr<T>()>& loader) {
+		auto handle = acquire(key + "#" + typeid(T).name(), [&loader]() -> std::shared_ptr<const void> {
+			return loader();
+		});
+		return std::static_pointer_cast<const T>(handle);
+	}
+
+	/* returns the model file mapped read-only, e.g. for tflite models */
+	std::shared_ptr<const MappedModel> map(const std::string& path);
+
+	size_t size() const;
+
+private:
+	ModelCache() = default;
+	~ModelCache() = default;
+	ModelCache(ModelCache& other) = delete;
+	void operator=(const ModelCache&) = delete;
+
+	struct Holder;
+
+	std::shared_ptr<const void> acquire(const std::string& key,
+										const std::function<std::shared_ptr<const void>()>& loader);
+	void release(const std::string& key);
+
+	mutable std::mutex _lock;
+	std::map<std::string, std::weak_ptr<Holder>> _models;
+};
+
+}
+
+#endif // __OPEN_VIDEO_INTELLIGENCE_MODEL_CACHE_H__
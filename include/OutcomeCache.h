@@ -17,36 +17,39 @@
 #ifndef __OPEN_VIDEO_INTELLIGENCE_OUTCOMECACHE_H__
 #define __OPEN_VIDEO_INTELLIGENCE_OUTCOMECACHE_H__
 
-#include "IPluginProcess.h"
-#include <map>
-#include <string>
+#include <vector>
 
-namespace ovi {
+#include "Accumulator.h"
 
-using DetectedData = std::map<std::string, Details>;
+namespace ovi {
 
+/* outcomes of the current frame, indexed by plugin id */
 class OutcomeCache
 {
 public:
-	bool hit(const std::string& uid) const;
-	void write(const std::string& uid, const Outcome& outcome);
-	void setDetected(const std::string& uid);
+	bool hit(PluginId id) const;
+	void write(PluginId id, const Outcome& outcome);
+	void setDetected(PluginId id);
 	const DetectedData& detected() const;
 	bool findMultiFrameResult();
 	const Details& getMultiFrameResult();
-	void setResultUid(const std::string& uid);
+	void setResultId(PluginId id);
 	const Outcome& result();
 	void clear();
 
 private:
 	bool empty() const;
-	void log(const std::string& uid, const Outcome& outcome) const;
+	void log(PluginId id, const Outcome& outcome) const;
+
+	static constexpr PluginId NO_RESULT = -1;
 
 	const Outcome _defaultOutcome = { true, {} };
 
-	std::map<std::string, Outcome> _storage;
+	std::vector<Outcome> _storage;
+	std::vector<bool> _written;
+	std::vector<PluginId> _writtenIds;	// in the order of write
 	DetectedData _detected;
-	std::string _resultUid;
+	PluginId _resultId { NO_RESULT };
 };
 
 }
@@ -18,12 +18,16 @@
 #define __OPEN_VIDEO_INTELLIGENCE_PLUGIN_LOADER_H__
 
 #include <memory>
+#include <mutex>
 #include "IPluginProcess.h"
 #include "IPluginEffect.h"
 #include "IPlugin.h"
 
 namespace ovi {
 
+/* dense index of a plugin loaded in a session */
+using PluginId = int;
+
 struct Plugin {
 	PluginType type {};
 	std::vector<int> formats {};
@@ -31,6 +35,9 @@ struct Plugin {
 	IPlugin* plugin {};
 	void* dlHandle {};
 	std::map<std::string, std::string> attrs;
+	std::string name;
+	/* attributes the instance was last configured with */
+	std::map<std::string, std::string> appliedAttrs;
 };
 
 typedef enum {
@@ -47,9 +54,14 @@ struct PluginInfo {
 	std::string description;
 	std::string libraryPath;
 	std::vector<Attribute> attrs;
+	/* file the plugin was found in, not kept in the registry */
+	std::string sourcePath;
 };
 
 class PyManager;
+class PyWorkerPool;
+class PluginRegistryCache;
+class PluginPool;
 
 class PluginLoader
 {
@@ -64,6 +76,7 @@ public:
 
 	Plugin load(const std::string& name);
 	void unload(Plugin pluginObj);
+	void applyAttrs(Plugin& pluginObj);
 
 private:
 	PluginLoader();
@@ -72,17 +85,24 @@ private:
 	void operator=(const PluginLoader&) = delete;
 
 	Plugin create(PluginInfo& info);
+	Plugin create(const std::string& name);
+	void destroy(Plugin& pluginObj);
 	void getSharedPathList(const std::string& pluginDir);
+	static PluginInfo getPluginInfo(const std::string& pluginPath);
 #ifdef OVI_ENABLE_PYTHON
-	void addPluginInfoForPy(const std::string& pluginPath, const std::string& moduleName);
+	PluginInfo getPluginInfoForPy(const std::string& moduleName);
+	std::shared_ptr<PyManager> pyManager();
 #endif /* OVI_ENABLE_PYTHON */
-	void addPluginInfo(const std::string& pluginPath);
 
 	std::vector<std::string> _sharedPathList;
 	std::vector<PluginInfo> _availablePlugins;
+	std::shared_ptr<PluginRegistryCache> _registry;
+	std::shared_ptr<PluginPool> _pluginPool;
 #ifdef OVI_ENABLE_PYTHON
 	bool _pyintf {};
+	std::mutex _pyManagerLock;
 	std::shared_ptr<PyManager> _pyManager;
+	std::shared_ptr<PyWorkerPool> _pyWorkerPool;
 #endif /* OVI_ENABLE_PYTHON */
 };
 
@@ -29,13 +29,18 @@ public:
 
 	const std::string& load(const std::string& name);
 	const Plugin& find(const std::string& uid) const;
+	const Plugin& find(PluginId id) const;
 	bool exist(const std::string& uid) const;
+	PluginId id(const std::string& uid) const;
+	const std::string& uid(PluginId id) const;
+	size_t size() const { return _pluginsById.size(); }
 	void validate(bool hasVideo, bool hasAudio) const;
 
 	void setAllAttrs();
 	void setAttrs(const std::string& uid, const std::map<std::string, std::string>& attrs);
 	const std::string& getAttr(const std::string& uid, const std::string& key) const;
-	void validateAttrs(const std::string& renderUid) const;
+	/* of the effects, or only the ones given, for the render */
+	void validateAttrs(const std::string& renderUid, const std::vector<std::string>& effects = {}) const;
 
 	MetaForm getMetaForm(const std::string& uid, const std::string& effectName) const;
 
@@ -44,6 +49,8 @@ private:
 
 	std::string makeId(const std::string& name);
 	std::map<std::string, Plugin> _loadedPlugins;
+	/* indexed by PluginId, in load order */
+	std::vector<std::map<std::string, Plugin>::iterator> _pluginsById;
 };
 
 } // ovi
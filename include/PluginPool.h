@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_PLUGIN_POOL_H__
+#define __OPEN_VIDEO_INTELLIGENCE_PLUGIN_POOL_H__
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+
+#include "PluginLoader.h"
+
+namespace ovi {
+
+/* Keeps initialized plugin instances which are checked back in by finished
+ * sessions, so that the next session skips the plugin setup cost.
+ * Idle instances are evicted when they exceed the cap or the idle timeout. */
+class PluginPool
+{
+public:
+	using Destroyer = std::function<void(Plugin&)>;
+
+	PluginPool(size_t maxIdle, std::chrono::seconds idleTimeout, Destroyer destroyer);
+	~PluginPool();
+
+	static bool poolable(const Plugin& plugin);
+
+	/* the most recently used idle instance of the plugin, if any */
+	std::optional<Plugin> checkout(const std::string& name);
+	/* swaps the plugin for an idle instance whose applied attributes match its attributes */
+	bool exchange(Plugin& plugin);
+	/* returns false if the pool does not keep the plugin, then it is the caller's to destroy */
+	bool checkin(Plugin&& plugin);
+
+	void clear();
+	size_t idle() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Idle {
+		Plugin plugin;
+		Clock::time_point since;
+	};
+
+	std::list<Idle> evict(Clock::time_point now);
+	void destroy(std::list<Idle>& victims);
+
+	size_t _maxIdle {};
+	std::chrono::seconds _idleTimeout {};
+	Destroyer _destroyer;
+
+	mutable std::mutex _lock;
+	/* ordered by check-in time, the most recent last */
+	std::list<Idle> _idle;
+};
+
+}
+
+#endif // __OPEN_VIDEO_INTELLIGENCE_PLUGIN_POOL_H__
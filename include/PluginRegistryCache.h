@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_PLUGIN_REGISTRY_CACHE_H__
+#define __OPEN_VIDEO_INTELLIGENCE_PLUGIN_REGISTRY_CACHE_H__
+
+#include <map>
+#include <optional>
+#include <string>
+
+#include "PluginLoader.h"
+
+namespace ovi {
+
+/* Persists the metadata of discovered plugins, keyed by the plugin file path.
+ * An entry is only valid while the file keeps the same mtime and size. */
+class PluginRegistryCache
+{
+public:
+	explicit PluginRegistryCache(const std::string& cachePath);
+	~PluginRegistryCache() = default;
+
+	static std::string defaultPath();
+
+	void load();
+	void save();
+
+	/* returns the cached info, or nullopt if the file is unknown or changed.
+	 * Failed discoveries are not cached, they are tried again on the next run. */
+	std::optional<PluginInfo> find(const std::string& pluginPath) const;
+	void update(const std::string& pluginPath, const PluginInfo& info);
+	void retain(const std::vector<std::string>& pluginPaths);
+
+	bool dirty() const { return _dirty; }
+
+private:
+	struct Stamp {
+		int64_t mtime {};
+		uint64_t size {};
+
+		bool operator==(const Stamp& other) const {
+			return mtime == other.mtime && size == other.size;
+		}
+	};
+
+	struct Entry {
+		Stamp stamp;
+		PluginInfo info;
+	};
+
+	static std::optional<Stamp> stamp(const std::string& pluginPath);
+
+	std::string _cachePath;
+	std::map<std::string, Entry> _entries;
+	bool _dirty {};
+};
+
+}
+
+#endif // __OPEN_VIDEO_INTELLIGENCE_PLUGIN_REGISTRY_CACHE_H__
@@ -23,6 +23,7 @@
 #include <atomic>
 #include <queue>
 #include <mutex>
+#include <condition_variable>
 #include <chrono>
 #include <future>
 
@@ -36,6 +37,15 @@ namespace ovi {
 
 using ResponseData = std::variant<PluginInfo, Outcome, bool>;
 
+/* buffer layout of a frame as seen from python (PEP 3118) */
+struct FrameLayout {
+	const char* format;
+	Py_ssize_t itemsize;
+	std::vector<Py_ssize_t> shape;
+};
+
+FrameLayout frameLayout(const FramePack* frame);
+
 class PyManager : public ThreadRunner
 {
 public:
@@ -49,7 +59,14 @@ public:
 	Outcome process(int key, FramePack* frame);
 
 private:
-	PyObject* find(int key);
+	/* the callables are resolved once when the module is created */
+	struct PyModule {
+		PyObject* module {};
+		PyObject* process {};
+		PyObject* setAttrs {};
+	};
+
+	const PyModule& find(int key);
 
 	enum request {
 		PY_INFO,
@@ -75,10 +92,11 @@ private:
 	void pySetAttrs(const QueueData& data);
 	void pyProcess(const QueueData& data);
 
-	std::map<int, PyObject*> _modules;
+	std::map<int, PyModule> _modules;
 
 	std::queue<QueueData> _req {};
 	std::mutex _m {};
+	std::condition_variable _cv {};
 };
 
 }
@@ -25,6 +25,7 @@
 namespace ovi {
 
 class PyManager;
+class PyWorkerPool;
 
 class PyPlugin : public IPluginProcess
 {
@@ -40,6 +41,22 @@ private:
 	std::shared_ptr<PyManager> _pyManager;
 };
 
+/* Runs the module in a worker process of the pool instead of the PyManager thread */
+class PyWorkerPlugin : public IPluginProcess
+{
+public:
+	PyWorkerPlugin(std::shared_ptr<PyWorkerPool> pool, const std::string& moduleName);
+	~PyWorkerPlugin();
+
+	int setAttrs(const std::map<std::string, std::string>& attrs) override;
+	Outcome process(ovi::FramePack* frame) override;
+
+private:
+	std::string _moduleName;
+	std::map<std::string, std::string> _attrs;
+	std::shared_ptr<PyWorkerPool> _pool;
+};
+
 }
 
 #endif /* OVI_ENABLE_PYTHON */
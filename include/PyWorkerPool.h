@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_PY_WORKER_POOL_H__
+#define __OPEN_VIDEO_INTELLIGENCE_PY_WORKER_POOL_H__
+
+#ifdef OVI_ENABLE_PYTHON
+
+#include <sys/types.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <condition_variable>
+#include <string>
+#include <vector>
+
+#include "IPluginProcess.h"
+
+namespace ovi {
+
+/* Hosts one python plugin module in a subprocess (plugins/srcs/OVIWorker.py).
+ * Requests, frames and results share one memfd mapping, and two eventfds
+ * are used as doorbells in each direction. See OVIWorker.py for the layout. */
+class PyWorker
+{
+public:
+	PyWorker(const std::string& interpreter, const std::string& moduleName);
+	~PyWorker();
+
+	/* a worker serves the instances of one attribute set, so it is configured once */
+	int setAttrs(const std::map<std::string, std::string>& attrs);
+	Outcome process(FramePack* frame);
+
+	/* none until the attributes are set successfully */
+	const std::optional<std::map<std::string, std::string>>& attrs() const { return _attrs; }
+
+private:
+	void spawn(const std::string& interpreter);
+	void reserve(size_t payloadSize);
+	void call(uint32_t op);
+	void terminate();
+
+	std::string _moduleName;
+	std::optional<std::map<std::string, std::string>> _attrs;
+
+	pid_t _pid { -1 };
+	int _shmFd { -1 };
+	int _reqFd { -1 };
+	int _respFd { -1 };
+	void* _map {};
+	size_t _mapSize {};
+};
+
+using PyWorkerPtr = std::unique_ptr<PyWorker>;
+
+using PyWorkerAttrs = std::map<std::string, std::string>;
+
+/* Replicas of worker processes per module and attribute set, shared by the plugin
+ * instances of the module with the same attributes. A worker is never configured
+ * again for another set. The workers of a set go away with its last instance. */
+class PyWorkerPool
+{
+public:
+	PyWorkerPool(const std::string& interpreter, size_t replicas);
+	~PyWorkerPool() = default;
+
+	/* an instance uses the workers of its attribute set between attach and detach */
+	void attach(const std::string& moduleName, const PyWorkerAttrs& attrs);
+	void detach(const std::string& moduleName, const PyWorkerAttrs& attrs);
+
+	/* a new worker is not configured yet */
+	PyWorkerPtr acquire(const std::string& moduleName, const PyWorkerAttrs& attrs);
+	void release(const std::string& moduleName, const PyWorkerAttrs& attrs, PyWorkerPtr worker);
+	void discard(const std::string& moduleName, const PyWorkerAttrs& attrs);
+
+	/* started and not discarded */
+	size_t workers();
+
+private:
+	struct Replicas {
+		std::vector<PyWorkerPtr> idle;
+		size_t count {};
+		size_t users {};
+	};
+
+	/* under the lock, the workers to stop are returned to be destroyed without it */
+	std::vector<PyWorkerPtr> drop(const std::string& moduleName, const PyWorkerAttrs& attrs);
+
+	std::string _interpreter;
+	size_t _maxReplicas {};
+
+	std::map<std::string, std::map<PyWorkerAttrs, Replicas>> _replicas;
+	std::mutex _m {};
+	std::condition_variable _cv {};
+};
+
+}
+
+#endif /* OVI_ENABLE_PYTHON */
+
+#endif /* __OPEN_VIDEO_INTELLIGENCE_PY_WORKER_POOL_H__ */
@@ -22,33 +22,112 @@
 #include "Callback.h"
 #include "DataAnalyzer.h"
 
+#include <condition_variable>
+#include <deque>
 #include <string>
 #include <future>
+#include <mutex>
+#include <set>
+#include <vector>
 
 namespace ovi {
 
+struct RenderTarget {
+	std::string uid;	// of the render plugin
+	std::string outputPath;
+	std::vector<std::string> effects;	// the uids of the effect plugins rendered, all if empty
+};
+
+/* Renders the time ranges of one analysis to several targets at the same time.
+ * The clips and their effects are made once, each target gets its own timeline
+ * with its effects. completeCb gets the first error of the targets once they are
+ * all done, targetCb the output path and the error of each target.
+ * A timeline made before, e.g. by OTIORender, is rendered without an analysis.
+ */
 class RenderTask
 {
 public:
 	RenderTask(const std::string& mediaPath,
 			std::shared_ptr<PluginManager> pluginManager,
-			const std::string& renderId,
+			const std::vector<RenderTarget>& targets,
+			MediaType type,
+			int64_t videoFrames,
+			double framerate,
+			const AccumulatedData& accumulated,
+			std::shared_ptr<IInvokable> completeCb,
+			std::shared_ptr<IInvokable> targetCb);
+	/* Streaming render: the clips of the time ranges emitted by analyzer() are rendered
+	 * while the analysis is going on, and finish() produces the output. */
+	RenderTask(const std::string& mediaPath,
+			std::shared_ptr<PluginManager> pluginManager,
+			const std::vector<RenderTarget>& targets,
 			MediaType type,
 			int64_t videoFrames,
 			double framerate,
-			const std::vector<RawData>& accumulated,
 			std::shared_ptr<IInvokable> completeCb,
-			const std::string& outputPath);
+			std::shared_ptr<IInvokable> targetCb);
+	/* Timeline render: the clips and the effects of the timeline are rendered as they are,
+	 * the effects of a target are those named by its effect plugins. */
+	RenderTask(std::shared_ptr<PluginManager> pluginManager,
+			const std::vector<RenderTarget>& targets,
+			timelineRetainer timeline,
+			std::shared_ptr<IInvokable> completeCb,
+			std::shared_ptr<IInvokable> targetCb);
 	~RenderTask();
 
+	std::shared_ptr<StreamingDataAnalyzer> analyzer() const { return _analyzer; }
+	/* falls back to the accumulated data if the streamed ranges are outdated */
+	void finish(const AccumulatedData& accumulated);
+
 private:
-	std::vector<TimeRangeWithMetadata> makeTimeRange(const std::vector<RawData>& accumulated, double framerate) const;
-	std::vector<effectRetainer> makeEffectList(SortedCollection collection);
+	using EffectList = std::vector<std::pair<PluginId, effectRetainer>>;
+
+	struct Output {
+		RenderTarget target;
+		IPluginRender* render {};
+		std::set<PluginId> effects;
+		std::unique_ptr<TimelineHelper> timeline;
+		timelineRetainer loaded;	// rendered instead of the timeline of the clips
+		ovi_error_e error = OVI_ERROR_NONE;
+		bool done {};	// reported to the target callback
+	};
+
+	bool waitRange(TimeRangeWithMetadata* range);
+	bool waitFinish();
+	void makeOutputs(const std::vector<RenderTarget>& targets);
+	void setAttrs();
+	void resetTimelines();
+	void loadTimelines(const timelineRetainer& timeline);
+	void appendClips(const AccumulatedData& accumulated);
+	void appendClip(const TimeRangeWithMetadata& tr, bool streaming);
+	ovi_error_e renderAll();
+	ovi_error_e fail(ovi_error_e error);
+	void report(Output& output, ovi_error_e error);
+	EffectList makeEffectList(const SortedCollection& collection);
 	effectRetainer initializeEffect(const Plugin& plugin);
 	otio::AnyVector fillFrameEffect(Details list);
 
 	std::future<void> _future;
+	std::string _mediaPath;
 	std::shared_ptr<PluginManager> _pluginManager;
+	MediaType _type {};
+	int64_t _videoFrames {};
+	double _framerate {};
+	std::shared_ptr<IInvokable> _completeCb;
+	std::shared_ptr<IInvokable> _targetCb;
+	std::vector<Output> _outputs;
+	std::mutex _reportLock;
+
+	std::shared_ptr<StreamingDataAnalyzer> _analyzer;
+	std::mutex _lock;
+	std::condition_variable _cond;
+	std::deque<TimeRangeWithMetadata> _ranges;
+	AccumulatedData _accumulated;
+	bool _finishing {};
+	bool _aborted {};
+	double _trackTolerance {};
+	int _trackGap {};
+	int _renderWorkers {};
 };
 
 }
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_RESULT_CACHE_H__
+#define __OPEN_VIDEO_INTELLIGENCE_RESULT_CACHE_H__
+
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "IPluginProcess.h"
+#include "PluginLoader.h"
+
+namespace ovi {
+
+/* Outcomes of the detect plugins on disk, one file per media and plugin
+ * configuration, named by the hash of both. A later analysis of the same
+ * media reuses the outcomes of the plugins which are configured the same.
+ *
+ * The records of a file are kept in frame order and are never loaded as a
+ * whole: the frames of a plugin are looked up in increasing order, so the
+ * file is read along with the analysis and merged with the new outcomes into
+ * a new file, which replaces the former one at save(). */
+class ResultCache
+{
+public:
+	//{ first frame number, last frame number } of the frames given to the plugin
+	using FrameKey = std::pair<int, int>;
+
+	ResultCache(const std::string& dir, const std::string& media);
+	~ResultCache();
+
+	/* 'config' identifies the plugin: its name, version, models and attributes */
+	void add(PluginId id, const std::string& config);
+	bool contains(PluginId id) const;
+
+	/* frames before the last ones found or stored of the plugin are not cached */
+	std::optional<Outcome> find(PluginId id, const FrameKey& frames);
+	void store(PluginId id, const FrameKey& frames, const Outcome& outcome);
+	/* stops caching the plugin and drops its outcomes, e.g. of a multi-frame plugin
+	 * whose result covers every frame it has seen */
+	void remove(PluginId id);
+	/* writes the new outcomes, the next lookups start over from the first frames */
+	void save();
+
+private:
+	struct Record {
+		FrameKey frames;
+		std::string raw;
+	};
+
+	struct Results {
+		std::string key;
+		std::string path;
+		bool opened {};
+		std::ifstream in;		// the former outcomes
+		std::streamoff consumed {};	// where 'next' starts in 'in', 0 if 'in' has no valid header
+		std::optional<Record> next;	// the first record of 'in' not passed yet
+		std::string outPath;
+		std::ofstream out;		// 'in' merged with the new outcomes
+		bool failed {};
+		std::optional<FrameKey> last;	// the last frames found or stored
+		size_t found {};
+		size_t added {};
+	};
+
+	void open(Results& results);
+	void readNext(Results& results);
+	void advance(Results& results, const FrameKey& frames);
+	bool beginWrite(Results& results);
+	void save(Results& results);
+	void reset(Results& results);
+
+	std::string _dir;
+	std::string _media;
+	std::vector<std::unique_ptr<Results>> _results;	// by plugin id
+};
+
+}
+
+#endif // __OPEN_VIDEO_INTELLIGENCE_RESULT_CACHE_H__
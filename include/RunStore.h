@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_RUN_STORE_H__
+#define __OPEN_VIDEO_INTELLIGENCE_RUN_STORE_H__
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ovi {
+
+//{ first frame number, consecutive frames, include, index of the detected data shared by the frames }
+struct FrameRun {
+	static constexpr int NO_DETECTION = -1;
+
+	double firstFrame {};
+	size_t frames {};
+	bool include {};
+	int detection { NO_DETECTION };
+};
+
+/* Append-only list of frame runs.
+ * With a spill directory, the full pages of runs are written to a temporary
+ * file and read back through a memory mapping, so only the last page stays
+ * in memory. Copies share the same store. */
+class RunStore
+{
+public:
+	static constexpr size_t PAGE_RUNS = 4096;
+
+	RunStore();
+	/* an empty directory keeps everything in memory */
+	explicit RunStore(const std::string& spillDir);
+
+	size_t size() const;
+	bool empty() const { return size() == 0; }
+	FrameRun operator[](size_t index) const;
+	/* the last run, which is always in memory */
+	FrameRun& back();
+
+	void push_back(const FrameRun& run);
+	/* drops the runs from 'size', which can only shrink the list */
+	void resize(size_t size);
+
+	size_t residentBytes() const;
+	bool spilled() const;
+
+	class const_iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = FrameRun;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const FrameRun*;
+		using reference = FrameRun;
+
+		const_iterator(const RunStore& store, size_t index) : _store(&store), _index(index) {}
+
+		FrameRun operator*() const { return (*_store)[_index]; }
+		const_iterator& operator++() { _index++; return *this; }
+		bool operator==(const const_iterator& other) const { return _index == other._index; }
+		bool operator!=(const const_iterator& other) const { return _index != other._index; }
+
+	private:
+		const RunStore* _store;
+		size_t _index;
+	};
+
+	const_iterator begin() const { return const_iterator(*this, 0); }
+	const_iterator end() const { return const_iterator(*this, size()); }
+
+private:
+	struct Impl;
+
+	std::shared_ptr<Impl> _impl;
+};
+
+}
+
+#endif // __OPEN_VIDEO_INTELLIGENCE_RUN_STORE_H__
@@ -17,6 +17,8 @@
 #ifndef __OPEN_VIDEO_INTELLIGENCE_SESSION_H__
 #define __OPEN_VIDEO_INTELLIGENCE_SESSION_H__
 
+#include <atomic>
+
 #include "DataFlow.h"
 #include "RenderTask.h"
 
@@ -39,6 +41,7 @@ public:
 	ovi_state_e state();
 
 	void setRender(const std::string& name, std::string outputPath);
+	void addRender(const std::string& name, std::string outputPath, const std::vector<std::string>& effects);
 
 	const std::string& appendPlugin(const std::string& name);
 	void setPluginAttrs(const std::string& uid, const std::map<std::string, std::string>& attrs);
@@ -51,13 +54,24 @@ public:
 	void unsetProgressCb();
 	void setStateChangedCb(ovi_state_changed_cb callback, void* userData);
 	void unsetStateChangedCb();
+	void setRenderCb(ovi_render_cb callback, void* userData);
+	void unsetRenderCb();
 	void setSkipVideoFrames(size_t frames);
+	void setStreamingRender(bool enable);
+	void setCheckpoint(const std::string& path);
+	void setTimeline(const std::string& path);
 
 private:
 	void updateState(ovi_state_e current);
 	static void completeCb(void* handle, ovi_error_e error, void* userData);
 	void runDataFlow();
 	void runRender();
+	void runStreamingRender();
+	void runTimelineRender();
+	std::tuple<MediaType, int64_t, double> renderStream() const;
+	void createResultCache();
+	void restoreCheckpoint();
+	std::string fingerprint() const;
 
 	std::unique_ptr<DataFlow> _dataFlow;
 	std::unique_ptr<RenderTask> _render;
@@ -68,18 +82,24 @@ private:
 	std::shared_ptr<AvSynchronizer> _avSynchronizer;
 	MediaInfoPtr _mediaInfo;
 
-	std::string _renderUid;
+	std::vector<RenderTarget> _renders;
 	std::string _mediaPath;
 	std::string _otioFilePath;
-	std::string _outputFilePath;
-	ovi_state_e _state;
+	std::atomic<ovi_state_e> _state { OVI_STATE_IDLE };
 	size_t _skipFrames {};
+	bool _streamingRender {};
+	std::vector<std::string> _request;
+	std::string _checkpointPath;
+	std::shared_ptr<ResultCache> _resultCache;
+	std::shared_ptr<Checkpoint> _checkpoint;
+	CheckpointPosition _checkpointPosition;
 
 	ovi_callbacks_s _progress_cb {};
 
 	std::unique_ptr<IInvokable> _errorCb;
 	std::unique_ptr<IInvokable>_stateChangedCb;
 	std::shared_ptr<IInvokable> _completeCb;
+	std::shared_ptr<IInvokable> _renderCb;
 
 };
 
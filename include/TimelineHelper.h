@@ -54,6 +54,9 @@ public:
 	explicit TimelineHelper(double framerate);
 	~TimelineHelper() = default;
 
+	static timelineRetainer load(const std::string& path);
+	static timelineRetainer clone(const timelineRetainer& timeline);
+
 	void makeMediaRef(const std::string& mediaPath,
 					double framerate,
 					double duration);
@@ -64,7 +67,7 @@ public:
 
 	void appendGap(const std::string& trackName, TimeRange range);
 
-	void appendClip(const std::string& trackName,
+	clipRetainer appendClip(const std::string& trackName,
 					const std::string& clipName,
 					TimeRange range,
 					const std::string& mediaPath,
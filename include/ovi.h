@@ -150,6 +150,22 @@ int ovi_session_set_media_path(session s, const char *media_path);
  */
 int ovi_session_set_render(session s, const char *render_name, const char *output_path);
 
+/**
+ * @brief Adds a render and the path to store its result, the session renders to all of them.
+ *
+ * @param[in] s the session handle
+ * @param[in] uid the uid of the render plugin
+ * @param[in] output_path the path to store the result
+ * @param[in] effects the uids of the effect plugins to render, NULL to render all the linked effects
+ * @param[in] size the number of effects
+ * @return int 0 on success
+ *
+ * The media is analyzed once and the renders run at the same time, each one with its effects.
+ * A render plugin renders one output, add the plugin again for another output of the same render.
+ * ovi_session_set_render() replaces all the renders added.
+ */
+int ovi_session_add_render(session s, const char *uid, const char *output_path, const char *effects[], unsigned int size);
+
 /* session : callbacks */
 /**
  * @brief Sets the callback function to be invoked when the error occur.
@@ -205,6 +221,27 @@ int ovi_session_set_state_changed_cb(session s, ovi_state_changed_cb callback, v
  */
 int ovi_session_unset_state_changed_cb(session s);
 
+/**
+ * @brief Sets the callback function to be invoked when each render is done.
+ *
+ * @param[in] s the session handle
+ * @param[in] callback the callback function to be invoked
+ * @param[in] user_data the user data to be passed to the callback function
+ * @return int 0 on success
+ *
+ * The callback is invoked once for each render with its output path and its error,
+ * before the session goes back to OVI_STATE_IDLE. The error callback gets the first error of the renders.
+ */
+int ovi_session_set_render_cb(session s, ovi_render_cb callback, void *user_data);
+
+/**
+ * @brief Unsets the callback function to be invoked when each render is done.
+ *
+ * @param[in] s the session handle
+ * @return int 0 on success
+ */
+int ovi_session_unset_render_cb(session s);
+
 /* session : optional */
 /**
  * @brief Sets the skip_frames for analyzing.
@@ -221,6 +258,49 @@ int ovi_session_unset_state_changed_cb(session s);
  */
 int ovi_session_set_skip_video_frames(session s, size_t skip_frames);
 
+/**
+ * @brief Sets whether to render the result while analyzing.
+ *
+ * @param[in] s the session handle
+ * @param[in] enable true to render the clips as soon as they are found
+ * @return int 0 on success
+ *
+ * In the streaming render, the clips are handed to the render as soon as the analysis
+ * finalizes them, about one second after their end, and the output is produced
+ * when the analysis is over. Renders without the support keep rendering after the analysis.
+ * The default is false.
+ */
+int ovi_session_set_streaming_render(session s, bool enable);
+
+/**
+ * @brief Sets the file to save the analysis progress to, and to resume from.
+ *
+ * @param[in] s the session handle
+ * @param[in] path the checkpoint file, an empty string disables it
+ * @return int 0 on success
+ *
+ * The accumulated results are saved every few seconds, and when the analysis is stopped or finished.
+ * If the file was saved by the same analysis, with the same media, plugins, attributes and skip frames,
+ * ovi_session_start() continues after the last saved frame instead of starting from the first one.
+ * A plugin giving one result for all the frames sees the frames after the resume point only,
+ * so its result applies to those frames. Remove the file to analyze the media from the start again.
+ */
+int ovi_session_set_checkpoint(session s, const char *path);
+
+/**
+ * @brief Sets the timeline to render instead of analyzing the media.
+ *
+ * @param[in] s the session handle
+ * @param[in] path the OpenTimelineIO file, e.g. saved by the otio render, an empty string unsets it
+ * @return int 0 on success
+ *
+ * ovi_session_start() renders the clips and the effects of the timeline to the targets
+ * of the session, going to OVI_STATE_RENDER without the analysis. The media path, the detect
+ * plugins and the checkpoint are not used. The effects of a target added with effect plugins
+ * are those named by the plugins. The file is loaded by each ovi_session_start().
+ */
+int ovi_session_set_timeline(session s, const char *path);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
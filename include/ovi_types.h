@@ -96,6 +96,16 @@ typedef void (*ovi_progress_cb)(void *handle, const char *progress, void *user_d
  */
 typedef void (*ovi_state_changed_cb)(void *handle, ovi_state_e previous, ovi_state_e current, void *user_data);
 
+/**
+ * @brief Called when a render is done
+ * @remarks The callback is called in the another thread as the one that calls the API.
+ * @param[in] handle the session handle
+ * @param[in] output_path the output path of the render
+ * @param[in] error the error code, OVI_ERROR_NONE if the output is complete
+ * @param[in] user_data the user data to be passed
+ */
+typedef void (*ovi_render_cb)(void *handle, const char *output_path, ovi_error_e error, void *user_data);
+
 /**
  * @brief Called when the available plugin is existed
  * @remarks The callback is called in the same thread as the one that calls the API.
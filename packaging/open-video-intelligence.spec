@@ -10,6 +10,7 @@ BuildRequires: pkgconfig(libswscale)
 BuildRequires: pkgconfig(libavcodec)
 BuildRequires: pkgconfig(libavutil)
 BuildRequires: pkgconfig(libavformat)
+BuildRequires: pkgconfig(libavfilter)
 BuildRequires: pkgconfig(libswresample)
 BuildRequires: pkgconfig(Imath)
 BuildRequires: pkgconfig(python3)
@@ -53,7 +53,7 @@ def setAttrs(attrs: Dict[str, str]) -> int:
 
 
 def process(channels, samplerate, format_type, samples, frame):
-    return ad.getResult(numpy.fromstring(frame, numpy.float32))
+    return ad.getResult(numpy.frombuffer(frame, numpy.float32))
 
 
 def pluginName():
@@ -19,6 +19,7 @@
 #include <opencv2/imgproc/imgproc_c.h>
 
 #include "IPluginProcess.h"
+#include "ModelCache.h"
 
 #define HAAR_FACE PLUGIN_MODEL_DIR"/haarcascade_frontalface_alt2.xml"
 #define HAAR_EYES PLUGIN_MODEL_DIR"/haarcascade_eye.xml"
@@ -38,23 +39,44 @@ public:
 private:
 	Mat toGray(Mat image, VideoFormat format);
 
-	CascadeClassifier _faceCascade;
-	CascadeClassifier _eyeCascade;
+	std::shared_ptr<const ModelPool<CascadeClassifier>> _faceCascade;
+	std::shared_ptr<const ModelPool<CascadeClassifier>> _eyeCascade;
 
 	bool _inverse {};
 	double _scale { 1.5 };
 	int _minNeighbors { 5 };
 };
 
-FaceDetect::FaceDetect()
+/* detectMultiScale is not safe to call concurrently on one classifier, so the instances
+ * share a pool of the classifiers built from one parsed xml */
+static std::shared_ptr<const ModelPool<CascadeClassifier>> loadCascade(const std::string& path)
 {
-	_faceCascade.load(HAAR_FACE);
-	if (_faceCascade.empty())
-		throw ovi::Exception(OVI_ERROR_INVALID_OPERATION, "face model load failed.");
+	return ModelCache::instance().get<ModelPool<CascadeClassifier>>(path, [&path]() {
+		auto storage = std::make_shared<FileStorage>(path, FileStorage::READ);
+		if (!storage->isOpened())
+			return std::shared_ptr<ModelPool<CascadeClassifier>>();
+
+		auto pool = std::make_shared<ModelPool<CascadeClassifier>>([storage, path]() {
+			auto cascade = std::make_unique<CascadeClassifier>();
+			if (!cascade->read(storage->getFirstTopLevelNode()))
+				throw ovi::Exception(OVI_ERROR_INVALID_OPERATION, "cascade load failed: " + path);
+			return cascade;
+		});
+
+		// the first classifier checks the model and is kept for the first detection
+		pool->lease();
+		return pool;
+	});
+}
 
-	_eyeCascade.load(HAAR_EYES);
-	if (_eyeCascade.empty())
-		throw ovi::Exception(OVI_ERROR_INVALID_OPERATION, "eyes model load failed.");
+FaceDetect::FaceDetect()
+{
+	try {
+		_faceCascade = loadCascade(HAAR_FACE);
+		_eyeCascade = loadCascade(HAAR_EYES);
+	} catch (const cv::Exception& e) {
+		throw ovi::Exception(OVI_ERROR_INVALID_OPERATION, std::string { "cascade load failed: " } + e.what());
+	}
 }
 
 int FaceDetect::setAttrs(const std::map<std::string, std::string>& attrs)
@@ -118,7 +140,7 @@ Outcome FaceDetect::process(ovi::FramePack *frame)
 	Mat gray = toGray(image, format);
 
 	std::vector<Rect> faces;
-	_faceCascade.detectMultiScale(gray, faces, _scale, _minNeighbors, 0, Size(30, 30));
+	_faceCascade->lease()->detectMultiScale(gray, faces, _scale, _minNeighbors, 0, Size(30, 30));
 
 	if (faces.empty()) {
 		ret.detect = (_inverse) ? true : false;
@@ -127,9 +149,10 @@ Outcome FaceDetect::process(ovi::FramePack *frame)
 		return ret;
 	}
 
+	auto eyeCascade = _eyeCascade->lease();
 	for (size_t i = 0; i < faces.size(); ++i) {
 		std::vector<Rect> eyes;
-		_eyeCascade.detectMultiScale(gray(faces[i]), eyes);
+		eyeCascade->detectMultiScale(gray(faces[i]), eyes);
 		if (eyes.size() > 0 && eyes.size() < 3) {
 			ret.detect = true;
 			OVIRect r = {
@@ -52,11 +52,8 @@ def setAttrs(attrs: Dict[str, str]):
 
 
 def process(width, height, frame, total_frame_num=0, fps=0.0):
-    detect, output = fd.getFaces(
-        np.frombuffer(frame, dtype='B', count=int(height) * int(width) * 3).reshape(
-            (int(height), int(width), 3)
-        )
-    )
+    # frame is a read-only (height, width, 3) memoryview valid only during this call
+    detect, output = fd.getFaces(np.asarray(frame))
 
     return (not detect, output) if fd.inverse else (detect, output)
 
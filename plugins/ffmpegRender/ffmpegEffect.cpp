@@ -14,253 +14,311 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
 #include <filesystem>
+#include <set>
 #include <unistd.h>
 
 #include "ffmpegEffect.h"
+#include "ffmpegEffectEngine.h"
+#include "ffmpegRemuxer.h"
+#include "ffmpegTranscoder.h"
+#include "ffmpegWorkerPool.h"
 
-std::string CmdGenerator::makeVideoBlurEffectCmd(const std::string& inputPath, const std::string& outputPath,
-												const std::string& blurName, int intensity,
-												std::vector<CoordinateInfo> coordInfo)
-{
-	std::string cmd = "/usr/bin/ffmpeg -y -i ";
-	cmd += inputPath;
-	cmd += " -filter_complex \"";
-
-	size_t _coordSize = coordInfo.size();
-	char tmp[256];
+static const double TIME_EPSILON = 1e-4;
 
-	for (size_t i = 0; i < _coordSize; i++) {
-		snprintf(tmp, 256, "[0:v]crop=%f:%f:%f:%f,%s=%d[crop%zu]; ",
-			coordInfo[i].w, coordInfo[i].h, coordInfo[i].x, coordInfo[i].y, blurName.c_str(), intensity, i + 1);
-
-		cmd += tmp;
+/* The value is unescaped once by the graph parser and once by the options parser of the filter. */
+static std::string __escape(const std::string& value)
+{
+	std::string option;
+	for (char c : value) {
+		if (c == '\\' || c == '\'' || c == ':')
+			option += '\\';
+		option += c;
 	}
 
-	for (size_t i = 0; i < _coordSize; i++) {
-		if (_coordSize == 1)	 {
-			snprintf(tmp, 256, "[0:v][crop%zu]overlay=%f:%f:enable='between(t,%f,%f)' ",
-				i + 1, coordInfo[i].x, coordInfo[i].y, coordInfo[i].time.startSec, coordInfo[i].time.endSec);
-
-			cmd += tmp;
-			break;
-		}
-
-		if (i == 0) {
-			snprintf(tmp, 256, "[0:v][crop%zu]overlay=%f:%f:enable='between(t,%f,%f)' [ovr%zu]; ",
-				i + 1, coordInfo[i].x, coordInfo[i].y, coordInfo[i].time.startSec, coordInfo[i].time.endSec, i + 1);
-		} else if (i == _coordSize - 1) {
-			snprintf(tmp, 256, "[ovr%zu][crop%zu]overlay=%f:%f:enable='between(t,%f,%f)' ",
-				i, i + 1, coordInfo[i].x, coordInfo[i].y, coordInfo[i].time.startSec, coordInfo[i].time.endSec);
-		} else {
-			snprintf(tmp, 256, "[ovr%zu][crop%zu]overlay=%f:%f:enable='between(t,%f,%f)' [ovr%zu]; ",
-				i, i + 1, coordInfo[i].x, coordInfo[i].y, coordInfo[i].time.startSec, coordInfo[i].time.endSec, i + 1);
-		}
-
-		cmd += tmp;
+	std::string escaped;
+	for (char c : option) {
+		if (c == '\\' || c == '\'' || c == '[' || c == ']' || c == ',' || c == ';')
+			escaped += '\\';
+		escaped += c;
 	}
 
-	cmd += "\" -movflags +faststart ";
-	cmd += outputPath;
-
-	std::cout << "blur effect cmd:" << cmd << std::endl;
-
-	return cmd;
+	return escaped;
 }
 
-std::string CmdGenerator::makeVideoBoxEffectCmd(const std::string& inputPath, const std::string& outputPath,
-												const std::string& color, int thickness,
-												std::vector<CoordinateInfo> coordInfo)
+static std::string __label(const std::string& name)
 {
-	std::string cmd = "/usr/bin/ffmpeg -y -i ";
-	cmd += inputPath;
-	cmd += " -vf \"";
+	return "[" + name + "]";
+}
 
-	for (size_t i = 0; i < coordInfo.size(); i++) {
-		char tmp[256];
-		snprintf(tmp, 256, "drawbox=x=%f:y=%f:w=%f:h=%f:enable='between(t,%f,%f)':c=%s:t=%d",
-			coordInfo[i].x, coordInfo[i].y, coordInfo[i].w, coordInfo[i].h,
-			coordInfo[i].time.startSec, coordInfo[i].time.endSec, color.c_str(), thickness);
+static std::string __enable(const std::vector<Timeline>& timeInfo)
+{
+	std::string enable = "enable='";
+	char tmp[256];
 
-		cmd += tmp;
-		if (i != coordInfo.size() - 1)
-			cmd += ",";
+	for (size_t i = 0; i < timeInfo.size(); i++) {
+		snprintf(tmp, 256, "%sbetween(t,%f,%f)", (i == 0) ? "" : "+", timeInfo[i].startSec, timeInfo[i].endSec);
+		enable += tmp;
 	}
 
-	cmd += "\" ";
-	cmd += outputPath;
-
-	std::cout << "box effect cmd:" << cmd << std::endl;
-
-	return cmd;
+	return enable + "'";
 }
 
-std::string CmdGenerator::makeVideoEqEffectCmd(const std::string& inputPath, const std::string& outputPath,
+std::string FilterGenerator::makeVideoEqFilter(const std::string& in, const std::string& out,
 											const std::string& effectName, double effectValue,
-											std::vector<Timeline> timeInfo)
+											const std::vector<Timeline>& timeInfo)
 {
-	std::string cmd = "/usr/bin/ffmpeg -y -i ";
-	cmd += inputPath;
-	cmd += " -vf \"eq=";
+	if (timeInfo.empty())
+		return __label(in) + "null" + __label(out);
 
 	char tmp[256];
-	snprintf(tmp, 256, "%s=%f:", effectName.c_str(), effectValue);
-	cmd += tmp;
-	cmd += "enable='";
-
-	for (size_t i = 0; i < timeInfo.size(); i++) {
-		if (i == 0)
-			snprintf(tmp, 256, "between(t,%f,%f)", timeInfo[i].startSec, timeInfo[i].endSec);
-		else
-			snprintf(tmp, 256, "+between(t,%f,%f)", timeInfo[i].startSec, timeInfo[i].endSec);
-		cmd += tmp;
-	}
+	snprintf(tmp, 256, "eq=%s=%f:", effectName.c_str(), effectValue);
 
-	cmd += "'\" ";
-	cmd += outputPath;
+	std::string graph = __label(in) + tmp + __enable(timeInfo) + __label(out);
 
-	std::cout << effectName << " effect cmd:" << cmd << std::endl;
+	std::cout << effectName << " effect filter:" << graph << std::endl;
 
-	return cmd;
+	return graph;
 }
 
-std::string CmdGenerator::makeVideoTextEffectCmd(const std::string& inputPath, const std::string& outputPath,
+std::string FilterGenerator::makeVideoTextFilter(const std::string& in, const std::string& out,
 												const std::string& fontColor, const std::string& fontSize,
 												int x, int y,
-												std::vector<StringInfo> strInfo)
-
+												const std::vector<StringInfo>& strInfo)
 {
-	std::string cmd = "/usr/bin/ffmpeg -y -i ";
-	cmd += inputPath;
-	cmd += " -vf \"";
+	if (strInfo.empty())
+		return __label(in) + "null" + __label(out);
+
+	std::string graph = __label(in);
 
 	for (size_t i = 0; i < strInfo.size(); i++) {
 		char tmp[256];
 
-		snprintf(tmp, 256, "drawtext=text=%s:enable='between(t,%f,%f)':fontcolor=%s:fontsize=%s:x=%d:y=%d",
-			strInfo[i].value.c_str(), strInfo[i].time.startSec, strInfo[i].time.endSec, fontColor.c_str(), fontSize.c_str(), x, y);
+		snprintf(tmp, 256, ":enable='between(t,%f,%f)':fontcolor=%s:fontsize=%s:x=%d:y=%d",
+			strInfo[i].time.startSec, strInfo[i].time.endSec, __escape(fontColor).c_str(), __escape(fontSize).c_str(), x, y);
 
-		cmd += tmp;
+		graph += "drawtext=text=" + __escape(strInfo[i].value) + tmp;
 		if (i != strInfo.size() - 1)
-			cmd += ",";
+			graph += ",";
 	}
 
-	cmd += "\" ";
-	cmd += outputPath;
+	graph += __label(out);
 
-	std::cout << "drawtext effect cmd:" << cmd << std::endl;
+	std::cout << "drawtext effect filter:" << graph << std::endl;
 
-	return cmd;
+	return graph;
 }
 
-std::string CmdGenerator::makeVideoStickerEffectCmd(const std::string& inputPath, const std::string& outputPath,
-													const std::string& imgPath,
-													std::vector<CoordinateInfo> coordInfo)
+std::string FilterGenerator::makeAudioVolumeFilter(const std::string& in, const std::string& out,
+													double volume,
+													const std::vector<Timeline>& timeInfo)
 {
-	std::string cmd = "/usr/bin/ffmpeg -y -i ";
-	cmd += inputPath;
-	cmd += " -i ";
-	cmd += imgPath;
-	cmd += " -filter_complex \"";
+	if (timeInfo.empty())
+		return __label(in) + "anull" + __label(out);
 
-	size_t coordSize = coordInfo.size();
 	char tmp[256];
+	snprintf(tmp, 256, "volume=volume=%f:", volume);
 
-	for (size_t i = 0; i < coordSize; i++) {
-		double scaleSize = ( coordInfo[i].w > coordInfo[i].h) ? coordInfo[i].w : coordInfo[i].h;	//ToDo. The ratio should be considered
-
-		if (i == 0) {
-			snprintf(tmp, 256, "[1:v]scale=%f:%f[s%zu], [0:v][s%zu]overlay=%f:%f:enable='between(t,%f,%f)' [ovr%zu] ",
-				scaleSize, scaleSize, i + 1, i + 1, coordInfo[i].x, coordInfo[i].y, coordInfo[i].time.startSec, coordInfo[i].time.endSec, i + 1);
-		} else if (i == coordSize - 1) {
-			snprintf(tmp, 256, "[1:v]scale=%f:%f[s%zu], [ovr%zu][s%zu]overlay=%f:%f:enable='between(t,%f,%f)' ",
-				scaleSize, scaleSize, i + 1, i, i + 1, coordInfo[i].x, coordInfo[i].y, coordInfo[i].time.startSec, coordInfo[i].time.endSec);
-		} else {
-			snprintf(tmp, 256, "[1:v]scale=%f:%f[s%zu], [ovr%zu][s%zu]overlay=%f:%f:enable='between(t,%f,%f)' [ovr%zu] ",
-				scaleSize, scaleSize, i + 1, i, i + 1, coordInfo[i].x, coordInfo[i].y, coordInfo[i].time.startSec, coordInfo[i].time.endSec, i + 1);
-		}
+	std::string graph = __label(in) + tmp + __enable(timeInfo) + __label(out);
+
+	std::cout << "volume effect filter:" << graph << std::endl;
+
+	return graph;
+}
+
+FFmpegEffect::FFmpegEffect(timelineRetainer otioTimeline, FFmpegWorkerPool& pool)
+{
+	auto clips = otioTimeline->find_clips();
+	if (clips.empty()) {
+		std::cout << "No clips" << std::endl;
+		return;
+	}
+
+	std::vector<Job> jobs(clips.size());
+	bool effects = false;
+
+	for (size_t i = 0; i < clips.size(); i++) {
+		const auto& clip = clips[i];
+		auto ex = dynamic_cast<otio::ExternalReference*>(clip->media_reference());
+		assert(ex);
 
-		cmd += tmp;
+		Job& job = jobs[i];
+		job.inputPath = ex->target_url();
+		job.startSec = clip->trimmed_range().start_time().to_seconds();
+		job.endSec = clip->trimmed_range().end_time_exclusive().to_seconds();
+		job.engine = std::make_unique<FFmpegEffectEngine>();
 
-		if (i != coordInfo.size() - 1)
-			cmd += ";";
+		for (const auto& effect : clip.value->effects()) {
+			addEffect(job, effect->effect_name(), effect->metadata(), clip->trimmed_range().duration().rate());
+			effects = true;
+		}
 	}
 
-	cmd += "\" ";
-	cmd += outputPath;
+	if (!effects)
+		return;
+
+	makeDirectory();
 
-	std::cout << "sticker effect cmd:" << cmd << std::endl;
+	try {
+		for (size_t i = 0; i < jobs.size(); i++) {
+			alignRanges(jobs[i]);
+			split(jobs[i], i);
+		}
+		run(jobs, pool);
+
+		// the clips are encoded alike, as a whole, when the encoded ranges can't follow the copied ones
+		if (!joinable(jobs)) {
+			std::cout << "the effect ranges can't be joined to the copied ones, the clips are encoded" << std::endl;
+			for (size_t i = 0; i < jobs.size(); i++) {
+				jobs[i].ranges = { { jobs[i].startSec, jobs[i].endSec } };
+				split(jobs[i], i);
+			}
+			run(jobs, pool);
+		}
+	} catch (...) {
+		std::error_code err;
+		std::filesystem::remove_all(_directory, err);
+		throw;
+	}
 
-	return cmd;
+	for (const auto& job : jobs)
+		_segments.insert(_segments.end(), job.segments.begin(), job.segments.end());
 }
 
-std::string CmdGenerator::makeAudioVolumeEffectCmd(const std::string& inputPath, const std::string& outputPath,
-													double volume,
-													std::vector<Timeline> timeInfo)
+FFmpegEffect::~FFmpegEffect()
 {
-	std::string cmd = "/usr/bin/ffmpeg -y -i ";
-	cmd += inputPath;
-	cmd += " -af \"volume=";
-
-	char tmp[256];
-	snprintf(tmp, 256, "volume=%f:", volume);
-	cmd += tmp;
-	cmd += "enable='";
+	std::error_code err;
+	if (!_directory.empty())
+		std::filesystem::remove_all(_directory, err);
+}
 
-	for (size_t i = 0; i < timeInfo.size(); i++) {
-		if (i == 0)
-			snprintf(tmp, 256, "between(t,%f,%f)", timeInfo[i].startSec, timeInfo[i].endSec);
+static std::vector<Timeline> __union(std::vector<Timeline> ranges)
+{
+	std::sort(ranges.begin(), ranges.end(), [](const Timeline& a, const Timeline& b) {
+		return a.startSec < b.startSec;
+	});
+
+	std::vector<Timeline> merged;
+	for (const auto& range : ranges) {
+		// the ranges of consecutive frames touch
+		if (!merged.empty() && range.startSec <= merged.back().endSec + TIME_EPSILON)
+			merged.back().endSec = std::max(merged.back().endSec, range.endSec);
 		else
-			snprintf(tmp, 256, "+between(t,%f,%f)", timeInfo[i].startSec, timeInfo[i].endSec);
-		cmd += tmp;
+			merged.push_back(range);
 	}
 
-	cmd += "'\" ";
-	cmd += outputPath;
+	return merged;
+}
 
-	std::cout << "volume effect cmd:" << cmd << std::endl;
+static std::vector<Timeline> __clamp(const std::vector<Timeline>& ranges, double startSec, double endSec)
+{
+	std::vector<Timeline> clamped;
+	for (const auto& range : ranges) {
+		Timeline in { std::max(range.startSec, startSec), std::min(range.endSec, endSec) };
+		if (in.endSec - in.startSec > TIME_EPSILON)
+			clamped.push_back(in);
+	}
 
-	return cmd;
+	return clamped;
 }
 
-FFmpegEffect::FFmpegEffect(timelineRetainer otioTimeline)
+void FFmpegEffect::alignRanges(Job& job)
 {
-	auto clips = otioTimeline->find_clips();
-	if (clips.empty()) {
-		std::cout << "No clips" << std::endl;
+	job.ranges = __union(__clamp(job.ranges, job.startSec, job.endSec));
+	if (job.ranges.empty())
 		return;
-	}
 
-	std::string inputPath;
+	// the copied packets start at a key frame, the ranges around them are encoded
+	std::vector<std::pair<double, double>> ranges;
+	for (const auto& range : job.ranges)
+		ranges.push_back({ range.startSec, range.endSec });
 
-	for (const auto& clip : clips) {
-		auto& effects = clip.value->effects();
+	std::vector<Timeline> aligned;
+	for (const auto& [ startSec, endSec ] : FFmpegRemuxer::keyFrameRanges(job.inputPath, ranges))
+		aligned.push_back({ startSec, endSec });
 
-		if (effects.empty()) {
-			std::cout << "No effect" << std::endl;
-			continue;
-		}
+	job.ranges = __union(__clamp(aligned, job.startSec, job.endSec));
+}
 
-		auto ex = dynamic_cast<otio::ExternalReference*>(clip->media_reference());
-		assert(ex);
-		auto targetUrl = ex->target_url();
+void FFmpegEffect::split(Job& job, size_t index)
+{
+	job.segments.clear();
 
-		if (inputPath.empty())
-			inputPath = targetUrl;
+	double position = job.startSec;
+	for (size_t i = 0; i < job.ranges.size(); i++) {
+		const Timeline& range = job.ranges[i];
+		if (range.startSec - position > TIME_EPSILON)
+			job.segments.push_back({ job.inputPath, position, range.startSec });
 
-		for (const auto& effect : effects) {
-			if (!_outputPath.empty())
-				inputPath = _outputPath;
+		// the encoded range starts at 0
+		job.segments.push_back({ rangePath(index, i), 0, range.endSec - range.startSec });
+		position = range.endSec;
+	}
 
-			setOutputPath(effect->effect_name());
-			applyEffect(inputPath, _outputPath,
-						effect->effect_name(), effect->metadata(),
-						clip->trimmed_range().duration().rate());
+	if (job.endSec - position > TIME_EPSILON)
+		job.segments.push_back({ job.inputPath, position, job.endSec });
+}
+
+void FFmpegEffect::run(std::vector<Job>& jobs, FFmpegWorkerPool& pool)
+{
+	// the engine of a clip follows its pictures in order, its ranges are encoded one after the other
+	pool.run(jobs.size(), [&](size_t i) {
+		for (size_t r = 0; r < jobs[i].ranges.size(); r++)
+			transcode(jobs[i], jobs[i].ranges[r], rangePath(i, r), pool.threadsPerJob());
+	});
+}
 
-			if (inputPath != targetUrl)
-				remove(inputPath.c_str());
+bool FFmpegEffect::joinable(const std::vector<Job>& jobs)
+{
+	std::string first;
+	std::set<std::string> checked;
+
+	for (const auto& job : jobs) {
+		for (const auto& segment : job.segments) {
+			if (first.empty())
+				first = segment.path;
+			if (!checked.insert(segment.path).second)
+				continue;
+
+			if (segment.path != first && !FFmpegRemuxer::joinable(first, segment.path))
+				return false;
 		}
 	}
+
+	return true;
+}
+
+void FFmpegEffect::transcode(Job& job, const Timeline& range, const std::string& outputPath, int threads)
+{
+	std::cout << "effect range:" << job.inputPath << " " << range.startSec << "~" << range.endSec << " -> " << outputPath << std::endl;
+
+	FFmpegTranscoder transcoder(job.inputPath, outputPath);
+	transcoder.setRange(range.startSec, range.endSec);
+	transcoder.setThreads(threads);
+	transcoder.transcode(graph(job.videoFilters, "v", "null"), graph(job.audioFilters, "a", "anull"),
+		job.engine->empty() ? nullptr : job.engine.get());
+}
+
+std::string FFmpegEffect::rangePath(size_t index, size_t range)
+{
+	return _directory + "/clip_" + std::to_string(index) + "_" + std::to_string(range) + ".mp4";	//ToDo
+}
+
+std::string FFmpegEffect::graph(const std::vector<std::string>& filters, const std::string& prefix, const std::string& passthrough)
+{
+	if (filters.empty())
+		return {};
+
+	std::string graph;
+	for (const auto& filter : filters)
+		graph += filter + "; ";
+
+	// the effects of a stream are chained, the last one gives the output of the graph
+	return graph + __label(prefix + std::to_string(filters.size())) + passthrough + __label("out");
 }
 
 std::string FFmpegEffect::popItem(otio::AnyDictionary& metadata, const std::string& key, const std::string& defaultValue)
@@ -274,63 +332,145 @@ std::string FFmpegEffect::popItem(otio::AnyDictionary& metadata, const std::stri
 	return value;
 }
 
-void FFmpegEffect::applyEffect(const std::string& inputPath, const std::string& outputPath,
-								const std::string& effectName,
-								otio::AnyDictionary& metadata, double rate)
+void FFmpegEffect::addEffect(Job& job, const std::string& effectName, otio::AnyDictionary& metadata, double rate)
 {
-	std::string cmd;
-
+	bool audio = (effectName == "volume");
+	auto& filters = audio ? job.audioFilters : job.videoFilters;
+	std::string prefix = audio ? "a" : "v";
+	std::string in = filters.empty() ? "in" : prefix + std::to_string(filters.size());
+	std::string out = prefix + std::to_string(filters.size() + 1);
+	std::string filter;
+	std::vector<Timeline> timeline = getTimeline(metadata, rate);
+
+	// the effects on regions are applied by the engine, on the pictures coming out of the graph
 	if (effectName == "boxblur" ||
-		effectName == "avgblur") {
+		effectName == "avgblur" ||
+		effectName == "gblur") {
 		int intensity = std::stoi(popItem(metadata, "intensity", FFmpegEffectSpec::effectAttrDefaultValue(effectName, "intensity"))); // 0 to 19
-		cmd = CmdGenerator::makeVideoBlurEffectCmd(inputPath, outputPath,
-												effectName, intensity,
-												getCoordInfo(metadata, rate));
+		job.engine->addBlur(effectName, intensity, getCoordInfo(metadata, rate));
+	} else if (effectName == "mosaic") {
+		int size = std::stoi(popItem(metadata, "size", FFmpegEffectSpec::effectAttrDefaultValue(effectName, "size")));
+		job.engine->addMosaic(size, getCoordInfo(metadata, rate));
 	} else if (effectName == "drawbox") {
 		std::string color = popItem(metadata, "color", FFmpegEffectSpec::effectAttrDefaultValue(effectName, "color"));
 		int thickness = std::stoi(popItem(metadata, "thickness", FFmpegEffectSpec::effectAttrDefaultValue(effectName, "thickness")));
-		cmd = CmdGenerator::makeVideoBoxEffectCmd(inputPath, outputPath,
-												color, thickness,
-												getCoordInfo(metadata, rate));
+		job.engine->addBox(color, thickness, getCoordInfo(metadata, rate));
 	} else if (effectName == "brightness") {
 		double value = std::stof(popItem(metadata, "value", FFmpegEffectSpec::effectAttrDefaultValue(effectName, "value"))); // -1.0 to 1.0
-		cmd = CmdGenerator::makeVideoEqEffectCmd(inputPath, outputPath,
-												effectName, value,
-												getTimeline(metadata, rate));
+		filter = FilterGenerator::makeVideoEqFilter(in, out,
+												effectName, value, timeline);
 	} else if (effectName == "contrast") {
 		double value = std::stof(popItem(metadata, "value", FFmpegEffectSpec::effectAttrDefaultValue(effectName, "value"))); // -1000.0 to 1000.0
-		cmd = CmdGenerator::makeVideoEqEffectCmd(inputPath, outputPath,
-												effectName, value,
-												getTimeline(metadata, rate));
+		filter = FilterGenerator::makeVideoEqFilter(in, out,
+												effectName, value, timeline);
 	} else if (effectName == "saturation") {
 		double value = std::stof(popItem(metadata, "value", FFmpegEffectSpec::effectAttrDefaultValue(effectName, "value"))); // 0.0 to 3.0
-		cmd = CmdGenerator::makeVideoEqEffectCmd(inputPath, outputPath,
-												effectName, value,
-												getTimeline(metadata, rate));
+		filter = FilterGenerator::makeVideoEqFilter(in, out,
+												effectName, value, timeline);
 	} else if (effectName == "drawtext") {
 		std::string fontcolor = popItem(metadata, "fontcolor", FFmpegEffectSpec::effectAttrDefaultValue(effectName, "fontcolor"));
 		std::string fontsize = popItem(metadata, "fontsize", FFmpegEffectSpec::effectAttrDefaultValue(effectName, "fontsize"));
 		int x = std::stoi(popItem(metadata, "x", FFmpegEffectSpec::effectAttrDefaultValue(effectName, "x")));
 		int y = std::stoi(popItem(metadata, "y", FFmpegEffectSpec::effectAttrDefaultValue(effectName, "y")));
-		cmd = CmdGenerator::makeVideoTextEffectCmd(inputPath, outputPath,
+		filter = FilterGenerator::makeVideoTextFilter(in, out,
 												fontcolor, fontsize, x, y,
 												getConvertedStringInfo(metadata, rate));
 	} else if (effectName == "sticker") {
 		std::string imgPath = popItem(metadata, "path", FFmpegEffectSpec::effectAttrDefaultValue(effectName, "path"));
-		cmd = CmdGenerator::makeVideoStickerEffectCmd(inputPath, outputPath,
-													imgPath,
-													getCoordInfo(metadata, rate));
+		job.engine->addSticker(imgPath, getCoordInfo(metadata, rate));
 	} else if (effectName == "volume") {
 		double volume = std::stof(popItem(metadata, "volume", FFmpegEffectSpec::effectAttrDefaultValue(effectName, "volume")));
-		cmd = CmdGenerator::makeAudioVolumeEffectCmd(inputPath, outputPath, volume, getTimeline(metadata, rate));
+		filter = FilterGenerator::makeAudioVolumeFilter(in, out, volume, timeline);
 	} else {
 		std::cout << "Not supported effect:" << effectName << std::endl;
 		return;
 	}
 
-	int ret = system(cmd.c_str());
-	if (ret == 127 || ret == -1)
-		std::cout << "system error:" << ret << std::endl;
+	if (!filter.empty())
+		filters.push_back(filter);
+
+	// only the frames of the effects are encoded
+	job.ranges.insert(job.ranges.end(), timeline.begin(), timeline.end());
+}
+
+/* The metadata has a key per frame number, and the tracks of the rectangles. */
+static bool __frameKey(const std::string& key, double* frame)
+{
+	char* end = nullptr;
+	*frame = std::strtod(key.c_str(), &end);
+
+	return end != key.c_str() && *end == '\0';
+}
+
+static double __number(const std::any& value)
+{
+	if (value.type() == typeid(int64_t))
+		return std::any_cast<int64_t>(value);
+	if (value.type() == typeid(int))
+		return std::any_cast<int>(value);
+
+	return std::any_cast<double>(value);
+}
+
+using TrackKey = std::array<double, 5>;	// frame, x, y, width, height
+
+static std::vector<std::vector<TrackKey>> __tracks(otio::AnyDictionary& metadata)
+{
+	std::vector<std::vector<TrackKey>> tracks;
+	auto found = metadata.find("tracks");
+	if (found == metadata.end())
+		return tracks;
+
+	for (const auto& anyTrack : std::any_cast<otio::AnyVector>(found->second)) {
+		auto track = std::any_cast<otio::AnyDictionary>(anyTrack);
+		std::vector<TrackKey> keys;
+
+		for (const auto& anyKey : std::any_cast<otio::AnyVector>(track["keys"])) {
+			auto key = std::any_cast<otio::AnyDictionary>(anyKey);
+			keys.push_back({ __number(key["frame"]), __number(key["x"]), __number(key["y"]),
+				__number(key["width"]), __number(key["height"]) });
+		}
+
+		if (!keys.empty())
+			tracks.push_back(std::move(keys));
+	}
+
+	return tracks;
+}
+
+/* Splits each segment of a track in as few pieces as the tolerance allows, each piece gets the rectangle of its middle. */
+static void __expandTrack(const std::vector<TrackKey>& keys, double tolerance, double rate, std::vector<CoordinateInfo>* coordInfo)
+{
+	auto piece = [&](const TrackKey& from, const TrackKey& to, double start, double end) {
+		double t = (to[0] > from[0]) ? std::clamp(((start + end) / 2 - from[0]) / (to[0] - from[0]), 0.0, 1.0) : 0;
+		coordInfo->push_back({
+			from[1] + (to[1] - from[1]) * t,
+			from[2] + (to[2] - from[2]) * t,
+			from[3] + (to[3] - from[3]) * t,
+			from[4] + (to[4] - from[4]) * t,
+			{ otio::RationalTime(start, rate).to_seconds(), otio::RationalTime(end, rate).to_seconds() }
+		});
+	};
+
+	if (keys.size() == 1) {
+		piece(keys[0], keys[0], keys[0][0], keys[0][0] + 1);
+		return;
+	}
+
+	for (size_t i = 1; i < keys.size(); i++) {
+		const auto& from = keys[i - 1];
+		const auto& to = keys[i];
+		double end = (i == keys.size() - 1) ? to[0] + 1 : to[0];
+		double frames = std::max(end - from[0], 1.0);
+
+		double delta = 0;
+		for (int c = 1; c < 5; c++)
+			delta = std::max(delta, std::fabs(to[c] - from[c]));
+
+		double pieces = std::clamp(std::ceil(delta / tolerance), 1.0, std::floor(frames));
+		for (double p = 0; p < pieces; p++)
+			piece(from, to, from[0] + std::round(frames * p / pieces), from[0] + std::round(frames * (p + 1) / pieces));
+	}
 }
 
 std::vector<CoordinateInfo> FFmpegEffect::getCoordInfo(otio::AnyDictionary& metadata, double rate)
@@ -338,24 +478,39 @@ std::vector<CoordinateInfo> FFmpegEffect::getCoordInfo(otio::AnyDictionary& meta
 	std::vector<CoordinateInfo> coordInfo;
 
 	for (const auto& [ key, value ] : metadata) {
+		double frame;
+		if (!__frameKey(key, &frame))
+			continue;
+
 		Timeline timeLine {
-			otio::RationalTime(std::stof(key), rate).to_seconds(),
-			otio::RationalTime(std::stof(key) + 1, rate).to_seconds()
+			otio::RationalTime(frame, rate).to_seconds(),
+			otio::RationalTime(frame + 1, rate).to_seconds()
 		};
 
 		for (const auto& anyRect : std::any_cast<otio::AnyVector>(value)) {
 			auto rect = std::any_cast<otio::AnyDictionary>(anyRect);
+			if (rect.find("x") == rect.end())
+				continue;
 
 			coordInfo.push_back({
-				std::any_cast<double>(rect["x"]),
-				std::any_cast<double>(rect["y"]),
-				std::any_cast<double>(rect["width"]),
-				std::any_cast<double>(rect["height"]),
+				__number(rect["x"]),
+				__number(rect["y"]),
+				__number(rect["width"]),
+				__number(rect["height"]),
 				timeLine
 			});
 		}
 	}
 
+	// a piece is never off the interpolated rectangle by more than a pixel, or by the tolerance of the tracks
+	double tolerance = 1;
+	auto found = metadata.find("tolerance");
+	if (found != metadata.end())
+		tolerance = std::max(__number(found->second), 1.0);
+
+	for (const auto& keys : __tracks(metadata))
+		__expandTrack(keys, tolerance, rate, &coordInfo);
+
 	return coordInfo;
 }
 
@@ -387,9 +542,13 @@ std::vector<StringInfo> FFmpegEffect::getConvertedStringInfo(otio::AnyDictionary
 	std::vector<StringInfo> stringInfo;
 
 	for (const auto& [ key, value ] : metadata) {
+		double frame;
+		if (!__frameKey(key, &frame))
+			continue;
+
 		Timeline timeLine {
-			otio::RationalTime(std::stof(key), rate).to_seconds(),
-			otio::RationalTime(std::stof(key) + 1, rate).to_seconds()
+			otio::RationalTime(frame, rate).to_seconds(),
+			otio::RationalTime(frame + 1, rate).to_seconds()
 		};
 
 		for (const auto& anyValue : std::any_cast<otio::AnyVector>(value)) {
@@ -409,16 +568,20 @@ std::vector<DoubleInfo> FFmpegEffect::getDoubleInfo(otio::AnyDictionary& metadat
 	std::vector<DoubleInfo> doubleInfo;
 
 	for (const auto& [ key, value ] : metadata) {
+		double frame;
+		if (!__frameKey(key, &frame))
+			continue;
+
 		Timeline timeLine {
-			otio::RationalTime(std::stof(key), rate).to_seconds(),
-			otio::RationalTime(std::stof(key) + 1, rate).to_seconds()
+			otio::RationalTime(frame, rate).to_seconds(),
+			otio::RationalTime(frame + 1, rate).to_seconds()
 		};
 
 		for (const auto& anyValue : std::any_cast<otio::AnyVector>(value)) {
 			auto dbl = std::any_cast<otio::AnyDictionary>(anyValue);
 
 			doubleInfo.push_back({
-				std::any_cast<double>(dbl["value"]),
+				__number(dbl["value"]),
 				timeLine
 			});
 		}
@@ -432,30 +595,38 @@ std::vector<Timeline> FFmpegEffect::getTimeline(otio::AnyDictionary& metadata, d
 	std::vector<Timeline> timeInfo;
 
 	for (const auto& [ key, value ] : metadata) {
+		double frame;
+		if (!__frameKey(key, &frame))
+			continue;
+
 		Timeline timeLine {
-			otio::RationalTime(std::stof(key), rate).to_seconds(),
-			otio::RationalTime(std::stof(key) + 1, rate).to_seconds()
+			otio::RationalTime(frame, rate).to_seconds(),
+			otio::RationalTime(frame + 1, rate).to_seconds()
 		};
 
 		timeInfo.push_back(timeLine);
 	}
 
+	for (const auto& keys : __tracks(metadata)) {
+		timeInfo.push_back({
+			otio::RationalTime(keys.front()[0], rate).to_seconds(),
+			otio::RationalTime(keys.back()[0] + 1, rate).to_seconds()
+		});
+	}
+
 	return timeInfo;
 }
 
-void FFmpegEffect::setOutputPath(const std::string& effectName)
+void FFmpegEffect::makeDirectory()
 {
-	static int fileNum = 0;
-
-	_outputPath = {};
+	std::string path = (std::filesystem::temp_directory_path() / "ovi_render_XXXXXX").string();
 
-	_outputPath += "./effect_";
-	_outputPath += effectName;
-	_outputPath += "_";
-	_outputPath += std::to_string(fileNum++);
-	_outputPath += ".mp4";	//ToDo
+	// the name is unique among the renders running at the same time
+	if (!mkdtemp(path.data()))
+		throw ovi::Exception(OVI_ERROR_PERMISSION_DENIED, "failed to create the render directory: " + path);
 
-	std::cout << "effect outputPath:" << _outputPath << std::endl;
+	_directory = path;
+	std::cout << "effect directory:" << _directory << std::endl;
 }
 
 std::map<std::string, std::string> FFmpegEffectSpec::descriptions()
@@ -463,6 +634,8 @@ std::map<std::string, std::string> FFmpegEffectSpec::descriptions()
 	std::map<std::string, std::string> effectDescription {
 		{ "boxblur", "Apply a boxblur algorithm to the input video. https://ffmpeg.org/ffmpeg-filters.html#toc-boxblur" },
 		{ "avgblur", "Apply average blur filter. https://ffmpeg.org/ffmpeg-filters.html#avgblur" },
+		{ "gblur", "Apply Gaussian blur filter. https://ffmpeg.org/ffmpeg-filters.html#gblur" },
+		{ "mosaic", "Pixelate the input image with blocks of the given size." },
 		{ "drawbox", "Draw a colored box on the input image. https://ffmpeg.org/ffmpeg-filters.html#toc-drawbox" },
 		{ "drawtext", "Draw a text string. https://ffmpeg.org/ffmpeg-filters.html#drawtext-1" },
 		{ "sticker", "Overlay image. https://ffmpeg.org/ffmpeg-filters.html#overlay-1" },
@@ -500,6 +673,26 @@ std::map<std::string, std::vector<AttributeSpec>> FFmpegEffectSpec::attributes()
 		}
 	};
 
+	attrsInfo["gblur"] = {
+		{ .name = "intensity",
+		  .spec = rangeStr + "0 ~ 19",
+		  .defaultValue = "10",
+		  .validateFunc = [](std::string& s) -> bool {
+				return (0.0 <= std::stof(s) && std::stof(s) <= 19.0);
+			}
+		}
+	};
+
+	attrsInfo["mosaic"] = {
+		{ .name = "size",
+		  .spec = rangeStr + "2 ~ 256",
+		  .defaultValue = "16",
+		  .validateFunc = [](std::string& s) -> bool {
+				return (2.0 <= std::stof(s) && std::stof(s) <= 256.0);
+			}
+		}
+	};
+
 	attrsInfo["drawbox"] = {
 		{ .name = "color",
 		  .defaultValue = "green"
@@ -614,6 +807,8 @@ MetaForm FFmpegEffectSpec::inputMetaForm(const std::string& effectName)
 	std::map<std::string, MetaForm> metaFormMap {
 		{ "boxblur", METAFORM_RECT},
 		{ "avgblur", METAFORM_RECT},
+		{ "gblur", METAFORM_RECT},
+		{ "mosaic", METAFORM_RECT},
 		{ "drawbox", METAFORM_RECT},
 		{ "drawtext", METAFORM_ANY},	//ToDo. Change to allow proper multiple formats
 		{ "sticker", METAFORM_RECT},
@@ -0,0 +1,389 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/parseutils.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+#include "Exception.h"
+#include "ffmpegEffectEngine.h"
+#include "ffmpegKernels.h"
+
+using namespace ovi;
+
+// of the times of the pictures, which are rounded to their time base
+static const double TIME_EPSILON = 1e-4;
+
+static Region __region(const CoordinateInfo& coord, int log2ChromaW, int log2ChromaH)
+{
+	int left = std::lround(coord.x);
+	int top = std::lround(coord.y);
+	int right = std::lround(coord.x + coord.w);
+	int bottom = std::lround(coord.y + coord.h);
+
+	// the chroma samples touched by the luma ones
+	left >>= log2ChromaW;
+	top >>= log2ChromaH;
+	right = (right + (1 << log2ChromaW) - 1) >> log2ChromaW;
+	bottom = (bottom + (1 << log2ChromaH) - 1) >> log2ChromaH;
+
+	return { left, top, right - left, bottom - top };
+}
+
+static Plane __plane(const AVFrame* frame, int index)
+{
+	auto desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+	int log2ChromaW = index ? desc->log2_chroma_w : 0;
+	int log2ChromaH = index ? desc->log2_chroma_h : 0;
+
+	return { frame->data[index], frame->linesize[index],
+		AV_CEIL_RSHIFT(frame->width, log2ChromaW), AV_CEIL_RSHIFT(frame->height, log2ChromaH) };
+}
+
+/* the value of the color in the range and the matrix of the picture, BT.709 for HD and BT.601 otherwise */
+static void __yuv(const uint8_t rgba[4], const AVFrame* frame, uint8_t yuv[3])
+{
+	bool bt709 = (frame->colorspace == AVCOL_SPC_BT709) || (frame->colorspace == AVCOL_SPC_UNSPECIFIED && frame->height > 576);
+	bool full = (frame->color_range == AVCOL_RANGE_JPEG) ||
+		frame->format == AV_PIX_FMT_YUVJ420P || frame->format == AV_PIX_FMT_YUVJ422P || frame->format == AV_PIX_FMT_YUVJ444P;
+	double kr = bt709 ? 0.2126 : 0.299;
+	double kb = bt709 ? 0.0722 : 0.114;
+
+	double r = rgba[0] / 255.0;
+	double g = rgba[1] / 255.0;
+	double b = rgba[2] / 255.0;
+	double y = kr * r + (1 - kr - kb) * g + kb * b;
+	double u = (b - y) / (2 * (1 - kb));
+	double v = (r - y) / (2 * (1 - kr));
+
+	double values[3] = {
+		full ? y * 255 : 16 + y * 219,
+		128 + u * (full ? 255 : 224),
+		128 + v * (full ? 255 : 224)
+	};
+
+	for (int i = 0; i < 3; i++)
+		yuv[i] = std::clamp<long>(std::lround(values[i]), 0, 255);
+}
+
+FFmpegEffectEngine::~FFmpegEffectEngine()
+{
+	for (auto& sticker : _stickers) {
+		av_frame_free(&sticker.image);
+		for (auto& [ size, scaled ] : sticker.scaled) {
+			av_frame_free(&scaled.luma);
+			av_frame_free(&scaled.chroma);
+		}
+	}
+}
+
+void FFmpegEffectEngine::add(const Operation& operation, const std::vector<CoordinateInfo>& coordInfo)
+{
+	for (const auto& coord : coordInfo) {
+		Operation added = operation;
+		added.coord = coord;
+		_operations.push_back(added);
+	}
+
+	_byStart.clear();
+}
+
+void FFmpegEffectEngine::addBlur(const std::string& blurName, int intensity, const std::vector<CoordinateInfo>& coordInfo)
+{
+	Operation operation;
+	operation.value = intensity;
+
+	if (blurName == "boxblur")
+		operation.kind = BOX_BLUR;
+	else if (blurName == "avgblur")
+		operation.kind = AVERAGE_BLUR;
+	else if (blurName == "gblur")
+		operation.kind = GAUSSIAN_BLUR;
+	else
+		throw Exception(OVI_ERROR_NOT_SUPPORTED_EFFECT, "Not supported blur:" + blurName);
+
+	add(operation, coordInfo);
+}
+
+void FFmpegEffectEngine::addMosaic(int size, const std::vector<CoordinateInfo>& coordInfo)
+{
+	Operation operation;
+	operation.kind = MOSAIC;
+	operation.value = size;
+
+	add(operation, coordInfo);
+}
+
+void FFmpegEffectEngine::addBox(const std::string& color, int thickness, const std::vector<CoordinateInfo>& coordInfo)
+{
+	Operation operation;
+	operation.kind = BOX;
+	operation.value = thickness;
+
+	// the colors of ffmpeg, a name or #RRGGBB, with @alpha
+	if (av_parse_color(operation.rgba, color.c_str(), -1, nullptr) < 0)
+		throw Exception(OVI_ERROR_INVALID_EFFECT_ATTR_VALUE, "invalid color:" + color);
+
+	add(operation, coordInfo);
+}
+
+void FFmpegEffectEngine::addSticker(const std::string& imgPath, const std::vector<CoordinateInfo>& coordInfo)
+{
+	if (coordInfo.empty())
+		return;
+
+	Sticker sticker;
+	sticker.image = loadImage(imgPath);
+	_stickers.push_back(std::move(sticker));
+
+	Operation operation;
+	operation.kind = STICKER;
+	operation.sticker = _stickers.size() - 1;
+
+	add(operation, coordInfo);
+}
+
+AVFrame* FFmpegEffectEngine::loadImage(const std::string& imgPath)
+{
+	AVFormatContext* input = nullptr;
+	if (avformat_open_input(&input, imgPath.c_str(), nullptr, nullptr) < 0)
+		throw Exception(OVI_ERROR_NO_SUCH_FILE, "failed to open the sticker:" + imgPath);
+
+	auto closeInput = [](AVFormatContext* input) { avformat_close_input(&input); };
+	std::unique_ptr<AVFormatContext, decltype(closeInput)> inputPtr(input, closeInput);
+
+	int index = av_find_best_stream(input, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+	if (index < 0)
+		throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, "no image in the sticker:" + imgPath);
+
+	const AVCodecParameters* par = input->streams[index]->codecpar;
+	const AVCodec* codec = avcodec_find_decoder(par->codec_id);
+	if (!codec)
+		throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, std::string("no decoder for ") + avcodec_get_name(par->codec_id));
+
+	auto freeContext = [](AVCodecContext* context) { avcodec_free_context(&context); };
+	std::unique_ptr<AVCodecContext, decltype(freeContext)> decoder(avcodec_alloc_context3(codec), freeContext);
+	auto freePacket = [](AVPacket* packet) { av_packet_free(&packet); };
+	std::unique_ptr<AVPacket, decltype(freePacket)> packet(av_packet_alloc(), freePacket);
+	AVFrame* image = av_frame_alloc();
+	if (!decoder || !packet || !image) {
+		av_frame_free(&image);
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate the sticker decoder");
+	}
+
+	bool decoded = (avcodec_parameters_to_context(decoder.get(), par) >= 0 && avcodec_open2(decoder.get(), codec, nullptr) >= 0);
+
+	// the first picture of the file
+	while (decoded && av_read_frame(input, packet.get()) >= 0) {
+		int ret = (packet->stream_index == index) ? avcodec_send_packet(decoder.get(), packet.get()) : 0;
+		av_packet_unref(packet.get());
+		if (ret >= 0 && avcodec_receive_frame(decoder.get(), image) >= 0)
+			return image;
+	}
+
+	if (decoded && avcodec_send_packet(decoder.get(), nullptr) >= 0 && avcodec_receive_frame(decoder.get(), image) >= 0)
+		return image;
+
+	av_frame_free(&image);
+	throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, "failed to decode the sticker:" + imgPath);
+}
+
+const FFmpegEffectEngine::Scaled& FFmpegEffectEngine::scaled(Sticker& sticker, int width, int height, int log2ChromaW, int log2ChromaH)
+{
+	auto key = std::make_tuple(width, height, log2ChromaW, log2ChromaH);
+	auto found = sticker.scaled.find(key);
+	if (found != sticker.scaled.end())
+		return found->second;
+
+	auto scale = [&sticker](int width, int height) {
+		AVFrame* frame = av_frame_alloc();
+		if (!frame)
+			throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate the sticker");
+
+		frame->format = AV_PIX_FMT_YUVA444P;
+		frame->width = std::max(width, 1);
+		frame->height = std::max(height, 1);
+
+		const AVFrame* image = sticker.image;
+		SwsContext* sws = sws_getContext(image->width, image->height, static_cast<AVPixelFormat>(image->format),
+			frame->width, frame->height, AV_PIX_FMT_YUVA444P, SWS_BICUBIC, nullptr, nullptr, nullptr);
+		if (!sws || av_frame_get_buffer(frame, 0) < 0) {
+			sws_freeContext(sws);
+			av_frame_free(&frame);
+			throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to scale the sticker");
+		}
+
+		sws_scale(sws, image->data, image->linesize, 0, image->height, frame->data, frame->linesize);
+		sws_freeContext(sws);
+
+		return frame;
+	};
+
+	Scaled scaled;
+	scaled.luma = scale(width, height);
+	try {
+		scaled.chroma = scale(AV_CEIL_RSHIFT(width, log2ChromaW), AV_CEIL_RSHIFT(height, log2ChromaH));
+	} catch (...) {
+		av_frame_free(&scaled.luma);
+		throw;
+	}
+
+	return sticker.scaled.emplace(key, scaled).first->second;
+}
+
+bool FFmpegEffectEngine::supported(int pixelFormat) const
+{
+	auto desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(pixelFormat));
+	if (!desc || desc->nb_components < 3 || !(desc->flags & AV_PIX_FMT_FLAG_PLANAR) ||
+		(desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM)))
+		return false;
+
+	// 8 bit Y, U and V, each in its own plane
+	for (int i = 0; i < 3; i++) {
+		if (desc->comp[i].plane != i || desc->comp[i].depth != 8 || desc->comp[i].step != 1)
+			return false;
+	}
+
+	return true;
+}
+
+void FFmpegEffectEngine::process(AVFrame* frame, double sec)
+{
+	if (_byStart.empty() || sec < _lastSec) {
+		_byStart.resize(_operations.size());
+		for (size_t i = 0; i < _byStart.size(); i++)
+			_byStart[i] = i;
+		std::stable_sort(_byStart.begin(), _byStart.end(), [this](size_t a, size_t b) {
+			return _operations[a].coord.time.startSec < _operations[b].coord.time.startSec;
+		});
+
+		_active.clear();
+		_next = 0;
+	}
+	_lastSec = sec;
+
+	// the pictures come in order, an operation is started once and ended once
+	while (_next < _byStart.size() && _operations[_byStart[_next]].coord.time.startSec <= sec + TIME_EPSILON)
+		_active.push_back(_byStart[_next++]);
+
+	_active.erase(std::remove_if(_active.begin(), _active.end(), [this, sec](size_t i) {
+		return _operations[i].coord.time.endSec <= sec + TIME_EPSILON;
+	}), _active.end());
+
+	std::sort(_active.begin(), _active.end());
+	for (size_t i : _active)
+		apply(_operations[i], frame);
+}
+
+void FFmpegEffectEngine::apply(const Operation& operation, AVFrame* frame)
+{
+	if (operation.kind == BOX) {
+		drawBox(operation, frame);
+		return;
+	}
+
+	if (operation.kind == STICKER) {
+		drawSticker(operation, frame);
+		return;
+	}
+
+	auto desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+
+	for (int i = 0; i < 3; i++) {
+		// the sizes are in luma pixels
+		int shift = i ? desc->log2_chroma_w : 0;
+		Plane plane = __plane(frame, i);
+		Region region = __region(operation.coord, shift, i ? desc->log2_chroma_h : 0);
+		int value = operation.value > 0 ? std::max(operation.value >> shift, 1) : 0;
+
+		switch (operation.kind) {
+		case BOX_BLUR:
+			// the two passes of the boxblur filter
+			FFmpegKernels::boxBlur(plane, region, value, 2);
+			break;
+		case AVERAGE_BLUR:
+			FFmpegKernels::boxBlur(plane, region, value);
+			break;
+		case GAUSSIAN_BLUR:
+			FFmpegKernels::gaussianBlur(plane, region, std::ldexp(operation.value, -shift));
+			break;
+		case MOSAIC:
+			FFmpegKernels::mosaic(plane, region, value);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void FFmpegEffectEngine::drawBox(const Operation& operation, AVFrame* frame)
+{
+	auto desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+	uint8_t yuv[3];
+	__yuv(operation.rgba, frame, yuv);
+
+	for (int i = 0; i < 3; i++) {
+		int log2ChromaW = i ? desc->log2_chroma_w : 0;
+		int log2ChromaH = i ? desc->log2_chroma_h : 0;
+		Plane plane = __plane(frame, i);
+		Region box = __region(operation.coord, log2ChromaW, log2ChromaH);
+		int thicknessX = AV_CEIL_RSHIFT(std::max(operation.value, 1), log2ChromaW);
+		int thicknessY = AV_CEIL_RSHIFT(std::max(operation.value, 1), log2ChromaH);
+
+		// the sides do not overlap, a translucent box is blended once
+		if (2 * thicknessX >= box.w || 2 * thicknessY >= box.h) {
+			FFmpegKernels::fill(plane, box, yuv[i], operation.rgba[3]);
+			continue;
+		}
+
+		int inner = box.h - 2 * thicknessY;
+		FFmpegKernels::fill(plane, { box.x, box.y, box.w, thicknessY }, yuv[i], operation.rgba[3]);
+		FFmpegKernels::fill(plane, { box.x, box.y + box.h - thicknessY, box.w, thicknessY }, yuv[i], operation.rgba[3]);
+		FFmpegKernels::fill(plane, { box.x, box.y + thicknessY, thicknessX, inner }, yuv[i], operation.rgba[3]);
+		FFmpegKernels::fill(plane, { box.x + box.w - thicknessX, box.y + thicknessY, thicknessX, inner }, yuv[i], operation.rgba[3]);
+	}
+}
+
+void FFmpegEffectEngine::drawSticker(const Operation& operation, AVFrame* frame)
+{
+	auto desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+	int x = std::lround(operation.coord.x);
+	int y = std::lround(operation.coord.y);
+	int size = std::lround(std::max(operation.coord.w, operation.coord.h));	//ToDo. The ratio should be considered
+	if (size <= 0)
+		return;
+
+	const Scaled& image = scaled(_stickers[operation.sticker], size, size, desc->log2_chroma_w, desc->log2_chroma_h);
+
+	for (int i = 0; i < 3; i++) {
+		const AVFrame* source = i ? image.chroma : image.luma;
+		Plane plane = __plane(frame, i);
+		Plane component { source->data[i], source->linesize[i], source->width, source->height };
+		Plane alpha { source->data[3], source->linesize[3], source->width, source->height };
+
+		FFmpegKernels::blend(plane, i ? x >> desc->log2_chroma_w : x, i ? y >> desc->log2_chroma_h : y, component, alpha);
+	}
+}
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "ffmpegKernels.h"
+
+/* The kernels work on vectors of LANES pixels widened to 32 bits, one SSE2 or NEON
+ * register. The vectors of the compiler are lowered to the instructions of the target.
+ */
+static constexpr int LANES = 4;
+typedef uint32_t Sums __attribute__((vector_size(LANES * sizeof(uint32_t))));
+typedef uint8_t Bytes __attribute__((vector_size(LANES)));
+
+static inline Sums __load(const uint8_t* data)
+{
+	Bytes bytes;
+	memcpy(&bytes, data, sizeof(bytes));
+	return __builtin_convertvector(bytes, Sums);
+}
+
+static inline void __store(uint8_t* data, const Sums& sums)
+{
+	Bytes bytes = __builtin_convertvector(sums, Bytes);
+	memcpy(data, &bytes, sizeof(bytes));
+}
+
+/* (src * alpha + dst * (255 - alpha)) / 255, rounded */
+template <typename T>
+static inline T __mix(T dst, T src, T alpha)
+{
+	T value = src * alpha + dst * (255 - alpha) + 128;
+	return (value + (value >> 8)) >> 8;
+}
+
+static bool __clip(const Plane& plane, Region* region)
+{
+	int left = std::max(region->x, 0);
+	int top = std::max(region->y, 0);
+	int right = std::min(region->x + region->w, plane.width);
+	int bottom = std::min(region->y + region->h, plane.height);
+	if (right <= left || bottom <= top)
+		return false;
+
+	*region = { left, top, right - left, bottom - top };
+	return true;
+}
+
+static inline uint8_t* __row(const Plane& plane, int y)
+{
+	return plane.data + static_cast<ptrdiff_t>(y) * plane.linesize;
+}
+
+/* A region copied out of its plane, the rows are padded to whole vectors. */
+struct Scratch {
+	Scratch(int width, int height)
+		: width(width)
+		, height(height)
+		, stride((width + LANES - 1) / LANES * LANES)
+		, data(static_cast<size_t>(stride) * height)
+	{
+	}
+
+	uint8_t* row(int y) { return data.data() + static_cast<size_t>(y) * stride; }
+	const uint8_t* row(int y) const { return data.data() + static_cast<size_t>(y) * stride; }
+
+	int width;
+	int height;
+	int stride;
+	std::vector<uint8_t> data;
+};
+
+static Scratch __copy(const Plane& plane, const Region& region)
+{
+	Scratch scratch(region.w, region.h);
+	for (int y = 0; y < region.h; y++)
+		memcpy(scratch.row(y), __row(plane, region.y + y) + region.x, region.w);
+
+	return scratch;
+}
+
+static void __copyBack(const Scratch& scratch, const Plane& plane, const Region& region)
+{
+	for (int y = 0; y < region.h; y++)
+		memcpy(__row(plane, region.y + y) + region.x, scratch.row(y), region.w);
+}
+
+static void __transpose(const Scratch& src, Scratch& dst)
+{
+	constexpr int BLOCK = 16;
+
+	for (int top = 0; top < src.height; top += BLOCK) {
+		for (int left = 0; left < src.width; left += BLOCK) {
+			int bottom = std::min(top + BLOCK, src.height);
+			int right = std::min(left + BLOCK, src.width);
+			for (int y = top; y < bottom; y++) {
+				const uint8_t* in = src.row(y);
+				for (int x = left; x < right; x++)
+					dst.row(x)[y] = in[x];
+			}
+		}
+	}
+}
+
+/* The running sums of the columns, a pixel costs the same whatever the radius. */
+static void __verticalBox(const Scratch& src, Scratch& dst, int radius)
+{
+	const int vectors = src.stride / LANES;
+	const int last = src.height - 1;
+	// the division by the size of the window, in 8.24 fixed point
+	const uint32_t scale = (1u << 24) / (2 * radius + 1);
+	std::vector<Sums> sums(vectors);
+
+	for (int k = -radius; k <= radius; k++) {
+		const uint8_t* in = src.row(std::clamp(k, 0, last));
+		for (int v = 0; v < vectors; v++)
+			sums[v] += __load(in + v * LANES);
+	}
+
+	for (int y = 0; y < src.height; y++) {
+		uint8_t* out = dst.row(y);
+		const uint8_t* in = src.row(std::min(y + radius + 1, last));
+		const uint8_t* outgoing = src.row(std::max(y - radius, 0));
+
+		for (int v = 0; v < vectors; v++) {
+			Sums sum = sums[v];
+			__store(out + v * LANES, (sum * scale + (1u << 23)) >> 24);
+			sums[v] = sum + __load(in + v * LANES) - __load(outgoing + v * LANES);
+		}
+	}
+}
+
+/* The rows are blurred as the columns of the transposed region, so every pass runs on whole vectors. */
+static void __blur(const Plane& plane, Region region, const std::vector<int>& radii)
+{
+	if (radii.empty() || !__clip(plane, &region))
+		return;
+
+	Scratch a = __copy(plane, region);
+	Scratch b(region.w, region.h);
+	for (int radius : radii) {
+		__verticalBox(a, b, radius);
+		std::swap(a, b);
+	}
+
+	Scratch c(region.h, region.w);
+	Scratch d(region.h, region.w);
+	__transpose(a, c);
+	for (int radius : radii) {
+		__verticalBox(c, d, radius);
+		std::swap(c, d);
+	}
+
+	__transpose(c, a);
+	__copyBack(a, plane, region);
+}
+
+void FFmpegKernels::boxBlur(const Plane& plane, const Region& region, int radius, int passes)
+{
+	if (radius <= 0 || passes <= 0)
+		return;
+
+	__blur(plane, region, std::vector<int>(passes, radius));
+}
+
+void FFmpegKernels::gaussianBlur(const Plane& plane, const Region& region, double sigma)
+{
+	constexpr int BOXES = 3;
+
+	if (sigma <= 0)
+		return;
+
+	// the sizes of the boxes whose variances add up to sigma²
+	int lower = static_cast<int>(std::sqrt(12 * sigma * sigma / BOXES + 1));
+	if (lower % 2 == 0)
+		lower--;
+	int upper = lower + 2;
+	int lowerBoxes = std::lround((12 * sigma * sigma - BOXES * lower * lower - 4 * BOXES * lower - 3 * BOXES) / (-4 * lower - 4));
+
+	std::vector<int> radii;
+	for (int i = 0; i < BOXES; i++) {
+		int radius = ((i < lowerBoxes) ? lower : upper) / 2;
+		if (radius > 0)
+			radii.push_back(radius);
+	}
+
+	__blur(plane, region, radii);
+}
+
+void FFmpegKernels::mosaic(const Plane& plane, const Region& area, int size)
+{
+	Region region = area;
+	if (size <= 1 || !__clip(plane, &region))
+		return;
+
+	Scratch scratch = __copy(plane, region);
+	std::vector<Sums> columns(scratch.stride / LANES);
+
+	for (int top = 0; top < region.h; top += size) {
+		int rows = std::min(size, region.h - top);
+
+		std::fill(columns.begin(), columns.end(), Sums {});
+		for (int y = top; y < top + rows; y++) {
+			const uint8_t* in = scratch.row(y);
+			for (size_t v = 0; v < columns.size(); v++)
+				columns[v] += __load(in + v * LANES);
+		}
+
+		for (int left = 0; left < region.w; left += size) {
+			int cols = std::min(size, region.w - left);
+			uint32_t sum = 0;
+			for (int x = left; x < left + cols; x++)
+				sum += columns[x / LANES][x % LANES];
+
+			uint32_t pixels = rows * cols;
+			uint8_t value = (sum + pixels / 2) / pixels;
+			for (int y = top; y < top + rows; y++)
+				memset(__row(plane, region.y + y) + region.x + left, value, cols);
+		}
+	}
+}
+
+void FFmpegKernels::fill(const Plane& plane, const Region& area, uint8_t value, uint8_t alpha)
+{
+	Region region = area;
+	if (alpha == 0 || !__clip(plane, &region))
+		return;
+
+	if (alpha == 255) {
+		for (int y = region.y; y < region.y + region.h; y++)
+			memset(__row(plane, y) + region.x, value, region.w);
+		return;
+	}
+
+	const Sums values = Sums {} + value;
+	const Sums alphas = Sums {} + alpha;
+
+	for (int y = region.y; y < region.y + region.h; y++) {
+		uint8_t* out = __row(plane, y) + region.x;
+		int x = 0;
+		for (; x + LANES <= region.w; x += LANES)
+			__store(out + x, __mix(__load(out + x), values, alphas));
+		for (; x < region.w; x++)
+			out[x] = __mix<uint32_t>(out[x], value, alpha);
+	}
+}
+
+void FFmpegKernels::blend(const Plane& plane, int x, int y, const Plane& source, const Plane& alpha)
+{
+	Region region { x, y, source.width, source.height };
+	if (!__clip(plane, &region))
+		return;
+
+	for (int row = 0; row < region.h; row++) {
+		uint8_t* out = __row(plane, region.y + row) + region.x;
+		const uint8_t* in = __row(source, region.y - y + row) + (region.x - x);
+		const uint8_t* weights = __row(alpha, region.y - y + row) + (region.x - x);
+
+		int i = 0;
+		for (; i + LANES <= region.w; i += LANES)
+			__store(out + i, __mix(__load(out + i), __load(in + i), __load(weights + i)));
+		for (; i < region.w; i++)
+			out[i] = __mix<uint32_t>(out[i], in[i], weights[i]);
+	}
+}
@@ -0,0 +1,519 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include "Exception.h"
+#include "ffmpegRemuxer.h"
+#include "ffmpegSmartCut.h"
+
+using namespace ovi;
+
+static std::string __errorString(const std::string& function, int err)
+{
+	char errorStr[AV_ERROR_MAX_STRING_SIZE] = {0};
+	av_make_error_string(errorStr, AV_ERROR_MAX_STRING_SIZE, err);
+	return "failed to " + function + ". err:" + errorStr;
+}
+
+static bool __remuxable(const AVStream* stream)
+{
+	auto type = stream->codecpar->codec_type;
+	if (type != AVMEDIA_TYPE_VIDEO && type != AVMEDIA_TYPE_AUDIO)
+		return false;
+
+	return !(stream->disposition & AV_DISPOSITION_ATTACHED_PIC);
+}
+
+FFmpegRemuxer::FFmpegRemuxer(const std::string& outputPath, bool smart)
+	: _outputPath(outputPath)
+	, _smart(smart)
+{
+}
+
+FFmpegRemuxer::~FFmpegRemuxer()
+{
+	// an output without its trailer can't be played
+	discard();
+}
+
+void FFmpegRemuxer::openOutput(AVFormatContext* input)
+{
+	int ret = avformat_alloc_output_context2(&_output, nullptr, nullptr, _outputPath.c_str());
+	if (ret < 0)
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, __errorString("avformat_alloc_output_context2()", ret));
+
+	for (unsigned int i = 0; i < input->nb_streams; i++) {
+		const AVStream* in = input->streams[i];
+		if (!__remuxable(in))
+			continue;
+
+		AVStream* out = avformat_new_stream(_output, nullptr);
+		if (!out || avcodec_parameters_copy(out->codecpar, in->codecpar) < 0)
+			throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to add the output stream");
+
+		out->codecpar->codec_tag = 0;
+		out->time_base = in->time_base;
+	}
+
+	_reencoded.assign(_output->nb_streams, false);
+	_lastDts.assign(_output->nb_streams, AV_NOPTS_VALUE);
+
+	if (!(_output->oformat->flags & AVFMT_NOFILE)) {
+		ret = avio_open(&_output->pb, _outputPath.c_str(), AVIO_FLAG_WRITE);
+		if (ret < 0)
+			throw Exception(OVI_ERROR_PERMISSION_DENIED, __errorString("avio_open()", ret));
+	}
+
+	ret = avformat_write_header(_output, nullptr);
+	if (ret < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("avformat_write_header()", ret));
+}
+
+static bool __sameExtradata(const AVCodecParameters* a, const AVCodecParameters* b)
+{
+	if (a->extradata_size != b->extradata_size)
+		return false;
+
+	return a->extradata_size == 0 || memcmp(a->extradata, b->extradata, a->extradata_size) == 0;
+}
+
+static bool __joinable(const AVCodecParameters* a, const AVCodecParameters* b)
+{
+	if (a->codec_type != b->codec_type || a->codec_id != b->codec_id || a->format != b->format ||
+		a->profile != b->profile || a->width != b->width || a->height != b->height ||
+		a->sample_rate != b->sample_rate)
+		return false;
+
+	if (__sameExtradata(a, b))
+		return true;
+
+	// the parameter sets of the decoder, a packet of another encode can't be decoded with them
+	// unless its key frames carry its own
+	if (!FFmpegSmartCut::supported(a))
+		return false;
+
+	int lengthSizeA = 0;
+	int lengthSizeB = 0;
+	bool setsA = !FFmpegSmartCut::parameterSets(a, &lengthSizeA).empty();
+	bool setsB = !FFmpegSmartCut::parameterSets(b, &lengthSizeB).empty();
+
+	return setsA && setsB && lengthSizeA == lengthSizeB;
+}
+
+/* The parameter sets before the data of a packet. */
+static void __prependParameterSets(AVPacket* packet, const std::vector<uint8_t>& sets)
+{
+	auto freePacket = [](AVPacket* packet) { av_packet_free(&packet); };
+	std::unique_ptr<AVPacket, decltype(freePacket)> prefixed(av_packet_alloc(), freePacket);
+	if (!prefixed || av_new_packet(prefixed.get(), sets.size() + packet->size) < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate a packet");
+
+	memcpy(prefixed->data, sets.data(), sets.size());
+	memcpy(prefixed->data + sets.size(), packet->data, packet->size);
+	av_packet_copy_props(prefixed.get(), packet);
+
+	av_packet_unref(packet);
+	av_packet_move_ref(packet, prefixed.get());
+}
+
+FFmpegRemuxer::InputPtr FFmpegRemuxer::openInput(const std::string& inputPath)
+{
+	AVFormatContext* formatCtx = nullptr;
+	int ret = avformat_open_input(&formatCtx, inputPath.c_str(), nullptr, nullptr);
+	if (ret < 0)
+		throw Exception(OVI_ERROR_NO_SUCH_FILE, __errorString("avformat_open_input()", ret));
+
+	InputPtr input(formatCtx, [](AVFormatContext* ctx) { avformat_close_input(&ctx); });
+
+	ret = avformat_find_stream_info(input.get(), nullptr);
+	if (ret < 0)
+		throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, __errorString("avformat_find_stream_info()", ret));
+
+	return input;
+}
+
+static std::vector<const AVCodecParameters*> __remuxableParameters(const AVFormatContext* ctx)
+{
+	std::vector<const AVCodecParameters*> parameters;
+	for (unsigned int i = 0; i < ctx->nb_streams; i++) {
+		if (__remuxable(ctx->streams[i]))
+			parameters.push_back(ctx->streams[i]->codecpar);
+	}
+
+	return parameters;
+}
+
+std::vector<int> FFmpegRemuxer::streamMap(const AVFormatContext* input) const
+{
+	// the n-th video or audio stream of every input goes to the n-th output stream
+	std::vector<int> streamMap(input->nb_streams, -1);
+	unsigned int streams = 0;
+	for (unsigned int i = 0; i < input->nb_streams; i++) {
+		const AVStream* in = input->streams[i];
+		if (!__remuxable(in))
+			continue;
+
+		if (streams >= _output->nb_streams || !__joinable(in->codecpar, _output->streams[streams]->codecpar))
+			return {};
+
+		streamMap[i] = streams++;
+	}
+
+	if (streams != _output->nb_streams)
+		return {};
+
+	return streamMap;
+}
+
+bool FFmpegRemuxer::compatible(const std::string& inputPath) const
+{
+	if (!_output)
+		return true;
+
+	return !streamMap(openInput(inputPath).get()).empty();
+}
+
+bool FFmpegRemuxer::joinable(const std::string& inputPath, const std::string& otherPath)
+{
+	InputPtr input = openInput(inputPath);
+	InputPtr other = openInput(otherPath);
+	auto parameters = __remuxableParameters(input.get());
+	auto otherParameters = __remuxableParameters(other.get());
+
+	if (parameters.size() != otherParameters.size())
+		return false;
+
+	for (size_t i = 0; i < parameters.size(); i++) {
+		if (!__joinable(parameters[i], otherParameters[i]))
+			return false;
+	}
+
+	return true;
+}
+
+std::vector<std::pair<double, double>> FFmpegRemuxer::keyFrameRanges(const std::string& inputPath,
+	const std::vector<std::pair<double, double>>& ranges)
+{
+	InputPtr input = openInput(inputPath);
+
+	// every audio frame is a key frame
+	int index = av_find_best_stream(input.get(), AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+	if (index < 0)
+		return ranges;
+
+	const AVStream* stream = input->streams[index];
+	int64_t origin = (input->start_time == AV_NOPTS_VALUE) ? 0 : input->start_time;
+
+	auto freePacket = [](AVPacket* packet) { av_packet_free(&packet); };
+	std::unique_ptr<AVPacket, decltype(freePacket)> packet(av_packet_alloc(), freePacket);
+	if (!packet)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate a packet");
+
+	std::vector<std::pair<double, double>> keyFrameRanges;
+	for (const auto& [ startSec, endSec ] : ranges) {
+		int64_t start = av_rescale_q(origin + std::llround(startSec * AV_TIME_BASE), AV_TIME_BASE_Q, stream->time_base);
+		int ret = av_seek_frame(input.get(), index, start, AVSEEK_FLAG_BACKWARD);
+		if (ret < 0)
+			throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("av_seek_frame()", ret));
+
+		// only the packets of the range are read, the end of the media stands for the last key frame
+		double from = NAN;
+		double to = INFINITY;
+		while (av_read_frame(input.get(), packet.get()) >= 0) {
+			bool key = (packet->stream_index == index && (packet->flags & AV_PKT_FLAG_KEY) && packet->pts != AV_NOPTS_VALUE);
+			double sec = key ? (av_rescale_q(packet->pts, stream->time_base, AV_TIME_BASE_Q) - origin) / static_cast<double>(AV_TIME_BASE) : 0;
+			av_packet_unref(packet.get());
+
+			if (!key)
+				continue;
+
+			if (std::isnan(from)) {
+				from = std::min(sec, startSec);
+			} else if (sec >= endSec) {
+				to = sec;
+				break;
+			}
+		}
+
+		keyFrameRanges.push_back({ std::isnan(from) ? startSec : from, to });
+	}
+
+	return keyFrameRanges;
+}
+
+void FFmpegRemuxer::append(const std::string& inputPath, double startSec, double endSec)
+{
+	InputPtr input = openInput(inputPath);
+
+	if (!_output) {
+		try {
+			openOutput(input.get());
+		} catch (...) {
+			discard();
+			throw;
+		}
+	}
+
+	std::vector<int> outputStreams = streamMap(input.get());
+	if (outputStreams.empty())
+		throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, "the codec parameters of " + inputPath + " don't match the output");
+
+	size_t streams = _output->nb_streams;
+
+	int64_t origin = (input->start_time == AV_NOPTS_VALUE) ? 0 : input->start_time;
+	int64_t start = origin + std::llround(startSec * AV_TIME_BASE);
+	int64_t end = origin + std::llround(endSec * AV_TIME_BASE);
+
+	int ret = av_seek_frame(input.get(), -1, start, AVSEEK_FLAG_BACKWARD);
+	if (ret < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("av_seek_frame()", ret));
+
+	Range range;
+	range.started.resize(streams);
+	range.waiting = streams;
+	range.position = _position;
+	std::vector<bool> done(streams);
+	size_t remaining = streams;
+
+	// the key frames of another encode carry its parameter sets, the next key frame of the output gets its own back
+	std::vector<std::vector<uint8_t>> parameterSets(streams);
+	std::vector<bool> foreign(streams);
+	for (unsigned int i = 0; i < input->nb_streams; i++) {
+		int index = outputStreams[i];
+		if (index < 0)
+			continue;
+
+		const AVCodecParameters* out = _output->streams[index]->codecpar;
+		int nalLengthSize = 0;
+		if (!__sameExtradata(input->streams[i]->codecpar, out)) {
+			foreign[index] = true;
+			parameterSets[index] = FFmpegSmartCut::parameterSets(input->streams[i]->codecpar, &nalLengthSize);
+		} else if (_reencoded[index] && !_smart) {
+			parameterSets[index] = FFmpegSmartCut::parameterSets(out, &nalLengthSize);
+		}
+	}
+
+	std::vector<std::unique_ptr<FFmpegSmartCut>> smartCuts(streams);
+	for (unsigned int i = 0; _smart && i < input->nb_streams; i++) {
+		const AVStream* in = input->streams[i];
+		int index = outputStreams[i];
+		if (index < 0 || foreign[index] || in->codecpar->codec_type != AVMEDIA_TYPE_VIDEO)
+			continue;
+
+		if (!FFmpegSmartCut::supported(in->codecpar)) {
+			std::cout << "smart cut: " << avcodec_get_name(in->codecpar->codec_id) << " is cut at the key frames" << std::endl;
+			continue;
+		}
+
+		smartCuts[index] = std::make_unique<FFmpegSmartCut>(in,
+			av_rescale_q(start, AV_TIME_BASE_Q, in->time_base), av_rescale_q(end, AV_TIME_BASE_Q, in->time_base),
+			_reencoded[index], [this, in, index, &range](AVPacket* packet) { write(packet, in->time_base, index, range); });
+	}
+
+	auto freePacket = [](AVPacket* packet) { av_packet_free(&packet); };
+	std::unique_ptr<AVPacket, decltype(freePacket)> packet(av_packet_alloc(), freePacket);
+	if (!packet)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate a packet");
+
+	while (remaining > 0 && av_read_frame(input.get(), packet.get()) >= 0) {
+		int index = outputStreams[packet->stream_index];
+		int64_t ts = (packet->pts != AV_NOPTS_VALUE) ? packet->pts : packet->dts;
+		if (index < 0 || done[index] || ts == AV_NOPTS_VALUE) {
+			av_packet_unref(packet.get());
+			continue;
+		}
+
+		const AVStream* in = input->streams[packet->stream_index];
+		if (smartCuts[index]) {
+			if (!smartCuts[index]->push(packet.get())) {
+				done[index] = true;
+				remaining--;
+			}
+			av_packet_unref(packet.get());
+			continue;
+		}
+
+		int64_t dts = (packet->dts != AV_NOPTS_VALUE) ? packet->dts : ts;
+
+		// the packets come in decoding order, the presentation of a later one may still be in the range
+		if (dts >= av_rescale_q(end, AV_TIME_BASE_Q, in->time_base)) {
+			done[index] = true;
+			remaining--;
+		}
+
+		bool outside = (ts >= av_rescale_q(end, AV_TIME_BASE_Q, in->time_base));
+		// each audio frame can be decoded alone, the frames before the range aren't needed
+		if (_smart && ts + packet->duration <= av_rescale_q(start, AV_TIME_BASE_Q, in->time_base))
+			outside = true;
+
+		if (outside) {
+			av_packet_unref(packet.get());
+			continue;
+		}
+
+		if (!parameterSets[index].empty() && (packet->flags & AV_PKT_FLAG_KEY)) {
+			__prependParameterSets(packet.get(), parameterSets[index]);
+			if (!foreign[index])
+				parameterSets[index].clear();
+		}
+
+		write(packet.get(), in->time_base, index, range);
+	}
+
+	for (size_t index = 0; index < streams; index++) {
+		if (smartCuts[index]) {
+			smartCuts[index]->finish();
+			_reencoded[index] = smartCuts[index]->reencoded();
+		} else if (foreign[index]) {
+			_reencoded[index] = true;
+		} else if (parameterSets[index].empty()) {
+			_reencoded[index] = false;
+		}
+	}
+
+	if (range.origin == AV_NOPTS_VALUE)
+		startRange(range);
+
+	_position = range.position;
+	_ranges++;
+}
+
+FFmpegRemuxer::Range::~Range()
+{
+	for (auto& packet : pending)
+		av_packet_free(&packet);
+}
+
+void FFmpegRemuxer::write(AVPacket* packet, AVRational timeBase, int index, Range& range)
+{
+	av_packet_rescale_ts(packet, timeBase, _output->streams[index]->time_base);
+	packet->stream_index = index;
+	packet->pos = -1;
+
+	if (range.origin != AV_NOPTS_VALUE) {
+		mux(packet, range);
+		return;
+	}
+
+	AVPacket* pending = av_packet_alloc();
+	if (!pending)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate a packet");
+
+	av_packet_move_ref(pending, packet);
+	range.pending.push_back(pending);
+
+	if (!range.started[index]) {
+		range.started[index] = true;
+		range.waiting--;
+	}
+
+	// a stream may start long after the others, or never in the range
+	if (range.waiting == 0 || range.pending.size() >= MAX_PENDING_PACKETS)
+		startRange(range);
+}
+
+void FFmpegRemuxer::startRange(Range& range)
+{
+	// all the streams are shifted together, they stay in sync
+	range.origin = INT64_MAX;
+	for (const auto& packet : range.pending) {
+		int64_t dts = (packet->dts != AV_NOPTS_VALUE) ? packet->dts : packet->pts;
+		range.origin = std::min(range.origin, av_rescale_q(dts, _output->streams[packet->stream_index]->time_base, AV_TIME_BASE_Q));
+	}
+
+	if (range.pending.empty())
+		range.origin = 0;
+
+	for (auto& packet : range.pending) {
+		mux(packet, range);
+		av_packet_free(&packet);
+	}
+	range.pending.clear();
+}
+
+void FFmpegRemuxer::mux(AVPacket* packet, Range& range)
+{
+	int index = packet->stream_index;
+	const AVStream* out = _output->streams[index];
+
+	int64_t offset = av_rescale_q(_position - range.origin, AV_TIME_BASE_Q, out->time_base);
+	if (packet->pts != AV_NOPTS_VALUE)
+		packet->pts += offset;
+	if (packet->dts != AV_NOPTS_VALUE)
+		packet->dts += offset;
+
+	int64_t dts = (packet->dts != AV_NOPTS_VALUE) ? packet->dts : packet->pts;
+	if (_lastDts[index] != AV_NOPTS_VALUE && dts <= _lastDts[index]) {
+		// the end of the previous range overlaps, e.g. with an audio frame across the cut
+		std::cout << "remuxer: drop the packet at " << dts << " of the stream " << index << std::endl;
+		av_packet_unref(packet);
+		return;
+	}
+	_lastDts[index] = dts;
+
+	int64_t ts = std::max(dts, (packet->pts != AV_NOPTS_VALUE) ? packet->pts : dts);
+	range.position = std::max(range.position, av_rescale_q(ts + packet->duration, out->time_base, AV_TIME_BASE_Q));
+
+	int ret = av_interleaved_write_frame(_output, packet);
+	if (ret < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("av_interleaved_write_frame()", ret));
+}
+
+void FFmpegRemuxer::finish()
+{
+	if (!_output)
+		return;
+
+	int ret = av_write_trailer(_output);
+	close();
+
+	if (ret < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("av_write_trailer()", ret));
+}
+
+void FFmpegRemuxer::discard()
+{
+	if (!_output)
+		return;
+
+	close();
+	remove(_outputPath.c_str());
+}
+
+void FFmpegRemuxer::close()
+{
+	if (_output->pb)
+		avio_closep(&_output->pb);
+
+	avformat_free_context(_output);
+	_output = nullptr;
+	_reencoded.clear();
+	_lastDts.clear();
+	_position = 0;
+	_ranges = 0;
+}
@@ -14,7 +14,11 @@
  * limitations under the License.
  */
 
+#include <set>
+
 #include "ffmpegEffect.h"
+#include "ffmpegRemuxer.h"
+#include "ffmpegWorkerPool.h"
 
 using namespace ovi;
 
@@ -27,20 +31,28 @@ public:
 	int setAttrs(const std::map<std::string, std::string>& attrs) override;
 	void validateEffectAttrs(const std::map<std::string, std::string>& attrs) override;
 	void render(timelineRetainer otioTimeline) override;
+	bool streamable() override { return true; }
+	void renderClip(clipRetainer clip) override;
+	void discardClips() override;
 	MetaForm effectMetaForm(const std::string& effectName) override;
 	static std::string makeDescription();
 
 private:
 	void cut();
+	void cutClip(const clipRetainer& clip, const std::string& inputPath);
+	void appendClip(const std::string& inputPath, double startSec, double endSec);
 	bool valid(const std::map<std::string, std::string>& attrs, const std::string& key);
-	std::string toTimeString(double time);
 
 	timelineRetainer _otioTimeline;
 	std::string _outputPath;
 	std::unique_ptr<FFmpegEffect> _effect;
 	std::unique_ptr<AttributeValidator>_attrsValidator;
-	std::string _effectOutputPath;
-
+	std::unique_ptr<FFmpegRemuxer> _remuxer;
+	std::unique_ptr<FFmpegWorkerPool> _pool;
+	std::string _mode = "copy";
+	int _workers {};
+	int _streamedClips {};
+	bool _streamedEffects {};	// the clips after the first one with effects wait for render()
 };
 
 FFmpegRender::FFmpegRender()
@@ -55,11 +67,31 @@ bool FFmpegRender::valid(const std::map<std::string, std::string>& attrs, const
 
 int FFmpegRender::setAttrs(const std::map<std::string, std::string>& attrs)
 {
-	if (!valid(attrs, "path"))
+	// the attributes not given keep their values, the core sets the path after the application
+	std::string path = valid(attrs, "path") ? attrs.at("path") : _outputPath;
+	std::string mode = valid(attrs, "mode") ? attrs.at("mode") : _mode;
+	if (mode != "copy" && mode != "smart")
 		return OVI_ERROR_INVALID_PARAMETER;
 
-	_outputPath = attrs.at("path");
-	std::cout << "outputPath:" << _outputPath << std::endl;
+	int workers = _workers;
+	if (valid(attrs, "workers")) {
+		try {
+			workers = std::stoi(attrs.at("workers"));
+		} catch (const std::exception& e) {
+			return OVI_ERROR_INVALID_PARAMETER;
+		}
+		if (workers < 0)
+			return OVI_ERROR_INVALID_PARAMETER;
+	}
+
+	_outputPath = path;
+	_mode = mode;
+	_workers = workers;
+	// render() fails without the path
+	if (!_outputPath.empty())
+		_remuxer = std::make_unique<FFmpegRemuxer>(_outputPath, mode == "smart");
+	_pool = std::make_unique<FFmpegWorkerPool>(workers);
+	std::cout << "outputPath:" << _outputPath << ", mode:" << mode << ", workers:" << _pool->workers() << std::endl;
 
 	return OVI_ERROR_NONE;
 }
@@ -69,90 +101,53 @@ void FFmpegRender::validateEffectAttrs(const std::map<std::string, std::string>&
 	return _attrsValidator->validate(attrs);
 }
 
-std::string FFmpegRender::toTimeString(double time)
+void FFmpegRender::cutClip(const clipRetainer& clip, const std::string& inputPath)
 {
-	char timestring[20];
+	auto start = clip->trimmed_range().start_time();
+	auto end = clip->trimmed_range().duration() + start;
 
-	int ms = static_cast<int>(time * 1000.);
-	int h = ms / (1000 * 60 * 60);
-	ms -= h * (1000 * 60 * 60);
-
-	int m = ms / (1000 * 60);
-	ms -= m * (1000 * 60);
-
-	int s = ms / 1000;
-	ms -= s * 1000;
-
-	snprintf(timestring, 20, "%.2d:%.2d:%.2d.%.3d", h%100, m%100, s%100, ms%1000);
+	appendClip(inputPath, start.to_seconds(), end.to_seconds());
+}
 
-	return timestring;
+void FFmpegRender::appendClip(const std::string& inputPath, double startSec, double endSec)
+{
+	std::cout << "ffmpegRender cut:" << inputPath << " " << startSec << "~" << endSec << std::endl;
+	_remuxer->append(inputPath, startSec, endSec);
 }
 
 void FFmpegRender::cut()
 {
 	const std::vector<clipRetainer> clips = _otioTimeline->find_clips();
-	int len = 0;
-	char tmp[30];
 
 	if (clips.empty()) {
 		std::cout << "No clips" << std::endl;
 		return;
 	}
 
-	for (const auto& clip : clips) {
-		auto end = clip->trimmed_range().duration() + clip->trimmed_range().start_time();
-		auto ex = dynamic_cast<otio::ExternalReference*>(clip->media_reference());
-		assert(ex);
-
-		std::string cmd;
-		cmd += "/usr/bin/ffmpeg -y -ss ";
-		cmd += toTimeString(clip->trimmed_range().start_time().to_seconds());
-		cmd += " -to ";
-		cmd += toTimeString(end.to_seconds());
-		cmd += " -i ";
-		cmd += _effectOutputPath.empty()? ex->target_url() : _effectOutputPath;
-		cmd += " -c copy ";
-		len++;
-		snprintf(tmp, 30, "tmp_%.3d.mp4", len);
-		cmd += tmp;
-
-		std::cout << "ffmpegRender cmd:" << cmd << std::endl;
-		int ret = system(cmd.c_str());
-		if (ret == 127 || ret == -1)
-			std::cout << "system error:" << ret << std::endl;
+	// the clips muxed while streaming have no effects, they are the first segments
+	const auto& segments = _effect->segments();
+	std::set<std::string> checked;
+	for (size_t i = _remuxer->ranges(); i < segments.size() && _remuxer->ranges() > 0; i++) {
+		if (checked.insert(segments[i].path).second && !_remuxer->compatible(segments[i].path)) {
+			std::cout << "the effect output can't be joined to the streamed clips" << std::endl;
+			_remuxer->discard();
+		}
 	}
 
-	if (len == 1) {
-		snprintf(tmp, 30, "tmp_%.3d.mp4", len);
-		rename(tmp, _outputPath.c_str());
-		return;
-	}
+	// in the order of the timeline, whatever order the workers finished in
+	for (size_t i = _remuxer->ranges(); i < segments.size(); i++)
+		appendClip(segments[i].path, segments[i].startSec, segments[i].endSec);
 
-	std::string concat = "/usr/bin/ffmpeg -y";
-	for (int i = 1; i <= len; i++) {
-		concat += " -i ";
-		snprintf(tmp, 30, "tmp_%.3d.mp4", i);
-		concat += tmp;
-	}
-	concat += " -filter_complex \"";
-	for (int i = 0; i < len; i++) {
-		snprintf(tmp, 30, "[%d:v] [%d:a] ", i%100, i%100);
-		concat += tmp;
-	}
-	concat += "concat=n=";
-	concat += std::to_string(len);
-	concat += ":v=1:a=1 [vv] [aa]\" -map \"[vv]\" -map \"[aa]\" ";
-	concat += _outputPath;
-
-	std::cout << "ffmpegRender concat:" << concat << std::endl;
-	int ret = system(concat.c_str());
-	if (ret == 127 || ret == -1)
-		std::cout << "system error:" << ret << std::endl;
-
-	for (int i = 1; i <= len; i++) {
-		snprintf(tmp, 30, "tmp_%.3d.mp4", i);
-		remove(tmp);
+	for (size_t i = _remuxer->ranges(); segments.empty() && i < clips.size(); i++) {
+		auto ex = dynamic_cast<otio::ExternalReference*>(clips[i]->media_reference());
+		assert(ex);
+
+		cutClip(clips[i], ex->target_url());
 	}
+
+	_remuxer->finish();
+	_streamedClips = 0;
+	_streamedEffects = false;
 }
 
 void FFmpegRender::render(timelineRetainer otioTimeline)
@@ -164,12 +159,40 @@ void FFmpegRender::render(timelineRetainer otioTimeline)
 	// TEMP: For debugging
 	_otioTimeline->to_json_file(_outputPath + ".otio");
 
-	_effect = std::make_unique<FFmpegEffect>(_otioTimeline);
-	_effectOutputPath = _effect->outputPath();
+	if (static_cast<size_t>(_streamedClips) != _otioTimeline->find_clips().size())
+		discardClips();
+
+	_effect = std::make_unique<FFmpegEffect>(_otioTimeline, *_pool);
 	cut();
 
-	if (!_effectOutputPath.empty())
-		remove(_effectOutputPath.c_str());
+	// removes the clips with effects
+	_effect.reset();
+}
+
+void FFmpegRender::renderClip(clipRetainer clip)
+{
+	_streamedClips++;
+
+	// the effects are applied to the whole media at the end, the clips are muxed in order
+	if (!clip->effects().empty())
+		_streamedEffects = true;
+
+	if (_streamedEffects || !_remuxer)
+		return;
+
+	auto ex = dynamic_cast<otio::ExternalReference*>(clip->media_reference());
+	assert(ex);
+
+	cutClip(clip, ex->target_url());
+}
+
+void FFmpegRender::discardClips()
+{
+	if (_remuxer)
+		_remuxer->discard();
+
+	_streamedClips = 0;
+	_streamedEffects = false;
 }
 
 MetaForm FFmpegRender::effectMetaForm(const std::string& effectName)
@@ -258,6 +281,8 @@ extern "C" void *attributeList()
 {
 	static std::vector<Attribute> attrs {
 		{ "path", "string", "output file path" },
+		{ "mode", "string", "copy (default): cut at the key frames, smart: cut at the frames, re-encoding the partial GOPs at the clip ends" },
+		{ "workers", "int", "clips transcoded at the same time for the effects, 0: as many as the CPUs (default: render_workers of the configuration)" },
 	};
 
 	return &attrs;
@@ -0,0 +1,406 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include "Exception.h"
+#include "ffmpegSmartCut.h"
+
+using namespace ovi;
+
+static std::string __errorString(const std::string& function, int err)
+{
+	char errorStr[AV_ERROR_MAX_STRING_SIZE] = {0};
+	av_make_error_string(errorStr, AV_ERROR_MAX_STRING_SIZE, err);
+	return "failed to " + function + ". err:" + errorStr;
+}
+
+static bool __startCode(const uint8_t* data, int size, int pos)
+{
+	return pos + 3 <= size && data[pos] == 0 && data[pos + 1] == 0 && data[pos + 2] == 1;
+}
+
+static void __appendNal(std::vector<uint8_t>& out, const uint8_t* nal, int nalSize, int lengthSize)
+{
+	for (int i = lengthSize - 1; i >= 0; i--)
+		out.push_back((nalSize >> (8 * i)) & 0xff);
+
+	out.insert(out.end(), nal, nal + nalSize);
+}
+
+std::vector<uint8_t> FFmpegSmartCut::parameterSets(const AVCodecParameters* par, int* nalLengthSize)
+{
+	const uint8_t* data = par->extradata;
+	int size = par->extradata_size;
+
+	*nalLengthSize = 0;
+	if (!data || size < 4)
+		return {};
+
+	if (__startCode(data, size, 0) || (data[0] == 0 && __startCode(data, size, 1)))
+		return std::vector<uint8_t>(data, data + size);
+
+	std::vector<uint8_t> sets;
+	int lengthSize = 0;
+	int pos = 0;
+
+	auto readNals = [&](int count) {
+		for (int i = 0; i < count; i++) {
+			if (pos + 2 > size)
+				return false;
+
+			int nalSize = (data[pos] << 8) | data[pos + 1];
+			pos += 2;
+			if (pos + nalSize > size)
+				return false;
+
+			__appendNal(sets, data + pos, nalSize, lengthSize);
+			pos += nalSize;
+		}
+
+		return true;
+	};
+
+	if (par->codec_id == AV_CODEC_ID_H264) {
+		if (size < 7)
+			return {};
+
+		lengthSize = (data[4] & 0x3) + 1;
+		pos = 6;
+		// the sequence, then the picture parameter sets
+		if (!readNals(data[5] & 0x1f) || pos >= size)
+			return {};
+
+		int count = data[pos++];
+		if (!readNals(count))
+			return {};
+	} else {
+		if (size < 23)
+			return {};
+
+		lengthSize = (data[21] & 0x3) + 1;
+		int arrays = data[22];
+		pos = 23;
+		for (int i = 0; i < arrays; i++) {
+			if (pos + 3 > size)
+				return {};
+
+			int count = (data[pos + 1] << 8) | data[pos + 2];
+			pos += 3;
+			if (!readNals(count))
+				return {};
+		}
+	}
+
+	*nalLengthSize = lengthSize;
+	return sets;
+}
+
+/* Replaces the start codes of an encoded packet by the NAL lengths of the stream. */
+static std::vector<uint8_t> __lengthPrefixed(const uint8_t* data, int size, int lengthSize)
+{
+	std::vector<uint8_t> out;
+	int pos = 0;
+
+	while (pos < size && !__startCode(data, size, pos))
+		pos++;
+
+	while (pos < size) {
+		int nal = pos + 3;
+		int next = nal;
+		while (next < size && !__startCode(data, size, next))
+			next++;
+
+		// the zeros before the next start code aren't part of the NAL unit
+		int nalEnd = next;
+		while (nalEnd > nal && data[nalEnd - 1] == 0)
+			nalEnd--;
+
+		__appendNal(out, data + nal, nalEnd - nal, lengthSize);
+		pos = next;
+	}
+
+	return out;
+}
+
+bool FFmpegSmartCut::supported(const AVCodecParameters* par)
+{
+	return par->codec_id == AV_CODEC_ID_H264 || par->codec_id == AV_CODEC_ID_HEVC;
+}
+
+FFmpegSmartCut::FFmpegSmartCut(const AVStream* stream, int64_t start, int64_t end, bool reencoded, Writer writer)
+	: _stream(stream)
+	, _start(start)
+	, _end(end)
+	, _reencoded(reencoded)
+	, _writer(std::move(writer))
+{
+	_parameterSets = parameterSets(stream->codecpar, &_nalLengthSize);
+}
+
+FFmpegSmartCut::~FFmpegSmartCut()
+{
+	for (auto& packet : _gop)
+		av_packet_free(&packet);
+
+	avcodec_free_context(&_decoder);
+	avcodec_free_context(&_encoder);
+}
+
+bool FFmpegSmartCut::push(const AVPacket* packet)
+{
+	bool key = packet->flags & AV_PKT_FLAG_KEY;
+
+	// the frames before the first key frame can't be decoded
+	if (_gop.empty() && !key)
+		return true;
+
+	if (key && !_gop.empty()) {
+		flushGop();
+
+		int64_t ts = (packet->pts != AV_NOPTS_VALUE) ? packet->pts : packet->dts;
+		if (ts >= _end)
+			return false;
+	}
+
+	AVPacket* clone = av_packet_clone(packet);
+	if (!clone)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to clone a packet");
+
+	_gop.push_back(clone);
+	return true;
+}
+
+void FFmpegSmartCut::finish()
+{
+	if (!_gop.empty())
+		flushGop();
+}
+
+void FFmpegSmartCut::flushGop()
+{
+	int64_t first = INT64_MAX;
+	int64_t last = INT64_MIN;
+
+	for (const auto& packet : _gop) {
+		int64_t ts = (packet->pts != AV_NOPTS_VALUE) ? packet->pts : packet->dts;
+		first = std::min(first, ts);
+		last = std::max(last, ts);
+	}
+
+	const AVPacket* key = _gop.front();
+	if (key->pts != AV_NOPTS_VALUE && key->dts != AV_NOPTS_VALUE)
+		_delay = std::max(_delay, key->pts - key->dts);
+
+	if (last < _start)
+		std::cout << "smart cut: skip the GOP at " << first << std::endl;
+	else if (first >= _start && last < _end)
+		copy();
+	else
+		reencode();
+
+	for (auto& packet : _gop)
+		av_packet_free(&packet);
+	_gop.clear();
+}
+
+void FFmpegSmartCut::copy()
+{
+	for (size_t i = 0; i < _gop.size(); i++) {
+		AVPacket* packet = _gop[i];
+
+		// the decoder still has the parameter sets of the encoder
+		if (i == 0 && _reencoded && !_parameterSets.empty()) {
+			std::vector<uint8_t> data(_parameterSets);
+			data.insert(data.end(), packet->data, packet->data + packet->size);
+			writeData(packet, data);
+		} else {
+			_writer(packet);
+		}
+	}
+
+	_reencoded = false;
+}
+
+void FFmpegSmartCut::reencode()
+{
+	if (_decoder)
+		avcodec_flush_buffers(_decoder);
+	else
+		openDecoder();
+
+	for (const auto& packet : _gop)
+		decode(packet);
+	decode(nullptr);
+
+	// the next copied GOP needs the decoding order of the stream, the encoder is drained here
+	closeEncoder();
+}
+
+void FFmpegSmartCut::openDecoder()
+{
+	const AVCodec* codec = avcodec_find_decoder(_stream->codecpar->codec_id);
+	if (!codec)
+		throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, std::string("no decoder for ") + avcodec_get_name(_stream->codecpar->codec_id));
+
+	_decoder = avcodec_alloc_context3(codec);
+	if (!_decoder)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate the decoder");
+
+	int ret = avcodec_parameters_to_context(_decoder, _stream->codecpar);
+	if (ret < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("avcodec_parameters_to_context()", ret));
+
+	_decoder->pkt_timebase = _stream->time_base;
+
+	ret = avcodec_open2(_decoder, codec, nullptr);
+	if (ret < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("avcodec_open2()", ret));
+}
+
+void FFmpegSmartCut::decode(const AVPacket* packet)
+{
+	int ret = avcodec_send_packet(_decoder, packet);
+	if (ret < 0) {
+		// like ffmpeg, a broken packet loses its frames, not the cut
+		std::cout << "smart cut: " << __errorString("avcodec_send_packet()", ret) << std::endl;
+		return;
+	}
+
+	auto freeFrame = [](AVFrame* frame) { av_frame_free(&frame); };
+	std::unique_ptr<AVFrame, decltype(freeFrame)> frame(av_frame_alloc(), freeFrame);
+	if (!frame)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate a frame");
+
+	while ((ret = avcodec_receive_frame(_decoder, frame.get())) >= 0) {
+		int64_t pts = frame->best_effort_timestamp;
+		if (pts != AV_NOPTS_VALUE && pts >= _start && pts < _end) {
+			frame->pts = pts;
+			// the encoder chooses the picture types
+			frame->pict_type = AV_PICTURE_TYPE_NONE;
+			encode(frame.get());
+		}
+		av_frame_unref(frame.get());
+	}
+
+	if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("avcodec_receive_frame()", ret));
+}
+
+void FFmpegSmartCut::openEncoder(const AVFrame* frame)
+{
+	const AVCodecParameters* par = _stream->codecpar;
+	const AVCodec* codec = avcodec_find_encoder(par->codec_id);
+	if (!codec)
+		throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, std::string("no encoder for ") + avcodec_get_name(par->codec_id));
+
+	_encoder = avcodec_alloc_context3(codec);
+	if (!_encoder)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate the encoder");
+
+	_encoder->width = frame->width;
+	_encoder->height = frame->height;
+	_encoder->pix_fmt = static_cast<AVPixelFormat>(frame->format);
+	_encoder->sample_aspect_ratio = frame->sample_aspect_ratio;
+	_encoder->color_range = par->color_range;
+	_encoder->color_primaries = par->color_primaries;
+	_encoder->color_trc = par->color_trc;
+	_encoder->colorspace = par->color_space;
+	_encoder->time_base = _stream->time_base;
+	_encoder->framerate = _stream->avg_frame_rate;
+	_encoder->bit_rate = par->bit_rate;
+	_encoder->profile = par->profile;
+	_encoder->level = par->level;
+	// the presentation order is the decoding order, see writeEncoded()
+	_encoder->max_b_frames = 0;
+	// without AV_CODEC_FLAG_GLOBAL_HEADER, the parameter sets are put in the key frames
+
+	int ret = avcodec_open2(_encoder, codec, nullptr);
+	if (ret < 0)
+		throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, __errorString("avcodec_open2()", ret));
+}
+
+void FFmpegSmartCut::encode(AVFrame* frame)
+{
+	if (frame && !_encoder)
+		openEncoder(frame);
+
+	if (!_encoder)
+		return;
+
+	int ret = avcodec_send_frame(_encoder, frame);
+	if (ret < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("avcodec_send_frame()", ret));
+
+	auto freePacket = [](AVPacket* packet) { av_packet_free(&packet); };
+	std::unique_ptr<AVPacket, decltype(freePacket)> packet(av_packet_alloc(), freePacket);
+	if (!packet)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate a packet");
+
+	while ((ret = avcodec_receive_packet(_encoder, packet.get())) >= 0)
+		writeEncoded(packet.get());
+
+	if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("avcodec_receive_packet()", ret));
+}
+
+void FFmpegSmartCut::closeEncoder()
+{
+	if (!_encoder)
+		return;
+
+	encode(nullptr);
+	avcodec_free_context(&_encoder);
+}
+
+void FFmpegSmartCut::writeEncoded(AVPacket* packet)
+{
+	if (packet->duration == 0 && _stream->avg_frame_rate.num > 0)
+		packet->duration = av_rescale_q(1, av_inv_q(_stream->avg_frame_rate), _stream->time_base);
+
+	// the copied packets around keep the decoding delay of the stream
+	packet->dts = packet->pts - _delay;
+	_reencoded = true;
+
+	if (_nalLengthSize == 0) {
+		_writer(packet);
+		return;
+	}
+
+	writeData(packet, __lengthPrefixed(packet->data, packet->size, _nalLengthSize));
+	av_packet_unref(packet);
+}
+
+void FFmpegSmartCut::writeData(const AVPacket* props, const std::vector<uint8_t>& data)
+{
+	auto freePacket = [](AVPacket* packet) { av_packet_free(&packet); };
+	std::unique_ptr<AVPacket, decltype(freePacket)> packet(av_packet_alloc(), freePacket);
+	if (!packet || av_new_packet(packet.get(), data.size()) < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate a packet");
+
+	memcpy(packet->data, data.data(), data.size());
+	av_packet_copy_props(packet.get(), props);
+	_writer(packet.get());
+}
@@ -0,0 +1,510 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/pixdesc.h>
+}
+
+#include <cinttypes>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+#include "Exception.h"
+#include "ffmpegTranscoder.h"
+
+using namespace ovi;
+
+#define NEW_CHANNEL_LAYOUT (LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100))
+
+static std::string __errorString(const std::string& function, int err)
+{
+	char errorStr[AV_ERROR_MAX_STRING_SIZE] = {0};
+	av_make_error_string(errorStr, AV_ERROR_MAX_STRING_SIZE, err);
+	return "failed to " + function + ". err:" + errorStr;
+}
+
+static void __check(const std::string& function, int ret)
+{
+	if (ret < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString(function, ret));
+}
+
+template <typename T>
+static T __supportedFormat(const T* formats, T format, T none)
+{
+	if (!formats)
+		return format;
+
+	for (const T* f = formats; *f != none; f++) {
+		if (*f == format)
+			return format;
+	}
+
+	return formats[0];
+}
+
+/* the format of the encoder the processor can edit, the chosen one if possible */
+static AVPixelFormat __processedFormat(const AVPixelFormat* formats, AVPixelFormat format, const IFrameProcessor& processor)
+{
+	if (processor.supported(format))
+		return format;
+
+	if (!formats)
+		return processor.supported(AV_PIX_FMT_YUV420P) ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_NONE;
+
+	for (const AVPixelFormat* f = formats; *f != AV_PIX_FMT_NONE; f++) {
+		if (processor.supported(*f))
+			return *f;
+	}
+
+	return AV_PIX_FMT_NONE;
+}
+
+FFmpegTranscoder::FFmpegTranscoder(const std::string& inputPath, const std::string& outputPath)
+	: _inputPath(inputPath)
+	, _outputPath(outputPath)
+{
+}
+
+FFmpegTranscoder::~FFmpegTranscoder()
+{
+	release(_video);
+	release(_audio);
+
+	avformat_close_input(&_input);
+
+	if (_output) {
+		if (_output->pb)
+			avio_closep(&_output->pb);
+		avformat_free_context(_output);
+	}
+}
+
+void FFmpegTranscoder::release(Stream& stream)
+{
+	avcodec_free_context(&stream.decoder);
+	avcodec_free_context(&stream.encoder);
+	avfilter_graph_free(&stream.graph);
+}
+
+void FFmpegTranscoder::setRange(double startSec, double endSec)
+{
+	_ranged = true;
+	_startSec = startSec;
+	_endSec = endSec;
+}
+
+void FFmpegTranscoder::transcode(const std::string& videoGraph, const std::string& audioGraph, IFrameProcessor* processor)
+{
+	_processor = processor;
+
+	open();
+	// the pictures are decoded for the processor even without filters, and a range is cut at the frames
+	addStream(_video, AVMEDIA_TYPE_VIDEO, (videoGraph.empty() && (processor || _ranged)) ? "[in]null[out]" : videoGraph);
+	addStream(_audio, AVMEDIA_TYPE_AUDIO, (audioGraph.empty() && _ranged) ? "[in]anull[out]" : audioGraph);
+	if (_video.input < 0 && _audio.input < 0)
+		throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, "no stream to transcode in " + _inputPath);
+
+	openOutput();
+	if (_ranged)
+		seek();
+
+	auto freePacket = [](AVPacket* packet) { av_packet_free(&packet); };
+	std::unique_ptr<AVPacket, decltype(freePacket)> packet(av_packet_alloc(), freePacket);
+	if (!packet)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate a packet");
+
+	while (!finished() && av_read_frame(_input, packet.get()) >= 0) {
+		Stream* stream = nullptr;
+		if (packet->stream_index == _video.input)
+			stream = &_video;
+		else if (packet->stream_index == _audio.input)
+			stream = &_audio;
+
+		if (stream && stream->decoder)
+			process(*stream, packet.get());
+		else if (stream)
+			copy(*stream, packet.get());
+
+		av_packet_unref(packet.get());
+	}
+
+	for (auto stream : { &_video, &_audio }) {
+		if (stream->decoder)
+			process(*stream, nullptr);
+	}
+
+	__check("av_write_trailer()", av_write_trailer(_output));
+}
+
+void FFmpegTranscoder::open()
+{
+	int ret = avformat_open_input(&_input, _inputPath.c_str(), nullptr, nullptr);
+	if (ret < 0)
+		throw Exception(OVI_ERROR_NO_SUCH_FILE, __errorString("avformat_open_input()", ret));
+
+	ret = avformat_find_stream_info(_input, nullptr);
+	if (ret < 0)
+		throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, __errorString("avformat_find_stream_info()", ret));
+
+	ret = avformat_alloc_output_context2(&_output, nullptr, nullptr, _outputPath.c_str());
+	if (ret < 0)
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, __errorString("avformat_alloc_output_context2()", ret));
+}
+
+void FFmpegTranscoder::seek()
+{
+	int64_t origin = (_input->start_time == AV_NOPTS_VALUE) ? 0 : _input->start_time;
+	int ret = av_seek_frame(_input, -1, origin + std::llround(_startSec * AV_TIME_BASE), AVSEEK_FLAG_BACKWARD);
+	if (ret < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("av_seek_frame()", ret));
+}
+
+bool FFmpegTranscoder::finished() const
+{
+	if (!_ranged)
+		return false;
+
+	// every stream is past the end of the range
+	for (auto stream : { &_video, &_audio }) {
+		if (stream->input >= 0 && !stream->finished)
+			return false;
+	}
+
+	return true;
+}
+
+void FFmpegTranscoder::addStream(Stream& stream, int type, const std::string& graph)
+{
+	int index = av_find_best_stream(_input, static_cast<AVMediaType>(type), -1, -1, nullptr, 0);
+	if (index < 0) {
+		if (!graph.empty())
+			std::cout << "no " << av_get_media_type_string(static_cast<AVMediaType>(type)) << " stream for the effects" << std::endl;
+		return;
+	}
+
+	stream.input = index;
+	AVRational timeBase = _input->streams[index]->time_base;
+	if (_input->start_time != AV_NOPTS_VALUE)
+		stream.start = av_rescale_q(_input->start_time, AV_TIME_BASE_Q, timeBase);
+	if (_ranged) {
+		stream.from = av_rescale_q(std::llround(_startSec * AV_TIME_BASE), AV_TIME_BASE_Q, timeBase);
+		stream.to = av_rescale_q(std::llround(_endSec * AV_TIME_BASE), AV_TIME_BASE_Q, timeBase);
+	}
+
+	if (graph.empty())
+		return;
+
+	openDecoder(stream);
+	openGraph(stream, graph);
+	openEncoder(stream);
+}
+
+void FFmpegTranscoder::openDecoder(Stream& stream)
+{
+	const AVStream* in = _input->streams[stream.input];
+	const AVCodec* codec = avcodec_find_decoder(in->codecpar->codec_id);
+	if (!codec)
+		throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, std::string("no decoder for ") + avcodec_get_name(in->codecpar->codec_id));
+
+	stream.decoder = avcodec_alloc_context3(codec);
+	if (!stream.decoder)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate the decoder");
+
+	__check("avcodec_parameters_to_context()", avcodec_parameters_to_context(stream.decoder, in->codecpar));
+	stream.decoder->pkt_timebase = in->time_base;
+	if (in->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+		stream.decoder->framerate = av_guess_frame_rate(_input, const_cast<AVStream*>(in), nullptr);
+
+	stream.decoder->thread_count = _threads;
+	__check("avcodec_open2()", avcodec_open2(stream.decoder, codec, nullptr));
+
+	// the codec of the source when it can be encoded, as ffmpeg would choose for the container otherwise
+	stream.codec = avcodec_find_encoder(in->codecpar->codec_id);
+	if (!stream.codec)
+		stream.codec = avcodec_find_encoder(av_guess_codec(_output->oformat, nullptr, _outputPath.c_str(), nullptr, in->codecpar->codec_type));
+	if (!stream.codec)
+		throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, std::string("no encoder for ") + avcodec_get_name(in->codecpar->codec_id));
+}
+
+void FFmpegTranscoder::openGraph(Stream& stream, const std::string& graph)
+{
+	const AVStream* in = _input->streams[stream.input];
+	AVCodecContext* decoder = stream.decoder;
+	bool video = (decoder->codec_type == AVMEDIA_TYPE_VIDEO);
+	char args[512];
+	std::string format;
+
+	if (video) {
+		AVRational aspect = decoder->sample_aspect_ratio;
+		snprintf(args, sizeof(args), "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
+			decoder->width, decoder->height, decoder->pix_fmt, in->time_base.num, in->time_base.den,
+			aspect.num, aspect.den > 0 ? aspect.den : 1);
+
+		AVPixelFormat pixelFormat = __supportedFormat(stream.codec->pix_fmts, decoder->pix_fmt, AV_PIX_FMT_NONE);
+		if (_processor)
+			pixelFormat = __processedFormat(stream.codec->pix_fmts, pixelFormat, *_processor);
+		if (pixelFormat == AV_PIX_FMT_NONE)
+			throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, std::string("no pixel format of ") + stream.codec->name + " for the effects");
+		format = std::string("pix_fmts=") + av_get_pix_fmt_name(pixelFormat);
+	} else {
+		char layout[64] = {0};
+#if NEW_CHANNEL_LAYOUT
+		if (decoder->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC)
+			av_channel_layout_default(&decoder->ch_layout, decoder->ch_layout.nb_channels);
+		av_channel_layout_describe(&decoder->ch_layout, layout, sizeof(layout));
+#else
+		if (!decoder->channel_layout)
+			decoder->channel_layout = av_get_default_channel_layout(decoder->channels);
+		snprintf(layout, sizeof(layout), "0x%" PRIx64, decoder->channel_layout);
+#endif
+		snprintf(args, sizeof(args), "time_base=%d/%d:sample_rate=%d:sample_fmt=%s:channel_layout=%s",
+			in->time_base.num, in->time_base.den, decoder->sample_rate, av_get_sample_fmt_name(decoder->sample_fmt), layout);
+
+		AVSampleFormat sampleFormat = __supportedFormat(stream.codec->sample_fmts, decoder->sample_fmt, AV_SAMPLE_FMT_NONE);
+		format = std::string("sample_fmts=") + av_get_sample_fmt_name(sampleFormat);
+	}
+
+	stream.graph = avfilter_graph_alloc();
+	if (!stream.graph)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate the filter graph");
+
+	AVFilterContext* formatFilter = nullptr;
+	__check("avfilter_graph_create_filter(source)", avfilter_graph_create_filter(&stream.source,
+		avfilter_get_by_name(video ? "buffer" : "abuffer"), "in", args, nullptr, stream.graph));
+	__check("avfilter_graph_create_filter(sink)", avfilter_graph_create_filter(&stream.sink,
+		avfilter_get_by_name(video ? "buffersink" : "abuffersink"), "out", nullptr, nullptr, stream.graph));
+	// the frames are converted to a format of the encoder
+	__check("avfilter_graph_create_filter(format)", avfilter_graph_create_filter(&formatFilter,
+		avfilter_get_by_name(video ? "format" : "aformat"), "encoder_format", format.c_str(), nullptr, stream.graph));
+	__check("avfilter_link()", avfilter_link(formatFilter, 0, stream.sink, 0));
+
+	AVFilterInOut* outputs = avfilter_inout_alloc();
+	AVFilterInOut* inputs = avfilter_inout_alloc();
+	if (!outputs || !inputs) {
+		avfilter_inout_free(&outputs);
+		avfilter_inout_free(&inputs);
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate the filter pads");
+	}
+
+	outputs->name = av_strdup("in");
+	outputs->filter_ctx = stream.source;
+	inputs->name = av_strdup("out");
+	inputs->filter_ctx = formatFilter;
+
+	std::cout << "effect graph:" << graph << std::endl;
+	int ret = avfilter_graph_parse_ptr(stream.graph, graph.c_str(), &inputs, &outputs, nullptr);
+	avfilter_inout_free(&outputs);
+	avfilter_inout_free(&inputs);
+	if (ret < 0)
+		throw Exception(OVI_ERROR_INVALID_EFFECT_ATTR_VALUE, __errorString("avfilter_graph_parse_ptr()", ret));
+
+	__check("avfilter_graph_config()", avfilter_graph_config(stream.graph, nullptr));
+}
+
+void FFmpegTranscoder::openEncoder(Stream& stream)
+{
+	const AVStream* in = _input->streams[stream.input];
+	AVCodecContext* encoder = stream.encoder = avcodec_alloc_context3(stream.codec);
+	if (!encoder)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate the encoder");
+
+	if (stream.decoder->codec_type == AVMEDIA_TYPE_VIDEO) {
+		encoder->width = av_buffersink_get_w(stream.sink);
+		encoder->height = av_buffersink_get_h(stream.sink);
+		encoder->pix_fmt = static_cast<AVPixelFormat>(av_buffersink_get_format(stream.sink));
+		encoder->sample_aspect_ratio = av_buffersink_get_sample_aspect_ratio(stream.sink);
+		encoder->framerate = stream.decoder->framerate;
+		encoder->color_range = stream.decoder->color_range;
+		encoder->color_primaries = stream.decoder->color_primaries;
+		encoder->color_trc = stream.decoder->color_trc;
+		encoder->colorspace = stream.decoder->colorspace;
+		// a range encoded like the source can be joined to its copied packets
+		if (stream.codec->id == in->codecpar->codec_id) {
+			encoder->profile = in->codecpar->profile;
+			encoder->level = in->codecpar->level;
+		}
+	} else {
+		encoder->sample_rate = av_buffersink_get_sample_rate(stream.sink);
+		encoder->sample_fmt = static_cast<AVSampleFormat>(av_buffersink_get_format(stream.sink));
+#if NEW_CHANNEL_LAYOUT
+		__check("av_buffersink_get_ch_layout()", av_buffersink_get_ch_layout(stream.sink, &encoder->ch_layout));
+#else
+		encoder->channel_layout = av_buffersink_get_channel_layout(stream.sink);
+		encoder->channels = av_buffersink_get_channels(stream.sink);
+#endif
+	}
+
+	encoder->time_base = av_buffersink_get_time_base(stream.sink);
+	encoder->bit_rate = in->codecpar->bit_rate;
+	if (_output->oformat->flags & AVFMT_GLOBALHEADER)
+		encoder->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+	encoder->thread_count = _threads;
+	__check("avcodec_open2()", avcodec_open2(encoder, stream.codec, nullptr));
+	stream.offset = av_rescale_q(stream.from, in->time_base, encoder->time_base);
+
+	if (encoder->codec_type == AVMEDIA_TYPE_AUDIO && encoder->frame_size > 0 &&
+		!(stream.codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE))
+		av_buffersink_set_frame_size(stream.sink, encoder->frame_size);
+}
+
+void FFmpegTranscoder::openOutput()
+{
+	for (auto stream : { &_video, &_audio }) {
+		if (stream->input < 0)
+			continue;
+
+		const AVStream* in = _input->streams[stream->input];
+		AVStream* out = avformat_new_stream(_output, nullptr);
+		if (!out)
+			throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to add the output stream");
+
+		if (stream->encoder) {
+			__check("avcodec_parameters_from_context()", avcodec_parameters_from_context(out->codecpar, stream->encoder));
+			out->time_base = stream->encoder->time_base;
+		} else {
+			__check("avcodec_parameters_copy()", avcodec_parameters_copy(out->codecpar, in->codecpar));
+			out->codecpar->codec_tag = 0;
+			out->time_base = in->time_base;
+		}
+
+		stream->output = out->index;
+	}
+
+	if (!(_output->oformat->flags & AVFMT_NOFILE)) {
+		int ret = avio_open(&_output->pb, _outputPath.c_str(), AVIO_FLAG_WRITE);
+		if (ret < 0)
+			throw Exception(OVI_ERROR_PERMISSION_DENIED, __errorString("avio_open()", ret));
+	}
+
+	__check("avformat_write_header()", avformat_write_header(_output, nullptr));
+}
+
+void FFmpegTranscoder::process(Stream& stream, AVPacket* packet)
+{
+	int ret = avcodec_send_packet(stream.decoder, packet);
+	if (ret < 0 && ret != AVERROR_EOF) {
+		// like ffmpeg, a broken packet loses its frames, not the output
+		std::cout << "transcoder: " << __errorString("avcodec_send_packet()", ret) << std::endl;
+		return;
+	}
+
+	auto freeFrame = [](AVFrame* frame) { av_frame_free(&frame); };
+	std::unique_ptr<AVFrame, decltype(freeFrame)> frame(av_frame_alloc(), freeFrame);
+	if (!frame)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate a frame");
+
+	while ((ret = avcodec_receive_frame(stream.decoder, frame.get())) >= 0) {
+		frame->pts = frame->best_effort_timestamp;
+		if (frame->pts != AV_NOPTS_VALUE)
+			frame->pts -= stream.start;
+
+		if (_ranged && frame->pts != AV_NOPTS_VALUE) {
+			// the decoding starts at the key frame before the range
+			if (frame->pts >= stream.to)
+				stream.finished = true;
+			if (frame->pts < stream.from || frame->pts >= stream.to) {
+				av_frame_unref(frame.get());
+				continue;
+			}
+		}
+
+		filter(stream, frame.get());
+		av_frame_unref(frame.get());
+	}
+
+	if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("avcodec_receive_frame()", ret));
+
+	// the end of the stream goes through the graph to the encoder
+	if (!packet)
+		filter(stream, nullptr);
+}
+
+void FFmpegTranscoder::filter(Stream& stream, AVFrame* frame)
+{
+	__check("av_buffersrc_add_frame()", av_buffersrc_add_frame_flags(stream.source, frame, 0));
+
+	auto freeFrame = [](AVFrame* frame) { av_frame_free(&frame); };
+	std::unique_ptr<AVFrame, decltype(freeFrame)> filtered(av_frame_alloc(), freeFrame);
+	if (!filtered)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate a frame");
+
+	int ret;
+	while ((ret = av_buffersink_get_frame(stream.sink, filtered.get())) >= 0) {
+		// the encoder chooses the picture types
+		filtered->pict_type = AV_PICTURE_TYPE_NONE;
+		if (_processor && stream.decoder->codec_type == AVMEDIA_TYPE_VIDEO && filtered->pts != AV_NOPTS_VALUE) {
+			// the picture may still be a reference of the decoder
+			__check("av_frame_make_writable()", av_frame_make_writable(filtered.get()));
+			_processor->process(filtered.get(), filtered->pts * av_q2d(av_buffersink_get_time_base(stream.sink)));
+		}
+		encode(stream, filtered.get());
+		av_frame_unref(filtered.get());
+	}
+
+	if (ret == AVERROR_EOF)
+		encode(stream, nullptr);
+	else if (ret != AVERROR(EAGAIN))
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("av_buffersink_get_frame()", ret));
+}
+
+void FFmpegTranscoder::encode(Stream& stream, AVFrame* frame)
+{
+	__check("avcodec_send_frame()", avcodec_send_frame(stream.encoder, frame));
+
+	auto freePacket = [](AVPacket* packet) { av_packet_free(&packet); };
+	std::unique_ptr<AVPacket, decltype(freePacket)> packet(av_packet_alloc(), freePacket);
+	if (!packet)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate a packet");
+
+	int ret;
+	while ((ret = avcodec_receive_packet(stream.encoder, packet.get())) >= 0) {
+		packet->stream_index = stream.output;
+		if (packet->pts != AV_NOPTS_VALUE)
+			packet->pts -= stream.offset;
+		if (packet->dts != AV_NOPTS_VALUE)
+			packet->dts -= stream.offset;
+		av_packet_rescale_ts(packet.get(), stream.encoder->time_base, _output->streams[stream.output]->time_base);
+		__check("av_interleaved_write_frame()", av_interleaved_write_frame(_output, packet.get()));
+	}
+
+	if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, __errorString("avcodec_receive_packet()", ret));
+}
+
+void FFmpegTranscoder::copy(const Stream& stream, AVPacket* packet)
+{
+	if (packet->pts != AV_NOPTS_VALUE)
+		packet->pts -= stream.start;
+	if (packet->dts != AV_NOPTS_VALUE)
+		packet->dts -= stream.start;
+
+	av_packet_rescale_ts(packet, _input->streams[stream.input]->time_base, _output->streams[stream.output]->time_base);
+	packet->stream_index = stream.output;
+	packet->pos = -1;
+
+	__check("av_interleaved_write_frame()", av_interleaved_write_frame(_output, packet));
+}
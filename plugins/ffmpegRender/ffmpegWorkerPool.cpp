@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ffmpegWorkerPool.h"
+
+static int __cpus()
+{
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+FFmpegWorkerPool::FFmpegWorkerPool(int workers)
+	: _workers(workers > 0 ? workers : __cpus())
+{
+}
+
+int FFmpegWorkerPool::threadsPerJob() const
+{
+	return std::max(1, __cpus() / _workers);
+}
+
+void FFmpegWorkerPool::run(size_t jobs, const std::function<void(size_t)>& job)
+{
+	std::atomic<size_t> next {};
+	std::atomic_bool failed {};
+	std::exception_ptr error;
+	std::mutex lock;
+
+	auto worker = [&] {
+		for (size_t i = next++; i < jobs && !failed; i = next++) {
+			try {
+				job(i);
+			} catch (...) {
+				std::lock_guard<std::mutex> guard(lock);
+				if (!error)
+					error = std::current_exception();
+				failed = true;
+			}
+		}
+	};
+
+	// the caller is one of the workers
+	std::vector<std::thread> threads;
+	size_t count = std::min(jobs, static_cast<size_t>(_workers));
+	for (size_t i = 1; i < count; i++)
+		threads.emplace_back(worker);
+
+	worker();
+	for (auto& thread : threads)
+		thread.join();
+
+	if (error)
+		std::rethrow_exception(error);
+}
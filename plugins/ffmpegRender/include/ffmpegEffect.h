@@ -45,17 +45,18 @@ struct DoubleInfo {
 	Timeline time;
 };
 
-struct CmdGenerator
+/* Each filter reads the pad 'in' and writes the pad 'out' of a filter graph. */
+struct FilterGenerator
 {
-	static std::string makeVideoBlurEffectCmd(const std::string& inputPath, const std::string& outputPath, const std::string& blurName, int intensity, std::vector<CoordinateInfo> coordInfo);
-	static std::string makeVideoBoxEffectCmd(const std::string& inputPath, const std::string& outputPath, const std::string& color, int thickness, std::vector<CoordinateInfo> coordInfo);
-	static std::string makeVideoEqEffectCmd(const std::string& inputPath, const std::string& outputPath, const std::string& effectName, double effectValue, std::vector<Timeline> timeInfo);
-	static std::string makeVideoTextEffectCmd(const std::string& inputPath, const std::string& outputPath, const std::string& fontColor, const std::string& fontSize,
-		int x, int y, std::vector<StringInfo> strInfo);
-	static std::string makeVideoStickerEffectCmd(const std::string& inputPath, const std::string& outputPath, const std::string& imgPath, std::vector<CoordinateInfo> _coordInfo);
-	static std::string makeAudioVolumeEffectCmd(const std::string& inputPath, const std::string& outputPath, double volume, std::vector<Timeline> _timeInfo);
+	static std::string makeVideoEqFilter(const std::string& in, const std::string& out, const std::string& effectName, double effectValue, const std::vector<Timeline>& timeInfo);
+	static std::string makeVideoTextFilter(const std::string& in, const std::string& out, const std::string& fontColor, const std::string& fontSize,
+		int x, int y, const std::vector<StringInfo>& strInfo);
+	static std::string makeAudioVolumeFilter(const std::string& in, const std::string& out, double volume, const std::vector<Timeline>& timeInfo);
 };
 
+class FFmpegEffectEngine;
+class FFmpegWorkerPool;
+
 struct FFmpegEffectSpec
 {
 	static std::map<std::string, std::string> descriptions();
@@ -64,17 +65,46 @@ struct FFmpegEffectSpec
 	static MetaForm inputMetaForm(const std::string& effectName);
 };
 
+/* A range of a media, the output is made of the segments of the clips in the order of the timeline. */
+struct Segment {
+	std::string path;
+	double startSec {};
+	double endSec {};
+};
+
+/* Encodes the ranges of the clips of a timeline with effects, in parallel.
+ * The ranges are extended to the key frames around them, the rest of the clips is copied.
+ */
 class FFmpegEffect
 {
 public:
-	explicit FFmpegEffect(timelineRetainer otioTimeline);
-	~FFmpegEffect() = default;
+	FFmpegEffect(timelineRetainer otioTimeline, FFmpegWorkerPool& pool);
+	~FFmpegEffect();
 
-	std::string outputPath() const { return _outputPath; }
+	/* of all the clips, none if no clip has effects */
+	const std::vector<Segment>& segments() const { return _segments; }
 
 private:
-	void applyEffect(const std::string& inputPath, const std::string& outputPath, const std::string& effectName, otio::AnyDictionary& metadata, double rate);
-	void setOutputPath(const std::string& effectName);
+	struct Job {
+		std::string inputPath;
+		double startSec {};
+		double endSec {};
+		std::vector<std::string> videoFilters;
+		std::vector<std::string> audioFilters;
+		std::unique_ptr<FFmpegEffectEngine> engine;
+		std::vector<Timeline> ranges;	// of the effects, then the encoded ones
+		std::vector<Segment> segments;
+	};
+
+	void addEffect(Job& job, const std::string& effectName, otio::AnyDictionary& metadata, double rate);
+	std::string graph(const std::vector<std::string>& filters, const std::string& prefix, const std::string& passthrough);
+	void alignRanges(Job& job);
+	void split(Job& job, size_t index);
+	void run(std::vector<Job>& jobs, FFmpegWorkerPool& pool);
+	bool joinable(const std::vector<Job>& jobs);
+	void transcode(Job& job, const Timeline& range, const std::string& outputPath, int threads);
+	std::string rangePath(size_t index, size_t range);
+	void makeDirectory();
 	std::vector<CoordinateInfo> getCoordInfo(otio::AnyDictionary& metadata, double rate);
 	std::vector<StringInfo> getConvertedStringInfo(otio::AnyDictionary& metadata, double rate);
 	std::vector<DoubleInfo> getDoubleInfo(otio::AnyDictionary& metadata, double rate);
@@ -82,6 +112,7 @@ private:
 
 	std::string popItem(otio::AnyDictionary& metadata, const std::string& key, const std::string& defaultValue);
 
-	std::string _outputPath;
+	std::string _directory;	// of the render, with the encoded ranges
+	std::vector<Segment> _segments;
 };
 #endif // __OPEN_VIDEO_INTELLIGENCE_FFMPEG_EFFECT_H__
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_FFMPEG_EFFECT_ENGINE_H__
+#define __OPEN_VIDEO_INTELLIGENCE_FFMPEG_EFFECT_ENGINE_H__
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "ffmpegEffect.h"
+#include "ffmpegTranscoder.h"
+
+/* Applies the effects on the regions of the decoded YUV pictures, in the pass that
+ * encodes them. The effects of a picture are applied in the order they were added.
+ */
+class FFmpegEffectEngine : public IFrameProcessor
+{
+public:
+	FFmpegEffectEngine() = default;
+	~FFmpegEffectEngine() override;
+
+	/* boxblur, avgblur or gblur */
+	void addBlur(const std::string& blurName, int intensity, const std::vector<CoordinateInfo>& coordInfo);
+	void addMosaic(int size, const std::vector<CoordinateInfo>& coordInfo);
+	void addBox(const std::string& color, int thickness, const std::vector<CoordinateInfo>& coordInfo);
+	void addSticker(const std::string& imgPath, const std::vector<CoordinateInfo>& coordInfo);
+	bool empty() const { return _operations.empty(); }
+
+	bool supported(int pixelFormat) const override;
+	void process(AVFrame* frame, double sec) override;
+
+private:
+	enum Kind {
+		BOX_BLUR,
+		AVERAGE_BLUR,
+		GAUSSIAN_BLUR,
+		MOSAIC,
+		BOX,
+		STICKER
+	};
+
+	struct Operation {
+		Kind kind {};
+		int value {};	// the intensity, block size or thickness
+		uint8_t rgba[4] {};	// of a box
+		size_t sticker {};
+		CoordinateInfo coord;
+	};
+
+	/* the image scaled to a size, in YUVA 4:4:4 at the size of the luma and of the chroma planes */
+	struct Scaled {
+		AVFrame* luma {};
+		AVFrame* chroma {};
+	};
+
+	struct Sticker {
+		AVFrame* image {};
+		std::map<std::tuple<int, int, int, int>, Scaled> scaled;
+	};
+
+	void add(const Operation& operation, const std::vector<CoordinateInfo>& coordInfo);
+	void apply(const Operation& operation, AVFrame* frame);
+	void drawBox(const Operation& operation, AVFrame* frame);
+	void drawSticker(const Operation& operation, AVFrame* frame);
+	const Scaled& scaled(Sticker& sticker, int width, int height, int log2ChromaW, int log2ChromaH);
+	AVFrame* loadImage(const std::string& imgPath);
+
+	std::vector<Operation> _operations;
+	std::vector<Sticker> _stickers;
+	std::vector<size_t> _byStart;	// the operations in the order of their start
+	std::vector<size_t> _active;
+	size_t _next {};
+	double _lastSec {};
+};
+#endif // __OPEN_VIDEO_INTELLIGENCE_FFMPEG_EFFECT_ENGINE_H__
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_FFMPEG_KERNELS_H__
+#define __OPEN_VIDEO_INTELLIGENCE_FFMPEG_KERNELS_H__
+
+#include <cstdint>
+
+/* An 8 bit plane of a picture, the rows are linesize bytes apart. */
+struct Plane {
+	uint8_t* data {};
+	int linesize {};
+	int width {};
+	int height {};
+};
+
+struct Region {
+	int x {};
+	int y {};
+	int w {};
+	int h {};
+};
+
+/* The kernels of the native effects, they edit a region of a plane in place.
+ * The regions are clipped to the plane, and the samples outside of the region are
+ * not read: a blurred region is the same as the blur of its crop.
+ */
+struct FFmpegKernels
+{
+	/* averages over the (2 * radius + 1)² square around each pixel, passes times */
+	static void boxBlur(const Plane& plane, const Region& region, int radius, int passes = 1);
+	/* approximated by three box blurs */
+	static void gaussianBlur(const Plane& plane, const Region& region, double sigma);
+	/* each size x size block takes its average, from the origin of the region */
+	static void mosaic(const Plane& plane, const Region& region, int size);
+	static void fill(const Plane& plane, const Region& region, uint8_t value, uint8_t alpha = 255);
+	/* composes the source at (x, y) of the plane, weighted by the alpha plane of the same size */
+	static void blend(const Plane& plane, int x, int y, const Plane& source, const Plane& alpha);
+};
+#endif // __OPEN_VIDEO_INTELLIGENCE_FFMPEG_KERNELS_H__
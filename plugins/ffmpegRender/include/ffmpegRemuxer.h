@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_FFMPEG_REMUXER_H__
+#define __OPEN_VIDEO_INTELLIGENCE_FFMPEG_REMUXER_H__
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct AVFormatContext;
+struct AVPacket;
+struct AVRational;
+
+/* Muxes ranges of media files into one output without decoding them.
+ * The packets are copied from the key frame at or before the start of each range,
+ * as 'ffmpeg -ss -to -c copy' does, and the timestamps of all the streams are shifted
+ * together so that the ranges follow each other in the output.
+ * All the inputs must have the codec parameters of the first one, an H.264 or HEVC input
+ * of another encode may differ in its parameter sets, they are put in its key frames.
+ * In the smart mode, the partial GOPs at the ends of the video ranges are re-encoded,
+ * the ranges are cut at their frames instead of the key frames.
+ */
+class FFmpegRemuxer
+{
+public:
+	explicit FFmpegRemuxer(const std::string& outputPath, bool smart = false);
+	~FFmpegRemuxer();
+
+	bool compatible(const std::string& inputPath) const;
+	/* the ranges of the two media can follow each other in an output */
+	static bool joinable(const std::string& inputPath, const std::string& otherPath);
+	/* each range from the key frame at or before its start to the first key frame at or after its end,
+	 * INFINITY: the end of the media
+	 */
+	static std::vector<std::pair<double, double>> keyFrameRanges(const std::string& inputPath,
+		const std::vector<std::pair<double, double>>& ranges);
+	void append(const std::string& inputPath, double startSec, double endSec);
+	void finish();
+	void discard();
+	int ranges() const { return _ranges; }
+
+private:
+	using InputPtr = std::unique_ptr<AVFormatContext, std::function<void(AVFormatContext*)>>;
+
+	static constexpr size_t MAX_PENDING_PACKETS = 512;
+
+	struct Range {
+		~Range();
+
+		int64_t origin = INT64_MIN;	// AV_NOPTS_VALUE until the first decoding timestamp of the range is known, in AV_TIME_BASE
+		int64_t position {};	// end of the written packets, in AV_TIME_BASE
+		std::vector<AVPacket*> pending;	// until the origin is known
+		std::vector<bool> started;	// the stream has pending packets
+		size_t waiting {};	// streams without packets
+	};
+
+	static InputPtr openInput(const std::string& inputPath);
+	std::vector<int> streamMap(const AVFormatContext* input) const;
+	void openOutput(AVFormatContext* input);
+	void write(AVPacket* packet, AVRational timeBase, int index, Range& range);
+	void startRange(Range& range);
+	void mux(AVPacket* packet, Range& range);
+	void close();
+
+	std::string _outputPath;
+	bool _smart {};
+	AVFormatContext* _output {};
+	std::vector<bool> _reencoded;	// the last packets of each stream were made by another encoder
+	std::vector<int64_t> _lastDts;	// of each stream, in its time base
+	int64_t _position {};	// end of the muxed ranges, in AV_TIME_BASE
+	int _ranges {};
+};
+#endif // __OPEN_VIDEO_INTELLIGENCE_FFMPEG_REMUXER_H__
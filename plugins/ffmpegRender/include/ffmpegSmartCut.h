@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_FFMPEG_SMART_CUT_H__
+#define __OPEN_VIDEO_INTELLIGENCE_FFMPEG_SMART_CUT_H__
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct AVCodecContext;
+struct AVCodecParameters;
+struct AVFrame;
+struct AVPacket;
+struct AVStream;
+
+/* Cuts a range of a video stream at its frames.
+ * The packets are pushed in decoding order from the key frame at or before the start.
+ * The GOPs inside the range are copied, the frames of the range in the partial GOPs
+ * at its ends are decoded and encoded again with the codec of the stream.
+ * The encoded packets carry their parameter sets, and the ones of the stream are put
+ * back before the next copied key frame, so only H.264 and HEVC are supported.
+ * Closed GOPs are assumed.
+ */
+class FFmpegSmartCut
+{
+public:
+	using Writer = std::function<void(AVPacket*)>;
+
+	FFmpegSmartCut(const AVStream* stream, int64_t start, int64_t end, bool reencoded, Writer writer);
+	~FFmpegSmartCut();
+
+	static bool supported(const AVCodecParameters* par);
+	/* of the avcC or hvcC configuration record, in the NAL format of the stream, 0: start codes */
+	static std::vector<uint8_t> parameterSets(const AVCodecParameters* par, int* nalLengthSize);
+
+	bool push(const AVPacket* packet);	// false once the range is over
+	void finish();
+	bool reencoded() const { return _reencoded; }
+
+private:
+	void flushGop();
+	void copy();
+	void reencode();
+	void openDecoder();
+	void decode(const AVPacket* packet);
+	void openEncoder(const AVFrame* frame);
+	void encode(AVFrame* frame);
+	void closeEncoder();
+	void writeEncoded(AVPacket* packet);
+	void writeData(const AVPacket* props, const std::vector<uint8_t>& data);
+
+	const AVStream* _stream {};
+	int64_t _start {};	// in the time base of the stream
+	int64_t _end {};
+	bool _reencoded {};
+	Writer _writer;
+
+	AVCodecContext* _decoder {};
+	AVCodecContext* _encoder {};
+	std::vector<AVPacket*> _gop;	// since the last key frame
+	int64_t _delay {};	// of the decoding timestamps of the stream, from the frame reordering
+	int _nalLengthSize {};	// of the NAL units of the stream, 0 for the start codes
+	std::vector<uint8_t> _parameterSets;	// of the stream, in its NAL format
+};
+#endif // __OPEN_VIDEO_INTELLIGENCE_FFMPEG_SMART_CUT_H__
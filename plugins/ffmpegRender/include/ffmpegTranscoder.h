@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_FFMPEG_TRANSCODER_H__
+#define __OPEN_VIDEO_INTELLIGENCE_FFMPEG_TRANSCODER_H__
+
+#include <cstdint>
+#include <string>
+
+struct AVCodec;
+struct AVCodecContext;
+struct AVFilterContext;
+struct AVFilterGraph;
+struct AVFormatContext;
+struct AVFrame;
+struct AVPacket;
+
+/* Edits the pictures between the filter graph and the encoder. */
+class IFrameProcessor
+{
+public:
+	virtual ~IFrameProcessor() = default;
+
+	/* the pixel formats (AVPixelFormat) it can edit */
+	virtual bool supported(int pixelFormat) const = 0;
+	/* sec is the time of the picture from the start of the media */
+	virtual void process(AVFrame* frame, double sec) = 0;
+};
+
+/* Applies a filter graph to the first video and audio streams of a media in one
+ * decode, filter and encode pass. The graph of a stream reads [in] and writes [out],
+ * a stream without a graph is copied. The video pictures go through the frame processor, if any.
+ */
+class FFmpegTranscoder
+{
+public:
+	FFmpegTranscoder(const std::string& inputPath, const std::string& outputPath);
+	~FFmpegTranscoder();
+
+	/* only the frames from startSec to endSec of the media, all the streams are encoded and start at 0 */
+	void setRange(double startSec, double endSec);
+	/* of each decoder and encoder, 0: as many as the CPUs */
+	void setThreads(int threads) { _threads = threads; }
+	void transcode(const std::string& videoGraph, const std::string& audioGraph, IFrameProcessor* processor = nullptr);
+
+private:
+	struct Stream {
+		int input = -1;
+		int output = -1;
+		int64_t start {};	// of the input, the filters see the timestamps from 0
+		int64_t from {};	// the range, in the time base of the input
+		int64_t to = INT64_MAX;
+		int64_t offset {};	// of the output, in the time base of the encoder
+		bool finished {};
+		const AVCodec* codec {};	// of the encoder
+		AVCodecContext* decoder {};
+		AVCodecContext* encoder {};
+		AVFilterGraph* graph {};
+		AVFilterContext* source {};
+		AVFilterContext* sink {};
+	};
+
+	void open();
+	void seek();
+	bool finished() const;
+	void addStream(Stream& stream, int type, const std::string& graph);
+	void openDecoder(Stream& stream);
+	void openGraph(Stream& stream, const std::string& graph);
+	void openEncoder(Stream& stream);
+	void openOutput();
+	void process(Stream& stream, AVPacket* packet);
+	void filter(Stream& stream, AVFrame* frame);
+	void encode(Stream& stream, AVFrame* frame);
+	void copy(const Stream& stream, AVPacket* packet);
+	void release(Stream& stream);
+
+	std::string _inputPath;
+	std::string _outputPath;
+	AVFormatContext* _input {};
+	AVFormatContext* _output {};
+	Stream _video;
+	Stream _audio;
+	IFrameProcessor* _processor {};
+	bool _ranged {};
+	double _startSec {};
+	double _endSec {};
+	int _threads {};
+};
+#endif // __OPEN_VIDEO_INTELLIGENCE_FFMPEG_TRANSCODER_H__
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __OPEN_VIDEO_INTELLIGENCE_FFMPEG_WORKER_POOL_H__
+#define __OPEN_VIDEO_INTELLIGENCE_FFMPEG_WORKER_POOL_H__
+
+#include <cstddef>
+#include <functional>
+
+/* Runs the jobs of a render on a bounded number of threads. */
+class FFmpegWorkerPool
+{
+public:
+	/* 0: as many workers as the CPUs */
+	explicit FFmpegWorkerPool(int workers);
+
+	int workers() const { return _workers; }
+	/* the threads an encoder of a job may use, so the jobs together use the CPUs */
+	int threadsPerJob() const;
+	/* job(0) to job(jobs - 1), returns when all are done. After a failure, the jobs
+	 * not started are skipped and the first exception is rethrown.
+	 */
+	void run(size_t jobs, const std::function<void(size_t)>& job);
+
+private:
+	int _workers {};
+};
+#endif // __OPEN_VIDEO_INTELLIGENCE_FFMPEG_WORKER_POOL_H__
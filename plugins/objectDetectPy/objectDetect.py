@@ -62,11 +62,8 @@ def setAttrs(attrs: Dict[str, str]) -> int:
 
 
 def process(width, height, frame, total_frame_num=0, fps=0.0) -> Tuple[bool, any]:
-    detect, output = od.getResult(
-        np.frombuffer(frame, dtype='B', count=int(height) * int(width) * 3).reshape(
-            (int(height), int(width), 3)
-        )
-    )
+    # frame is a read-only (height, width, 3) memoryview valid only during this call
+    detect, output = od.getResult(np.asarray(frame))
     return (detect, output)
 
 
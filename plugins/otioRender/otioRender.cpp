@@ -26,6 +26,8 @@ public:
 
 	int setAttrs(const std::map<std::string, std::string>& attrs) override;
 	void render(timelineRetainer otioTimeline) override;
+	// the whole timeline is written at the end
+	bool streamable() override { return true; }
 	MetaForm effectMetaForm(const std::string& effectName) override;
 
 private:
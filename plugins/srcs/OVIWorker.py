@@ -0,0 +1,154 @@
+# Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+"""Hosts a python plugin module in a worker process.
+
+The core spawns this script with the plugin directory, the module name and
+three file descriptors: a memfd shared with the core and two eventfds used as
+doorbells (request, response). The shared memory starts with HEADER, the
+request payload (frame or attributes) follows at PAYLOAD_OFFSET, and the
+results are written back over the payload as ITEMs.
+"""
+
+import importlib
+import mmap
+import os
+import struct
+import sys
+import traceback
+
+HEADER = struct.Struct('<IIQQiiiiqdII4sI3q')
+ITEM = struct.Struct('<II4d')
+PAYLOAD_OFFSET = 128
+
+OP_ATTRS = 1
+OP_PROCESS_VIDEO = 2
+OP_PROCESS_AUDIO = 3
+OP_QUIT = 4
+
+STATUS_OK = 0
+STATUS_ERROR = 1
+
+ITEM_RECT = 0
+ITEM_BOOL = 1
+ITEM_DOUBLE = 2
+
+
+class SharedMemory:
+
+    def __init__(self, fd: int) -> None:
+        self.fd = fd
+        self.map = mmap.mmap(fd, os.fstat(fd).st_size)
+
+    def remap(self) -> None:
+        size = HEADER.unpack_from(self.map, 0)[3]
+        if size != len(self.map):
+            self.map.close()
+            self.map = mmap.mmap(self.fd, size)
+
+
+def _is_bool(value) -> bool:
+    return isinstance(value, bool) or type(value).__name__ == 'bool_'
+
+
+def _encode(details) -> list:
+    if _is_bool(details) or isinstance(details, (int, float)):
+        details = [details]
+
+    items = []
+    for item in details:
+        if _is_bool(item):
+            items.append((ITEM_BOOL, 0, float(bool(item)), 0.0, 0.0, 0.0))
+        elif isinstance(item, (int, float)):
+            items.append((ITEM_DOUBLE, 0, float(item), 0.0, 0.0, 0.0))
+        elif len(item) == 4:
+            items.append((ITEM_RECT, 0, *(float(v) for v in item)))
+        else:
+            raise ValueError(f'unsupported result item: {item!r}')
+    return items
+
+
+def _process(module, header, shm: SharedMemory) -> tuple:
+    op, _, size, _, a0, a1, a2, a3, duration, fps, _, _, typecode, ndim, *shape = header
+
+    typecode = typecode.rstrip(b'\0').decode()
+    view = memoryview(shm.map)[PAYLOAD_OFFSET:PAYLOAD_OFFSET + size]
+    frame = view.cast(typecode, shape[:ndim])
+    try:
+        if op == OP_PROCESS_VIDEO:
+            detect, details = module.process(a0, a1, frame.toreadonly(), duration, fps)
+        else:
+            detect, details = module.process(a0, a1, a2, a3, frame.toreadonly())
+    finally:
+        frame.release()
+        view.release()
+
+    return bool(detect), _encode(details)
+
+
+def _set_attrs(module, header, shm: SharedMemory) -> int:
+    size = header[2]
+    fields = bytes(shm.map[PAYLOAD_OFFSET:PAYLOAD_OFFSET + size]).split(b'\0')[:-1]
+    attrs = {fields[i].decode(): fields[i + 1].decode() for i in range(0, len(fields) - 1, 2)}
+    return int(module.setAttrs(attrs))
+
+
+def main(argv) -> int:
+    plugin_dir, module_name = argv[1], argv[2]
+    shm_fd, req_fd, resp_fd = (int(fd) for fd in argv[3:6])
+
+    sys.path.append(plugin_dir)
+    module = importlib.import_module(module_name)
+    configured = False
+    shm = SharedMemory(shm_fd)
+
+    while True:
+        os.eventfd_read(req_fd)
+        shm.remap()
+
+        header = HEADER.unpack_from(shm.map, 0)
+        op = header[0]
+        if op == OP_QUIT:
+            break
+
+        status, detect, items = STATUS_ERROR, False, []
+        try:
+            if op == OP_ATTRS:
+                # a worker serves one attribute set, it is only configured again
+                # after a failure, which must not leave a part of the attributes
+                if configured:
+                    module = importlib.reload(module)
+                configured = True
+                status = STATUS_OK if _set_attrs(module, header, shm) == 0 else STATUS_ERROR
+            elif op in (OP_PROCESS_VIDEO, OP_PROCESS_AUDIO):
+                detect, items = _process(module, header, shm)
+                if PAYLOAD_OFFSET + len(items) * ITEM.size > len(shm.map):
+                    raise ValueError(f'too many result items: {len(items)}')
+                for i, item in enumerate(items):
+                    ITEM.pack_into(shm.map, PAYLOAD_OFFSET + i * ITEM.size, *item)
+                status = STATUS_OK
+        except Exception:
+            traceback.print_exc()
+            items = []
+
+        struct.pack_into('<I', shm.map, 4, status)
+        struct.pack_into('<II', shm.map, 56, int(detect), len(items))
+        os.eventfd_write(resp_fd, 1)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -14,27 +14,167 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include "Accumulator.h"
+#include "Configuration.h"
+#include "DataAnalyzer.h"
+#include "Exception.h"
 #include "Log.h"
 
 using namespace ovi;
 
-void Accumulator::append(double frameNumber, bool include, const DetectedData& detected)
+static size_t __budget()
 {
-	_rawdata.push_back({ frameNumber, include, detected });
+	auto budget = Configuration::instance().get(CATEGORY_CORE, CORE_ACCUMULATOR_BUDGET_MB, 256);
+
+	return static_cast<size_t>(std::max(budget, 0)) << 20;
+}
+
+static std::string __spillDir()
+{
+	return Configuration::instance().get(CATEGORY_CORE, CORE_ACCUMULATOR_SPILL_DIR, std::string { "/tmp" });
+}
+
+Accumulator::Accumulator()
+	: Accumulator(__budget(), __spillDir())
+{
+}
+
+Accumulator::Accumulator(size_t memoryBudget, const std::string& spillDir)
+{
+	// the runs are paged out along with the detections, apart from the budget
+	if (memoryBudget > 0)
+		_spillDir = spillDir;
+
+	_data.detections = DetectionStore(memoryBudget, spillDir);
+	_data.runs = RunStore(_spillDir);
+}
+
+size_t AccumulatedData::frames() const
+{
+	size_t frames = 0;
+	for (const auto& run : runs)
+		frames += run.frames;
+
+	return frames;
+}
+
+void Accumulator::append(double firstFrame, size_t frames, bool include, const DetectedData& detected)
+{
+	if (frames == 0)
+		return;
+
+	if (_analyzer)
+		_analyzer->append(firstFrame, frames, include, detected);
+
+	if (detected.empty() && !_data.runs.empty()) {
+		auto& last = _data.runs.back();
+		if (last.include == include && last.detection == FrameRun::NO_DETECTION &&
+			last.firstFrame + last.frames == firstFrame) {
+			last.frames += frames;
+			_changedRun = std::min(_changedRun, _data.runs.size() - 1);
+			return;
+		}
+	}
+
+	FrameRun run { firstFrame, frames, include, FrameRun::NO_DETECTION };
+	if (!detected.empty()) {
+		run.detection = _data.detections.add(detected);
+	}
+
+	_changedRun = std::min(_changedRun, _data.runs.size());
+	_data.runs.push_back(run);
 }
 
 void Accumulator::update(const Details& detected)
 {
-	int i = 0;
+	RunStore runs(_spillDir);
+	size_t frame = 0;
+	size_t i = 0;
 
-	for (auto& item : _rawdata) {
-		LOG_INFO("[%f] : %d -> %d", item.frameNumber, item.include, std::get<bool>(detected[i]));
-		item.include = std::get<bool>(detected[i++]);
+	if (_analyzer) {
+		LOG_WARN("the streamed time ranges are outdated by the multi-frame result");
+		_analyzer.reset();
 	}
+
+	if (_resumedFrames > 0)
+		LOG_WARN("the multi-frame result covers the frames after the first %zu restored ones only", _resumedFrames);
+
+	// split the runs where the multi-frame result changes
+	for (const auto& run : _data.runs) {
+		for (size_t offset = 0; offset < run.frames; offset++, frame++) {
+			bool include = run.include;
+			// the plugin has seen the frames from the resume point only
+			if (frame >= _resumedFrames) {
+				if (i < detected.size())
+					include = std::get<bool>(detected[i]);
+				i++;
+			}
+
+			if (!runs.empty() && offset > 0 && runs.back().include == include) {
+				runs.back().frames++;
+				continue;
+			}
+
+			runs.push_back({ run.firstFrame + offset, 1, include, run.detection });
+		}
+	}
+
+	LOG_INFO("update %zu frames with %zu results: %zu -> %zu runs", i, detected.size(), _data.runs.size(), runs.size());
+	_data.runs = std::move(runs);
+	_changedRun = 0;
+}
+
+const AccumulatedData& Accumulator::accumulated()
+{
+	return _data;
+}
+
+size_t Accumulator::takeChangedRun()
+{
+	size_t changed = _changedRun;
+	_changedRun = _data.runs.size();
+
+	return changed;
 }
 
-const std::vector<RawData>& Accumulator::accumulated()
+void Accumulator::restore(size_t fromRun, const std::vector<FrameRun>& runs, const std::vector<DetectedData>& detections)
 {
-	return _rawdata;
+	if (fromRun > _data.runs.size())
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, "invalid run to restore from: " + std::to_string(fromRun));
+
+	_data.runs.resize(fromRun);
+	for (const auto& run : runs)
+		_data.runs.push_back(run);
+
+	for (const auto& detected : detections)
+		_data.detections.add(detected);
+
+	_changedRun = _data.runs.size();
+	_resumedFrames = _data.frames();
+}
+
+void Accumulator::setStreamingAnalyzer(std::shared_ptr<StreamingDataAnalyzer> analyzer)
+{
+	_analyzer = std::move(analyzer);
+	if (!_analyzer)
+		return;
+
+	// the restored frames come first
+	auto cursor = _data.detections.cursor();
+	for (const auto& run : _data.runs) {
+		if (run.detection == FrameRun::NO_DETECTION)
+			_analyzer->append(run.firstFrame, run.frames, run.include, {});
+		else
+			_analyzer->append(run.firstFrame, run.frames, run.include, cursor.at(run.detection));
+	}
+}
+
+void Accumulator::finish()
+{
+	if (_analyzer)
+		_analyzer->finish();
+
+	_analyzer.reset();
 }
@@ -71,3 +71,21 @@ void StateChangedCallback::invoke(VariantData data1, VariantData data2)
 
 	_callback(_handle, previous, current, _userData);
 }
+
+RenderCallback::RenderCallback(void* handle, ovi_render_cb cb, void* userData)
+							: AbstractCallback(handle, userData), _callback(cb)
+{
+	LOG_INFO(">>> callback %p, handle %p, userData %p registered",
+			reinterpret_cast<void*>(cb), handle, userData);
+}
+
+void RenderCallback::invoke(VariantData data1, VariantData data2)
+{
+	auto outputPath = std::get<std::string>(data1);
+	auto error = std::get<ovi_error_e>(data2);
+
+	LOG_INFO(">>> RenderCallback %p, handle %p, output %s, error %d, userData %p",
+			reinterpret_cast<void*>(_callback), _handle, outputPath.c_str(), error, _userData);
+
+	_callback(_handle, outputPath.c_str(), error, _userData);
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <fstream>
+
+#include "BinaryCodec.h"
+#include "Checkpoint.h"
+#include "Exception.h"
+#include "Log.h"
+
+using namespace ovi;
+
+namespace {
+
+const std::string JOURNAL_HEADER = "OVI_CHECKPOINT 1\n";
+constexpr uint32_t RECORD_MAGIC = 0x4b43564f;	// "OVCK"
+
+struct RecordHeader {
+	uint32_t magic;
+	uint32_t checksum;
+	uint64_t bytes;
+};
+
+}
+
+Checkpoint::Checkpoint(const std::string& path, const std::string& fingerprint)
+	: _path(path), _fingerprint(fingerprint)
+{
+	if (_path.empty())
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, "empty checkpoint path");
+}
+
+Checkpoint::~Checkpoint()
+{
+	if (_fd >= 0)
+		close(_fd);
+}
+
+bool Checkpoint::restore(Accumulator& accumulator, CheckpointPosition* position)
+{
+	std::ifstream file(_path, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::string header(JOURNAL_HEADER.size(), '\0');
+	uint32_t len = 0;
+	if (!file.read(header.data(), header.size()) || header != JOURNAL_HEADER ||
+		!file.read(reinterpret_cast<char*>(&len), sizeof(len))) {
+		LOG_WARN("%s is not a checkpoint", _path.c_str());
+		return false;
+	}
+
+	std::string fingerprint(len, '\0');
+	if (!file.read(fingerprint.data(), len) || fingerprint != _fingerprint) {
+		LOG_WARN("%s was written by another analysis", _path.c_str());
+		return false;
+	}
+
+	bool restored = false;
+	std::streamoff valid = file.tellg();
+	std::string payload;
+	RecordHeader record {};
+
+	while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+		if (record.magic != RECORD_MAGIC)
+			break;
+
+		payload.resize(record.bytes);
+		if (!file.read(payload.data(), payload.size()) || checksum(payload.data(), payload.size()) != record.checksum)
+			break;
+
+		BinaryReader reader(payload);
+		CheckpointPosition saved;
+		saved.videoFrame = reader.get<int32_t>();
+		saved.videoPts = reader.get<double>();
+		saved.audioFrame = reader.get<int32_t>();
+		saved.audioPts = reader.get<double>();
+
+		auto fromRun = reader.get<uint64_t>();
+		std::vector<FrameRun> runs(reader.get<uint64_t>());
+		for (auto& run : runs) {
+			run.firstFrame = reader.get<double>();
+			run.frames = reader.get<uint64_t>();
+			run.include = reader.get<uint8_t>() != 0;
+			run.detection = reader.get<int32_t>();
+		}
+
+		std::vector<DetectedData> detections(reader.get<uint64_t>());
+		for (auto& detected : detections)
+			detected = reader.getDetected();
+
+		accumulator.restore(fromRun, runs, detections);
+		*position = saved;
+		restored = true;
+		valid = file.tellg();
+	}
+
+	_savedDetections = accumulator.accumulated().detections.size();
+
+	// continue the journal after the last complete record
+	_fd = open(_path.c_str(), O_WRONLY | O_CLOEXEC);
+	if (_fd < 0 || ftruncate(_fd, valid) < 0 || lseek(_fd, valid, SEEK_SET) < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to open " + _path + ": " + strerror(errno));
+
+	LOG_INFO("restored %zu runs from %s, video frame:%d audio frame:%d",
+			accumulator.accumulated().runs.size(), _path.c_str(), position->videoFrame, position->audioFrame);
+
+	return restored;
+}
+
+void Checkpoint::create()
+{
+	_fd = open(_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (_fd < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to create " + _path + ": " + strerror(errno));
+
+	BinaryWriter writer;
+	writer.buffer() = JOURNAL_HEADER;
+	writer.put(_fingerprint);
+
+	if (write(_fd, writer.buffer().data(), writer.buffer().size()) != static_cast<ssize_t>(writer.buffer().size()))
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to write " + _path + ": " + strerror(errno));
+}
+
+void Checkpoint::save(Accumulator& accumulator, const CheckpointPosition& position)
+{
+	if (_fd < 0)
+		create();
+
+	const auto& data = accumulator.accumulated();
+	size_t fromRun = accumulator.takeChangedRun();
+
+	BinaryWriter writer;
+	writer.put(RecordHeader {});
+	writer.put(static_cast<int32_t>(position.videoFrame));
+	writer.put(position.videoPts);
+	writer.put(static_cast<int32_t>(position.audioFrame));
+	writer.put(position.audioPts);
+
+	writer.put(static_cast<uint64_t>(fromRun));
+	writer.put(static_cast<uint64_t>(data.runs.size() - fromRun));
+	for (size_t i = fromRun; i < data.runs.size(); i++) {
+		const auto& run = data.runs[i];
+		writer.put(run.firstFrame);
+		writer.put(static_cast<uint64_t>(run.frames));
+		writer.put(static_cast<uint8_t>(run.include));
+		writer.put(static_cast<int32_t>(run.detection));
+	}
+
+	writer.put(static_cast<uint64_t>(data.detections.size() - _savedDetections));
+	auto cursor = data.detections.cursor();
+	for (size_t i = _savedDetections; i < data.detections.size(); i++)
+		writer.put(cursor.at(static_cast<int>(i)));
+
+	auto& buffer = writer.buffer();
+	const char* payload = buffer.data() + sizeof(RecordHeader);
+	size_t bytes = buffer.size() - sizeof(RecordHeader);
+	RecordHeader record { RECORD_MAGIC, checksum(payload, bytes), bytes };
+	memcpy(buffer.data(), &record, sizeof(record));
+
+	off_t start = lseek(_fd, 0, SEEK_CUR);
+	for (size_t written = 0; written < buffer.size();) {
+		ssize_t ret = write(_fd, buffer.data() + written, buffer.size() - written);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			std::string error = strerror(errno);
+			// a torn record would hide the following ones
+			if (ftruncate(_fd, start) == 0)
+				lseek(_fd, start, SEEK_SET);
+			throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to write " + _path + ": " + error);
+		}
+		written += ret;
+	}
+	fdatasync(_fd);
+
+	_savedDetections = data.detections.size();
+
+	LOG_DEBUG("checkpoint %zu bytes, runs from %zu, video frame:%d audio frame:%d",
+			buffer.size(), fromRun, position.videoFrame, position.audioFrame);
+}
@@ -15,6 +15,7 @@
  */
 
 #include "DataAnalyzer.h"
+#include <algorithm>
 #include <cmath>
 
 using namespace ovi;
@@ -24,59 +25,98 @@ void DataAnalyzer::setCorrectionValue(double framerate)
 	_frameCount = ceil(framerate);
 }
 
-bool DataAnalyzer::canSkip(const std::vector<RawData>& inputData, size_t i, size_t* skip)
+/* Whether the excluded frames from (run, offset) are followed by an included frame
+ * within the correction value. 'skip' is the number of the excluded frames. */
+bool DataAnalyzer::canSkip(const AccumulatedData& inputData, size_t run, size_t offset, size_t* skip) const
 {
 	size_t len = static_cast<size_t>(_frameCount);
+	size_t gap = inputData.runs[run].frames - offset;
 
-	if (i + len >= inputData.size())
-		len = inputData.size() - i;
-
-	for (size_t j = 1; j < len; j++) {
-		if (inputData[i + j].include) {
-			*skip = j;
+	for (size_t r = run + 1; r < inputData.runs.size() && gap < len; r++) {
+		if (inputData.runs[r].include) {
+			*skip = gap;
 			return true;
 		}
+		gap += inputData.runs[r].frames;
 	}
 
 	return false;
 }
 
-void DataAnalyzer::analyzeRawData(const std::vector<RawData>& inputData)
+void DataAnalyzer::analyzeRawData(const AccumulatedData& inputData)
+{
+	analyzeRawData(inputData, [this](TimeRangeWithMetadata&& range) {
+		_timeRange.push_back(std::move(range));
+	});
+}
+
+void DataAnalyzer::analyzeRawData(const AccumulatedData& inputData, const TimeRangeCallback& callback)
 {
 	bool before = false;
 	double start = -1.0;	//Frame number starts 0.
 	double duration = 1.0;
-	std::vector<RawData> temp;
-
-	for (size_t i = 0; i < inputData.size(); i++) {
-		if (!before && inputData[i].include) {
-			start = inputData[i].frameNumber;
-			before = inputData[i].include;
-			if (!inputData[i].detected.empty())
-				temp.push_back(inputData[i]);
-		} else if (before && inputData[i].include) {
-			duration++;
-			if (!inputData[i].detected.empty())
-				temp.push_back(inputData[i]);
-		} else if (before && !inputData[i].include) {
+	SortedCollection collection;
+	// the runs refer to the detections in increasing order, read them in one pass
+	auto cursor = inputData.detections.cursor();
+
+	const auto& runs = inputData.runs;
+	auto collect = [&](const FrameRun& run, size_t from) {
+		if (run.detection == FrameRun::NO_DETECTION || from >= run.frames)
+			return;
+
+		const auto& detected = cursor.at(run.detection);
+		for (size_t offset = from; offset < run.frames; offset++) {
+			for (const auto& [ id, details ] : detected)
+				collection[id].push_back({ run.firstFrame + offset, details });
+		}
+	};
+	auto emit = [&]() {
+		TimeRangeWithMetadata range { { start, duration }, std::move(collection) };
+		collection = {};
+		callback(std::move(range));
+	};
+
+	size_t r = 0;
+	size_t offset = 0;	// the first frame of runs[r] to look at
+	while (r < runs.size()) {
+		const auto& run = runs[r];
+
+		if (run.include) {
+			if (!before) {
+				start = run.firstFrame + offset;
+				before = true;
+				duration += (run.frames - offset - 1);
+			} else {
+				duration += (run.frames - offset);
+			}
+			collect(run, offset);
+		} else if (before) {
 			size_t skip = 0;
-			if (canSkip(inputData, i, &skip)) {
-				// Include current frame
+			if (canSkip(inputData, r, offset, &skip)) {
+				// Include the gap and the next included frame, which is not collected
 				duration += (skip + 1);
-				i += skip;
-			} else {
-				_timeRange.push_back({ start, duration, sort(temp) });
-				start = -1.0;
-				duration = 1.0;
-				before = false;
-				temp.clear();
-				temp.shrink_to_fit();
+				for (r = r + 1; !runs[r].include; r++)
+					;
+				offset = 1;
+				if (offset >= runs[r].frames) {
+					r++;
+					offset = 0;
+				}
+				continue;
 			}
+
+			emit();
+			start = -1.0;
+			duration = 1.0;
+			before = false;
 		}
+
+		r++;
+		offset = 0;
 	}
 
 	if (start >= 0.0)
-		_timeRange.push_back({ start, duration, sort(temp) });
+		emit();
 }
 
 const std::vector<TimeRangeWithMetadata>& DataAnalyzer::result() const
@@ -84,18 +124,68 @@ const std::vector<TimeRangeWithMetadata>& DataAnalyzer::result() const
 	return _timeRange;
 }
 
-SortedCollection DataAnalyzer::sort(const std::vector<RawData>& input)
+StreamingDataAnalyzer::StreamingDataAnalyzer(double framerate, RangeCallback callback)
+	: _frameCount(static_cast<size_t>(ceil(framerate))), _callback(std::move(callback))
+{
+}
+
+void StreamingDataAnalyzer::append(double firstFrame, size_t frames, bool include, const DetectedData& detected)
 {
-	if (input.empty())
-		return {};
+	if (frames == 0)
+		return;
 
-	SortedCollection tmp;
+	if (!include) {
+		if (!_before)
+			return;
 
-	for (const auto& data : input) {
-		for (const auto& [ uid, details ] : data.detected) {
-			tmp[uid].push_back({ data.frameNumber, details });
-		}
+		// the range is over unless an included frame shows up within the correction value
+		_gap += frames;
+		if (_gap >= std::max<size_t>(_frameCount, 1))
+			emit();
+		return;
+	}
+
+	if (!_before) {
+		_start = firstFrame;
+		_before = true;
+		_duration += (frames - 1);
+		collect(firstFrame, frames, detected);
+	} else if (_gap > 0) {
+		// Include the gap and the first included frame, which is not collected
+		_duration += (_gap + frames);
+		_gap = 0;
+		collect(firstFrame + 1, frames - 1, detected);
+	} else {
+		_duration += frames;
+		collect(firstFrame, frames, detected);
+	}
+}
+
+void StreamingDataAnalyzer::finish()
+{
+	if (_before)
+		emit();
+
+	_finished = true;
+}
+
+void StreamingDataAnalyzer::collect(double firstFrame, size_t frames, const DetectedData& detected)
+{
+	for (size_t offset = 0; offset < frames; offset++) {
+		for (const auto& [ id, details ] : detected)
+			_collection[id].push_back({ firstFrame + offset, details });
 	}
+}
+
+void StreamingDataAnalyzer::emit()
+{
+	TimeRangeWithMetadata range { { _start, _duration }, std::move(_collection) };
+
+	_before = false;
+	_start = -1.0;
+	_duration = 1.0;
+	_gap = 0;
+	_collection = {};
 
-	return tmp;
+	_callback(std::move(range));
 }
@@ -69,31 +69,33 @@ void DataFlow::worker()
 		_logicAnalyzer->reset();
 		_outcomeCache.clear();
 		while (_run.load()) {
-			std::string uid = _logicAnalyzer->nextPlugin(_outcomeCache.result().detect);
-			LOG_DEBUG("plugin:%s", uid.c_str());
+			PluginId id = _logicAnalyzer->nextPluginId(_outcomeCache.result().detect);
 
-			if (uid == OVI_EOP) {
+			if (id == OVI_EOP_ID) {
 				// multi-frame detector check..
 				if (_outcomeCache.findMultiFrameResult())
 					updateAllResult(_outcomeCache.getMultiFrameResult());
 				else
 					appendResult(vFrame.get(), aFrames, _outcomeCache.detected());
+				saveCheckpoint(vFrame.get(), aFrames);
 				break;
 			}
 
-			if (_outcomeCache.hit(uid)) {
-				_outcomeCache.setResultUid(uid);
+			LOG_DEBUG("plugin:%s", _pluginManager->uid(id).c_str());
+
+			if (_outcomeCache.hit(id)) {
+				_outcomeCache.setResultId(id);
 				continue;
 			}
 
-			const auto& plugin = _pluginManager->find(uid);
+			const auto& plugin = _pluginManager->find(id);
 			if (plugin.type == PLUGIN_TYPE_VIDEO_EFFECT || plugin.type == PLUGIN_TYPE_AUDIO_EFFECT) {
-				_outcomeCache.setDetected(uid);
+				_outcomeCache.setDetected(id);
 				continue;
 			}
 
 			try {
-				_outcomeCache.write(uid, processPlugin(uid, vFrame.get(), aFrames));
+				_outcomeCache.write(id, process(id, plugin, vFrame.get(), aFrames));
 			} catch (const Exception& e) {
 				LOG_ERROR("%s", e.what());
 				ret = e.error();
@@ -115,6 +117,17 @@ void DataFlow::worker()
 			invokeProgressCb(progressStr);
 	}
 
+	// stopped or finished, the next run continues from here
+	if (ret == OVI_ERROR_NONE)
+		saveCheckpoint();
+
+	if (_resultCache)
+		_resultCache->save();
+
+	// the end of the media closes the last streamed time range
+	if (ret == OVI_ERROR_NONE && _run.load())
+		_accumulator->finish();
+
 	invokeProgressCb("Finish Analysis...");
 
 	_run.store(false);
@@ -129,15 +142,72 @@ void DataFlow::setProgressCallback(void* handle, ovi_progress_cb callback, void*
 	_progressCallback = std::unique_ptr<IInvokable>(new ProgressCallback(handle, callback, userData));
 }
 
+void DataFlow::setResultCache(std::shared_ptr<ResultCache> resultCache)
+{
+	_resultCache = resultCache;
+}
+
+void DataFlow::setCheckpoint(std::shared_ptr<Checkpoint> checkpoint, const CheckpointPosition& position,
+							std::chrono::seconds interval)
+{
+	_checkpoint = checkpoint;
+	_position = position;
+	_checkpointInterval = interval;
+	_checkpointTime = std::chrono::steady_clock::now();
+}
+
+void DataFlow::saveCheckpoint(const FramePack* vFrame, const std::vector<FramePackPtr>& aFrames)
+{
+	if (!_checkpoint)
+		return;
+
+	if (vFrame) {
+		_position.videoFrame = vFrame->frameNum();
+		_position.videoPts = vFrame->pts();
+	}
+	if (!aFrames.empty()) {
+		_position.audioFrame = aFrames.back()->frameNum();
+		_position.audioPts = aFrames.back()->pts();
+	}
+	_positionSaved = false;
+
+	if (std::chrono::steady_clock::now() - _checkpointTime >= _checkpointInterval)
+		saveCheckpoint();
+}
+
+void DataFlow::saveCheckpoint()
+{
+	if (!_checkpoint || _positionSaved)
+		return;
+
+	// losing a checkpoint only costs the frames since the previous one
+	try {
+		_checkpoint->save(*_accumulator, _position);
+	} catch (const Exception& e) {
+		LOG_ERROR("%s", e.what());
+	}
+
+	_checkpointTime = std::chrono::steady_clock::now();
+	_positionSaved = true;
+}
+
 void DataFlow::appendResult(const FramePack* vFrame, std::vector<FramePackPtr>& aFrames, const DetectedData& detected)
 {
+	// the skipped frames share the result of the analyzed one
 	if (vFrame) {
-		for (int i = _skipFrames; i >= 0; i--)
-			_accumulator->append(vFrame->frameNum() - i, _logicAnalyzer->include(), detected);
+		_accumulator->append(vFrame->frameNum() - static_cast<double>(_skipFrames), _skipFrames + 1,
+							_logicAnalyzer->include(), detected);
 
 	} else {
-		for (size_t i = 0; i < aFrames.size(); i++)
-			_accumulator->append(aFrames[i]->frameNum(), _logicAnalyzer->include(), detected);
+		for (size_t i = 0; i < aFrames.size();) {
+			size_t frames = 1;
+			while (i + frames < aFrames.size() &&
+					aFrames[i + frames]->frameNum() == aFrames[i]->frameNum() + static_cast<int>(frames))
+				frames++;
+
+			_accumulator->append(aFrames[i]->frameNum(), frames, _logicAnalyzer->include(), detected);
+			i += frames;
+		}
 	}
 }
 
@@ -146,11 +216,38 @@ void DataFlow::updateAllResult(const Details& detected)
 	_accumulator->update(detected);
 }
 
-Outcome DataFlow::processPlugin(const std::string& uid, FramePack* vFrame, std::vector<FramePackPtr>& aFrames)
+/* The outcome of the previous analysis of the frames with the same plugin configuration, if any */
+Outcome DataFlow::process(PluginId id, const Plugin& plugin, FramePack* vFrame, std::vector<FramePackPtr>& aFrames)
+{
+	if (!_resultCache || !_resultCache->contains(id))
+		return processPlugin(plugin, vFrame, aFrames);
+
+	ResultCache::FrameKey frames;
+	if (plugin.type == PLUGIN_TYPE_VIDEO_DETECT && vFrame)
+		frames = { vFrame->frameNum(), vFrame->frameNum() };
+	else if (plugin.type == PLUGIN_TYPE_AUDIO_DETECT && !aFrames.empty())
+		frames = { aFrames.front()->frameNum(), aFrames.back()->frameNum() };
+	else
+		return processPlugin(plugin, vFrame, aFrames);
+
+	if (auto cached = _resultCache->find(id, frames))
+		return *cached;
+
+	auto outcome = processPlugin(plugin, vFrame, aFrames);
+
+	// a multi-frame result covers the frames the plugin has seen, which must be all of them
+	if (!outcome.list.empty() && std::holds_alternative<bool>(outcome.list[0]))
+		_resultCache->remove(id);
+	else
+		_resultCache->store(id, frames, outcome);
+
+	return outcome;
+}
+
+Outcome DataFlow::processPlugin(const Plugin& plugin, FramePack* vFrame, std::vector<FramePackPtr>& aFrames)
 {
 	Outcome result = { true, {} };
 
-	auto& plugin = _pluginManager->find(uid);
 	auto processObj = dynamic_cast<IPluginProcess*>(plugin.plugin);
 	assert(processObj);
 
@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string.h>
+#include <algorithm>
+
+#include "DetectionStore.h"
+#include "Exception.h"
+#include "Log.h"
+
+using namespace ovi;
+
+namespace {
+
+constexpr uint32_t BLOCK_MAGIC = 0x4b4c4244;	// "DBLK"
+
+/* set on the first row of each (plugin id, details) pair */
+constexpr uint8_t DETAIL_ENTRY = 0x80;
+
+enum DetailType : uint8_t {
+	DETAIL_EMPTY,	// an effect without details
+	DETAIL_RECT,
+	DETAIL_RECT_TAG,
+	DETAIL_DOUBLE,
+	DETAIL_BOOL,
+};
+
+/* followed by the columns: uint32 detection[rows], int32 plugin[rows], uint8 type[rows], payload */
+struct BlockHeader {
+	uint32_t magic;
+	uint32_t rows;
+	uint32_t firstDetection;
+	uint32_t detections;
+	uint64_t bytes;	// of the whole block
+};
+
+template<typename T>
+void put(std::string& buffer, const T& value)
+{
+	buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T get(const char*& cursor)
+{
+	T value;
+	memcpy(&value, cursor, sizeof(T));
+	cursor += sizeof(T);
+	return value;
+}
+
+class VisitorEncode {
+public:
+	VisitorEncode(std::vector<uint8_t>& types, std::string& payload)
+		: _types(types), _payload(payload) {}
+
+	void operator()(const OVIRect& rect) {
+		_types.push_back(DETAIL_RECT);
+		putRect(rect.x, rect.y, rect.width, rect.height);
+	}
+
+	void operator()(const OVIRectTag& rectTag) {
+		_types.push_back(DETAIL_RECT_TAG);
+		putRect(rectTag.x, rectTag.y, rectTag.width, rectTag.height);
+		put(_payload, static_cast<uint32_t>(rectTag.tag.size()));
+		_payload.append(rectTag.tag);
+	}
+
+	void operator()(const double& value) {
+		_types.push_back(DETAIL_DOUBLE);
+		put(_payload, value);
+	}
+
+	void operator()(const bool& value) {
+		_types.push_back(DETAIL_BOOL);
+		put(_payload, static_cast<uint8_t>(value));
+	}
+
+private:
+	void putRect(double x, double y, double width, double height) {
+		put(_payload, x);
+		put(_payload, y);
+		put(_payload, width);
+		put(_payload, height);
+	}
+
+	std::vector<uint8_t>& _types;
+	std::string& _payload;
+};
+
+size_t detectedBytes(const DetectedData& detected)
+{
+	size_t bytes = sizeof(DetectedData) + detected.capacity() * sizeof(DetectedData::value_type);
+	for (const auto& [ id, details ] : detected) {
+		bytes += details.capacity() * sizeof(Details::value_type);
+		for (const auto& item : details) {
+			if (auto rectTag = std::get_if<OVIRectTag>(&item))
+				bytes += rectTag->tag.capacity();
+		}
+	}
+
+	return bytes;
+}
+
+}
+
+struct DetectionStore::Impl {
+	struct Block {
+		uint64_t offset;
+		uint32_t firstDetection;
+		uint32_t detections;
+	};
+
+	size_t memoryBudget {};
+	std::string spillDir;
+
+	int fd { -1 };
+	uint64_t fileSize {};
+	std::vector<Block> blocks;
+
+	std::vector<DetectedData> resident;
+	size_t residentFirst {};
+	size_t residentBytes {};
+
+	void* map { MAP_FAILED };
+	size_t mapped {};
+
+	~Impl() {
+		if (map != MAP_FAILED)
+			munmap(map, mapped);
+		if (fd >= 0)
+			close(fd);
+	}
+
+	bool overBudget() const { return memoryBudget > 0 && residentBytes > memoryBudget; }
+	void open();
+	void flush();
+	const char* data(const Block& block);
+	std::vector<DetectedData> decode(const Block& block);
+};
+
+void DetectionStore::Impl::open()
+{
+	std::string path = spillDir + "/ovi_detections_XXXXXX";
+	fd = mkostemp(path.data(), O_CLOEXEC);
+	if (fd < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to create the spill file in " + spillDir + ": " + strerror(errno));
+
+	// nobody else needs the file, it goes away with the descriptor
+	unlink(path.c_str());
+	LOG_INFO("spill detections over %zu bytes to %s", memoryBudget, spillDir.c_str());
+}
+
+void DetectionStore::Impl::flush()
+{
+	if (resident.empty())
+		return;
+
+	if (fd < 0)
+		open();
+
+	std::vector<uint32_t> detections;
+	std::vector<int32_t> plugins;
+	std::vector<uint8_t> types;
+	std::string payload;
+
+	for (size_t i = 0; i < resident.size(); i++) {
+		for (const auto& [ id, details ] : resident[i]) {
+			size_t entry = types.size();
+			if (details.empty())
+				types.push_back(DETAIL_EMPTY);
+			for (const auto& item : details)
+				std::visit(VisitorEncode { types, payload }, item);
+			types[entry] |= DETAIL_ENTRY;
+
+			detections.resize(types.size(), static_cast<uint32_t>(residentFirst + i));
+			plugins.resize(types.size(), id);
+		}
+	}
+
+	BlockHeader header { BLOCK_MAGIC, static_cast<uint32_t>(types.size()),
+						static_cast<uint32_t>(residentFirst), static_cast<uint32_t>(resident.size()), 0 };
+	std::string buffer;
+	buffer.reserve(sizeof(header) + types.size() * 9 + payload.size());
+	put(buffer, header);
+	buffer.append(reinterpret_cast<const char*>(detections.data()), detections.size() * sizeof(uint32_t));
+	buffer.append(reinterpret_cast<const char*>(plugins.data()), plugins.size() * sizeof(int32_t));
+	buffer.append(reinterpret_cast<const char*>(types.data()), types.size());
+	buffer.append(payload);
+
+	header.bytes = buffer.size();
+	memcpy(buffer.data(), &header, sizeof(header));
+
+	for (size_t written = 0; written < buffer.size();) {
+		ssize_t ret = pwrite(fd, buffer.data() + written, buffer.size() - written, fileSize + written);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			throw Exception(OVI_ERROR_INVALID_OPERATION, std::string { "failed to spill detections: " } + strerror(errno));
+		}
+		written += ret;
+	}
+
+	blocks.push_back({ fileSize, header.firstDetection, header.detections });
+	fileSize += buffer.size();
+
+	LOG_DEBUG("spilled %zu detections, %zu bytes", resident.size(), buffer.size());
+
+	residentFirst += resident.size();
+	resident.clear();
+	resident.shrink_to_fit();
+	residentBytes = 0;
+}
+
+const char* DetectionStore::Impl::data(const Block& block)
+{
+	if (mapped < fileSize) {
+		if (map != MAP_FAILED)
+			munmap(map, mapped);
+
+		mapped = fileSize;
+		map = mmap(nullptr, mapped, PROT_READ, MAP_SHARED, fd, 0);
+		if (map == MAP_FAILED) {
+			mapped = 0;
+			throw Exception(OVI_ERROR_INVALID_OPERATION, std::string { "failed to map detections: " } + strerror(errno));
+		}
+		madvise(map, mapped, MADV_SEQUENTIAL);
+	}
+
+	return static_cast<const char*>(map) + block.offset;
+}
+
+std::vector<DetectedData> DetectionStore::Impl::decode(const Block& block)
+{
+	const char* cursor = data(block);
+	auto header = get<BlockHeader>(cursor);
+	if (header.magic != BLOCK_MAGIC)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "corrupted detection block");
+
+	const char* detections = cursor;
+	const char* plugins = detections + header.rows * sizeof(uint32_t);
+	const char* types = plugins + header.rows * sizeof(int32_t);
+	const char* payload = types + header.rows;
+
+	std::vector<DetectedData> result(header.detections);
+
+	for (uint32_t row = 0; row < header.rows; row++) {
+		auto detection = get<uint32_t>(detections) - header.firstDetection;
+		auto id = static_cast<PluginId>(get<int32_t>(plugins));
+		auto type = get<uint8_t>(types);
+
+		auto& detected = result[detection];
+		if (type & DETAIL_ENTRY)
+			detected.emplace_back(id, Details {});
+
+		auto& details = detected.back().second;
+		switch (type & ~DETAIL_ENTRY) {
+		case DETAIL_EMPTY:
+			break;
+		case DETAIL_RECT: {
+			OVIRect rect;
+			rect.x = get<double>(payload);
+			rect.y = get<double>(payload);
+			rect.width = get<double>(payload);
+			rect.height = get<double>(payload);
+			details.push_back(rect);
+			break;
+		}
+		case DETAIL_RECT_TAG: {
+			OVIRectTag rectTag;
+			rectTag.x = get<double>(payload);
+			rectTag.y = get<double>(payload);
+			rectTag.width = get<double>(payload);
+			rectTag.height = get<double>(payload);
+			auto len = get<uint32_t>(payload);
+			rectTag.tag.assign(payload, len);
+			payload += len;
+			details.push_back(std::move(rectTag));
+			break;
+		}
+		case DETAIL_DOUBLE:
+			details.push_back(get<double>(payload));
+			break;
+		case DETAIL_BOOL:
+			details.push_back(get<uint8_t>(payload) != 0);
+			break;
+		default:
+			throw Exception(OVI_ERROR_INVALID_OPERATION, "unknown detail type: " + std::to_string(type));
+		}
+	}
+
+	return result;
+}
+
+DetectionStore::DetectionStore()
+	: _impl(std::make_shared<Impl>())
+{
+}
+
+DetectionStore::DetectionStore(size_t memoryBudget, const std::string& spillDir)
+	: _impl(std::make_shared<Impl>())
+{
+	_impl->memoryBudget = memoryBudget;
+	_impl->spillDir = spillDir;
+}
+
+int DetectionStore::add(const DetectedData& detected)
+{
+	int index = static_cast<int>(size());
+
+	_impl->resident.push_back(detected);
+	_impl->residentBytes += detectedBytes(detected);
+
+	if (_impl->overBudget())
+		_impl->flush();
+
+	return index;
+}
+
+size_t DetectionStore::size() const
+{
+	return _impl->residentFirst + _impl->resident.size();
+}
+
+bool DetectionStore::spilled() const
+{
+	return !_impl->blocks.empty();
+}
+
+size_t DetectionStore::residentBytes() const
+{
+	return _impl->residentBytes;
+}
+
+size_t DetectionStore::blocks() const
+{
+	return _impl->blocks.size();
+}
+
+DetectedData DetectionStore::at(int index) const
+{
+	return Cursor(*this).at(index);
+}
+
+DetectionStore::Cursor::Cursor(const DetectionStore& store)
+	: _store(store)
+{
+}
+
+const DetectedData& DetectionStore::Cursor::at(int index)
+{
+	auto& impl = *_store._impl;
+
+	if (index < 0 || static_cast<size_t>(index) >= _store.size())
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, "no detection: " + std::to_string(index));
+
+	if (static_cast<size_t>(index) >= impl.residentFirst)
+		return impl.resident[index - impl.residentFirst];
+
+	if (_blockFirst < 0 || index < _blockFirst || index >= _blockFirst + static_cast<int>(_block.size())) {
+		auto iter = std::upper_bound(impl.blocks.begin(), impl.blocks.end(), static_cast<uint32_t>(index),
+									[](uint32_t value, const auto& block) { return value < block.firstDetection; });
+		const auto& block = *std::prev(iter);
+
+		_block = impl.decode(block);
+		_blockFirst = static_cast<int>(block.firstDetection);
+	}
+
+	return _block[index - _blockFirst];
+}
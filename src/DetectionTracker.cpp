@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "DetectionTracker.h"
+
+using namespace ovi;
+
+// of the intersection over the union, for a rectangle to continue a track
+static const double MIN_OVERLAP = 0.1;
+
+static double __overlap(const OVIRect& a, const OVIRect& b)
+{
+	double width = std::min(a.x + a.width, b.x + b.width) - std::max(a.x, b.x);
+	double height = std::min(a.y + a.height, b.y + b.height) - std::max(a.y, b.y);
+	if (width <= 0 || height <= 0)
+		return 0;
+
+	double intersection = width * height;
+	return intersection / (a.width * a.height + b.width * b.height - intersection);
+}
+
+static void __values(const OVIRect& rect, double values[4])
+{
+	values[0] = rect.x;
+	values[1] = rect.y;
+	values[2] = rect.width;
+	values[3] = rect.height;
+}
+
+static void __resetSlopes(double low[4], double high[4])
+{
+	std::fill(low, low + 4, -std::numeric_limits<double>::infinity());
+	std::fill(high, high + 4, std::numeric_limits<double>::infinity());
+}
+
+/* the slopes from the key for which the interpolation at the frame is within the tolerance */
+static void __constrain(const TrackKey& key, const TrackKey& frame, double tolerance, double low[4], double high[4])
+{
+	double keyValues[4];
+	double values[4];
+	double span = frame.frame - key.frame;
+
+	__values(key.rect, keyValues);
+	__values(frame.rect, values);
+
+	for (int i = 0; i < 4; i++) {
+		low[i] = std::max(low[i], (values[i] - tolerance - keyValues[i]) / span);
+		high[i] = std::min(high[i], (values[i] + tolerance - keyValues[i]) / span);
+	}
+}
+
+DetectionTracker::DetectionTracker(double tolerance, double maxGap)
+	: _tolerance(std::max(tolerance, 0.0))
+	, _maxGap(maxGap)
+{
+}
+
+void DetectionTracker::add(double frame, const Details& details)
+{
+	for (auto it = _active.begin(); it != _active.end();) {
+		if (frame - it->last.frame - 1 > _maxGap) {
+			close(*it);
+			it = _active.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	std::vector<bool> matched(_active.size());
+
+	for (const auto& item : details) {
+		if (auto rect = std::get_if<OVIRect>(&item))
+			add(frame, *rect, false, {}, matched);
+		else if (auto rectTag = std::get_if<OVIRectTag>(&item))
+			add(frame, { rectTag->x, rectTag->y, rectTag->width, rectTag->height }, true, rectTag->tag, matched);
+	}
+}
+
+void DetectionTracker::add(double frame, const OVIRect& rect, bool tagged, const std::string& tag, std::vector<bool>& matched)
+{
+	int best = -1;
+	double bestOverlap = MIN_OVERLAP;
+
+	for (size_t i = 0; i < _active.size(); i++) {
+		const auto& active = _active[i];
+		if (matched[i] || active.last.frame >= frame || active.track.tagged != tagged || active.track.tag != tag)
+			continue;
+
+		double overlap = __overlap(active.last.rect, rect);
+		if (overlap >= bestOverlap) {
+			best = i;
+			bestOverlap = overlap;
+		}
+	}
+
+	if (best >= 0) {
+		matched[best] = true;
+		extend(_active[best], { frame, rect });
+		return;
+	}
+
+	Active active;
+	active.track.tagged = tagged;
+	active.track.tag = tag;
+	active.track.keys.push_back({ frame, rect });
+	active.last = { frame, rect };
+	__resetSlopes(active.low, active.high);
+
+	_active.push_back(std::move(active));
+	matched.push_back(true);
+}
+
+void DetectionTracker::extend(Active& active, const TrackKey& next)
+{
+	const TrackKey& key = active.track.keys.back();
+
+	if (active.last.frame != key.frame) {
+		double keyValues[4];
+		double values[4];
+		double span = next.frame - key.frame;
+		bool interpolated = true;
+
+		__values(key.rect, keyValues);
+		__values(next.rect, values);
+
+		// the slopes allowed by the frames between the key and this one
+		for (int i = 0; i < 4; i++) {
+			double slope = (values[i] - keyValues[i]) / span;
+			if (slope < active.low[i] || slope > active.high[i])
+				interpolated = false;
+		}
+
+		if (!interpolated) {
+			active.track.keys.push_back(active.last);
+			__resetSlopes(active.low, active.high);
+		}
+	}
+
+	__constrain(active.track.keys.back(), next, _tolerance, active.low, active.high);
+	active.last = next;
+}
+
+void DetectionTracker::close(Active& active)
+{
+	if (active.last.frame != active.track.keys.back().frame)
+		active.track.keys.push_back(active.last);
+
+	_finished.push_back(std::move(active.track));
+}
+
+std::vector<DetectionTrack> DetectionTracker::tracks()
+{
+	for (auto& active : _active)
+		close(active);
+	_active.clear();
+
+	std::stable_sort(_finished.begin(), _finished.end(), [](const DetectionTrack& a, const DetectionTrack& b) {
+		return a.keys.front().frame < b.keys.front().frame;
+	});
+
+	return std::exchange(_finished, {});
+}
@@ -192,6 +192,9 @@ AvDecoder::AvDecoder(AVMediaType mediaType, int streamId, std::string mediaPath,
 
 AvDecoder::~AvDecoder()
 {
+	if (_pending)
+		av_frame_free(&_pending);
+
 	if (_codecCtx)
 		avcodec_free_context(&_codecCtx);
 
@@ -232,7 +235,7 @@ AVFrame* AvDecoder::decode()
 		ret = avcodec_receive_frame(_codecCtx, frame);
 		switch (ret) {
 		case 0:
-			_frameNum = _codecCtx->frame_number;
+			_frameNum = _codecCtx->frame_number + _frameOffset;
 			return frame;
 		case AVERROR(EAGAIN):
 			LOG_INFO("AVERROR(EAGAIN)");
@@ -342,7 +345,7 @@ AVPacket* AvDecoder::readFrame()
 
 FramePackPtr AvDecoder::frame(double framerate, int64_t duration)
 {
-	AVFrame* frame = decode();
+	AVFrame* frame = _pending ? std::exchange(_pending, nullptr) : decode();
 
 	if (!frame)
 		return nullptr;
@@ -358,6 +361,36 @@ size_t AvDecoder::frameNum() const
 	return _frameNum;
 }
 
+void AvDecoder::seek(int frameNum, double pts)
+{
+	AVStream* stream = _formatCtx->streams[_streamId];
+	int64_t timestamp = static_cast<int64_t>(pts / av_q2d(stream->time_base));
+
+	// to the key frame before, then decode up to the frame
+	int ret = av_seek_frame(_formatCtx, _streamId, timestamp, AVSEEK_FLAG_BACKWARD);
+	if (ret < 0) {
+		__printFFmpegErrorStr("av_seek_frame()", ret);
+		LOG_WARN("decode from the start up to pts:%f", pts);
+	} else {
+		avcodec_flush_buffers(_codecCtx);
+		_eof = false;
+	}
+
+	while (AVFrame* frame = decode()) {
+		if (av_q2d(_time_base) * frame->pts > pts) {
+			_pending = frame;
+			break;
+		}
+		av_frame_free(&frame);
+	}
+
+	// the numbers go on from the checkpoint, not from the seek point
+	_frameOffset += (frameNum + 1) - static_cast<int64_t>(_frameNum);
+	_frameNum = frameNum + 1;
+
+	LOG_INFO("seek to pts:%f, next frame:%zu", pts, _frameNum);
+}
+
 std::unique_ptr<AvDecoder> AvDecoderFactory::createAudioDecoder(int streamId, const std::string& mediaPath)
 {
 	return std::make_unique<AvDecoder>(AVMEDIA_TYPE_AUDIO, streamId, mediaPath,
@@ -406,6 +439,22 @@ FramePackPtr FrameExtractorFFMPEG::nextAudio() const
 	return _audioDecoder->frame(_mediaInfo->audio()->framerate(), _mediaInfo->audio()->frameNum());
 }
 
+void FrameExtractorFFMPEG::seekVideo(int frameNum, double pts)
+{
+	if (!_videoDecoder)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "invalid _videoDecoder");
+
+	_videoDecoder->seek(frameNum, pts);
+}
+
+void FrameExtractorFFMPEG::seekAudio(int frameNum, double pts)
+{
+	if (!_audioDecoder)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "invalid _audioDecoder");
+
+	_audioDecoder->seek(frameNum, pts);
+}
+
 void FrameExtractorFFMPEG::setup(const std::string& mediaPath)
 {
 	LOG_INFO("media_path: %s", mediaPath.c_str());
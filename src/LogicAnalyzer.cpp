@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <memory>
 
 #include "LogicAnalyzer.h"
@@ -22,7 +23,8 @@
 
 using namespace ovi;
 
-#define OVI_EOPP "OVI_EOPP"  // End Of Plugin Pipeline
+constexpr PluginId NO_PLUGIN = -2;
+constexpr PluginId OVI_EOPP_ID = -3;  // End Of Plugin Pipeline
 
 typedef enum {
 	LOGICAL_OPERATOR_NONE = 0,
@@ -132,7 +134,8 @@ bool ovi::validate_logic(const std::vector<std::string>& request, const PluginMa
 	return true;
 }
 
-bool ovi::validate_link(const LogicAnalyzer* logicAnalyzer, const PluginManager* pluginManager, const std::string& renderId)
+bool ovi::validate_link(const LogicAnalyzer* logicAnalyzer, const PluginManager* pluginManager, const std::string& renderId,
+						const std::vector<std::string>& effects)
 {
 	LOG_ENTER();
 
@@ -151,6 +154,11 @@ bool ovi::validate_link(const LogicAnalyzer* logicAnalyzer, const PluginManager*
 			continue;
 		}
 
+		if (!effects.empty() && std::find(effects.begin(), effects.end(), str) == effects.end()) {
+			prev = str;
+			continue;
+		}
+
 		const std::string& effectName = pluginManager->getAttr(str, "name");
 		MetaForm detectMetaForm = pluginManager->getMetaForm(detect, {});
 		MetaForm effectMetaForm = pluginManager->getMetaForm(renderId, effectName);
@@ -166,7 +174,7 @@ bool ovi::validate_link(const LogicAnalyzer* logicAnalyzer, const PluginManager*
 	return true;
 }
 
-PluginNode::PluginNode(const std::string& id, bool cut)
+PluginNode::PluginNode(PluginId id, bool cut)
 	: _include(true), _cut(cut)
 {
 	_plugins.push_back(id);
@@ -176,12 +184,12 @@ PluginNode::~PluginNode()
 {
 }
 
-std::string PluginNode::pop()
+PluginId PluginNode::pop()
 {
 	if (!_include)
-		return {};
+		return NO_PLUGIN;
 	if (_pos >= _plugins.size())
-		return {};
+		return NO_PLUGIN;
 	return _plugins[_pos++];
 }
 
@@ -226,22 +234,22 @@ void PluginPipeline::push(PluginNodePtr plugin)
 	_pipeline.push_back(plugin);
 }
 
-std::string PluginPipeline::pop(bool include)
+PluginId PluginPipeline::pop(bool include)
 {
 	// check if it will move in the pipeline
 	if (!include) {
 		LOG_DEBUG("include %d", include);
-		return {};
+		return NO_PLUGIN;
 	}
 
 	// get current node
-	std::string plugin = _pipeline[_pos]->pop();
-	if (!plugin.empty())
+	PluginId plugin = _pipeline[_pos]->pop();
+	if (plugin != NO_PLUGIN)
 		return plugin;
 
 	// if the current node is empty, goes next node
 	if (++_pos >= _pipeline.size())
-		return OVI_EOPP;
+		return OVI_EOPP_ID;
 
 	return _pipeline[_pos]->pop();
 }
@@ -275,7 +283,7 @@ void PluginPipeline::dump() const
 // LCOV_EXCL_STOP
 
 LogicAnalyzer::LogicAnalyzer(const std::vector<std::string>& expression, const PluginManager* pluginManager)
-	: _expression(expression)
+	: _pluginManager(pluginManager), _expression(expression)
 {
 	LOG_ENTER();
 
@@ -288,42 +296,46 @@ LogicAnalyzer::~LogicAnalyzer()
 
 void LogicAnalyzer::reset()
 {
-	LOG_ENTER();
-	_pos = 0;
-	for (auto& pipeline : _pipelines)
-		pipeline->reset();
+	_pc = PROGRAM_START;
 }
 
-std::string LogicAnalyzer::nextPlugin(bool include)
+PluginId LogicAnalyzer::nextPluginId(bool result)
 {
-	PluginNodePtr currentNode = _pipelines[_pos]->current();
+	if (_pc == PROGRAM_END)
+		return OVI_EOP_ID;
+
+	const auto& instruction = _program[_pc];
 
 	// process 'cut'
-	_include = currentNode->post(include);
+	bool include = instruction.cut ? result : true;
 
-	std::string next = _pipelines[_pos]->pop(_include);
-	// if all of a pipeline are included, it end.
-	if (next == OVI_EOPP) {
-		for (_pos = _pos + 1; _pos < _pipelines.size(); _pos++) {
-			if (_pipelines[_pos]->isEssential())
-				break;
-		}
-		if (_pos >= _pipelines.size())
-			return OVI_EOP;
-		_pipelines[_pos]->reset();
-		return nextPlugin(true);
-	}
+	if (!include)
+		_pc = instruction.fail;
+	else if (instruction.first && !result)
+		_pc = instruction.skip;
+	else
+		_pc = instruction.next;
 
-	// if next is empty, move to another pipeline.
-	if (next.empty()) {
-		if (++_pos >= _pipelines.size())
-			return OVI_EOP;
-		_pipelines[_pos]->reset();
-		return nextPlugin(true);
+	if (_pc == PROGRAM_END) {
+		_include = include;
+		return OVI_EOP_ID;
 	}
 
-	LOG_DEBUG("next is %s in case of %d ", next.c_str(), _include);
-	return next;
+	_include = true;
+
+	LOG_DEBUG("next is %d in case of %d ", _program[_pc].plugin, include);
+	return _program[_pc].plugin;
+}
+
+const std::string& LogicAnalyzer::nextPlugin(bool include)
+{
+	static const std::string eop { OVI_EOP };
+
+	PluginId next = nextPluginId(include);
+	if (next == OVI_EOP_ID)
+		return eop;
+
+	return _pluginManager->uid(next);
 }
 
 void LogicAnalyzer::runAnalysis(std::vector<std::string> expression, const PluginManager* pluginManager)
@@ -357,10 +369,12 @@ void LogicAnalyzer::runAnalysis(std::vector<std::string> expression, const Plugi
 			continue;
 		}
 
+		PluginId id = pluginManager->id(str);
+
 		switch(logicalOperator) {
 		case LOGICAL_OPERATOR_AND:
 			// Add new plugin node at whole pipelines.
-			pluginNode = std::make_shared<PluginNode>(str, cut);
+			pluginNode = std::make_shared<PluginNode>(id, cut);
 			for (auto& _pipeline : _pipelines)
 				_pipeline->push(pluginNode);
 			break;
@@ -368,18 +382,18 @@ void LogicAnalyzer::runAnalysis(std::vector<std::string> expression, const Plugi
 			// Add new pipeline and insert new plugin node at new pipeline.
 			pipeline = std::make_shared<PluginPipeline>();
 			_pipelines.push_back(pipeline);
-			pluginNode = std::make_shared<PluginNode>(str, cut);
+			pluginNode = std::make_shared<PluginNode>(id, cut);
 			pipeline->push(pluginNode);
 			break;
 		case LOGICAL_OPERATOR_COLON:
 			// Add new plugin at the current node and set essential pipeline.
-			pluginNode->push(str);
+			pluginNode->push(id);
 			if (_pipelines.size() > 1)
 				pipeline->setEssential();
 			break;
 		default:
 			// Add new plugin as default.
-			pluginNode = std::make_shared<PluginNode>(str, cut);
+			pluginNode = std::make_shared<PluginNode>(id, cut);
 			pipeline->push(pluginNode);
 			break;
 		}
@@ -387,10 +401,66 @@ void LogicAnalyzer::runAnalysis(std::vector<std::string> expression, const Plugi
 		cut = true;
 	}
 	// all '_pos' to '0'
+	for (auto& pipeline : _pipelines)
+		pipeline->reset();
+
+	compile();
 	reset();
 	// dump();
 }
 
+/* Flattens the pipelines into a program, one instruction per plugin of each pipeline.
+ * A node moves on to its next plugin, the next node, or the next essential pipeline.
+ * A cut plugin which is not detected moves to the next pipeline instead. */
+void LogicAnalyzer::compile()
+{
+	std::vector<int> entries(_pipelines.size() + 1, PROGRAM_END);
+	int pc = PROGRAM_START + 1;
+
+	for (size_t p = 0; p < _pipelines.size(); p++) {
+		entries[p] = pc;
+		for (const auto& node : _pipelines[p]->nodes())
+			pc += static_cast<int>(node->plugins().size());
+	}
+
+	auto nextEssential = [&](size_t p) -> int {
+		for (size_t q = p + 1; q < _pipelines.size(); q++) {
+			if (_pipelines[q]->isEssential())
+				return entries[q];
+		}
+		return PROGRAM_END;
+	};
+
+	_program.assign(pc, {});
+
+	// the start resumes with the first plugin, as if a plugin before it is detected
+	auto& start = _program[PROGRAM_START];
+	start.plugin = OVI_EOP_ID;
+	start.cut = _pipelines[0]->nodes().empty() || _pipelines[0]->nodes().front()->cut();
+	start.next = start.skip = entries[0];
+	start.fail = entries[1];
+
+	pc = PROGRAM_START + 1;
+	for (size_t p = 0; p < _pipelines.size(); p++) {
+		const auto& nodes = _pipelines[p]->nodes();
+
+		for (size_t n = 0; n < nodes.size(); n++) {
+			const auto& plugins = nodes[n]->plugins();
+			int nextNode = (n + 1 < nodes.size()) ? pc + static_cast<int>(plugins.size()) : nextEssential(p);
+
+			for (size_t k = 0; k < plugins.size(); k++, pc++) {
+				auto& instruction = _program[pc];
+				instruction.plugin = plugins[k];
+				instruction.cut = nodes[n]->cut();
+				instruction.first = (k == 0);
+				instruction.next = (k + 1 < plugins.size()) ? pc + 1 : nextNode;
+				instruction.skip = nextNode;
+				instruction.fail = entries[p + 1];
+			}
+		}
+	}
+}
+
 // LCOV_EXCL_START
 void LogicAnalyzer::dump() const
 {
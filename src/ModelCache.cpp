@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "ModelCache.h"
+#include "Exception.h"
+#include "Log.h"
+
+using namespace ovi;
+
+MappedModel::MappedModel(const std::string& path)
+{
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, "open model failed: " + path + ": " + strerror(errno));
+
+	struct stat st {};
+	if (fstat(fd, &st) < 0 || st.st_size <= 0) {
+		close(fd);
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, "invalid model file: " + path);
+	}
+
+	_size = static_cast<size_t>(st.st_size);
+	_data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (_data == MAP_FAILED) {
+		_data = nullptr;
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "mmap model failed: " + path + ": " + strerror(errno));
+	}
+}
+
+MappedModel::~MappedModel()
+{
+	if (_data)
+		munmap(_data, _size);
+}
+
+/* The handles share the control block of the holder, made here. The model inside,
+ * its control block and its deleter are made by the loader, i.e. by plugin code. */
+struct ModelCache::Holder {
+	std::string key;
+	std::shared_ptr<const void> model;
+
+	~Holder() {
+		model.reset();
+		ModelCache::instance().release(key);
+	}
+};
+
+std::shared_ptr<const void> ModelCache::acquire(const std::string& key,
+												const std::function<std::shared_ptr<const void>()>& loader)
+{
+	{
+		std::lock_guard<std::mutex> locker(_lock);
+		auto iter = _models.find(key);
+		if (iter != _models.end()) {
+			if (auto holder = iter->second.lock())
+				return std::shared_ptr<const void>(holder, holder->model.get());
+		}
+	}
+
+	/* load without the lock, other models may be requested meanwhile */
+	auto model = loader();
+	if (!model)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "model load failed: " + key);
+
+	std::lock_guard<std::mutex> locker(_lock);
+
+	auto& entry = _models[key];
+	auto holder = entry.lock();
+	if (!holder) {
+		holder = std::make_shared<Holder>();
+		holder->key = key;
+		holder->model = std::move(model);
+		entry = holder;
+		LOG_INFO("model loaded: %s", key.c_str());
+	}
+
+	return std::shared_ptr<const void>(holder, holder->model.get());
+}
+
+void ModelCache::release(const std::string& key)
+{
+	std::lock_guard<std::mutex> locker(_lock);
+
+	/* the key may already be loaded again by a racing acquire */
+	auto iter = _models.find(key);
+	if (iter != _models.end() && iter->second.expired())
+		_models.erase(iter);
+}
+
+std::shared_ptr<const MappedModel> ModelCache::map(const std::string& path)
+{
+	return get<MappedModel>(path, [&path]() { return std::make_shared<MappedModel>(path); });
+}
+
+size_t ModelCache::size() const
+{
+	std::lock_guard<std::mutex> locker(_lock);
+
+	return _models.size();
+}
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <variant>
 
 #include "Log.h"
@@ -21,20 +22,38 @@
 
 using namespace ovi;
 
-bool OutcomeCache::hit(const std::string& uid) const
+bool OutcomeCache::hit(PluginId id) const
 {
-	return (_storage.find(uid) != _storage.end());
+	return (id >= 0 && static_cast<size_t>(id) < _written.size() && _written[id]);
 }
-void OutcomeCache::write(const std::string& uid, const Outcome& outcome)
+
+void OutcomeCache::write(PluginId id, const Outcome& outcome)
 {
-	log(uid, outcome);
-	_storage.insert_or_assign(uid, outcome);
-	setResultUid(uid);
+	log(id, outcome);
+
+	if (static_cast<size_t>(id) >= _storage.size()) {
+		_storage.resize(id + 1);
+		_written.resize(id + 1);
+	}
+
+	_storage[id] = outcome;
+	if (!_written[id]) {
+		_written[id] = true;
+		_writtenIds.push_back(id);
+	}
+	setResultId(id);
 }
 
-void OutcomeCache::setDetected(const std::string& uid)
+void OutcomeCache::setDetected(PluginId id)
 {
-	_detected.insert_or_assign(uid, result().list);
+	const auto& list = result().list;
+
+	auto iter = std::find_if(_detected.begin(), _detected.end(),
+							[id](const auto& detected) { return detected.first == id; });
+	if (iter != _detected.end())
+		iter->second = list;
+	else
+		_detected.emplace_back(id, list);
 }
 
 const DetectedData& OutcomeCache::detected() const
@@ -44,8 +63,9 @@ const DetectedData& OutcomeCache::detected() const
 
 bool OutcomeCache::findMultiFrameResult()
 {
-	for (auto it = _storage.begin(); it != _storage.end(); it++) {
-		if (!it->second.list.empty() && std::holds_alternative<bool>(it->second.list[0]))
+	for (auto id : _writtenIds) {
+		const auto& list = _storage[id].list;
+		if (!list.empty() && std::holds_alternative<bool>(list[0]))
 			return true;
 	}
 
@@ -54,17 +74,18 @@ bool OutcomeCache::findMultiFrameResult()
 
 const Details& OutcomeCache::getMultiFrameResult()
 {
-	for (auto it = _storage.begin(); it != _storage.end(); it++) {
-		if (!it->second.list.empty() && std::holds_alternative<bool>(it->second.list[0]))
-			return it->second.list;
+	for (auto id : _writtenIds) {
+		const auto& list = _storage[id].list;
+		if (!list.empty() && std::holds_alternative<bool>(list[0]))
+			return list;
 	}
 
 	throw ovi::Exception(OVI_ERROR_INVALID_OPERATION, "No items");
 }
 
-void OutcomeCache::setResultUid(const std::string& uid)
+void OutcomeCache::setResultId(PluginId id)
 {
-	_resultUid = uid;
+	_resultId = id;
 }
 
 const Outcome& OutcomeCache::result()
@@ -72,51 +93,54 @@ const Outcome& OutcomeCache::result()
 	if (empty())
 		return _defaultOutcome;
 
-	return _storage[_resultUid];
+	return _storage[_resultId];
 }
 
 void OutcomeCache::clear()
 {
-	_storage.clear();
+	/* keep the storage, it is reused by the next frame */
+	for (auto id : _writtenIds)
+		_written[id] = false;
+	_writtenIds.clear();
 	_detected.clear();
-	_resultUid.clear();
+	_resultId = NO_RESULT;
 }
 
 bool OutcomeCache::empty() const
 {
-	return (_storage.empty() || _resultUid.empty());
+	return (_resultId == NO_RESULT || !hit(_resultId));
 }
 
 class VisitorLogItem {
 public:
-	explicit VisitorLogItem(const std::string& uid)
-		: _uid(uid) {}
+	explicit VisitorLogItem(PluginId id)
+		: _id(id) {}
 
 	void operator()(const OVIRect& rect) {
-		LOG_DEBUG("[%s] rect: %f, %f, %f, %f",
-			_uid.c_str(), rect.x, rect.y, rect.width, rect.height);
+		LOG_DEBUG("[%d] rect: %f, %f, %f, %f",
+			_id, rect.x, rect.y, rect.width, rect.height);
 	}
 
 	void operator()(const OVIRectTag& rectTag) {
-		LOG_DEBUG("[%s] rectTag: %f, %f, %f, %f, %s",
-			_uid.c_str(), rectTag.x, rectTag.y, rectTag.width, rectTag.height, rectTag.tag.c_str());
+		LOG_DEBUG("[%d] rectTag: %f, %f, %f, %f, %s",
+			_id, rectTag.x, rectTag.y, rectTag.width, rectTag.height, rectTag.tag.c_str());
 	}
 
 	void operator()(const double& value) {
-		LOG_DEBUG("[%s] double: %f", _uid.c_str(), value);
+		LOG_DEBUG("[%d] double: %f", _id, value);
 	}
 
 	void operator()(const bool& value) {
-		LOG_DEBUG("[%s] bool: %d", _uid.c_str(), value);
+		LOG_DEBUG("[%d] bool: %d", _id, value);
 	}
 private:
-	std::string _uid;
+	PluginId _id;
 };
 
-void OutcomeCache::log(const std::string& uid, const Outcome& outcome) const
+void OutcomeCache::log(PluginId id, const Outcome& outcome) const
 {
-	LOG_DEBUG("[%s] detect: %d", uid.c_str(), outcome.detect);
+	LOG_DEBUG("[%d] detect: %d", id, outcome.detect);
 	for (const auto& item : outcome.list) {
-		std::visit(VisitorLogItem { uid }, item);
+		std::visit(VisitorLogItem { id }, item);
 	}
 }
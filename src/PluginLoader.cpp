@@ -18,12 +18,18 @@
 #include <stdio.h>
 #include <filesystem>
 #include <algorithm>
+#include <future>
+#include <optional>
 
 #include "PluginLoader.h"
+#include "PluginRegistryCache.h"
+#include "PluginPool.h"
+#include "Configuration.h"
 #include "Log.h"
 #ifdef OVI_ENABLE_PYTHON
 #include "PyPluginProcess.h"
 #include "PyManager.h"
+#include "PyWorkerPool.h"
 #endif /* OVI_ENABLE_PYTHON */
 
 using namespace ovi;
@@ -43,28 +49,72 @@ void PluginLoader::getSharedPathList(const std::string& pluginDir)
 	std::error_code ec {};
 	std::filesystem::directory_iterator dit(pluginDir, ec);
 
-	if (!ec) {
-		for (const auto& entry : dit) {
-			if (!entry.is_regular_file())
-				continue;
-
-			if (entry.path().extension().compare(".so") == 0)
-				addPluginInfo(entry.path());
+	if (ec) {
+		LOG_ERROR("directory_iterator failed: %d", ec.value());
+		return;
+	}
 
+	struct Candidate {
+		std::string path;
+		std::optional<PluginInfo> cached;
+		std::future<PluginInfo> discovery;
+	};
+	std::vector<Candidate> candidates;
+
+	/* plugins unchanged since the last run are served from the registry,
+	 * the others are discovered in parallel */
+	for (const auto& entry : dit) {
+		if (!entry.is_regular_file())
+			continue;
+
+		const auto& path = entry.path();
+		bool isShared = path.extension().compare(".so") == 0;
+		bool isPython = false;
 #ifdef OVI_ENABLE_PYTHON
-			if (!_pyintf) {
-				if (entry.path().extension().compare(".py") == 0 &&
-					entry.path().stem().compare("__init__") != 0)
-					addPluginInfoForPy(entry.path(), entry.path().stem());
-			}
+		isPython = !_pyintf && path.extension().compare(".py") == 0 &&
+					path.stem().compare("__init__") != 0;
 #endif /* OVI_ENABLE_PYTHON */
+		if (!isShared && !isPython)
+			continue;
+
+		Candidate candidate { path.string(), _registry->find(path.string()), {} };
+		if (!candidate.cached) {
+			if (isShared) {
+				candidate.discovery = std::async(std::launch::async, getPluginInfo, candidate.path);
+			} else {
+#ifdef OVI_ENABLE_PYTHON
+				candidate.discovery = std::async(std::launch::async,
+					[this, moduleName = path.stem().string()] { return getPluginInfoForPy(moduleName); });
+#endif /* OVI_ENABLE_PYTHON */
+			}
 		}
-	} else {
-		LOG_ERROR("directory_iterator failed: %d", ec.value());
+
+		candidates.push_back(std::move(candidate));
 	}
+
+	std::vector<std::string> seen;
+
+	for (auto& candidate : candidates) {
+		PluginInfo info {};
+		if (candidate.cached) {
+			info = std::move(*candidate.cached);
+		} else {
+			info = candidate.discovery.get();
+			/* failed python modules are discovered again, their dependencies may be installed later */
+			_registry->update(candidate.path, info);
+		}
+
+		info.sourcePath = candidate.path;
+		if (!info.name.empty())
+			_availablePlugins.push_back(std::move(info));
+		seen.push_back(candidate.path);
+	}
+
+	/* forget plugins which are removed from the directory */
+	_registry->retain(seen);
 }
 
-void PluginLoader::addPluginInfo(const std::string& pluginPath)
+PluginInfo PluginLoader::getPluginInfo(const std::string& pluginPath)
 {
 	void* handle = nullptr;
 	LOG_ENTER();
@@ -99,57 +149,95 @@ void PluginLoader::addPluginInfo(const std::string& pluginPath)
 			throw Exception(OVI_ERROR_INVALID_OPERATION, std::string { "attributeList dlsym failed: " } + dlerror());
 
 		auto attrs = reinterpret_cast<std::vector<Attribute>*>(attrFunc());
-		_availablePlugins.push_back( { LANG_C,
-							nameFunc(),
-							typeFunc(),
-							*formatFunc(),
-							metaFormFunc(),
-							descFunc(),
-							pluginPath,
-							*attrs } );
+		PluginInfo info { LANG_C,
+						nameFunc(),
+						typeFunc(),
+						*formatFunc(),
+						metaFormFunc(),
+						descFunc(),
+						pluginPath,
+						*attrs };
 
 		dlclose(handle);
+		LOG_LEAVE();
+
+		return info;
 	} catch (const Exception& e) {
 		LOG_ERROR("ERROR: %s", e.what());
 		if (handle)
 			dlclose(handle);
 		throw;
 	}
-	LOG_LEAVE();
 }
 
 #ifdef OVI_ENABLE_PYTHON
-void PluginLoader::addPluginInfoForPy(const std::string& pluginPath, const std::string& moduleName)
+PluginInfo PluginLoader::getPluginInfoForPy(const std::string& moduleName)
 {
 	LOG_ENTER();
 	try {
-		auto info = _pyManager->getPluginInfo(moduleName);
-		if (info.libraryPath.compare(moduleName) == 0)
-			_availablePlugins.push_back(info);
+		auto info = pyManager()->getPluginInfo(moduleName);
+		if (info.libraryPath.compare(moduleName) == 0) {
+			LOG_LEAVE();
+			return info;
+		}
 	} catch (const std::bad_variant_access& e) {
 		LOG_ERROR("ERROR: %s", e.what());
 	}
 
 	LOG_LEAVE();
+	return {};
+}
+
+std::shared_ptr<PyManager> PluginLoader::pyManager()
+{
+	std::lock_guard<std::mutex> locker(_pyManagerLock);
+
+	if (!_pyManager)
+		_pyManager = std::make_shared<PyManager>();
+
+	return _pyManager;
 }
 #endif /* OVI_ENABLE_PYTHON */
 
 PluginLoader::PluginLoader()
 {
 #ifdef OVI_ENABLE_PYTHON
+	/* the interpreter is started on the first use of a python plugin */
 	if (Py_IsInitialized())
 		_pyintf = true;
-	else
-		_pyManager = std::make_shared<PyManager>();
+
+	auto replicas = Configuration::instance().get(CATEGORY_PYTHON, PYTHON_WORKER_PROCESSES, 0);
+	if (replicas > 0) {
+		auto interpreter = Configuration::instance().get(CATEGORY_PYTHON, PYTHON_INTERPRETER,
+														std::string(PYTHON_EXECUTABLE_PATH));
+		_pyWorkerPool = std::make_shared<PyWorkerPool>(interpreter, replicas);
+	}
 #endif /* OVI_ENABLE_PYTHON */
+	auto registryPath = Configuration::instance().get(CATEGORY_CORE, CORE_PLUGIN_REGISTRY_CACHE,
+													PluginRegistryCache::defaultPath());
+	_registry = std::make_shared<PluginRegistryCache>(registryPath);
+	_registry->load();
+
 	getSharedPathList(PLUGIN_INSTALLED_DIR);
+
+	_registry->save();
+
+	auto maxIdle = Configuration::instance().get(CATEGORY_CORE, CORE_PLUGIN_POOL_MAX_IDLE, 8);
+	auto idleTimeout = Configuration::instance().get(CATEGORY_CORE, CORE_PLUGIN_POOL_IDLE_TIMEOUT, 300);
+	if (maxIdle > 0) {
+		_pluginPool = std::make_shared<PluginPool>(maxIdle, std::chrono::seconds(idleTimeout),
+												[this](Plugin& pluginObj) { destroy(pluginObj); });
+	}
 }
 
 PluginLoader::~PluginLoader()
 {
+	/* pooled python plugins need the interpreter */
+	_pluginPool.reset();
 #ifdef OVI_ENABLE_PYTHON
 	// Note: must be unique owner in this momement
 	_pyManager.reset();
+	_pyWorkerPool.reset();
 #endif /* OVI_ENABLE_PYTHON */
 }
 
@@ -164,18 +252,22 @@ Plugin PluginLoader::create(PluginInfo& info)
 		if (!createPluginFunc)
 			throw Exception(OVI_ERROR_INVALID_OPERATION, std::string { "dlsym failed: " } + dlerror());
 
-		return Plugin({ info.type, info.formats, info.metaForm, createPluginFunc(), handle });
+		return Plugin({ info.type, info.formats, info.metaForm, createPluginFunc(), handle, {}, info.name });
 	} else if (info.lang == LANG_PYTHON) {
 #ifdef OVI_ENABLE_PYTHON
-		IPlugin* func = new PyPlugin(_pyManager, info.libraryPath);
-		return Plugin({ info.type, info.formats, info.metaForm, func, nullptr });
+		IPlugin* func {};
+		if (_pyWorkerPool)
+			func = new PyWorkerPlugin(_pyWorkerPool, info.libraryPath);
+		else
+			func = new PyPlugin(pyManager(), info.libraryPath);
+		return Plugin({ info.type, info.formats, info.metaForm, func, nullptr, {}, info.name });
 #endif /* OVI_ENABLE_PYTHON */
 	}
 
 	throw Exception(OVI_ERROR_INVALID_OPERATION, "Unsupported language");
 }
 
-Plugin PluginLoader::load(const std::string& name)
+Plugin PluginLoader::create(const std::string& name)
 {
 	for (auto& item : _availablePlugins) {
 		if (item.name.compare(name) == 0)
@@ -185,7 +277,50 @@ Plugin PluginLoader::load(const std::string& name)
 	throw Exception(OVI_ERROR_INVALID_OPERATION, std::string { "No plugin: " } + name);
 }
 
+Plugin PluginLoader::load(const std::string& name)
+{
+	if (_pluginPool) {
+		if (auto pooled = _pluginPool->checkout(name))
+			return std::move(*pooled);
+	}
+
+	return create(name);
+}
+
 void PluginLoader::unload(Plugin pluginObj)
+{
+	if (_pluginPool && _pluginPool->checkin(std::move(pluginObj)))
+		return;
+
+	destroy(pluginObj);
+}
+
+void PluginLoader::applyAttrs(Plugin& pluginObj)
+{
+	if (pluginObj.appliedAttrs == pluginObj.attrs)
+		return;
+
+	if (_pluginPool && _pluginPool->exchange(pluginObj))
+		return;
+
+	/* plugins only overwrite the attributes they are given,
+	 * so an instance configured with other keys cannot be reused */
+	bool covered = std::all_of(pluginObj.appliedAttrs.begin(), pluginObj.appliedAttrs.end(),
+							[&](const auto& attr) { return pluginObj.attrs.count(attr.first) > 0; });
+	if (!covered) {
+		auto fresh = create(pluginObj.name);
+		std::swap(pluginObj.plugin, fresh.plugin);
+		std::swap(pluginObj.dlHandle, fresh.dlHandle);
+		std::swap(pluginObj.appliedAttrs, fresh.appliedAttrs);
+		unload(std::move(fresh));
+	}
+
+	if (!pluginObj.attrs.empty())
+		pluginObj.plugin->setAttrs(pluginObj.attrs);
+	pluginObj.appliedAttrs = pluginObj.attrs;
+}
+
+void PluginLoader::destroy(Plugin& pluginObj)
 {
 	if (pluginObj.dlHandle) {
 		auto destroyPluginFunc = reinterpret_cast<destroyPlugin>(dlsym(pluginObj.dlHandle, "destroyPlugin"));
@@ -195,6 +330,9 @@ void PluginLoader::unload(Plugin pluginObj)
 	} else {
 		delete pluginObj.plugin;
 	}
+
+	pluginObj.plugin = nullptr;
+	pluginObj.dlHandle = nullptr;
 }
 
 const std::vector<Attribute>& PluginLoader::getPluginAttrs(const std::string& name) const
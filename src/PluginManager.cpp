@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include "PluginManager.h"
 #include "IPluginRender.h"
 #include "Log.h"
@@ -34,11 +36,10 @@ std::string PluginManager::makeId(const std::string& name)
 const std::string& PluginManager::load(const std::string& name)
 {
 	std::string uid = makeId(name);
-	_loadedPlugins.insert({ uid, PluginLoader::instance().load(name) });
-
-	LOG_DEBUG("plugin name:%s", name.c_str());
+	auto [ plugin, inserted ] = _loadedPlugins.insert({ uid, PluginLoader::instance().load(name) });
+	_pluginsById.push_back(plugin);
 
-	auto plugin = _loadedPlugins.find(uid);
+	LOG_DEBUG("plugin name:%s id:%zu", name.c_str(), _pluginsById.size() - 1);
 
 	return plugin->first;
 }
@@ -53,6 +54,32 @@ const Plugin& PluginManager::find(const std::string& uid) const
 	return iter->second;
 }
 
+const Plugin& PluginManager::find(PluginId id) const
+{
+	if (id < 0 || static_cast<size_t>(id) >= _pluginsById.size())
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, std::string { "No plugin id: " } + std::to_string(id));
+
+	return _pluginsById[id]->second;
+}
+
+PluginId PluginManager::id(const std::string& uid) const
+{
+	for (size_t i = 0; i < _pluginsById.size(); i++) {
+		if (_pluginsById[i]->first == uid)
+			return static_cast<PluginId>(i);
+	}
+
+	throw Exception(OVI_ERROR_INVALID_PARAMETER, std::string { "No plugin: " } + uid);
+}
+
+const std::string& PluginManager::uid(PluginId id) const
+{
+	if (id < 0 || static_cast<size_t>(id) >= _pluginsById.size())
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, std::string { "No plugin id: " } + std::to_string(id));
+
+	return _pluginsById[id]->first;
+}
+
 bool PluginManager::exist(const std::string& uid) const
 {
 	auto iter = _loadedPlugins.find(uid);
@@ -65,6 +92,7 @@ void PluginManager::unloadAll()
 	for (auto iter = _loadedPlugins.begin(); iter != _loadedPlugins.end(); iter++)
 		PluginLoader::instance().unload(iter->second);
 
+	_pluginsById.clear();
 	_loadedPlugins.clear();
 }
 
@@ -90,13 +118,16 @@ void PluginManager::validate(bool hasVideo, bool hasAudio) const
 	}
 }
 
-void PluginManager::validateAttrs(const std::string& renderUid) const
+void PluginManager::validateAttrs(const std::string& renderUid, const std::vector<std::string>& effects) const
 {
 	auto renderPlugin = find(renderUid);
 	auto renderObj = dynamic_cast<IPluginRender*>(renderPlugin.plugin);
 	assert(renderObj);
 
 	for (const auto& [uid, plugin] : _loadedPlugins) {	//ToDo. check only the plugins linked
+		if (!effects.empty() && std::find(effects.begin(), effects.end(), uid) == effects.end())
+			continue;
+
 		if (plugin.type == PLUGIN_TYPE_VIDEO_EFFECT || plugin.type == PLUGIN_TYPE_AUDIO_EFFECT) {
 			if (plugin.attrs.empty())
 				throw Exception(OVI_ERROR_INVALID_OPERATION, std::string { "No effect info: " } + uid);
@@ -110,15 +141,9 @@ void PluginManager::validateAttrs(const std::string& renderUid) const
 
 void PluginManager::setAllAttrs()
 {
-	for (const auto& plugin : _loadedPlugins) {
 	//ToDo :: validate check here..
-		if (!plugin.second.attrs.empty()) {
-
-				plugin.second.plugin->setAttrs(plugin.second.attrs);
-		} else {
-			//TODO: No attribute cases..
-		}
-	}
+	for (auto& plugin : _loadedPlugins)
+		PluginLoader::instance().applyAttrs(plugin.second);
 }
 
 const std::string& PluginManager::getAttr(const std::string& uid, const std::string& key) const
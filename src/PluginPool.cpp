@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "PluginPool.h"
+#include "Log.h"
+
+using namespace ovi;
+
+PluginPool::PluginPool(size_t maxIdle, std::chrono::seconds idleTimeout, Destroyer destroyer)
+	: _maxIdle(maxIdle)
+	, _idleTimeout(idleTimeout)
+	, _destroyer(std::move(destroyer))
+{
+}
+
+PluginPool::~PluginPool()
+{
+	clear();
+}
+
+bool PluginPool::poolable(const Plugin& plugin)
+{
+	/* effects and renders keep the state of the session they belong to */
+	return plugin.type == PLUGIN_TYPE_VIDEO_DETECT || plugin.type == PLUGIN_TYPE_AUDIO_DETECT;
+}
+
+std::optional<Plugin> PluginPool::checkout(const std::string& name)
+{
+	std::list<Idle> victims;
+	std::optional<Plugin> plugin;
+	{
+		std::lock_guard<std::mutex> locker(_lock);
+		victims = evict(Clock::now());
+
+		auto iter = std::find_if(_idle.rbegin(), _idle.rend(),
+								[&](const auto& idle) { return idle.plugin.name == name; });
+		if (iter != _idle.rend()) {
+			plugin = std::move(iter->plugin);
+			/* the new session sets its own attributes */
+			plugin->attrs.clear();
+			_idle.erase(std::next(iter).base());
+		}
+	}
+
+	destroy(victims);
+
+	if (plugin)
+		LOG_DEBUG("reuse plugin instance: %s", name.c_str());
+
+	return plugin;
+}
+
+bool PluginPool::exchange(Plugin& plugin)
+{
+	std::lock_guard<std::mutex> locker(_lock);
+
+	auto iter = std::find_if(_idle.rbegin(), _idle.rend(), [&](const auto& idle) {
+		return idle.plugin.name == plugin.name && idle.plugin.appliedAttrs == plugin.attrs;
+	});
+	if (iter == _idle.rend())
+		return false;
+
+	/* the session keeps its attributes, only the instances are swapped */
+	std::swap(plugin.plugin, iter->plugin.plugin);
+	std::swap(plugin.dlHandle, iter->plugin.dlHandle);
+	std::swap(plugin.appliedAttrs, iter->plugin.appliedAttrs);
+	iter->since = Clock::now();
+
+	/* keep the list ordered by check-in time */
+	_idle.splice(_idle.end(), _idle, std::next(iter).base());
+
+	LOG_DEBUG("exchange plugin instance: %s", plugin.name.c_str());
+
+	return true;
+}
+
+bool PluginPool::checkin(Plugin&& plugin)
+{
+	if (_maxIdle == 0 || !poolable(plugin))
+		return false;
+
+	std::list<Idle> victims;
+	{
+		std::lock_guard<std::mutex> locker(_lock);
+
+		_idle.push_back({ std::move(plugin), Clock::now() });
+
+		victims = evict(Clock::now());
+	}
+
+	destroy(victims);
+
+	return true;
+}
+
+void PluginPool::clear()
+{
+	std::list<Idle> victims;
+	{
+		std::lock_guard<std::mutex> locker(_lock);
+		victims.swap(_idle);
+	}
+
+	destroy(victims);
+}
+
+size_t PluginPool::idle() const
+{
+	std::lock_guard<std::mutex> locker(_lock);
+
+	return _idle.size();
+}
+
+std::list<PluginPool::Idle> PluginPool::evict(Clock::time_point now)
+{
+	std::list<Idle> victims;
+
+	while (!_idle.empty() &&
+			(_idle.size() > _maxIdle || now - _idle.front().since > _idleTimeout))
+		victims.splice(victims.end(), _idle, _idle.begin());
+
+	return victims;
+}
+
+void PluginPool::destroy(std::list<Idle>& victims)
+{
+	/* plugins are destroyed out of the lock, it may take a while */
+	for (auto& victim : victims) {
+		LOG_DEBUG("evict plugin instance: %s", victim.plugin.name.c_str());
+		_destroyer(victim.plugin);
+	}
+
+	victims.clear();
+}
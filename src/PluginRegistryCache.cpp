@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+
+#include "PluginRegistryCache.h"
+#include "Configuration.h"
+#include "Log.h"
+
+using namespace ovi;
+
+static const std::string REGISTRY_MAGIC = "OVI_PLUGIN_REGISTRY";
+static constexpr int REGISTRY_VERSION = 1;
+
+/* strings are stored as <length>:<bytes>, so that they may contain anything */
+static void _writeString(std::ostream& os, const std::string& str)
+{
+	os << str.size() << ':' << str << '\n';
+}
+
+static bool _readString(std::istream& is, std::string& str)
+{
+	size_t len {};
+	char sep {};
+	if (!(is >> len) || !is.get(sep) || sep != ':')
+		return false;
+
+	str.resize(len);
+	return static_cast<bool>(is.read(str.data(), static_cast<std::streamsize>(len)));
+}
+
+PluginRegistryCache::PluginRegistryCache(const std::string& cachePath)
+	: _cachePath(cachePath)
+{
+}
+
+std::string PluginRegistryCache::defaultPath()
+{
+	std::string base;
+	if (auto xdg = getenv("XDG_CACHE_HOME"); xdg && *xdg)
+		base = xdg;
+	else if (auto home = getenv("HOME"); home && *home)
+		base = std::string(home) + "/.cache";
+	else
+		return {};
+
+	return base + "/ovi/plugin_registry";
+}
+
+std::optional<PluginRegistryCache::Stamp> PluginRegistryCache::stamp(const std::string& pluginPath)
+{
+	std::error_code ec {};
+	auto size = std::filesystem::file_size(pluginPath, ec);
+	if (ec)
+		return std::nullopt;
+
+	auto mtime = std::filesystem::last_write_time(pluginPath, ec);
+	if (ec)
+		return std::nullopt;
+
+	return Stamp { static_cast<int64_t>(mtime.time_since_epoch().count()), static_cast<uint64_t>(size) };
+}
+
+void PluginRegistryCache::load()
+{
+	_entries.clear();
+	_dirty = false;
+
+	if (_cachePath.empty())
+		return;
+
+	std::ifstream is(_cachePath, std::ios::binary);
+	if (!is.is_open())
+		return;
+
+	std::string magic;
+	int version {};
+	size_t count {};
+	if (!(is >> magic >> version >> count) || magic != REGISTRY_MAGIC || version != REGISTRY_VERSION) {
+		LOG_WARN("Ignore invalid plugin registry: %s", _cachePath.c_str());
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		std::string path;
+		Entry entry;
+		int lang {}, type {}, metaForm {};
+		size_t formats {}, attrs {};
+
+		if (!_readString(is, path) ||
+			!(is >> entry.stamp.mtime >> entry.stamp.size >> lang >> type >> metaForm >> formats))
+			break;
+
+		entry.info.lang = static_cast<language_e>(lang);
+		entry.info.type = static_cast<PluginType>(type);
+		entry.info.metaForm = static_cast<MetaForm>(metaForm);
+
+		entry.info.formats.resize(formats);
+		for (auto& format : entry.info.formats)
+			is >> format;
+
+		if (!_readString(is, entry.info.name) ||
+			!_readString(is, entry.info.description) ||
+			!_readString(is, entry.info.libraryPath) ||
+			!(is >> attrs))
+			break;
+
+		entry.info.attrs.resize(attrs);
+		for (auto& attr : entry.info.attrs) {
+			if (!_readString(is, attr.key) || !_readString(is, attr.type) || !_readString(is, attr.description))
+				break;
+		}
+
+		if (!is)
+			break;
+
+		_entries[path] = std::move(entry);
+	}
+
+	if (_entries.size() != count) {
+		LOG_WARN("Ignore truncated plugin registry: %s", _cachePath.c_str());
+		_entries.clear();
+	}
+}
+
+void PluginRegistryCache::save()
+{
+	if (_cachePath.empty() || !_dirty)
+		return;
+
+	std::error_code ec {};
+	std::filesystem::create_directories(std::filesystem::path(_cachePath).parent_path(), ec);
+
+	/* write a private file and rename it, so that readers never see a partial registry */
+	const std::string tmpPath = _cachePath + "." + std::to_string(getpid());
+	{
+		std::ofstream os(tmpPath, std::ios::binary | std::ios::trunc);
+		if (!os.is_open()) {
+			LOG_WARN("Failed to write plugin registry: %s", _cachePath.c_str());
+			return;
+		}
+
+		os << REGISTRY_MAGIC << ' ' << REGISTRY_VERSION << ' ' << _entries.size() << '\n';
+
+		for (const auto& [path, entry] : _entries) {
+			const auto& info = entry.info;
+
+			_writeString(os, path);
+			os << entry.stamp.mtime << ' ' << entry.stamp.size << ' '
+				<< info.lang << ' ' << info.type << ' ' << info.metaForm << ' ' << info.formats.size();
+			for (auto format : info.formats)
+				os << ' ' << format;
+			os << '\n';
+
+			_writeString(os, info.name);
+			_writeString(os, info.description);
+			_writeString(os, info.libraryPath);
+
+			os << info.attrs.size() << '\n';
+			for (const auto& attr : info.attrs) {
+				_writeString(os, attr.key);
+				_writeString(os, attr.type);
+				_writeString(os, attr.description);
+			}
+		}
+
+		if (!os.good()) {
+			std::filesystem::remove(tmpPath, ec);
+			return;
+		}
+	}
+
+	std::filesystem::rename(tmpPath, _cachePath, ec);
+	if (ec) {
+		LOG_WARN("Failed to replace plugin registry: %s", ec.message().c_str());
+		std::filesystem::remove(tmpPath, ec);
+		return;
+	}
+
+	_dirty = false;
+}
+
+std::optional<PluginInfo> PluginRegistryCache::find(const std::string& pluginPath) const
+{
+	auto iter = _entries.find(pluginPath);
+	if (iter == _entries.end())
+		return std::nullopt;
+
+	auto current = stamp(pluginPath);
+	if (!current || !(*current == iter->second.stamp))
+		return std::nullopt;
+
+	return iter->second.info;
+}
+
+void PluginRegistryCache::update(const std::string& pluginPath, const PluginInfo& info)
+{
+	/* a failure may come from a missing dependency rather than the file, so it is not kept */
+	if (info.name.empty()) {
+		if (_entries.erase(pluginPath) > 0)
+			_dirty = true;
+		return;
+	}
+
+	auto current = stamp(pluginPath);
+	if (!current)
+		return;
+
+	_entries[pluginPath] = Entry { *current, info };
+	_dirty = true;
+}
+
+void PluginRegistryCache::retain(const std::vector<std::string>& pluginPaths)
+{
+	for (auto iter = _entries.begin(); iter != _entries.end();) {
+		if (std::find(pluginPaths.begin(), pluginPaths.end(), iter->first) == pluginPaths.end()) {
+			iter = _entries.erase(iter);
+			_dirty = true;
+		} else {
+			++iter;
+		}
+	}
+}
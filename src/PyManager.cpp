@@ -16,6 +16,8 @@
 
 #ifdef OVI_ENABLE_PYTHON
 
+#include <algorithm>
+
 #include "PyManager.h"
 #include "Log.h"
 #include "Exception.h"
@@ -24,6 +26,10 @@
 
 using namespace ovi;
 
+#if PY_VERSION_HEX < 0x03090000
+#define PyObject_Vectorcall _PyObject_Vectorcall
+#endif
+
 
 PyManager::PyManager()
 	: ThreadRunner()
@@ -35,7 +41,7 @@ PyManager::~PyManager()
 {
 }
 
-PyObject* PyManager::find(int key)
+const PyManager::PyModule& PyManager::find(int key)
 {
 	auto iter = _modules.find(key);
 	if (iter == _modules.end())
@@ -58,6 +64,7 @@ PluginInfo PyManager::getPluginInfo(const std::string& moduleName)
 	});
 
 	locker.unlock();
+	_cv.notify_one();
 
 	return std::get<PluginInfo>(f.get());
 }
@@ -73,6 +80,7 @@ int PyManager::create(const std::string& moduleName)
 		.key = ++key,
 		.moduleName = moduleName,
 	});
+	_cv.notify_one();
 
 	return key;
 }
@@ -85,6 +93,7 @@ void PyManager::remove(int key)
 		.type = PY_REMOVE,
 		.key = key,
 	});
+	_cv.notify_one();
 }
 
 int PyManager::setAttributes(int key, std::map<std::string, std::string> attrs)
@@ -102,6 +111,7 @@ int PyManager::setAttributes(int key, std::map<std::string, std::string> attrs)
 	});
 
 	locker.unlock();
+	_cv.notify_one();
 
 	return std::get<bool>(f.get()) ? OVI_ERROR_NONE : OVI_ERROR_INVALID_PARAMETER;
 }
@@ -121,6 +131,7 @@ Outcome PyManager::process(int key, FramePack* frame)
 	});
 
 	locker.unlock();
+	_cv.notify_one();
 
 	return std::get<Outcome>(f.get());
 }
@@ -135,14 +146,13 @@ void PyManager::worker()
 	while (_run.load()) {
 		std::unique_lock<std::mutex> locker(_m);
 
-		if (_req.empty()) {
-			locker.unlock();
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		/* wake up periodically to notice stop() */
+		if (!_cv.wait_for(locker, std::chrono::milliseconds(100), [this] { return !_req.empty(); }))
 			continue;
-		}
 
 		auto data = _req.front();
 		_req.pop();
+		locker.unlock();
 
 		switch (data.type) {
 		case PY_INFO:
@@ -171,8 +181,11 @@ void PyManager::worker()
 		}
 	}
 	/* Do not use spdlog here */
-	for (auto& it : _modules)
-		Py_DECREF(it.second);
+	for (auto& it : _modules) {
+		Py_XDECREF(it.second.process);
+		Py_XDECREF(it.second.setAttrs);
+		Py_XDECREF(it.second.module);
+	}
 
 	_modules.clear();
 	Py_FinalizeEx();
@@ -245,6 +258,111 @@ static std::vector<Attribute> _getListForPy(PyObject* mod, const std::string& fu
 	return res;
 }
 
+FrameLayout ovi::frameLayout(const FramePack* frame)
+{
+	const Py_ssize_t bytes = static_cast<Py_ssize_t>(frame->size());
+	FrameLayout layout { "B", 1, { bytes } };
+
+	if (frame->type() == MEDIA_TYPE_VIDEO) {
+		auto vFrame = dynamic_cast<const VideoFramePack*>(frame);
+		auto [width, height, format] = vFrame->videoProperties();
+
+		switch (format) {
+		case VIDEO_FORMAT_RGB24:
+		case VIDEO_FORMAT_BGR24:
+			layout.shape = { height, width, 3 };
+			break;
+		case VIDEO_FORMAT_ARGB:
+		case VIDEO_FORMAT_RGBA:
+		case VIDEO_FORMAT_ABGR:
+		case VIDEO_FORMAT_BGRA:
+			layout.shape = { height, width, 4 };
+			break;
+		case VIDEO_FORMAT_GRAY8:
+			layout.shape = { height, width };
+			break;
+		default:
+			/* planar formats are passed as flat bytes */
+			break;
+		}
+	} else if (frame->type() == MEDIA_TYPE_AUDIO) {
+		auto aFrame = dynamic_cast<const AudioFramePack*>(frame);
+		auto [channels, samplerate, format, samples] = aFrame->audioProperties();
+		std::ignore = samplerate;
+
+		static const std::map<AudioFormat, std::pair<const char*, Py_ssize_t>> sampleTypes {
+			{ AUDIO_FORMAT_U8, { "B", 1 } }, { AUDIO_FORMAT_U8P, { "B", 1 } },
+			{ AUDIO_FORMAT_S16, { "h", 2 } }, { AUDIO_FORMAT_S16P, { "h", 2 } },
+			{ AUDIO_FORMAT_S32, { "i", 4 } }, { AUDIO_FORMAT_S32P, { "i", 4 } },
+			{ AUDIO_FORMAT_FLT, { "f", 4 } }, { AUDIO_FORMAT_FLTP, { "f", 4 } },
+			{ AUDIO_FORMAT_DBL, { "d", 8 } }, { AUDIO_FORMAT_DBLP, { "d", 8 } },
+			{ AUDIO_FORMAT_S64, { "q", 8 } }, { AUDIO_FORMAT_S64P, { "q", 8 } },
+		};
+
+		auto iter = sampleTypes.find(format);
+		if (iter != sampleTypes.end()) {
+			std::tie(layout.format, layout.itemsize) = iter->second;
+			if (format >= AUDIO_FORMAT_U8P)
+				layout.shape = { channels, samples };
+			else
+				layout.shape = { samples, channels };
+		}
+	}
+
+	Py_ssize_t items = 1;
+	for (auto dim : layout.shape)
+		items *= dim;
+
+	if (items * layout.itemsize != bytes)
+		layout = { "B", 1, { bytes } };
+
+	return layout;
+}
+
+/* The frame is handed to python as a read-only memoryview over FramePack::data(),
+ * so that numpy.asarray()/numpy.frombuffer() can wrap it without copying. */
+static PyObject* _makeFrameView(const FramePack* frame)
+{
+	auto layout = frameLayout(frame);
+
+	std::vector<Py_ssize_t> strides(layout.shape.size());
+	Py_ssize_t stride = layout.itemsize;
+	for (size_t i = layout.shape.size(); i > 0; i--) {
+		strides[i - 1] = stride;
+		stride *= layout.shape[i - 1];
+	}
+
+	/* memoryview copies shape and strides, but keeps the format pointer */
+	Py_buffer view {};
+	view.buf = const_cast<void*>(frame->data());
+	view.len = static_cast<Py_ssize_t>(frame->size());
+	view.readonly = 1;
+	view.itemsize = layout.itemsize;
+	view.format = const_cast<char*>(layout.format);
+	view.ndim = static_cast<int>(layout.shape.size());
+	view.shape = layout.shape.data();
+	view.strides = strides.data();
+
+	return PyMemoryView_FromBuffer(&view);
+}
+
+/* The view must not outlive the call, since the frame buffer is reused once
+ * the plugin returns. release() fails if the plugin kept an export of it. */
+static void _releaseFrameView(PyObject* view)
+{
+	if (!view)
+		return;
+
+	auto res = PyObject_CallMethod(view, "release", nullptr);
+	if (!res) {
+		PyErr_Clear();
+		LOG_WARN("Python plugin keeps a reference to the frame after process()");
+	}
+
+	Py_XDECREF(res);
+	Py_DECREF(view);
+}
+
 void PyManager::pyGetPluginInfo(const QueueData& data)
 {
 	auto name = PyUnicode_DecodeFSDefault(data.moduleName.c_str());
@@ -272,14 +390,151 @@ void PyManager::pyGetPluginInfo(const QueueData& data)
 	Py_DECREF(mod);
 }
 
+static PyObject* _getCallableForPy(PyObject* mod, const char* funcName)
+{
+	auto func = PyObject_GetAttrString(mod, funcName);
+	if (func && PyCallable_Check(func))
+		return func;
+
+	PyErr_Clear();
+	Py_XDECREF(func);
+	LOG_ERROR("No callable %s", funcName);
+
+	return nullptr;
+}
+
+static bool _isNumberForPy(PyObject* obj)
+{
+	return PyFloat_Check(obj) || (PyLong_Check(obj) && !PyBool_Check(obj));
+}
+
+/* fast path: a packed (N, 4) float64 array of x, y, width, height */
+static bool _decodeRectArrayForPy(PyObject* obj, Details& list)
+{
+	Py_buffer view {};
+	if (PyObject_GetBuffer(obj, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) != 0) {
+		PyErr_Clear();
+		LOG_ERROR("Boxes must be a C-contiguous buffer");
+		return false;
+	}
+
+	const std::string format = view.format ? view.format : "B";
+	bool valid = (format == "d" || format == "<d" || format == "=d" || format == "@d") &&
+				view.itemsize == sizeof(double) &&
+				((view.ndim == 2 && view.shape[1] == 4) || view.len == 0);
+
+	if (valid) {
+		auto values = static_cast<const double*>(view.buf);
+		size_t count = static_cast<size_t>(view.len) / (4 * sizeof(double));
+
+		list.reserve(list.size() + count);
+		for (size_t i = 0; i < count; i++, values += 4)
+			list.push_back(OVIRect { values[0], values[1], values[2], values[3] });
+	} else {
+		LOG_ERROR("Boxes must be (N, 4) float64, not ndim %d of '%s'", view.ndim, format.c_str());
+	}
+
+	PyBuffer_Release(&view);
+
+	return valid;
+}
+
+static bool _decodeRectForPy(PyObject* item, Details& list)
+{
+	PyObject* seq = PySequence_Fast(item, "");
+	if (!seq || PySequence_Fast_GET_SIZE(seq) != 4) {
+		PyErr_Clear();
+		Py_XDECREF(seq);
+		return false;
+	}
+
+	double v[4] {};
+	PyObject** values = PySequence_Fast_ITEMS(seq);
+	for (int i = 0; i < 4; i++) {
+		if (!_isNumberForPy(values[i])) {
+			Py_DECREF(seq);
+			return false;
+		}
+		v[i] = PyFloat_AsDouble(values[i]);
+	}
+
+	Py_DECREF(seq);
+	list.push_back(OVIRect { v[0], v[1], v[2], v[3] });
+
+	return true;
+}
+
+/* Accepts (detect, details) where details is a list/tuple of (x, y, w, h)
+ * or bool items, an (N, 4) float64 array, or a number for audio plugins. */
+static bool _decodeOutcomeForPy(PyObject* value, Outcome& o)
+{
+	if (!value) {
+		PyErr_Print();
+		return false;
+	}
+
+	if (!PyTuple_Check(value) || PyTuple_GET_SIZE(value) != 2) {
+		LOG_ERROR("process() must return a (detect, details) tuple");
+		return false;
+	}
+
+	auto detect = PyTuple_GET_ITEM(value, 0);
+	auto details = PyTuple_GET_ITEM(value, 1);
+
+	if (!PyBool_Check(detect) && !PyLong_Check(detect)) {
+		LOG_ERROR("detect must be a bool");
+		return false;
+	}
+	o.detect = PyObject_IsTrue(detect);
+
+	if (_isNumberForPy(details)) {
+		o.list.push_back(PyFloat_AsDouble(details));
+		return true;
+	}
+
+	if (!PyList_Check(details) && !PyTuple_Check(details)) {
+		if (PyObject_CheckBuffer(details))
+			return _decodeRectArrayForPy(details, o.list);
+
+		LOG_ERROR("Unsupported details type: %s", Py_TYPE(details)->tp_name);
+		return false;
+	}
+
+	PyObject* seq = PySequence_Fast(details, "");
+	Py_ssize_t len = PySequence_Fast_GET_SIZE(seq);
+	PyObject** items = PySequence_Fast_ITEMS(seq);
+
+	o.list.reserve(len);
+	for (Py_ssize_t i = 0; i < len; i++) {
+		auto item = items[i];
+		if (PyBool_Check(item)) {
+			o.list.push_back(item == Py_True);
+		} else if (!_decodeRectForPy(item, o.list)) {
+			LOG_ERROR("Unsupported detail item: %s", Py_TYPE(item)->tp_name);
+			Py_DECREF(seq);
+			return false;
+		}
+	}
+
+	Py_DECREF(seq);
+
+	return true;
+}
+
 void PyManager::pyCreate(const QueueData& data)
 {
 	auto name = PyUnicode_DecodeFSDefault(data.moduleName.c_str());
 	auto mod = PyImport_Import(name);
 	Py_DECREF(name);
 
+	if (!mod) {
+		PyErr_Print();
+		LOG_ERROR("Import python module failed: %s", data.moduleName.c_str());
+		return;
+	}
+
 	_modules.insert({
-		data.key, mod
+		data.key, { mod, _getCallableForPy(mod, "process"), _getCallableForPy(mod, "setAttrs") }
 	});
 }
 
@@ -287,7 +542,9 @@ void PyManager::pyDelete(const QueueData& data)
 {
 	try {
 		auto mod = find(data.key);
-		Py_DECREF(mod);
+		Py_XDECREF(mod.process);
+		Py_XDECREF(mod.setAttrs);
+		Py_DECREF(mod.module);
 		_modules.erase(data.key);
 	} catch (const Exception& e) {
 		LOG_ERROR("No item");
@@ -297,8 +554,7 @@ void PyManager::pyDelete(const QueueData& data)
 void PyManager::pySetAttrs(const QueueData& data)
 {
 	try {
-		auto mod = find(data.key);
-		auto func = PyObject_GetAttrString(mod, "setAttrs");
+		auto func = find(data.key).setAttrs;
 
 		if (func == nullptr) {
 			LOG_ERROR("Get function failed");
@@ -307,22 +563,24 @@ void PyManager::pySetAttrs(const QueueData& data)
 			return;
 		}
 
-		auto args = PyTuple_New(1);
 		auto dict = PyDict_New();
-		for (const auto& item : data.attrs)
-			PyDict_SetItemString(dict, item.first.c_str(), PyUnicode_FromString(item.second.c_str()));
+		for (const auto& item : data.attrs) {
+			auto value = PyUnicode_FromString(item.second.c_str());
+			PyDict_SetItemString(dict, item.first.c_str(), value);
+			Py_DECREF(value);
+		}
 
-		PyTuple_SetItem(args, 0, dict);
+		PyObject* args[] = { dict };
+		auto value = PyObject_Vectorcall(func, args, 1, nullptr);
+		if (!value)
+			PyErr_Print();
 
-		auto value = PyObject_CallObject(func, args);
-		auto res = static_cast<int>(PyLong_AsLong(value));
+		auto res = value ? static_cast<int>(PyLong_AsLong(value)) : -1;
 
 		data.response->set_value(res == 0);
 
 		Py_DECREF(dict);
-		Py_DECREF(args);
-		Py_DECREF(value);
-		Py_DECREF(func);
+		Py_XDECREF(value);
 	} catch (const Exception& e) {
 		LOG_ERROR("No item");
 		data.response->set_value(false);
@@ -333,74 +591,58 @@ void PyManager::pyProcess(const QueueData& data)
 {
 	Outcome o;
 	try {
-		auto mod = find(data.key);
-		PyObject* func = PyObject_GetAttrString(mod, "process");
+		auto func = find(data.key).process;
 		if (func == nullptr) {
 			LOG_ERROR("Get function failed");
 			data.response->set_value(o);
 			return;
 		}
 
+		PyObject* args[5] {};
+		size_t nargs {};
+
 		if (data.frame->type() == MEDIA_TYPE_VIDEO) {
 			ovi::VideoFramePack* vFrame = dynamic_cast<ovi::VideoFramePack*>(data.frame);
 			assert(vFrame);
-			int width {};
-			int height {};
-			std::tie(width, height, std::ignore) = vFrame->videoProperties();
-
-			auto args = Py_BuildValue("(iiy#Lf)",
-				width, height, vFrame->data(), vFrame->size(), vFrame->duration(), vFrame->framerate());
-			auto value = PyObject_CallObject(func, args);
-			Py_DECREF(args);
-
-			//TODO: Need to check value type before casting..
-			if (PyTuple_Check(value)) {
-				o.detect = PyLong_AsLong(PyTuple_GET_ITEM(value, 0));
-				auto list = PyTuple_GET_ITEM(value, 1);
-				size_t len = PyList_GET_SIZE(list);
-
-				for (size_t i = 0; i < len; i++) {
-					auto item = PyList_GET_ITEM(list, i);
-					if (PyTuple_Check(item)) {
-						auto x = PyLong_AsLong(PyTuple_GET_ITEM(item, 0));
-						auto y = PyLong_AsLong(PyTuple_GET_ITEM(item, 1));
-						auto w = PyLong_AsLong(PyTuple_GET_ITEM(item, 2));
-						auto h = PyLong_AsLong(PyTuple_GET_ITEM(item, 3));
-
-						OVIRect r {
-							static_cast<double>(x),
-							static_cast<double>(y),
-							static_cast<double>(w),
-							static_cast<double>(h),
-						};
-						o.list.push_back(r);
-					} else if (PyBool_Check(item)) {
-						bool v = PyObject_IsTrue(item);
-						o.list.push_back(v);
-					}
-				}
-			}
-
-			Py_DECREF(value);
-			Py_DECREF(func);
-
+			auto [width, height, format] = vFrame->videoProperties();
+			std::ignore = format;
+
+			args[nargs++] = PyLong_FromLong(width);
+			args[nargs++] = PyLong_FromLong(height);
+			args[nargs++] = _makeFrameView(vFrame);
+			args[nargs++] = PyLong_FromLongLong(vFrame->duration());
+			args[nargs++] = PyFloat_FromDouble(vFrame->framerate());
 		} else if (data.frame->type() == MEDIA_TYPE_AUDIO) {
 			ovi::AudioFramePack* aFrame = dynamic_cast<ovi::AudioFramePack*>(data.frame);
 			assert(aFrame);
 			auto [channels, samplerate, format, samples] = aFrame->audioProperties();
 
-			auto args = Py_BuildValue("(iiiiy#)", channels, samplerate, format, samples, aFrame->data(), aFrame->size());
-			auto value = PyObject_CallObject(func, args);
-			Py_DECREF(args);
-			if (PyTuple_Check(value)) {
-				o.detect = PyLong_AsLong(PyTuple_GET_ITEM(value, 0));
-				auto db = PyFloat_AsDouble(PyTuple_GET_ITEM(value, 1));
-				o.list.push_back(db);
-			}
+			args[nargs++] = PyLong_FromLong(channels);
+			args[nargs++] = PyLong_FromLong(samplerate);
+			args[nargs++] = PyLong_FromLong(format);
+			args[nargs++] = PyLong_FromLong(samples);
+			args[nargs++] = _makeFrameView(aFrame);
+		}
 
-			Py_DECREF(value);
-			Py_DECREF(func);
+		bool ready = nargs > 0 && std::all_of(args, args + nargs, [](auto arg) { return arg != nullptr; });
+		if (ready) {
+			auto value = PyObject_Vectorcall(func, args, nargs, nullptr);
+
+			if (!_decodeOutcomeForPy(value, o))
+				o = Outcome {};
+
+			Py_XDECREF(value);
+		} else {
+			PyErr_Print();
+		}
+
+		/* the frame view is released explicitly, the other arguments are just dropped */
+		auto frameView = (data.frame->type() == MEDIA_TYPE_VIDEO) ? args[2] : args[4];
+		for (size_t i = 0; i < nargs; i++) {
+			if (args[i] != frameView)
+				Py_XDECREF(args[i]);
 		}
+		_releaseFrameView(frameView);
 
 		data.response->set_value(o);
 	} catch (const Exception& e) {
@@ -18,6 +18,8 @@
 
 #include "PyPluginProcess.h"
 #include "PyManager.h"
+#include "PyWorkerPool.h"
+#include "Exception.h"
 
 using namespace ovi;
 
@@ -42,4 +44,80 @@ Outcome PyPlugin::process(ovi::FramePack* frame)
 	return _pyManager->process(_pluginId, frame);
 }
 
+/* Workers are shared by the instances of the same attributes, so each call leases one */
+template <typename Func>
+static auto _withWorker(PyWorkerPool& pool, const std::string& moduleName, const PyWorkerAttrs& attrs, Func func)
+{
+	auto worker = pool.acquire(moduleName, attrs);
+
+	try {
+		auto res = func(*worker);
+		pool.release(moduleName, attrs, std::move(worker));
+		return res;
+	} catch (...) {
+		/* a broken worker is not returned to the pool */
+		worker.reset();
+		pool.discard(moduleName, attrs);
+		throw;
+	}
+}
+
+PyWorkerPlugin::PyWorkerPlugin(std::shared_ptr<PyWorkerPool> pool, const std::string& moduleName)
+	: _moduleName(moduleName), _pool(pool)
+{
+	_pool->attach(_moduleName, _attrs);
+}
+
+PyWorkerPlugin::~PyWorkerPlugin()
+{
+	_pool->detach(_moduleName, _attrs);
+}
+
+int PyWorkerPlugin::setAttrs(const std::map<std::string, std::string>& attrs)
+{
+	/* the worker gets every attribute of the instance, not only the ones given */
+	auto merged = _attrs;
+	for (const auto& [key, value] : attrs)
+		merged[key] = value;
+
+	if (merged == _attrs)
+		return OVI_ERROR_NONE;
+
+	/* the attributes are checked by a worker of the new set, which is kept for the instance */
+	int ret {};
+	_pool->attach(_moduleName, merged);
+	try {
+		ret = _withWorker(*_pool, _moduleName, merged, [&](PyWorker& worker) {
+			return worker.attrs() ? OVI_ERROR_NONE : worker.setAttrs(merged);
+		});
+	} catch (...) {
+		_pool->detach(_moduleName, merged);
+		throw;
+	}
+
+	if (ret != OVI_ERROR_NONE) {
+		_pool->detach(_moduleName, merged);
+		return ret;
+	}
+
+	_pool->detach(_moduleName, _attrs);
+	_attrs = std::move(merged);
+
+	return OVI_ERROR_NONE;
+}
+
+Outcome PyWorkerPlugin::process(ovi::FramePack* frame)
+{
+	return _withWorker(*_pool, _moduleName, _attrs, [&](PyWorker& worker) {
+		/* a new worker is configured by its first user */
+		if (!worker.attrs()) {
+			int ret = worker.setAttrs(_attrs);
+			if (ret != OVI_ERROR_NONE)
+				throw Exception(ret, "Failed to set the attributes of " + _moduleName);
+		}
+
+		return worker.process(frame);
+	});
+}
+
 #endif /* OVI_ENABLE_PYTHON */
\ No newline at end of file
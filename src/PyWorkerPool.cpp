@@ -0,0 +1,444 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef OVI_ENABLE_PYTHON
+
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cstring>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include "PyWorkerPool.h"
+#include "PyManager.h"
+#include "Log.h"
+#include "Exception.h"
+
+using namespace ovi;
+
+namespace {
+
+enum : uint32_t {
+	WORKER_OP_ATTRS = 1,
+	WORKER_OP_PROCESS_VIDEO,
+	WORKER_OP_PROCESS_AUDIO,
+	WORKER_OP_QUIT,
+};
+
+enum : uint32_t {
+	WORKER_STATUS_OK = 0,
+	WORKER_STATUS_ERROR,
+};
+
+enum : uint32_t {
+	WORKER_ITEM_RECT = 0,
+	WORKER_ITEM_BOOL,
+	WORKER_ITEM_DOUBLE,
+};
+
+/* Must match HEADER in OVIWorker.py */
+struct WorkerHeader {
+	uint32_t op;
+	uint32_t status;
+	uint64_t payloadSize;
+	uint64_t mapSize;
+	int32_t args[4];
+	int64_t duration;
+	double framerate;
+	uint32_t detect;
+	uint32_t count;
+	char typecode[4];
+	uint32_t ndim;
+	int64_t shape[3];
+};
+static_assert(sizeof(WorkerHeader) == 96, "WorkerHeader layout is shared with OVIWorker.py");
+
+/* Must match ITEM in OVIWorker.py */
+struct WorkerItem {
+	uint32_t type;
+	uint32_t reserved;
+	double value[4];
+};
+static_assert(sizeof(WorkerItem) == 40, "WorkerItem layout is shared with OVIWorker.py");
+
+constexpr size_t PAYLOAD_OFFSET = 128;
+constexpr size_t INITIAL_MAP_SIZE = 1 << 20;
+constexpr int POLL_INTERVAL_MS = 200;
+constexpr int QUIT_WAIT_MS = 1000;
+
+}
+
+PyWorker::PyWorker(const std::string& interpreter, const std::string& moduleName)
+	: _moduleName(moduleName)
+{
+	try {
+		spawn(interpreter);
+	} catch (const Exception& e) {
+		terminate();
+		throw;
+	}
+}
+
+PyWorker::~PyWorker()
+{
+	terminate();
+}
+
+void PyWorker::spawn(const std::string& interpreter)
+{
+	_shmFd = memfd_create("ovi-pyworker", MFD_CLOEXEC);
+	_reqFd = eventfd(0, EFD_CLOEXEC);
+	_respFd = eventfd(0, EFD_CLOEXEC);
+	if (_shmFd < 0 || _reqFd < 0 || _respFd < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "Failed to create python worker channel");
+
+	reserve(INITIAL_MAP_SIZE - PAYLOAD_OFFSET);
+
+	std::vector<std::string> args {
+		interpreter,
+		std::string(PLUGIN_SRC_DIR) + "/OVIWorker.py",
+		PLUGIN_INSTALLED_DIR,
+		_moduleName,
+		std::to_string(_shmFd),
+		std::to_string(_reqFd),
+		std::to_string(_respFd),
+	};
+
+	std::vector<char*> argv;
+	for (auto& arg : args)
+		argv.push_back(arg.data());
+	argv.push_back(nullptr);
+
+	const int fds[] = { _shmFd, _reqFd, _respFd };
+
+	_pid = fork();
+	if (_pid < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "Failed to fork python worker");
+
+	if (_pid == 0) {
+		/* only async-signal-safe calls until exec */
+		prctl(PR_SET_PDEATHSIG, SIGTERM);
+		for (auto fd : fds)
+			fcntl(fd, F_SETFD, 0);
+
+		execvp(argv[0], argv.data());
+		_exit(127);
+	}
+
+	LOG_INFO("python worker for %s started: %d", _moduleName.c_str(), _pid);
+}
+
+void PyWorker::terminate()
+{
+	if (_pid > 0) {
+		if (_map) {
+			uint64_t signal = 1;
+			static_cast<WorkerHeader*>(_map)->op = WORKER_OP_QUIT;
+			if (write(_reqFd, &signal, sizeof(signal)) < 0)
+				kill(_pid, SIGTERM);
+		}
+
+		int waited = 0;
+		while (waitpid(_pid, nullptr, WNOHANG) == 0) {
+			if (waited >= QUIT_WAIT_MS) {
+				kill(_pid, SIGKILL);
+				waitpid(_pid, nullptr, 0);
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			waited += 10;
+		}
+		_pid = -1;
+	}
+
+	if (_map)
+		munmap(_map, _mapSize);
+	_map = nullptr;
+	_mapSize = 0;
+
+	for (auto fd : { &_shmFd, &_reqFd, &_respFd }) {
+		if (*fd >= 0)
+			close(*fd);
+		*fd = -1;
+	}
+}
+
+void PyWorker::reserve(size_t payloadSize)
+{
+	size_t required = PAYLOAD_OFFSET + payloadSize;
+	if (required <= _mapSize)
+		return;
+
+	size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t size = std::max(required, _mapSize * 2);
+	size = (size + pageSize - 1) / pageSize * pageSize;
+
+	if (ftruncate(_shmFd, static_cast<off_t>(size)) != 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "Failed to grow python worker memory");
+
+	void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _shmFd, 0);
+	if (map == MAP_FAILED)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "Failed to map python worker memory");
+
+	if (_map)
+		munmap(_map, _mapSize);
+
+	/* the worker remaps itself when it sees the new size in the header */
+	_map = map;
+	_mapSize = size;
+	static_cast<WorkerHeader*>(_map)->mapSize = _mapSize;
+}
+
+void PyWorker::call(uint32_t op)
+{
+	auto header = static_cast<WorkerHeader*>(_map);
+	header->op = op;
+	header->status = WORKER_STATUS_ERROR;
+
+	uint64_t signal = 1;
+	if (write(_reqFd, &signal, sizeof(signal)) != sizeof(signal))
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "Failed to signal python worker");
+
+	pollfd pfd { _respFd, POLLIN, 0 };
+	while (true) {
+		int ret = poll(&pfd, 1, POLL_INTERVAL_MS);
+		if (ret > 0)
+			break;
+
+		if (ret < 0 && errno != EINTR)
+			throw Exception(OVI_ERROR_INVALID_OPERATION, "Failed to wait python worker");
+
+		if (waitpid(_pid, nullptr, WNOHANG) == _pid) {
+			_pid = -1;
+			throw Exception(OVI_ERROR_INVALID_OPERATION, "python worker exited: " + _moduleName);
+		}
+	}
+
+	if (read(_respFd, &signal, sizeof(signal)) != sizeof(signal))
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "Failed to read python worker response");
+}
+
+int PyWorker::setAttrs(const std::map<std::string, std::string>& attrs)
+{
+	std::string payload;
+	for (const auto& [key, value] : attrs) {
+		payload.append(key).push_back('\0');
+		payload.append(value).push_back('\0');
+	}
+
+	reserve(payload.size());
+
+	auto header = static_cast<WorkerHeader*>(_map);
+	memcpy(static_cast<char*>(_map) + PAYLOAD_OFFSET, payload.data(), payload.size());
+	header->payloadSize = payload.size();
+
+	_attrs.reset();
+	call(WORKER_OP_ATTRS);
+
+	if (header->status != WORKER_STATUS_OK)
+		return OVI_ERROR_INVALID_PARAMETER;
+
+	_attrs = attrs;
+
+	return OVI_ERROR_NONE;
+}
+
+Outcome PyWorker::process(FramePack* frame)
+{
+	auto layout = frameLayout(frame);
+
+	reserve(frame->size());
+
+	auto header = static_cast<WorkerHeader*>(_map);
+	auto payload = static_cast<char*>(_map) + PAYLOAD_OFFSET;
+
+	memcpy(payload, frame->data(), frame->size());
+	header->payloadSize = frame->size();
+	header->duration = frame->duration();
+	header->framerate = frame->framerate();
+
+	memset(header->typecode, 0, sizeof(header->typecode));
+	strncpy(header->typecode, layout.format, sizeof(header->typecode) - 1);
+	header->ndim = static_cast<uint32_t>(layout.shape.size());
+	for (size_t i = 0; i < layout.shape.size() && i < 3; i++)
+		header->shape[i] = layout.shape[i];
+
+	uint32_t op {};
+	if (frame->type() == MEDIA_TYPE_VIDEO) {
+		auto vFrame = dynamic_cast<VideoFramePack*>(frame);
+		auto [width, height, format] = vFrame->videoProperties();
+		header->args[0] = width;
+		header->args[1] = height;
+		header->args[2] = format;
+		header->args[3] = 0;
+		op = WORKER_OP_PROCESS_VIDEO;
+	} else if (frame->type() == MEDIA_TYPE_AUDIO) {
+		auto aFrame = dynamic_cast<AudioFramePack*>(frame);
+		auto [channels, samplerate, format, samples] = aFrame->audioProperties();
+		header->args[0] = channels;
+		header->args[1] = samplerate;
+		header->args[2] = format;
+		header->args[3] = samples;
+		op = WORKER_OP_PROCESS_AUDIO;
+	} else {
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, "Unsupported frame type");
+	}
+
+	call(op);
+
+	Outcome o;
+	if (header->status != WORKER_STATUS_OK) {
+		LOG_ERROR("python worker failed to process: %s", _moduleName.c_str());
+		return o;
+	}
+
+	o.detect = header->detect != 0;
+
+	/* results are written over the frame, which is no longer needed */
+	auto items = reinterpret_cast<const WorkerItem*>(payload);
+	size_t count = std::min<size_t>(header->count, (_mapSize - PAYLOAD_OFFSET) / sizeof(WorkerItem));
+
+	for (size_t i = 0; i < count; i++) {
+		const auto& item = items[i];
+		switch (item.type) {
+		case WORKER_ITEM_RECT:
+			o.list.push_back(OVIRect { item.value[0], item.value[1], item.value[2], item.value[3] });
+			break;
+		case WORKER_ITEM_BOOL:
+			o.list.push_back(item.value[0] != 0.0);
+			break;
+		case WORKER_ITEM_DOUBLE:
+			o.list.push_back(item.value[0]);
+			break;
+		default:
+			LOG_WARN("Unknown item type: %u", item.type);
+			break;
+		}
+	}
+
+	return o;
+}
+
+PyWorkerPool::PyWorkerPool(const std::string& interpreter, size_t replicas)
+	: _interpreter(interpreter), _maxReplicas(std::max<size_t>(replicas, 1))
+{
+}
+
+void PyWorkerPool::attach(const std::string& moduleName, const PyWorkerAttrs& attrs)
+{
+	std::lock_guard<std::mutex> locker(_m);
+
+	_replicas[moduleName][attrs].users++;
+}
+
+void PyWorkerPool::detach(const std::string& moduleName, const PyWorkerAttrs& attrs)
+{
+	std::vector<PyWorkerPtr> stopped;
+	std::lock_guard<std::mutex> locker(_m);
+
+	auto& replicas = _replicas[moduleName][attrs];
+	if (replicas.users > 0)
+		replicas.users--;
+	stopped = drop(moduleName, attrs);
+}
+
+std::vector<PyWorkerPtr> PyWorkerPool::drop(const std::string& moduleName, const PyWorkerAttrs& attrs)
+{
+	auto& sets = _replicas[moduleName];
+	auto iter = sets.find(attrs);
+	if (iter == sets.end() || iter->second.users > 0)
+		return {};
+
+	auto& replicas = iter->second;
+	auto stopped = std::move(replicas.idle);
+	replicas.count -= std::min(replicas.count, stopped.size());
+
+	/* the leased workers are dropped when they come back */
+	if (replicas.count == 0)
+		sets.erase(iter);
+	if (sets.empty())
+		_replicas.erase(moduleName);
+
+	return stopped;
+}
+
+PyWorkerPtr PyWorkerPool::acquire(const std::string& moduleName, const PyWorkerAttrs& attrs)
+{
+	std::unique_lock<std::mutex> locker(_m);
+
+	auto& replicas = _replicas[moduleName][attrs];
+	_cv.wait(locker, [&] { return !replicas.idle.empty() || replicas.count < _maxReplicas; });
+
+	if (!replicas.idle.empty()) {
+		auto worker = std::move(replicas.idle.back());
+		replicas.idle.pop_back();
+		return worker;
+	}
+
+	replicas.count++;
+	locker.unlock();
+
+	try {
+		return std::make_unique<PyWorker>(_interpreter, moduleName);
+	} catch (...) {
+		discard(moduleName, attrs);
+		throw;
+	}
+}
+
+void PyWorkerPool::release(const std::string& moduleName, const PyWorkerAttrs& attrs, PyWorkerPtr worker)
+{
+	std::vector<PyWorkerPtr> stopped;
+	std::lock_guard<std::mutex> locker(_m);
+
+	_replicas[moduleName][attrs].idle.push_back(std::move(worker));
+	stopped = drop(moduleName, attrs);
+	_cv.notify_all();
+}
+
+void PyWorkerPool::discard(const std::string& moduleName, const PyWorkerAttrs& attrs)
+{
+	std::vector<PyWorkerPtr> stopped;
+	std::lock_guard<std::mutex> locker(_m);
+
+	auto& replicas = _replicas[moduleName][attrs];
+	if (replicas.count > 0)
+		replicas.count--;
+	stopped = drop(moduleName, attrs);
+	_cv.notify_all();
+}
+
+size_t PyWorkerPool::workers()
+{
+	std::lock_guard<std::mutex> locker(_m);
+
+	size_t count = 0;
+	for (const auto& [ moduleName, sets ] : _replicas) {
+		for (const auto& [ attrs, replicas ] : sets)
+			count += replicas.count;
+	}
+
+	return count;
+}
+
+#endif /* OVI_ENABLE_PYTHON */
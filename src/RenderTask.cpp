@@ -15,53 +15,160 @@
  */
 
 #include "RenderTask.h"
+#include "Configuration.h"
+#include "DetectionTracker.h"
 #include "Log.h"
 
+#include <algorithm>
+#include <thread>
+
 using namespace ovi;
 
 RenderTask::RenderTask(const std::string& mediaPath,
 					std::shared_ptr<PluginManager> pluginManager,
-					const std::string& renderId,
+					const std::vector<RenderTarget>& targets,
 					MediaType type,
 					int64_t videoFrames,
 					double framerate,
-					const std::vector<RawData>& accumulated,
+					const AccumulatedData& accumulated,
 					std::shared_ptr<IInvokable> completeCb,
-					const std::string& outputPath)
-	: _pluginManager(pluginManager)
+					std::shared_ptr<IInvokable> targetCb)
+	: _mediaPath(mediaPath)
+	, _pluginManager(pluginManager)
+	, _type(type)
+	, _videoFrames(videoFrames)
+	, _framerate(framerate)
+	, _completeCb(completeCb)
+	, _targetCb(targetCb)
+	, _trackTolerance(Configuration::instance().get(CATEGORY_CORE, CORE_TRACK_TOLERANCE, 2.0))
+	, _trackGap(Configuration::instance().get(CATEGORY_CORE, CORE_TRACK_GAP, 0))
+	, _renderWorkers(Configuration::instance().get(CATEGORY_CORE, CORE_RENDER_WORKERS, 0))
 {
+	makeOutputs(targets);
+
 	_future = std::async([=] {
 		LOG_DEBUG("Entering task...");
 
-		auto renderObj = dynamic_cast<IPluginRender*>(pluginManager->find(renderId).plugin);
-		assert(renderObj);
+		ovi_error_e error;
+		try {
+			setAttrs();
+			resetTimelines();
+			appendClips(accumulated);
+
+			error = renderAll();
+		} catch (const Exception& e) {
+			LOG_ERROR("%s", e.what());
+			error = fail(static_cast<ovi_error_e>(e.error()));
+		}
+
+		_completeCb->invoke(error);
+
+		LOG_DEBUG("task terminated");
+	});
+}
+
+RenderTask::RenderTask(const std::string& mediaPath,
+					std::shared_ptr<PluginManager> pluginManager,
+					const std::vector<RenderTarget>& targets,
+					MediaType type,
+					int64_t videoFrames,
+					double framerate,
+					std::shared_ptr<IInvokable> completeCb,
+					std::shared_ptr<IInvokable> targetCb)
+	: _mediaPath(mediaPath)
+	, _pluginManager(pluginManager)
+	, _type(type)
+	, _videoFrames(videoFrames)
+	, _framerate(framerate)
+	, _completeCb(completeCb)
+	, _targetCb(targetCb)
+	, _trackTolerance(Configuration::instance().get(CATEGORY_CORE, CORE_TRACK_TOLERANCE, 2.0))
+	, _trackGap(Configuration::instance().get(CATEGORY_CORE, CORE_TRACK_GAP, 0))
+	, _renderWorkers(Configuration::instance().get(CATEGORY_CORE, CORE_RENDER_WORKERS, 0))
+{
+	makeOutputs(targets);
+
+	_analyzer = std::make_shared<StreamingDataAnalyzer>(framerate, [this](TimeRangeWithMetadata&& range) {
+		std::lock_guard<std::mutex> lock(_lock);
+		_ranges.push_back(std::move(range));
+		_cond.notify_one();
+	});
+
+	_future = std::async(std::launch::async, [=] {
+		LOG_DEBUG("Entering streaming task...");
 
 		try {
-			TimelineHelper th = TimelineHelper(framerate);
-			//TODO: Need to fix the below after multi-tracks supporting.
-			th.appendTrack("Track-001", type);
-			th.makeMediaRef(mediaPath, framerate, videoFrames);
-
-			auto trs = makeTimeRange(accumulated, framerate);
-			for (const auto& tr : trs) {
-				th.appendClip(
-							"Track-001",
-							std::string(),
-							tr.timeRange,
-							mediaPath,
-							makeEffectList(tr.collection));
+			setAttrs();
+			resetTimelines();
+
+			TimeRangeWithMetadata tr;
+			size_t clips = 0;
+			while (waitRange(&tr)) {
+				appendClip(tr, true);
+				clips++;
+			}
+
+			if (!waitFinish()) {
+				for (auto& output : _outputs)
+					output.render->discardClips();
+				LOG_DEBUG("streaming task aborted");
+				return;
 			}
 
-			renderObj->setAttrs({ {"path", outputPath} });
-			renderObj->render(th.getTimeline());
+			if (_analyzer->finished()) {
+				LOG_INFO("%zu clips rendered during the analysis", clips);
+			} else {
+				LOG_WARN("the streamed clips are outdated, render the accumulated data");
+				for (auto& output : _outputs)
+					output.render->discardClips();
 
-			completeCb->invoke(OVI_ERROR_NONE);
+				resetTimelines();
+				appendClips(_accumulated);
+			}
+
+			_completeCb->invoke(renderAll());
 		} catch (const Exception& e) {
 			LOG_ERROR("%s", e.what());
-			completeCb->invoke(static_cast<ovi_error_e>(e.error()));
+			for (auto& output : _outputs)
+				output.render->discardClips();
+			// the session waits for the end of the analysis
+			if (waitFinish())
+				_completeCb->invoke(fail(static_cast<ovi_error_e>(e.error())));
 		}
 
-		LOG_DEBUG("task terminated");
+		LOG_DEBUG("streaming task terminated");
+	});
+}
+
+RenderTask::RenderTask(std::shared_ptr<PluginManager> pluginManager,
+					const std::vector<RenderTarget>& targets,
+					timelineRetainer timeline,
+					std::shared_ptr<IInvokable> completeCb,
+					std::shared_ptr<IInvokable> targetCb)
+	: _pluginManager(pluginManager)
+	, _completeCb(completeCb)
+	, _targetCb(targetCb)
+	, _renderWorkers(Configuration::instance().get(CATEGORY_CORE, CORE_RENDER_WORKERS, 0))
+{
+	makeOutputs(targets);
+
+	_future = std::async(std::launch::async, [=] {
+		LOG_DEBUG("Entering timeline task...");
+
+		ovi_error_e error;
+		try {
+			setAttrs();
+			loadTimelines(timeline);
+
+			error = renderAll();
+		} catch (const Exception& e) {
+			LOG_ERROR("%s", e.what());
+			error = fail(static_cast<ovi_error_e>(e.error()));
+		}
+
+		_completeCb->invoke(error);
+
+		LOG_DEBUG("timeline task terminated");
 	});
 }
 
@@ -69,33 +176,324 @@ RenderTask::~RenderTask()
 {
 	LOG_ENTER();
 
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		if (_analyzer && !_finishing)
+			_aborted = true;
+		_cond.notify_one();
+	}
+
 	_future.get();
 
 	LOG_INFO("Task get done!");
 }
 
-std::vector<TimeRangeWithMetadata> RenderTask::makeTimeRange(const std::vector<RawData>& accumulated, double framerate) const
+void RenderTask::finish(const AccumulatedData& accumulated)
 {
-	DataAnalyzer da = DataAnalyzer();
+	std::lock_guard<std::mutex> lock(_lock);
 
-	da.setCorrectionValue(framerate);
-	da.analyzeRawData(accumulated);
+	_accumulated = accumulated;
+	_finishing = true;
+	_cond.notify_one();
+}
+
+/* The next range to render, false when the analysis is over */
+bool RenderTask::waitRange(TimeRangeWithMetadata* range)
+{
+	std::unique_lock<std::mutex> lock(_lock);
 
-	return da.result();
+	_cond.wait(lock, [this] { return !_ranges.empty() || _finishing || _aborted; });
+	if (_aborted || _ranges.empty())
+		return false;
+
+	*range = std::move(_ranges.front());
+	_ranges.pop_front();
+
+	return true;
 }
 
-std::vector<effectRetainer> RenderTask::makeEffectList(SortedCollection collection)
+/* Whether the analysis is over, not aborted */
+bool RenderTask::waitFinish()
 {
-	std::vector<effectRetainer> result;
+	std::unique_lock<std::mutex> lock(_lock);
 
-	for (const auto& [ uid, details ] : collection) {
-		auto effect = initializeEffect(_pluginManager->find(uid));
+	_cond.wait(lock, [this] { return _finishing || _aborted; });
+
+	return !_aborted;
+}
+
+void RenderTask::makeOutputs(const std::vector<RenderTarget>& targets)
+{
+	for (const auto& target : targets) {
+		Output output;
+		output.target = target;
+		output.render = dynamic_cast<IPluginRender*>(_pluginManager->find(target.uid).plugin);
+		assert(output.render);
+
+		for (const auto& effect : target.effects)
+			output.effects.insert(_pluginManager->id(effect));
+
+		_outputs.push_back(std::move(output));
+	}
+}
+
+/* the attribute is left to the core: the render declares it and the user did not set it */
+static bool __defaultAttr(const Plugin& plugin, const std::string& key)
+{
+	if (plugin.attrs.count(key) > 0)
+		return false;
+
+	const auto& declared = PluginLoader::instance().getPluginAttrs(plugin.name);
+
+	return std::any_of(declared.begin(), declared.end(), [&key](const auto& attr) { return attr.key == key; });
+}
+
+void RenderTask::setAttrs()
+{
+	std::vector<bool> defaultWorkers;
+	for (const auto& output : _outputs)
+		defaultWorkers.push_back(__defaultAttr(_pluginManager->find(output.target.uid), "workers"));
+
+	// the renders running together share the workers
+	int workers = _renderWorkers;
+	int sharing = static_cast<int>(std::count(defaultWorkers.begin(), defaultWorkers.end(), true));
+	if (sharing > 1) {
+		int total = (workers > 0) ? workers : static_cast<int>(std::thread::hardware_concurrency());
+		workers = std::max(1, total / sharing);
+	}
+
+	for (size_t i = 0; i < _outputs.size(); i++) {
+		auto& output = _outputs[i];
+		std::map<std::string, std::string> attrs { {"path", output.target.outputPath} };
+		if (defaultWorkers[i])
+			attrs["workers"] = std::to_string(workers);
+
+		int ret = output.render->setAttrs(attrs);
+		if (ret != OVI_ERROR_NONE) {
+			LOG_ERROR("failed to set the attributes of %s", output.target.uid.c_str());
+			report(output, static_cast<ovi_error_e>(ret));
+		}
+	}
+}
+
+void RenderTask::resetTimelines()
+{
+	for (auto& output : _outputs) {
+		output.timeline = std::make_unique<TimelineHelper>(_framerate);
+		//TODO: Need to fix the below after multi-tracks supporting.
+		output.timeline->appendTrack("Track-001", _type);
+		output.timeline->makeMediaRef(_mediaPath, _framerate, _videoFrames);
+	}
+}
+
+/* Each target gets its own copy of the timeline, keeping the effects of its plugins */
+void RenderTask::loadTimelines(const timelineRetainer& timeline)
+{
+	for (auto& output : _outputs) {
+		// the renders may edit the metadata
+		output.loaded = (_outputs.size() > 1) ? TimelineHelper::clone(timeline) : timeline;
+		if (output.effects.empty())
+			continue;
+
+		std::set<std::string> names;
+		for (const auto& id : output.effects) {
+			auto obj = dynamic_cast<IPluginEffect*>(_pluginManager->find(id).plugin);
+			assert(obj);
+			const auto& infoList = obj->effectInfo();
+			auto name = infoList.find("name");
+			if (name != infoList.end())
+				names.insert(name->second);
+		}
+
+		for (const auto& clip : output.loaded->find_clips()) {
+			auto& effects = clip->effects();
+			effects.erase(std::remove_if(effects.begin(), effects.end(), [&](const effectRetainer& effect) {
+				return names.count(effect->effect_name()) == 0;
+			}), effects.end());
+		}
+	}
+}
+
+/* One time range at a time: its detections are read from the store, made effects and dropped
+ * before the next range, so the detected data is never all in memory at once. */
+void RenderTask::appendClips(const AccumulatedData& accumulated)
+{
+	DataAnalyzer da;
+
+	da.setCorrectionValue(_framerate);
+	da.analyzeRawData(accumulated, [this](TimeRangeWithMetadata&& tr) {
+		appendClip(tr, false);
+	});
+}
+
+void RenderTask::appendClip(const TimeRangeWithMetadata& tr, bool streaming)
+{
+	auto effects = makeEffectList(tr.collection);
+
+	for (auto& output : _outputs) {
+		if (output.done)
+			continue;
+
+		std::vector<effectRetainer> effectList;
+		for (const auto& [ id, effect ] : effects) {
+			if (!output.effects.empty() && output.effects.count(id) == 0)
+				continue;
+
+			// the renders may edit the metadata, each one gets its own effects
+			if (_outputs.size() > 1)
+				effectList.push_back(new otio::Effect(effect->name(), effect->effect_name(), effect->metadata()));
+			else
+				effectList.push_back(effect);
+		}
+
+		auto clip = output.timeline->appendClip(
+					"Track-001",
+					std::string(),
+					tr.timeRange,
+					_mediaPath,
+					effectList);
+
+		if (!streaming)
+			continue;
+
+		try {
+			output.render->renderClip(clip);
+		} catch (const Exception& e) {
+			LOG_ERROR("%s: %s", output.target.uid.c_str(), e.what());
+			output.render->discardClips();
+			report(output, static_cast<ovi_error_e>(e.error()));
+		}
+	}
+}
+
+/* Renders the targets at the same time, the first error of the targets */
+ovi_error_e RenderTask::renderAll()
+{
+	std::vector<std::future<void>> renders;
+
+	for (auto& output : _outputs) {
+		if (output.done)
+			continue;
+
+		renders.push_back(std::async(std::launch::async, [this, &output] {
+			try {
+				if (output.loaded)
+					output.render->render(output.loaded);
+				else
+					output.render->render(output.timeline->getTimeline());
+				report(output, OVI_ERROR_NONE);
+			} catch (const Exception& e) {
+				LOG_ERROR("%s: %s", output.target.uid.c_str(), e.what());
+				output.render->discardClips();
+				report(output, static_cast<ovi_error_e>(e.error()));
+			}
+		}));
+	}
+
+	for (auto& render : renders)
+		render.get();
+
+	for (const auto& output : _outputs) {
+		if (output.error != OVI_ERROR_NONE)
+			return output.error;
+	}
+
+	return OVI_ERROR_NONE;
+}
+
+/* Reports the error to the targets not done yet */
+ovi_error_e RenderTask::fail(ovi_error_e error)
+{
+	for (auto& output : _outputs) {
+		if (!output.done)
+			report(output, error);
+	}
+
+	return error;
+}
+
+void RenderTask::report(Output& output, ovi_error_e error)
+{
+	std::lock_guard<std::mutex> lock(_reportLock);
+
+	output.error = error;
+	output.done = true;
+
+	if (_targetCb)
+		_targetCb->invoke(output.target.outputPath, error);
+}
+
+static bool __isRect(const std::variant<OVIRect, OVIRectTag, double, bool>& item)
+{
+	return std::holds_alternative<OVIRect>(item) || std::holds_alternative<OVIRectTag>(item);
+}
+
+static otio::AnyVector __fillTracks(const std::vector<DetectionTrack>& tracks)
+{
+	otio::AnyVector result;
+
+	for (const auto& track : tracks) {
+		otio::AnyVector keys;
+		for (const auto& key : track.keys) {
+			keys.push_back(
+				otio::AnyDictionary {
+					{ "frame", key.frame },
+					{ "x", key.rect.x },
+					{ "y", key.rect.y },
+					{ "width", key.rect.width },
+					{ "height", key.rect.height }
+				}
+			);
+		}
+
+		otio::AnyDictionary dic { { "keys", keys } };
+		if (track.tagged)
+			dic["tag"] = track.tag;
+
+		result.push_back(dic);
+	}
+
+	return result;
+}
+
+RenderTask::EffectList RenderTask::makeEffectList(const SortedCollection& collection)
+{
+	EffectList result;
+
+	// the effects are applied in the order of the plugin uids, not the order the plugins are loaded in
+	std::vector<PluginId> ids;
+	for (const auto& item : collection)
+		ids.push_back(item.first);
+	std::sort(ids.begin(), ids.end(), [this](PluginId a, PluginId b) {
+		return _pluginManager->uid(a) < _pluginManager->uid(b);
+	});
+
+	for (auto id : ids) {
+		const auto& details = collection.at(id);
+		auto effect = initializeEffect(_pluginManager->find(id));
 		auto& dic = effect->metadata();
 
-		for (const auto& detected : details)
-			dic[std::to_string(detected.frameNumber)] = fillFrameEffect(detected.list);
+		// the rectangles become tracks of keyframes, so the metadata grows with the motion rather than the frames
+		DetectionTracker tracker(_trackTolerance, std::max(0, _trackGap));
+
+		for (const auto& detected : details) {
+			Details others;
+			std::copy_if(detected.list.begin(), detected.list.end(), std::back_inserter(others), [](const auto& item) {
+				return !__isRect(item);
+			});
+
+			tracker.add(detected.frameNumber, detected.list);
+			if (!others.empty() || detected.list.empty())
+				dic[std::to_string(detected.frameNumber)] = fillFrameEffect(others);
+		}
+
+		auto tracks = tracker.tracks();
+		if (!tracks.empty()) {
+			dic["tracks"] = __fillTracks(tracks);
+			dic["tolerance"] = _trackTolerance;
+		}
 
-		result.push_back(effect);
+		result.push_back({ id, effect });
 	}
 
 	return result;
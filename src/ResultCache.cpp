@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include "BinaryCodec.h"
+#include "ResultCache.h"
+#include "Log.h"
+
+using namespace ovi;
+
+namespace {
+
+/* the header is followed by the key and by the records, each one the size and
+ * the checksum of { int32 first frame, int32 last frame, uint8 detect, details } and those */
+const std::string RESULTS_HEADER = "OVI_RESULTS 3\n";
+
+std::string hashName(const std::string& key)
+{
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	for (auto c : key) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 1099511628211ull;
+	}
+
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+
+	return name;
+}
+
+void writeRecord(std::ofstream& os, const std::string& raw)
+{
+	uint32_t prefix[] = { static_cast<uint32_t>(raw.size()), checksum(raw.data(), raw.size()) };
+	os.write(reinterpret_cast<const char*>(prefix), sizeof(prefix));
+	os.write(raw.data(), raw.size());
+}
+
+}
+
+ResultCache::ResultCache(const std::string& dir, const std::string& media)
+	: _dir(dir), _media(media)
+{
+}
+
+ResultCache::~ResultCache()
+{
+	// the outcomes not saved are dropped
+	for (auto& results : _results) {
+		if (results)
+			reset(*results);
+	}
+}
+
+void ResultCache::add(PluginId id, const std::string& config)
+{
+	if (id < 0)
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, "invalid plugin id");
+
+	if (static_cast<size_t>(id) >= _results.size())
+		_results.resize(id + 1);
+
+	auto results = std::make_unique<Results>();
+	results->key = _media + "\n" + config;
+	results->path = _dir + "/" + hashName(results->key);
+	_results[id] = std::move(results);
+}
+
+bool ResultCache::contains(PluginId id) const
+{
+	return id >= 0 && static_cast<size_t>(id) < _results.size() && _results[id];
+}
+
+std::optional<Outcome> ResultCache::find(PluginId id, const FrameKey& frames)
+{
+	if (!contains(id))
+		return std::nullopt;
+
+	auto& results = *_results[id];
+	if (!results.opened)
+		open(results);
+
+	if (results.last && frames <= *results.last)
+		return std::nullopt;
+
+	advance(results, frames);
+	if (!results.next || results.next->frames != frames)
+		return std::nullopt;
+
+	Outcome outcome;
+	try {
+		BinaryReader reader(results.next->raw);
+		reader.get<int32_t>();
+		reader.get<int32_t>();
+		outcome.detect = reader.get<uint8_t>() != 0;
+		outcome.list = reader.getDetails();
+	} catch (const Exception& e) {
+		LOG_WARN("broken results %s: %s", results.path.c_str(), e.what());
+		results.in.close();
+		results.next.reset();
+		return std::nullopt;
+	}
+
+	if (results.out.is_open())
+		writeRecord(results.out, results.next->raw);
+
+	results.last = frames;
+	results.found++;
+	readNext(results);
+
+	return outcome;
+}
+
+void ResultCache::store(PluginId id, const FrameKey& frames, const Outcome& outcome)
+{
+	if (!contains(id))
+		return;
+
+	auto& results = *_results[id];
+	if (!results.opened)
+		open(results);
+
+	if (results.last && frames <= *results.last) {
+		LOG_WARN("frames %d-%d are out of order, not cached", frames.first, frames.second);
+		return;
+	}
+
+	advance(results, frames);
+	if (!results.out.is_open() && !beginWrite(results))
+		return;
+
+	// replaced by the new outcome
+	if (results.next && results.next->frames == frames)
+		readNext(results);
+
+	BinaryWriter writer;
+	writer.put(static_cast<int32_t>(frames.first));
+	writer.put(static_cast<int32_t>(frames.second));
+	writer.put(static_cast<uint8_t>(outcome.detect));
+	writer.put(outcome.list);
+	writeRecord(results.out, writer.buffer());
+
+	results.last = frames;
+	results.added++;
+}
+
+void ResultCache::remove(PluginId id)
+{
+	if (!contains(id))
+		return;
+
+	auto& results = *_results[id];
+	if (results.found > 0)
+		LOG_WARN("%zu cached outcomes were used before the plugin was found uncacheable", results.found);
+
+	reset(results);
+
+	std::error_code ec {};
+	std::filesystem::remove(results.path, ec);
+	_results[id].reset();
+}
+
+void ResultCache::open(Results& results)
+{
+	results.opened = true;
+
+	results.in.open(results.path, std::ios::binary);
+	if (!results.in.is_open())
+		return;
+
+	try {
+		std::string header(RESULTS_HEADER.size(), '\0');
+		uint32_t size {};
+		results.in.read(header.data(), header.size());
+		results.in.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+		std::string key(results.in ? size : 0, '\0');
+		results.in.read(key.data(), key.size());
+
+		// a hash collision or another format
+		if (!results.in || header != RESULTS_HEADER || key != results.key)
+			throw Exception(OVI_ERROR_INVALID_OPERATION, "results of another analysis");
+	} catch (const std::exception& e) {
+		LOG_WARN("ignore %s: %s", results.path.c_str(), e.what());
+		results.in.close();
+		return;
+	}
+
+	results.consumed = results.in.tellg();
+	readNext(results);
+}
+
+void ResultCache::readNext(Results& results)
+{
+	results.next.reset();
+	if (!results.in.is_open())
+		return;
+
+	results.consumed = results.in.tellg();
+
+	uint32_t prefix[2] {};
+	if (!results.in.read(reinterpret_cast<char*>(prefix), sizeof(prefix))) {
+		if (results.in.gcount() != 0)
+			LOG_WARN("broken results %s at %lld", results.path.c_str(), static_cast<long long>(results.consumed));
+		results.in.close();
+		return;
+	}
+
+	auto [ size, sum ] = prefix;
+	Record record;
+	// a first frame, a last frame and the detect flag at least
+	const size_t minSize = 2 * sizeof(int32_t) + sizeof(uint8_t);
+	if (size >= minSize) {
+		try {
+			record.raw.resize(size);
+		} catch (const std::exception&) {
+			record.raw.clear();
+		}
+	}
+
+	if (record.raw.size() != size || !results.in.read(record.raw.data(), size) ||
+		checksum(record.raw.data(), size) != sum) {
+		LOG_WARN("broken results %s at %lld", results.path.c_str(), static_cast<long long>(results.consumed));
+		results.in.close();
+		return;
+	}
+
+	BinaryReader reader(record.raw);
+	record.frames.first = reader.get<int32_t>();
+	record.frames.second = reader.get<int32_t>();
+	results.next = std::move(record);
+}
+
+void ResultCache::advance(Results& results, const FrameKey& frames)
+{
+	// the records passed are kept, for the frames the analysis skipped this time
+	while (results.next && results.next->frames < frames) {
+		if (results.out.is_open())
+			writeRecord(results.out, results.next->raw);
+		readNext(results);
+	}
+}
+
+bool ResultCache::beginWrite(Results& results)
+{
+	if (results.failed)
+		return false;
+
+	std::error_code ec {};
+	std::filesystem::create_directories(_dir, ec);
+
+	/* write a private file and rename it, so that readers never see partial results */
+	results.outPath = results.path + ".XXXXXX";
+	int fd = mkstemp(results.outPath.data());
+	if (fd >= 0) {
+		results.out.open(results.outPath, std::ios::binary | std::ios::trunc);
+		close(fd);
+	}
+
+	if (!results.out.is_open()) {
+		LOG_WARN("Failed to write results: %s", results.outPath.c_str());
+		if (fd >= 0) {
+			std::error_code ec {};
+			std::filesystem::remove(results.outPath, ec);
+		}
+		results.failed = true;
+		return false;
+	}
+
+	if (results.consumed == 0) {
+		BinaryWriter writer;
+		writer.buffer() = RESULTS_HEADER;
+		writer.put(results.key);
+		results.out.write(writer.buffer().data(), writer.buffer().size());
+		return true;
+	}
+
+	// the header and the records passed so far
+	std::ifstream is(results.path, std::ios::binary);
+	std::string buffer(1 << 16, '\0');
+	for (std::streamoff left = results.consumed; left > 0 && is; ) {
+		is.read(buffer.data(), std::min<std::streamoff>(left, buffer.size()));
+		results.out.write(buffer.data(), is.gcount());
+		left -= is.gcount();
+	}
+
+	return true;
+}
+
+void ResultCache::save()
+{
+	for (auto& results : _results) {
+		if (results)
+			save(*results);
+	}
+}
+
+void ResultCache::save(Results& results)
+{
+	if (!results.out.is_open()) {
+		reset(results);
+		return;
+	}
+
+	while (results.next) {
+		writeRecord(results.out, results.next->raw);
+		readNext(results);
+	}
+
+	results.out.close();
+
+	std::error_code ec {};
+	if (!results.out) {
+		LOG_WARN("Failed to write results: %s", results.outPath.c_str());
+		std::filesystem::remove(results.outPath, ec);
+	} else if (std::filesystem::rename(results.outPath, results.path, ec); ec) {
+		LOG_WARN("Failed to replace results: %s", ec.message().c_str());
+		std::filesystem::remove(results.outPath, ec);
+	} else {
+		LOG_INFO("saved %zu new outcomes to %s", results.added, results.path.c_str());
+	}
+
+	results.outPath.clear();
+	reset(results);
+}
+
+void ResultCache::reset(Results& results)
+{
+	if (results.out.is_open()) {
+		results.out.close();
+		std::error_code ec {};
+		std::filesystem::remove(results.outPath, ec);
+	}
+
+	results.out.clear();
+	results.in.close();
+	results.in.clear();
+	results.opened = false;
+	results.consumed = 0;
+	results.next.reset();
+	results.failed = false;
+	results.last.reset();
+	results.found = 0;
+	results.added = 0;
+}
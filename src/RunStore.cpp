@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "RunStore.h"
+#include "Exception.h"
+#include "Log.h"
+
+using namespace ovi;
+
+struct RunStore::Impl {
+	std::string spillDir;
+
+	int fd { -1 };
+	size_t spilledRuns {};	// in the file, before the resident ones
+	std::vector<FrameRun> resident;
+
+	void* map { MAP_FAILED };
+	size_t mapped {};
+
+	~Impl() {
+		if (map != MAP_FAILED)
+			munmap(map, mapped);
+		if (fd >= 0)
+			close(fd);
+	}
+
+	void open();
+	void spill();
+	const FrameRun* spilled(size_t index);
+};
+
+void RunStore::Impl::open()
+{
+	std::string path = spillDir + "/ovi_runs_XXXXXX";
+	fd = mkostemp(path.data(), O_CLOEXEC);
+	if (fd < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to create the spill file in " + spillDir + ": " + strerror(errno));
+
+	// nobody else needs the file, it goes away with the descriptor
+	unlink(path.c_str());
+	LOG_INFO("spill frame runs by %zu to %s", PAGE_RUNS, spillDir.c_str());
+}
+
+void RunStore::Impl::spill()
+{
+	if (fd < 0)
+		open();
+
+	const char* buffer = reinterpret_cast<const char*>(resident.data());
+	size_t bytes = resident.size() * sizeof(FrameRun);
+	off_t offset = static_cast<off_t>(spilledRuns * sizeof(FrameRun));
+
+	for (size_t written = 0; written < bytes;) {
+		ssize_t ret = pwrite(fd, buffer + written, bytes - written, offset + written);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			throw Exception(OVI_ERROR_INVALID_OPERATION, std::string { "failed to spill frame runs: " } + strerror(errno));
+		}
+		written += ret;
+	}
+
+	spilledRuns += resident.size();
+	// the page is reused for the next runs
+	resident.clear();
+}
+
+const FrameRun* RunStore::Impl::spilled(size_t index)
+{
+	size_t bytes = spilledRuns * sizeof(FrameRun);
+	if (mapped < bytes) {
+		if (map != MAP_FAILED)
+			munmap(map, mapped);
+
+		mapped = bytes;
+		map = mmap(nullptr, mapped, PROT_READ, MAP_SHARED, fd, 0);
+		if (map == MAP_FAILED) {
+			mapped = 0;
+			throw Exception(OVI_ERROR_INVALID_OPERATION, std::string { "failed to map frame runs: " } + strerror(errno));
+		}
+		madvise(map, mapped, MADV_SEQUENTIAL);
+	}
+
+	return static_cast<const FrameRun*>(map) + index;
+}
+
+RunStore::RunStore()
+	: _impl(std::make_shared<Impl>())
+{
+}
+
+RunStore::RunStore(const std::string& spillDir)
+	: _impl(std::make_shared<Impl>())
+{
+	_impl->spillDir = spillDir;
+}
+
+size_t RunStore::size() const
+{
+	return _impl->spilledRuns + _impl->resident.size();
+}
+
+FrameRun RunStore::operator[](size_t index) const
+{
+	auto& impl = *_impl;
+
+	if (index >= size())
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, "no frame run: " + std::to_string(index));
+
+	if (index >= impl.spilledRuns)
+		return impl.resident[index - impl.spilledRuns];
+
+	FrameRun run;
+	memcpy(&run, impl.spilled(index), sizeof(run));
+	return run;
+}
+
+FrameRun& RunStore::back()
+{
+	if (_impl->resident.empty())
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "no frame run");
+
+	return _impl->resident.back();
+}
+
+void RunStore::push_back(const FrameRun& run)
+{
+	auto& impl = *_impl;
+
+	// the page is written once the next run comes, so that back() stays in memory
+	if (!impl.spillDir.empty() && impl.resident.size() == PAGE_RUNS)
+		impl.spill();
+
+	if (impl.resident.capacity() == 0 && !impl.spillDir.empty())
+		impl.resident.reserve(PAGE_RUNS);
+
+	impl.resident.push_back(run);
+}
+
+void RunStore::resize(size_t size)
+{
+	auto& impl = *_impl;
+
+	if (size > this->size())
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, "can not grow the frame runs to " + std::to_string(size));
+
+	if (size >= impl.spilledRuns) {
+		impl.resident.resize(size - impl.spilledRuns);
+		return;
+	}
+
+	// the page of the new last run comes back to memory, the file is overwritten from it
+	size_t first = size > 0 ? (size - 1) / PAGE_RUNS * PAGE_RUNS : 0;
+	const FrameRun* runs = impl.spilled(first);
+	impl.resident.assign(runs, runs + (size - first));
+	impl.spilledRuns = first;
+}
+
+size_t RunStore::residentBytes() const
+{
+	return _impl->resident.capacity() * sizeof(FrameRun);
+}
+
+bool RunStore::spilled() const
+{
+	return _impl->spilledRuns > 0;
+}
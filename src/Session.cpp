@@ -15,12 +15,14 @@
  */
 
 #include "Session.h"
+#include "Configuration.h"
 #include "PerformanceMeasure.h"
 #include "Log.h"
 #include "ovi_types.h"
 
 #include <string>
 #include <filesystem>
+#include <algorithm>
 
 using namespace ovi;
 
@@ -44,11 +46,22 @@ void Session::completeCb(void* handle, ovi_error_e error, void* userData)
 		return;
 	}
 
+	// a session rendering a timeline starts in OVI_STATE_RENDER
 	if (session->_state == OVI_STATE_ANALYSIS) {
 		PerformanceMeasure::instance().split("analysis");
-		session->runRender();
+		// the render may be complete before runRender() returns, e.g. with the clips streamed
 		session->updateState(OVI_STATE_RENDER);
 
+		try {
+			session->runRender();
+		} catch (const Exception& e) {
+			LOG_ERROR("%s", e.what());
+			if (session->_errorCb)
+				session->_errorCb->invoke(static_cast<ovi_error_e>(e.error()));
+
+			session->updateState(OVI_STATE_IDLE);
+		}
+
 	} else if (session->_state == OVI_STATE_RENDER) {
 		PerformanceMeasure::instance().split("render");
 		PerformanceMeasure::instance().stop();
@@ -60,8 +73,7 @@ void Session::completeCb(void* handle, ovi_error_e error, void* userData)
 
 void Session::updateState(ovi_state_e current)
 {
-	ovi_state_e previous = _state;
-	_state = current;
+	ovi_state_e previous = _state.exchange(current);
 
 	if (_stateChangedCb && (previous != current)) {
 		LOG_DEBUG("invoke state changed callback. previous:%d, current:%d", previous, current);
@@ -173,11 +185,38 @@ void Session::unsetStateChangedCb()
 	_stateChangedCb.reset();
 }
 
+void Session::setRenderCb(ovi_render_cb callback, void* userData)
+{
+	if (_state != OVI_STATE_IDLE)
+		throw Exception(OVI_ERROR_INVALID_STATE, "invalid _state");
+
+	if (!callback)
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, "invalid callback");
+
+	_renderCb = std::shared_ptr<IInvokable>(new RenderCallback(this, callback, userData));
+}
+
+void Session::unsetRenderCb()
+{
+	if (_state != OVI_STATE_IDLE)
+		throw Exception(OVI_ERROR_INVALID_STATE, "invalid _state");
+
+	if (!_renderCb)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "callback was not set");
+
+	_renderCb.reset();
+}
+
 void Session::start()
 {
 	if (_state != OVI_STATE_IDLE)
 		throw Exception(OVI_ERROR_INVALID_STATE, "invalid _state");
 
+	if (!_otioFilePath.empty()) {
+		runTimelineRender();
+		return;
+	}
+
 	if (!_logicAnalyzer)
 		throw Exception(OVI_ERROR_INVALID_OPERATION, "invalid _logicAnalyzer");
 
@@ -187,29 +226,41 @@ void Session::start()
 	if (_mediaPath.empty())
 		throw Exception(OVI_ERROR_INVALID_OPERATION, "invalid _mediaPath");
 
-	if (_renderUid.empty())
-		throw Exception(OVI_ERROR_INVALID_OPERATION, "invalid _renderUid");
-
-	if (_outputFilePath.empty())
-		throw Exception(OVI_ERROR_INVALID_OPERATION, "invalid _outputFilePath");
+	if (_renders.empty())
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "invalid _renders");
 
-	if (!validate_link(_logicAnalyzer.get(), _pluginManager.get(), _renderUid))
-		throw Exception(OVI_ERROR_INVALID_OPERATION, "invalid link");
+	for (const auto& render : _renders) {
+		if (!validate_link(_logicAnalyzer.get(), _pluginManager.get(), render.uid, render.effects))
+			throw Exception(OVI_ERROR_INVALID_OPERATION, "invalid link");
+	}
 
 	_frameExtractor = std::shared_ptr<IFrameExtractor>(FrameExtractorFactory::create(_mediaPath));
 	_mediaInfo = _frameExtractor->mediaInfo();
 
 	_pluginManager->validate(_mediaInfo->hasVideo(), _mediaInfo->hasAudio());
-	_pluginManager->validateAttrs(_renderUid);
+	for (const auto& render : _renders)
+		_pluginManager->validateAttrs(render.uid, render.effects);
 	_pluginManager->setAllAttrs();
 
 	_accumulator = std::make_shared<Accumulator>();
+	createResultCache();
+	restoreCheckpoint();
 	_avSynchronizer = std::make_shared<AvSynchronizer>(_frameExtractor);
 
 	PerformanceMeasure::instance().start();
-	runDataFlow();
+	_render.reset();
+	if (_streamingRender)
+		runStreamingRender();
 
+	// the analysis may be complete before runDataFlow() returns
 	updateState(OVI_STATE_ANALYSIS);
+
+	try {
+		runDataFlow();
+	} catch (...) {
+		updateState(OVI_STATE_IDLE);
+		throw;
+	}
 }
 
 void Session::stop()
@@ -224,11 +275,19 @@ void Session::stop()
 
 	_dataFlow->stop();
 
+	// drops the clips rendered during the analysis
+	_accumulator->setStreamingAnalyzer(nullptr);
+	_render.reset();
+
 	PerformanceMeasure::instance().stop();
 }
 
 void Session::destroy()
 {
+	// waits for the render while the callbacks are there
+	if (_state == OVI_STATE_RENDER)
+		_render.reset();
+
 	if (!_dataFlow)
 		return;
 
@@ -239,6 +298,22 @@ void Session::destroy()
 }
 
 void Session::setRender(const std::string& uid, std::string outputPath)
+{
+	if (_state != OVI_STATE_IDLE)
+		throw Exception(OVI_ERROR_INVALID_STATE, "invalid _state :" + stateInfo[_state]);
+
+	std::vector<RenderTarget> renders;
+	renders.swap(_renders);
+
+	try {
+		addRender(uid, outputPath, {});
+	} catch (...) {
+		_renders.swap(renders);
+		throw;
+	}
+}
+
+void Session::addRender(const std::string& uid, std::string outputPath, const std::vector<std::string>& effects)
 {
 	if (_state != OVI_STATE_IDLE)
 		throw Exception(OVI_ERROR_INVALID_STATE, "invalid _state :" + stateInfo[_state]);
@@ -254,8 +329,24 @@ void Session::setRender(const std::string& uid, std::string outputPath)
 	if (plugin.type != PLUGIN_TYPE_RENDER)
 		throw Exception(OVI_ERROR_INVALID_PARAMETER, "not render uid");
 
-	_renderUid = uid;
-	_outputFilePath = outputPath;
+	// a render plugin keeps the state of its output
+	for (const auto& render : _renders) {
+		if (render.uid == uid)
+			throw Exception(OVI_ERROR_INVALID_PARAMETER, "render already added: " + uid);
+		if (render.outputPath == outputPath)
+			throw Exception(OVI_ERROR_INVALID_PARAMETER, "outputPath already added: " + outputPath);
+	}
+
+	for (const auto& effect : effects) {
+		if (!_pluginManager->exist(effect))
+			throw Exception(OVI_ERROR_INVALID_PARAMETER, "invalid effect uid: " + effect);
+
+		auto type = _pluginManager->find(effect).type;
+		if (type != PLUGIN_TYPE_VIDEO_EFFECT && type != PLUGIN_TYPE_AUDIO_EFFECT)
+			throw Exception(OVI_ERROR_INVALID_PARAMETER, "not effect uid: " + effect);
+	}
+
+	_renders.push_back({ uid, outputPath, effects });
 }
 
 void Session::registerPlugin(const std::vector<std::string>& request)
@@ -270,6 +361,7 @@ void Session::registerPlugin(const std::vector<std::string>& request)
 		throw Exception(OVI_ERROR_INVALID_PARAMETER, "invalid request");
 
 	_logicAnalyzer = std::make_shared<LogicAnalyzer>(request, _pluginManager.get());
+	_request = request;
 }
 
 const std::string& Session::appendPlugin(const std::string& name)
@@ -309,6 +401,14 @@ void Session::runDataFlow()
 										_completeCb,
 										((_mediaInfo->hasVideo()) ? _skipFrames : 0));
 
+	if (_resultCache)
+		_dataFlow->setResultCache(_resultCache);
+
+	if (_checkpoint) {
+		auto interval = Configuration::instance().get(CATEGORY_CORE, CORE_CHECKPOINT_INTERVAL, 5);
+		_dataFlow->setCheckpoint(_checkpoint, _checkpointPosition, std::chrono::seconds(interval));
+	}
+
 	if (_progress_cb.callback)
 		_dataFlow->setProgressCallback(this,
 									(ovi_progress_cb)_progress_cb.callback,
@@ -317,29 +417,241 @@ void Session::runDataFlow()
 	_dataFlow->start();
 }
 
+/* { type, frames, framerate } of the rendered stream */
+std::tuple<MediaType, int64_t, double> Session::renderStream() const
+{
+	if (_mediaInfo->hasAudio() && !_mediaInfo->hasVideo())
+		return std::make_tuple(_mediaInfo->audio()->type(),
+							_mediaInfo->audio()->frameNum(),
+							_mediaInfo->audio()->framerate());
+
+	return std::make_tuple(_mediaInfo->video()->type(),
+						_mediaInfo->video()->frameNum(),
+						_mediaInfo->video()->framerate());
+}
+
 void Session::runRender()
 {
+	if (_render) {
+		_render->finish(_accumulator->accumulated());
+		return;
+	}
+
 	//ToDo: RenderTask refactoring
-	const auto [ type, frameNum, framerate ] = [&] {
-		if (_mediaInfo->hasAudio() && !_mediaInfo->hasVideo())
-			return std::make_tuple(_mediaInfo->audio()->type(),
-								_mediaInfo->audio()->frameNum(),
-								_mediaInfo->audio()->framerate());
-		else
-			return std::make_tuple(_mediaInfo->video()->type(),
-								_mediaInfo->video()->frameNum(),
-								_mediaInfo->video()->framerate());
-	}();
+	const auto [ type, frameNum, framerate ] = renderStream();
 
 	_render = std::make_unique<RenderTask>(_mediaPath,
 										_pluginManager,
-										_renderUid,
+										_renders,
 										type,
 										frameNum,
 										framerate,
 										_accumulator->accumulated(),
 										_completeCb,
-										_outputFilePath);
+										_renderCb);
+}
+
+void Session::runStreamingRender()
+{
+	// the renders without the support get the clips after the analysis
+	bool streamable = false;
+	for (const auto& render : _renders) {
+		auto renderObj = dynamic_cast<IPluginRender*>(_pluginManager->find(render.uid).plugin);
+		if (renderObj && renderObj->streamable())
+			streamable = true;
+		else
+			LOG_WARN("%s renders after the analysis", render.uid.c_str());
+	}
+
+	if (!streamable)
+		return;
+
+	const auto [ type, frameNum, framerate ] = renderStream();
+
+	_render = std::make_unique<RenderTask>(_mediaPath,
+										_pluginManager,
+										_renders,
+										type,
+										frameNum,
+										framerate,
+										_completeCb,
+										_renderCb);
+
+	_accumulator->setStreamingAnalyzer(_render->analyzer());
+}
+
+void Session::runTimelineRender()
+{
+	if (!_pluginManager)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "invalid _pluginManager");
+
+	if (_renders.empty())
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "invalid _renders");
+
+	auto timeline = TimelineHelper::load(_otioFilePath);
+
+	for (const auto& render : _renders)
+		_pluginManager->validateAttrs(render.uid, render.effects);
+	_pluginManager->setAllAttrs();
+
+	PerformanceMeasure::instance().start();
+	_render.reset();
+
+	// the task may be complete before the constructor returns
+	updateState(OVI_STATE_RENDER);
+
+	try {
+		_render = std::make_unique<RenderTask>(_pluginManager,
+											_renders,
+											timeline,
+											_completeCb,
+											_renderCb);
+	} catch (...) {
+		updateState(OVI_STATE_IDLE);
+		throw;
+	}
+}
+
+void Session::restoreCheckpoint()
+{
+	_checkpoint.reset();
+	_checkpointPosition = {};
+
+	if (_checkpointPath.empty())
+		return;
+
+	_checkpoint = std::make_shared<Checkpoint>(_checkpointPath, fingerprint());
+	if (!_checkpoint->restore(*_accumulator, &_checkpointPosition))
+		return;
+
+	if (_checkpointPosition.videoFrame >= 0)
+		_frameExtractor->seekVideo(_checkpointPosition.videoFrame, _checkpointPosition.videoPts);
+	if (_checkpointPosition.audioFrame >= 0)
+		_frameExtractor->seekAudio(_checkpointPosition.audioFrame, _checkpointPosition.audioPts);
+}
+
+static std::string fileStamp(const std::string& path)
+{
+	std::error_code err;
+
+	return path +
+		" size:" + std::to_string(std::filesystem::file_size(path, err)) +
+		" mtime:" + std::to_string(std::filesystem::last_write_time(path, err).time_since_epoch().count());
+}
+
+/* The files a plugin loads besides its own, e.g. the models */
+static std::string dirStamp(const std::string& path)
+{
+	std::error_code err;
+	std::vector<std::string> files;
+
+	for (auto iter = std::filesystem::recursive_directory_iterator(path, err);
+		!err && iter != std::filesystem::recursive_directory_iterator(); iter.increment(err)) {
+		if (iter->is_regular_file(err))
+			files.push_back(iter->path().string());
+	}
+
+	std::sort(files.begin(), files.end());
+
+	std::string result;
+	for (const auto& file : files)
+		result += " " + fileStamp(file);
+
+	return result;
+}
+
+/* The name, the version, the models and the attributes of a plugin */
+static std::string pluginConfig(const Plugin& plugin)
+{
+	std::string result = plugin.name;
+
+	for (const auto& info : PluginLoader::instance().getAvailablePluginList()) {
+		if (info.name == plugin.name) {
+			result += " " + fileStamp(info.sourcePath);
+			if (info.lang == LANG_PYTHON)
+				result += dirStamp(PLUGIN_SRC_DIR);
+			break;
+		}
+	}
+
+	result += dirStamp(PLUGIN_MODEL_DIR);
+
+	for (const auto& [ key, value ] : plugin.attrs)
+		result += " " + key + "=" + value;
+
+	return result;
+}
+
+/* What the accumulated data depends on: the media, the skipped frames and the plugin graph */
+std::string Session::fingerprint() const
+{
+	std::string result = fileStamp(_mediaPath);
+
+	result += "\nskip:" + std::to_string(_skipFrames);
+
+	for (const auto& item : _request) {
+		result += "\n";
+		if (_pluginManager->exist(item))
+			result += pluginConfig(_pluginManager->find(item));
+		else
+			result += item;
+	}
+
+	return result;
+}
+
+void Session::createResultCache()
+{
+	_resultCache.reset();
+
+	auto dir = Configuration::instance().get(CATEGORY_CORE, CORE_RESULT_CACHE_DIR, std::string {});
+	if (dir.empty())
+		return;
+
+	_resultCache = std::make_shared<ResultCache>(dir, fileStamp(_mediaPath));
+
+	for (PluginId id = 0; id < static_cast<PluginId>(_pluginManager->size()); id++) {
+		const auto& plugin = _pluginManager->find(id);
+		if (plugin.type == PLUGIN_TYPE_VIDEO_DETECT || plugin.type == PLUGIN_TYPE_AUDIO_DETECT)
+			_resultCache->add(id, pluginConfig(plugin));
+	}
+}
+
+void Session::setCheckpoint(const std::string& path)
+{
+	if (_state != OVI_STATE_IDLE)
+		throw Exception(OVI_ERROR_INVALID_STATE, "invalid _state :" + stateInfo[_state]);
+
+	_checkpointPath = path;
+}
+
+void Session::setTimeline(const std::string& path)
+{
+	if (_state != OVI_STATE_IDLE)
+		throw Exception(OVI_ERROR_INVALID_STATE, "invalid _state :" + stateInfo[_state]);
+
+	if (path.empty()) {
+		_otioFilePath.clear();
+		return;
+	}
+
+	std::error_code err;
+	auto pathObj = std::filesystem::canonical(path, err);
+	if (err.value() == EINVAL)
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, "Invalid path");
+
+	if (err.value() == ENOENT)
+		throw Exception(OVI_ERROR_NO_SUCH_FILE, "No such file");
+
+	_otioFilePath = pathObj.string();
+}
+
+void Session::setStreamingRender(bool enable)
+{
+	if (_state != OVI_STATE_IDLE)
+		throw Exception(OVI_ERROR_INVALID_STATE, "invalid _state :" + stateInfo[_state]);
+
+	_streamingRender = enable;
 }
 
 void Session::setSkipVideoFrames(size_t frames)
@@ -26,6 +26,30 @@ TimelineHelper::TimelineHelper(double framerate)
 {
 }
 
+timelineRetainer TimelineHelper::load(const std::string& path)
+{
+	otio::ErrorStatus err;
+	otio::SerializableObject::Retainer<> object(otio::SerializableObject::from_json_file(path, &err));
+	if (otio::is_error(err))
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, "failed to load the timeline: " + err.details);
+
+	auto timeline = otio::dynamic_retainer_cast<otio::Timeline>(object);
+	if (!timeline)
+		throw Exception(OVI_ERROR_INVALID_PARAMETER, "not a timeline: " + path);
+
+	return timeline;
+}
+
+timelineRetainer TimelineHelper::clone(const timelineRetainer& timeline)
+{
+	otio::ErrorStatus err;
+	otio::SerializableObject::Retainer<> object(timeline->clone(&err));
+	if (otio::is_error(err))
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to clone the timeline: " + err.details);
+
+	return otio::dynamic_retainer_cast<otio::Timeline>(object);
+}
+
 void TimelineHelper::makeMediaRef(const std::string& mediaPath,
 								double framerate,
 								double duration)
@@ -77,11 +101,11 @@ void TimelineHelper::appendGap(const std::string& trackName, TimeRange range)
 	}
 }
 
-void TimelineHelper::appendClip(const std::string& trackName,
-								const std::string& clipName,
-								TimeRange range,
-								const std::string& mediaPath,
-								const std::vector<effectRetainer>& effectList)
+clipRetainer TimelineHelper::appendClip(const std::string& trackName,
+										const std::string& clipName,
+										TimeRange range,
+										const std::string& mediaPath,
+										const std::vector<effectRetainer>& effectList)
 {
 	try {
 		auto ref = findRef(mediaPath);
@@ -101,6 +125,8 @@ void TimelineHelper::appendClip(const std::string& trackName,
 		if (!findTrack(trackName)->append_child(clip, &err))
 			throw Exception(OVI_ERROR_INVALID_OPERATION, err.details);
 
+		return clip;
+
 	} catch (const Exception& e) {
 		LOG_ERROR("Error: %s", e.what());
 		throw Exception(e.error(), "appendClip failed");
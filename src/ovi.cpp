@@ -143,6 +143,42 @@ int ovi_session_unset_state_changed_cb(session s)
 	return OVI_ERROR_NONE;
 }
 
+int ovi_session_set_render_cb(session s, ovi_render_cb callback, void *user_data)
+{
+	LOG_ENTER();
+
+	auto session = static_cast<Session*>(s);
+	if (!session)
+		return OVI_ERROR_INVALID_PARAMETER;
+
+	try {
+		session->setRenderCb(callback, user_data);
+	} catch (const Exception& e) {
+		LOG_ERROR("%s", e.what());
+		return e.error();
+	}
+
+	return OVI_ERROR_NONE;
+}
+
+int ovi_session_unset_render_cb(session s)
+{
+	LOG_ENTER();
+
+	auto session = static_cast<Session*>(s);
+	if (!session)
+		return OVI_ERROR_INVALID_PARAMETER;
+
+	try {
+		session->unsetRenderCb();
+	} catch (const Exception& e) {
+		LOG_ERROR("%s", e.what());
+		return e.error();
+	}
+
+	return OVI_ERROR_NONE;
+}
+
 int ovi_session_add_plugin(session s, const char *name, const char **uid)
 {
 	LOG_ENTER();
@@ -283,6 +319,50 @@ int ovi_session_set_render(session s, const char *uid, const char *output_path)
 	return OVI_ERROR_NONE;
 }
 
+int ovi_session_add_render(session s, const char *uid, const char *output_path, const char *effects[], unsigned int size)
+{
+	LOG_ENTER();
+
+	auto session = static_cast<Session*>(s);
+	if (!session) {
+		LOG_ERROR("invalid session");
+		return OVI_ERROR_INVALID_PARAMETER;
+	}
+
+	if (!uid) {
+		LOG_ERROR("invalid uid");
+		return OVI_ERROR_INVALID_PARAMETER;
+	}
+
+	if (!output_path) {
+		LOG_ERROR("invalid output_path");
+		return OVI_ERROR_INVALID_PARAMETER;
+	}
+
+	if (!effects && size > 0) {
+		LOG_ERROR("invalid effects");
+		return OVI_ERROR_INVALID_PARAMETER;
+	}
+
+	std::vector<std::string> effectList;
+	for (unsigned int i = 0; i < size; i++) {
+		if (!effects[i]) {
+			LOG_ERROR("invalid effects");
+			return OVI_ERROR_INVALID_PARAMETER;
+		}
+		effectList.push_back(effects[i]);
+	}
+
+	try {
+		session->addRender(uid, output_path, effectList);
+	} catch (const Exception& e) {
+		LOG_ERROR("%s", e.what());
+		return e.error();
+	}
+
+	return OVI_ERROR_NONE;
+}
+
 int ovi_session_set_media_path(session s, const char* media_path)
 {
 	LOG_ENTER();
@@ -434,3 +514,73 @@ int ovi_session_set_skip_video_frames(session s, size_t skip_frames)
 
 	return OVI_ERROR_NONE;
 }
+
+int ovi_session_set_streaming_render(session s, bool enable)
+{
+	LOG_ENTER();
+
+	auto session = static_cast<Session*>(s);
+	if (!session) {
+		LOG_ERROR("invalid session");
+		return OVI_ERROR_INVALID_PARAMETER;
+	}
+
+	try {
+		session->setStreamingRender(enable);
+	} catch (const Exception& e) {
+		LOG_ERROR("%s", e.what());
+		return e.error();
+	}
+
+	return OVI_ERROR_NONE;
+}
+
+int ovi_session_set_checkpoint(session s, const char *path)
+{
+	LOG_ENTER();
+
+	auto session = static_cast<Session*>(s);
+	if (!session) {
+		LOG_ERROR("invalid session");
+		return OVI_ERROR_INVALID_PARAMETER;
+	}
+
+	if (!path) {
+		LOG_ERROR("invalid path");
+		return OVI_ERROR_INVALID_PARAMETER;
+	}
+
+	try {
+		session->setCheckpoint(path);
+	} catch (const Exception& e) {
+		LOG_ERROR("%s", e.what());
+		return e.error();
+	}
+
+	return OVI_ERROR_NONE;
+}
+
+int ovi_session_set_timeline(session s, const char *path)
+{
+	LOG_ENTER();
+
+	auto session = static_cast<Session*>(s);
+	if (!session) {
+		LOG_ERROR("invalid session");
+		return OVI_ERROR_INVALID_PARAMETER;
+	}
+
+	if (!path) {
+		LOG_ERROR("invalid path");
+		return OVI_ERROR_INVALID_PARAMETER;
+	}
+
+	try {
+		session->setTimeline(path);
+	} catch (const Exception& e) {
+		LOG_ERROR("%s", e.what());
+		return e.error();
+	}
+
+	return OVI_ERROR_NONE;
+}
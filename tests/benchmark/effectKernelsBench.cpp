@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Measures the kernels of the native effects of the ffmpeg render, on the
+ * luma plane of a 1080p picture, for a region and for the whole picture.
+ *
+ * usage: effectKernelsBench [iterations]
+ */
+
+#include <stdlib.h>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "ffmpegKernels.h"
+
+static void measure(const std::string& name, const Region& region, int iterations, const std::function<void()>& kernel)
+{
+	const int warmup = 3;
+
+	for (int i = 0; i < warmup; i++)
+		kernel();
+
+	auto begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++)
+		kernel();
+	auto elapsed = std::chrono::steady_clock::now() - begin;
+
+	auto us = std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+	std::cout << name << " " << region.w << "x" << region.h << ": " << us << " us/call, "
+			<< (region.w * region.h / us) << " Mpixels/s" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	const int iterations = (argc > 1) ? atoi(argv[1]) : 100;
+	const int width = 1920;
+	const int height = 1080;
+
+	std::vector<uint8_t> luma(width * height);
+	std::vector<uint8_t> sticker(256 * 256);
+	std::vector<uint8_t> alpha(256 * 256);
+	for (size_t i = 0; i < luma.size(); i++)
+		luma[i] = rand();
+	for (size_t i = 0; i < sticker.size(); i++) {
+		sticker[i] = rand();
+		alpha[i] = rand();
+	}
+
+	Plane plane { luma.data(), width, width, height };
+	Plane source { sticker.data(), 256, 256, 256 };
+	Plane weights { alpha.data(), 256, 256, 256 };
+
+	for (const Region& region : { Region { 800, 400, 256, 256 }, Region { 0, 0, width, height } }) {
+		measure("boxBlur(r=10)", region, iterations, [&] { FFmpegKernels::boxBlur(plane, region, 10); });
+		measure("boxBlur(r=10, passes=2)", region, iterations, [&] { FFmpegKernels::boxBlur(plane, region, 10, 2); });
+		measure("gaussianBlur(sigma=10)", region, iterations, [&] { FFmpegKernels::gaussianBlur(plane, region, 10); });
+		measure("mosaic(16)", region, iterations, [&] { FFmpegKernels::mosaic(plane, region, 16); });
+		measure("fill(opaque)", region, iterations, [&] { FFmpegKernels::fill(plane, region, 128); });
+		measure("fill(alpha=128)", region, iterations, [&] { FFmpegKernels::fill(plane, region, 128, 128); });
+	}
+
+	measure("blend", { 800, 400, 256, 256 }, iterations, [&] { FFmpegKernels::blend(plane, 800, 400, source, weights); });
+
+	return 0;
+}
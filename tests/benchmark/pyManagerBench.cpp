@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Measures the per-call overhead of PyManager::process() with a python
+ * plugin that does no work, for each supported result encoding.
+ *
+ * usage: pyManagerBench [iterations]
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "PyManager.h"
+
+using namespace ovi;
+
+static const char* BENCH_MODULE = "ovi_bench_plugin";
+
+static const char* BENCH_SOURCE = R"(
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+BOXES = [(10, 20, 30, 40)] * 8
+result = []
+
+
+def setAttrs(attrs):
+    global result
+    mode = attrs.get('result', 'empty')
+    if mode == 'tuple':
+        result = BOXES
+    elif mode == 'array':
+        if numpy is None:
+            return -1
+        result = numpy.array(BOXES, dtype=numpy.float64)
+    else:
+        result = []
+    return 0
+
+
+def process(width, height, frame, total_frame_num=0, fps=0.0):
+    return (True, result)
+)";
+
+int main(int argc, char* argv[])
+{
+	const int iterations = (argc > 1) ? atoi(argv[1]) : 2000;
+	const int warmup = 50;
+
+	char dir[] = "/tmp/ovi_bench_XXXXXX";
+	if (!mkdtemp(dir)) {
+		std::cerr << "mkdtemp failed" << std::endl;
+		return 1;
+	}
+
+	const std::string modulePath = std::string(dir) + "/" + BENCH_MODULE + ".py";
+	std::ofstream(modulePath) << BENCH_SOURCE;
+	setenv("PYTHONPATH", dir, 1);
+
+	{
+		auto pyManager = std::make_shared<PyManager>();
+		int key = pyManager->create(BENCH_MODULE);
+
+		const int width = 1920;
+		const int height = 1080;
+		std::vector<char> buffer(width * height * 3);
+		VideoFramePack frame(width, height, VIDEO_FORMAT_RGB24);
+		frame.assign(buffer, 1, 0.0, 30.0);
+
+		for (const auto& mode : { "empty", "tuple", "array" }) {
+			if (pyManager->setAttributes(key, { { "result", mode } }) != OVI_ERROR_NONE) {
+				std::cout << mode << ": skipped" << std::endl;
+				continue;
+			}
+
+			for (int i = 0; i < warmup; i++)
+				pyManager->process(key, &frame);
+
+			auto begin = std::chrono::steady_clock::now();
+			size_t items = 0;
+			for (int i = 0; i < iterations; i++)
+				items += pyManager->process(key, &frame).list.size();
+			auto elapsed = std::chrono::steady_clock::now() - begin;
+
+			auto us = std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+			std::cout << mode << ": " << us << " us/call, "
+					<< (items / iterations) << " items/call" << std::endl;
+		}
+
+		pyManager->remove(key);
+	}
+
+	unlink(modulePath.c_str());
+	rmdir(dir);
+
+	return 0;
+}
@@ -33,27 +33,118 @@ TEST_F(AccumulatorTest, append_test)
 
 	auto res = _accumulator.accumulated();
 
-	EXPECT_EQ(res.size(), 5);
+	EXPECT_EQ(res.frames(), 5);
+	EXPECT_EQ(res.runs.size(), 3);
+	EXPECT_EQ(res.detections.size(), 0);
 }
 
 TEST_F(AccumulatorTest, accumulated_test)
 {
 	_accumulator.append(9, false);
 	OVIRect r = {10, 10, 10, 10};
-	_accumulator.append(10, true, {{ "plugin.1", { r }}});
+	_accumulator.append(10, true, {{ 1, { r }}});
 	_accumulator.append(11, true);
 	_accumulator.append(12, true);
 	_accumulator.append(13, false);
 
 	auto res = _accumulator.accumulated();
 
-	EXPECT_EQ(res.size(), 5);
-	EXPECT_EQ(res[0].frameNumber, 9);
-	EXPECT_EQ(res[0].include, false);
+	EXPECT_EQ(res.frames(), 5);
+	ASSERT_EQ(res.runs.size(), 4);
+	EXPECT_EQ(res.runs[0].firstFrame, 9);
+	EXPECT_EQ(res.runs[0].include, false);
+	EXPECT_EQ(res.runs[2].firstFrame, 11);
+	EXPECT_EQ(res.runs[2].frames, 2);
 
-	OVIRect getResult = std::get<OVIRect>(res[1].detected["plugin.1"][0]);
+	ASSERT_NE(res.runs[1].detection, FrameRun::NO_DETECTION);
+	auto detected = res.detections.at(res.runs[1].detection);
+	ASSERT_EQ(detected.size(), 1);
+	EXPECT_EQ(detected[0].first, 1);
+	OVIRect getResult = std::get<OVIRect>(detected[0].second[0]);
 	EXPECT_EQ(getResult.x, 10);
 	EXPECT_EQ(getResult.y, 10);
 	EXPECT_EQ(getResult.width, 10);
 	EXPECT_EQ(getResult.height, 10);
 }
+
+TEST_F(AccumulatorTest, append_range_test)
+{
+	OVIRect r = {10, 10, 10, 10};
+	_accumulator.append(0, 3, true, {{ 1, { r }}});
+	_accumulator.append(3, 3, true);
+	_accumulator.append(6, 3, true);
+	_accumulator.append(10, 3, true);
+
+	auto res = _accumulator.accumulated();
+
+	EXPECT_EQ(res.frames(), 12);
+	ASSERT_EQ(res.runs.size(), 3);
+	EXPECT_EQ(res.runs[0].frames, 3);
+	EXPECT_EQ(res.runs[1].frames, 6);
+	EXPECT_EQ(res.runs[2].firstFrame, 10);
+	EXPECT_EQ(res.detections.size(), 1);
+}
+
+TEST_F(AccumulatorTest, update_test)
+{
+	_accumulator.append(0, 4, true);
+	_accumulator.append(4, 2, false);
+
+	_accumulator.update({ true, false, false, true, true, true });
+
+	auto res = _accumulator.accumulated();
+
+	EXPECT_EQ(res.frames(), 6);
+	ASSERT_EQ(res.runs.size(), 4);
+	EXPECT_EQ(res.runs[1].firstFrame, 1);
+	EXPECT_EQ(res.runs[1].frames, 2);
+	EXPECT_FALSE(res.runs[1].include);
+	EXPECT_TRUE(res.runs[2].include);
+	EXPECT_TRUE(res.runs[3].include);
+}
+
+TEST_F(AccumulatorTest, long_media_test)
+{
+	constexpr size_t budget = 1 << 20;
+	constexpr int frames = 2000000;
+	Accumulator accumulator(budget, "/tmp");
+	const auto& res = accumulator.accumulated();
+
+	// a detection on every frame, which makes a run for each
+	for (int i = 0; i < frames; i++) {
+		accumulator.append(i, true, { { 0, { OVIRect { static_cast<double>(i), 1, 1, 1 } } } });
+		ASSERT_LE(res.detections.residentBytes(), budget);
+		ASSERT_LE(res.runs.residentBytes(), RunStore::PAGE_RUNS * sizeof(FrameRun));
+	}
+
+	EXPECT_TRUE(res.runs.spilled());
+	EXPECT_EQ(res.runs.size(), frames);
+	EXPECT_EQ(res.detections.size(), frames);
+	EXPECT_LT(res.detections.blocks(), frames / 1000);
+
+	auto run = res.runs[frames / 2];
+	EXPECT_EQ(run.firstFrame, frames / 2);
+	EXPECT_EQ(std::get<OVIRect>(res.detections.at(run.detection)[0].second[0]).x, frames / 2);
+	EXPECT_EQ(res.frames(), frames);
+}
+
+TEST_F(AccumulatorTest, update_after_restore_test)
+{
+	_accumulator.restore(0, { { 0, 3, true, FrameRun::NO_DETECTION } }, {});
+	_accumulator.append(3, 3, true);
+
+	// a multi-frame plugin has only seen the frames after the resume point
+	_accumulator.update({ false, true, false });
+
+	auto res = _accumulator.accumulated();
+
+	EXPECT_EQ(res.frames(), 6);
+	ASSERT_EQ(res.runs.size(), 4);
+	EXPECT_EQ(res.runs[0].frames, 3);
+	EXPECT_TRUE(res.runs[0].include);
+	EXPECT_EQ(res.runs[1].firstFrame, 3);
+	EXPECT_FALSE(res.runs[1].include);
+	EXPECT_EQ(res.runs[2].firstFrame, 4);
+	EXPECT_TRUE(res.runs[2].include);
+	EXPECT_FALSE(res.runs[3].include);
+}
@@ -0,0 +1,151 @@
+/*
+* Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <unistd.h>
+
+#include "utBase.h"
+#include "Checkpoint.h"
+
+class CheckpointTest : public UtBase {
+protected:
+	void SetUp() override {
+		_path = "/tmp/ovi_checkpoint_ut_" + std::to_string(getpid());
+		unlink(_path.c_str());
+	}
+
+	void TearDown() override {
+		unlink(_path.c_str());
+	}
+
+	static void expectSame(const AccumulatedData& expected, const AccumulatedData& actual) {
+		ASSERT_EQ(expected.runs.size(), actual.runs.size());
+		for (size_t i = 0; i < expected.runs.size(); i++) {
+			EXPECT_EQ(expected.runs[i].firstFrame, actual.runs[i].firstFrame);
+			EXPECT_EQ(expected.runs[i].frames, actual.runs[i].frames);
+			EXPECT_EQ(expected.runs[i].include, actual.runs[i].include);
+			EXPECT_EQ(expected.runs[i].detection, actual.runs[i].detection);
+		}
+
+		ASSERT_EQ(expected.detections.size(), actual.detections.size());
+		for (size_t i = 0; i < expected.detections.size(); i++) {
+			auto e = expected.detections.at(i);
+			auto a = actual.detections.at(i);
+			ASSERT_EQ(e.size(), a.size());
+			for (size_t j = 0; j < e.size(); j++) {
+				EXPECT_EQ(e[j].first, a[j].first);
+				EXPECT_EQ(e[j].second.size(), a[j].second.size());
+			}
+		}
+	}
+
+	std::string _path;
+	const DetectedData _detected = {
+		{ 0, { OVIRect { 1, 2, 3, 4 }, OVIRectTag { 1, 2, 3, 4, "face" } } },
+		{ 1, { 0.5, true } },
+	};
+};
+
+TEST_F(CheckpointTest, restore_check_incremental_saves)
+{
+	Accumulator accumulator(0, {});
+	Checkpoint checkpoint(_path, "graph");
+
+	accumulator.append(0, 3, false);
+	accumulator.append(3, 2, true, _detected);
+	checkpoint.save(accumulator, { 4, 0.16, -1, -1.0 });
+
+	// grows the last run, adds a run and a detection
+	accumulator.append(5, 2, true);
+	accumulator.append(7, 2, true);
+	accumulator.append(9, 1, true, _detected);
+	checkpoint.save(accumulator, { 9, 0.36, -1, -1.0 });
+
+	Accumulator restored(0, {});
+	CheckpointPosition position;
+	ASSERT_TRUE(Checkpoint(_path, "graph").restore(restored, &position));
+
+	EXPECT_EQ(position.videoFrame, 9);
+	EXPECT_EQ(position.videoPts, 0.36);
+	EXPECT_EQ(position.audioFrame, -1);
+	expectSame(accumulator.accumulated(), restored.accumulated());
+
+	auto detected = restored.accumulated().detections.at(1);
+	EXPECT_EQ(std::get<OVIRectTag>(detected[0].second[1]).tag, "face");
+	EXPECT_EQ(std::get<bool>(detected[1].second[1]), true);
+}
+
+TEST_F(CheckpointTest, restore_check_multi_frame_update)
+{
+	Accumulator accumulator(0, {});
+	Checkpoint checkpoint(_path, "graph");
+
+	accumulator.append(0, 4, true, _detected);
+	checkpoint.save(accumulator, { 3, 0.12, -1, -1.0 });
+	accumulator.update({ true, false, false, true });
+	checkpoint.save(accumulator, { 3, 0.12, -1, -1.0 });
+
+	Accumulator restored(0, {});
+	CheckpointPosition position;
+	ASSERT_TRUE(Checkpoint(_path, "graph").restore(restored, &position));
+	expectSame(accumulator.accumulated(), restored.accumulated());
+}
+
+TEST_F(CheckpointTest, restore_check_torn_record_and_continue)
+{
+	{
+		Accumulator accumulator(0, {});
+		Checkpoint checkpoint(_path, "graph");
+		accumulator.append(0, 3, true, _detected);
+		checkpoint.save(accumulator, { 2, 0.08, 1, 0.05 });
+	}
+
+	// a crash in the middle of the next record
+	auto size = std::filesystem::file_size(_path);
+	{
+		std::ofstream file(_path, std::ios::binary | std::ios::app);
+		file << "OVCK partial";
+	}
+
+	Accumulator restored(0, {});
+	CheckpointPosition position;
+	Checkpoint checkpoint(_path, "graph");
+	ASSERT_TRUE(checkpoint.restore(restored, &position));
+	EXPECT_EQ(std::filesystem::file_size(_path), size);
+	EXPECT_EQ(position.audioFrame, 1);
+
+	// the journal goes on after the restored records
+	restored.append(3, 1, false);
+	checkpoint.save(restored, { 3, 0.12, 2, 0.1 });
+
+	Accumulator again(0, {});
+	ASSERT_TRUE(Checkpoint(_path, "graph").restore(again, &position));
+	EXPECT_EQ(position.videoFrame, 3);
+	expectSame(restored.accumulated(), again.accumulated());
+}
+
+TEST_F(CheckpointTest, restore_check_other_analysis)
+{
+	Accumulator accumulator(0, {});
+	accumulator.append(0, 3, true);
+	Checkpoint(_path, "graph").save(accumulator, { 2, 0.08, -1, -1.0 });
+
+	Accumulator restored(0, {});
+	CheckpointPosition position;
+	EXPECT_FALSE(Checkpoint(_path, "other graph").restore(restored, &position));
+	EXPECT_FALSE(Checkpoint(_path + ".none", "graph").restore(restored, &position));
+	EXPECT_EQ(restored.accumulated().runs.size(), 0);
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <random>
+
+#include "utBase.h"
+#include "DataAnalyzer.h"
+
+//{ frame number, include, detected }
+struct FrameData {
+	double frameNumber {};
+	bool include {};
+	DetectedData detected;
+};
+
+/* The analysis over one entry per frame, as DataAnalyzer did before the runs */
+static std::vector<TimeRangeWithMetadata> referenceAnalyze(const std::vector<FrameData>& inputData, double framerate)
+{
+	size_t frameCount = static_cast<size_t>(ceil(framerate));
+	std::vector<TimeRangeWithMetadata> timeRange;
+
+	auto sort = [](const std::vector<FrameData>& input) {
+		SortedCollection tmp;
+		for (const auto& data : input)
+			for (const auto& [ id, details ] : data.detected)
+				tmp[id].push_back({ data.frameNumber, details });
+		return tmp;
+	};
+
+	bool before = false;
+	double start = -1.0;
+	double duration = 1.0;
+	std::vector<FrameData> temp;
+
+	for (size_t i = 0; i < inputData.size(); i++) {
+		if (!before && inputData[i].include) {
+			start = inputData[i].frameNumber;
+			before = true;
+			if (!inputData[i].detected.empty())
+				temp.push_back(inputData[i]);
+		} else if (before && inputData[i].include) {
+			duration++;
+			if (!inputData[i].detected.empty())
+				temp.push_back(inputData[i]);
+		} else if (before && !inputData[i].include) {
+			size_t len = (i + frameCount >= inputData.size()) ? inputData.size() - i : frameCount;
+			size_t skip = 0;
+			for (size_t j = 1; j < len; j++) {
+				if (inputData[i + j].include) {
+					skip = j;
+					break;
+				}
+			}
+
+			if (skip > 0) {
+				duration += (skip + 1);
+				i += skip;
+			} else {
+				timeRange.push_back({ { start, duration }, sort(temp) });
+				start = -1.0;
+				duration = 1.0;
+				before = false;
+				temp.clear();
+			}
+		}
+	}
+
+	if (start >= 0.0)
+		timeRange.push_back({ { start, duration }, sort(temp) });
+
+	return timeRange;
+}
+
+static void expectEqual(const std::vector<TimeRangeWithMetadata>& expected,
+						const std::vector<TimeRangeWithMetadata>& actual)
+{
+	ASSERT_EQ(expected.size(), actual.size());
+
+	for (size_t i = 0; i < expected.size(); i++) {
+		EXPECT_EQ(expected[i].timeRange.startFrameNum, actual[i].timeRange.startFrameNum);
+		EXPECT_EQ(expected[i].timeRange.duration, actual[i].timeRange.duration);
+
+		ASSERT_EQ(expected[i].collection.size(), actual[i].collection.size());
+		for (const auto& [ id, details ] : expected[i].collection) {
+			ASSERT_EQ(1, actual[i].collection.count(id));
+			const auto& actualDetails = actual[i].collection.at(id);
+			ASSERT_EQ(details.size(), actualDetails.size());
+			for (size_t j = 0; j < details.size(); j++)
+				EXPECT_EQ(details[j].frameNumber, actualDetails[j].frameNumber);
+		}
+	}
+}
+
+class DataAnalyzerTest : public UtBase {
+protected:
+	void append(std::vector<FrameData>& frames, bool include, const DetectedData& detected, size_t count) {
+		_accumulator.append(static_cast<double>(frames.size()), count, include, detected);
+		for (size_t i = 0; i < count; i++)
+			frames.push_back({ static_cast<double>(frames.size()), include, detected });
+	}
+
+	std::vector<TimeRangeWithMetadata> analyze(double framerate) {
+		DataAnalyzer dataAnalyzer;
+		dataAnalyzer.setCorrectionValue(framerate);
+		dataAnalyzer.analyzeRawData(_accumulator.accumulated());
+		return dataAnalyzer.result();
+	}
+
+	Accumulator _accumulator;
+	const DetectedData _detected = { { 0, { OVIRect { 1, 1, 1, 1 } } } };
+};
+
+TEST_F(DataAnalyzerTest, analyzeRawData_bridge_short_gap)
+{
+	std::vector<FrameData> frames;
+	append(frames, true, {}, 3);
+	append(frames, false, {}, 2);
+	append(frames, true, _detected, 3);
+	append(frames, false, {}, 10);
+
+	auto result = analyze(5);
+	ASSERT_EQ(result.size(), 1);
+	EXPECT_EQ(result[0].timeRange.startFrameNum, 0);
+	EXPECT_EQ(result[0].timeRange.duration, 8);
+
+	// the first frame after the gap is not collected
+	ASSERT_EQ(result[0].collection.at(0).size(), 2);
+	EXPECT_EQ(result[0].collection.at(0)[0].frameNumber, 6);
+
+	expectEqual(referenceAnalyze(frames, 5), result);
+}
+
+TEST_F(DataAnalyzerTest, analyzeRawData_split_long_gap)
+{
+	std::vector<FrameData> frames;
+	append(frames, false, {}, 2);
+	append(frames, true, _detected, 3);
+	append(frames, false, {}, 5);
+	append(frames, true, {}, 1);
+
+	auto result = analyze(5);
+	ASSERT_EQ(result.size(), 2);
+	EXPECT_EQ(result[0].timeRange.startFrameNum, 2);
+	EXPECT_EQ(result[0].timeRange.duration, 3);
+	EXPECT_EQ(result[1].timeRange.startFrameNum, 10);
+	EXPECT_TRUE(result[1].collection.empty());
+
+	expectEqual(referenceAnalyze(frames, 5), result);
+}
+
+TEST_F(DataAnalyzerTest, analyzeRawData_compare_with_reference_for_random_data)
+{
+	std::mt19937 rng(20230714);
+
+	for (int test = 0; test < 300; test++) {
+		// every other accumulator spills its detections almost at once
+		_accumulator = (test % 2) ? Accumulator(256, "/tmp") : Accumulator(0, {});
+		std::vector<FrameData> frames;
+
+		int runs = 1 + rng() % 30;
+		for (int r = 0; r < runs; r++) {
+			bool include = rng() % 2;
+			size_t count = 1 + rng() % 8;
+			// detections only come with included frames
+			DetectedData detected;
+			if (include && rng() % 3 == 0)
+				detected = { { static_cast<PluginId>(rng() % 3), { OVIRect { 0, 0, 1, 1 } } } };
+			append(frames, include, detected, count);
+		}
+
+		double framerate = 1 + rng() % 6;
+		SCOPED_TRACE("test #" + std::to_string(test));
+		expectEqual(referenceAnalyze(frames, framerate), analyze(framerate));
+	}
+}
+
+TEST_F(DataAnalyzerTest, analyzeRawData_callback_compare_with_result_for_random_data)
+{
+	std::mt19937 rng(20231018);
+
+	for (int test = 0; test < 100; test++) {
+		_accumulator = Accumulator(256, "/tmp");
+		std::vector<FrameData> frames;
+
+		int runs = 1 + rng() % 30;
+		for (int r = 0; r < runs; r++) {
+			bool include = rng() % 2;
+			DetectedData detected;
+			if (include && rng() % 2 == 0)
+				detected = { { static_cast<PluginId>(rng() % 3), { OVIRect { 0, 0, 1, 1 } } } };
+			append(frames, include, detected, 1 + rng() % 8);
+		}
+
+		double framerate = 1 + rng() % 6;
+		std::vector<TimeRangeWithMetadata> ranges;
+		DataAnalyzer dataAnalyzer;
+		dataAnalyzer.setCorrectionValue(framerate);
+		dataAnalyzer.analyzeRawData(_accumulator.accumulated(), [&](TimeRangeWithMetadata&& range) {
+			// a range only holds the detections of its own frames
+			for (const auto& [ id, details ] : range.collection) {
+				for (const auto& detected : details) {
+					EXPECT_GE(detected.frameNumber, range.timeRange.startFrameNum);
+					EXPECT_LT(detected.frameNumber, range.timeRange.startFrameNum + range.timeRange.duration);
+				}
+			}
+			ranges.push_back(std::move(range));
+		});
+
+		SCOPED_TRACE("test #" + std::to_string(test));
+		EXPECT_TRUE(dataAnalyzer.result().empty());
+		expectEqual(analyze(framerate), ranges);
+	}
+}
+
+TEST_F(DataAnalyzerTest, streaming_compare_with_batch_for_random_data)
+{
+	std::mt19937 rng(20230715);
+
+	for (int test = 0; test < 300; test++) {
+		double framerate = 1 + rng() % 6;
+		std::vector<TimeRangeWithMetadata> streamed;
+		double appending = -1.0;	// the first frame of the current append
+
+		_accumulator = Accumulator(0, {});
+		_accumulator.setStreamingAnalyzer(std::make_shared<StreamingDataAnalyzer>(framerate,
+			[&](TimeRangeWithMetadata&& range) {
+				// a range is final within the correction value after its end
+				EXPECT_LE(appending - (range.timeRange.startFrameNum + range.timeRange.duration), ceil(framerate));
+				streamed.push_back(std::move(range));
+			}));
+
+		std::vector<FrameData> frames;
+		int runs = 1 + rng() % 30;
+		for (int r = 0; r < runs; r++) {
+			bool include = rng() % 2;
+			size_t count = 1 + rng() % 8;
+			DetectedData detected;
+			if (include && rng() % 3 == 0)
+				detected = { { static_cast<PluginId>(rng() % 3), { OVIRect { 0, 0, 1, 1 } } } };
+			appending = static_cast<double>(frames.size());
+			append(frames, include, detected, count);
+		}
+		_accumulator.finish();
+
+		SCOPED_TRACE("test #" + std::to_string(test));
+		expectEqual(analyze(framerate), streamed);
+	}
+}
@@ -0,0 +1,125 @@
+/*
+* Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include "utBase.h"
+#include "DetectionStore.h"
+
+class DetectionStoreTest : public UtBase {
+protected:
+	static DetectedData makeDetected(int i) {
+		OVIRect rect;
+		rect.x = i;
+		rect.y = i + 1;
+		rect.width = 10;
+		rect.height = 20;
+
+		OVIRectTag rectTag;
+		rectTag.x = i;
+		rectTag.y = 0;
+		rectTag.width = 1;
+		rectTag.height = 2;
+		rectTag.tag = "tag" + std::to_string(i);
+
+		// two entries of the same plugin must stay apart
+		return { { 0, { rect, rectTag } }, { 1, { i * 0.5, i % 2 == 0 } }, { 1, {} }, { 2, { rect } } };
+	}
+
+	static void expectDetected(const DetectedData& detected, int i) {
+		ASSERT_EQ(detected.size(), 4);
+		EXPECT_EQ(detected[0].first, 0);
+		ASSERT_EQ(detected[0].second.size(), 2);
+		auto rect = std::get<OVIRect>(detected[0].second[0]);
+		EXPECT_EQ(rect.x, i);
+		EXPECT_EQ(rect.y, i + 1);
+		EXPECT_EQ(rect.height, 20);
+		auto rectTag = std::get<OVIRectTag>(detected[0].second[1]);
+		EXPECT_EQ(rectTag.tag, "tag" + std::to_string(i));
+		EXPECT_EQ(rectTag.height, 2);
+
+		EXPECT_EQ(detected[1].first, 1);
+		ASSERT_EQ(detected[1].second.size(), 2);
+		EXPECT_EQ(std::get<double>(detected[1].second[0]), i * 0.5);
+		EXPECT_EQ(std::get<bool>(detected[1].second[1]), i % 2 == 0);
+
+		EXPECT_EQ(detected[2].first, 1);
+		EXPECT_TRUE(detected[2].second.empty());
+
+		EXPECT_EQ(detected[3].first, 2);
+		EXPECT_EQ(std::get<OVIRect>(detected[3].second[0]).x, i);
+	}
+};
+
+TEST_F(DetectionStoreTest, memory_test)
+{
+	DetectionStore store;
+
+	for (int i = 0; i < 100; i++)
+		EXPECT_EQ(store.add(makeDetected(i)), i);
+
+	EXPECT_EQ(store.size(), 100);
+	EXPECT_FALSE(store.spilled());
+	expectDetected(store.at(42), 42);
+}
+
+TEST_F(DetectionStoreTest, spill_test)
+{
+	DetectionStore store(4096, "/tmp");
+
+	for (int i = 0; i < 1000; i++)
+		store.add(makeDetected(i));
+
+	EXPECT_EQ(store.size(), 1000);
+	EXPECT_TRUE(store.spilled());
+
+	auto cursor = store.cursor();
+	for (int i = 0; i < 1000; i++)
+		expectDetected(cursor.at(i), i);
+
+	// random access and appending after reading
+	expectDetected(store.at(3), 3);
+	store.add(makeDetected(1000));
+	expectDetected(store.at(1000), 1000);
+	expectDetected(store.cursor().at(999), 999);
+}
+
+TEST_F(DetectionStoreTest, shared_copy_test)
+{
+	DetectionStore store(1024, "/tmp");
+	DetectionStore copy = store;
+
+	for (int i = 0; i < 50; i++)
+		store.add(makeDetected(i));
+
+	EXPECT_EQ(copy.size(), 50);
+	expectDetected(copy.at(7), 7);
+	EXPECT_THROW(copy.at(50), ovi::Exception);
+}
+
+TEST_F(DetectionStoreTest, resident_bytes_test)
+{
+	DetectionStore store(4096, "/tmp");
+
+	for (int i = 0; i < 1000; i++) {
+		store.add(makeDetected(i));
+		EXPECT_LE(store.residentBytes(), 4096);
+	}
+
+	// a block holds all the detections under the budget, not one each
+	EXPECT_TRUE(store.spilled());
+	EXPECT_LT(store.blocks(), 1000 / 4);
+	expectDetected(store.at(999), 999);
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+
+#include "utBase.h"
+#include "DetectionTracker.h"
+
+class DetectionTrackerTest : public UtBase {
+protected:
+	static OVIRect interpolate(const DetectionTrack& track, double frame) {
+		for (size_t i = 1; i < track.keys.size(); i++) {
+			const auto& from = track.keys[i - 1];
+			const auto& to = track.keys[i];
+			if (frame > to.frame)
+				continue;
+
+			double t = (frame - from.frame) / (to.frame - from.frame);
+			return { from.rect.x + (to.rect.x - from.rect.x) * t,
+				from.rect.y + (to.rect.y - from.rect.y) * t,
+				from.rect.width + (to.rect.width - from.rect.width) * t,
+				from.rect.height + (to.rect.height - from.rect.height) * t };
+		}
+		return track.keys.back().rect;
+	}
+};
+
+TEST_F(DetectionTrackerTest, tracks_check_linear_motion)
+{
+	DetectionTracker tracker(1.0, 5);
+
+	for (int frame = 0; frame < 100; frame++)
+		tracker.add(frame, { OVIRect { 10.0 + frame * 2, 20.0 + frame, 50, 40 } });
+
+	auto tracks = tracker.tracks();
+	ASSERT_EQ(tracks.size(), 1u);
+	ASSERT_EQ(tracks[0].keys.size(), 2u);
+	EXPECT_EQ(tracks[0].keys[0].frame, 0);
+	EXPECT_EQ(tracks[0].keys[1].frame, 99);
+	EXPECT_DOUBLE_EQ(tracks[0].keys[1].rect.x, 208);
+	EXPECT_FALSE(tracks[0].tagged);
+}
+
+TEST_F(DetectionTrackerTest, tracks_check_interpolation_within_tolerance)
+{
+	const double tolerance = 2.0;
+	std::vector<OVIRect> rects;
+	DetectionTracker tracker(tolerance, 5);
+
+	for (int frame = 0; frame < 200; frame++) {
+		rects.push_back({ 100 + 60 * std::sin(frame / 20.0), 100 + frame * 0.5, 30.0 + (frame % 3), 30 });
+		tracker.add(frame, { rects.back() });
+	}
+
+	auto tracks = tracker.tracks();
+	ASSERT_EQ(tracks.size(), 1u);
+	EXPECT_LT(tracks[0].keys.size(), rects.size() / 4);
+
+	for (int frame = 0; frame < 200; frame++) {
+		auto rect = interpolate(tracks[0], frame);
+		EXPECT_NEAR(rect.x, rects[frame].x, tolerance + 1e-9);
+		EXPECT_NEAR(rect.y, rects[frame].y, tolerance + 1e-9);
+		EXPECT_NEAR(rect.width, rects[frame].width, tolerance + 1e-9);
+		EXPECT_NEAR(rect.height, rects[frame].height, tolerance + 1e-9);
+	}
+}
+
+TEST_F(DetectionTrackerTest, tracks_check_separate_objects)
+{
+	DetectionTracker tracker(1.0, 5);
+
+	for (int frame = 0; frame < 30; frame++) {
+		tracker.add(frame, { OVIRect { 10.0 + frame, 10, 20, 20 }, OVIRect { 300.0 - frame, 200, 20, 20 },
+			OVIRectTag { 10.0 + frame, 10, 20, 20, "face" } });
+	}
+
+	auto tracks = tracker.tracks();
+	ASSERT_EQ(tracks.size(), 3u);
+	for (const auto& track : tracks)
+		EXPECT_EQ(track.keys.size(), 2u);
+
+	int tagged = 0;
+	for (const auto& track : tracks) {
+		if (track.tagged) {
+			tagged++;
+			EXPECT_EQ(track.tag, "face");
+		} else {
+			EXPECT_DOUBLE_EQ(track.keys[0].rect.x + track.keys[1].rect.x, track.keys[0].rect.y < 100 ? 49 : 571);
+		}
+	}
+	EXPECT_EQ(tagged, 1);
+}
+
+TEST_F(DetectionTrackerTest, tracks_check_gap_ends_track)
+{
+	DetectionTracker tracker(1.0, 3);
+
+	for (int frame = 0; frame < 10; frame++)
+		tracker.add(frame, { OVIRect { 10, 10, 20, 20 } });
+	tracker.add(12, { OVIRect { 10, 10, 20, 20 } });
+	tracker.add(20, { OVIRect { 10, 10, 20, 20 } });
+
+	auto tracks = tracker.tracks();
+	ASSERT_EQ(tracks.size(), 2u);
+	EXPECT_EQ(tracks[0].keys.front().frame, 0);
+	EXPECT_EQ(tracks[0].keys.back().frame, 12);
+	ASSERT_EQ(tracks[1].keys.size(), 1u);
+	EXPECT_EQ(tracks[1].keys[0].frame, 20);
+}
+
+TEST_F(DetectionTrackerTest, tracks_check_no_gap_bridged)
+{
+	DetectionTracker tracker(1.0, 0);
+
+	for (int frame = 0; frame < 10; frame++) {
+		if (frame != 5)
+			tracker.add(frame, { OVIRect { 10, 10, 20, 20 } });
+	}
+
+	auto tracks = tracker.tracks();
+	ASSERT_EQ(tracks.size(), 2u);
+	EXPECT_EQ(tracks[0].keys.front().frame, 0);
+	EXPECT_EQ(tracks[0].keys.back().frame, 4);
+	EXPECT_EQ(tracks[1].keys.front().frame, 6);
+	EXPECT_EQ(tracks[1].keys.back().frame, 9);
+}
+
+TEST_F(DetectionTrackerTest, tracks_check_no_overlap_starts_track)
+{
+	DetectionTracker tracker(1.0, 5);
+
+	tracker.add(0, { OVIRect { 0, 0, 20, 20 } });
+	tracker.add(1, { OVIRect { 100, 100, 20, 20 } });
+
+	EXPECT_EQ(tracker.tracks().size(), 2u);
+	EXPECT_TRUE(tracker.tracks().empty());
+}
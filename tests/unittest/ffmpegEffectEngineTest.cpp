@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef ENABLE_FFMPEGRENDER
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/pixdesc.h>
+}
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <unistd.h>
+
+#include "utBase.h"
+#include "ffmpegEffectEngine.h"
+#include "ffmpegKernels.h"
+
+/* of a 4:2:0 picture of odd sizes */
+static const int WIDTH = 37;
+static const int HEIGHT = 23;
+
+/* red in BT.601 limited range, as the engine converts it for a picture of this size */
+static const int RED_YUV[3] = { 81, 90, 240 };
+static const int BACKGROUND_YUV[3] = { 16, 128, 128 };
+
+struct FrameDeleter {
+	void operator()(AVFrame* frame) const { av_frame_free(&frame); }
+};
+using FramePtr = std::unique_ptr<AVFrame, FrameDeleter>;
+
+class FFmpegEffectEngineTest : public UtBase {
+protected:
+	void SetUp() override {
+		_frame = FramePtr(av_frame_alloc());
+		ASSERT_TRUE(_frame);
+		_frame->format = AV_PIX_FMT_YUV420P;
+		_frame->width = WIDTH;
+		_frame->height = HEIGHT;
+		ASSERT_GE(av_frame_get_buffer(_frame.get(), 0), 0);
+
+		for (int i = 0; i < 3; i++) {
+			for (int y = 0; y < height(i); y++)
+				memset(_frame->data[i] + y * _frame->linesize[i], BACKGROUND_YUV[i], width(i));
+		}
+	}
+
+	void TearDown() override {
+		if (!_sticker.empty())
+			std::filesystem::remove(_sticker);
+	}
+
+	static int width(int plane) { return plane ? AV_CEIL_RSHIFT(WIDTH, 1) : WIDTH; }
+	static int height(int plane) { return plane ? AV_CEIL_RSHIFT(HEIGHT, 1) : HEIGHT; }
+
+	Plane plane(int index) const {
+		return { _frame->data[index], _frame->linesize[index], width(index), height(index) };
+	}
+
+	static CoordinateInfo coord(double x, double y, double w, double h) {
+		return { x, y, w, h, { 0.0, 1.0 } };
+	}
+
+	static bool inside(const Region& region, int x, int y) {
+		return x >= region.x && x < region.x + region.w && y >= region.y && y < region.y + region.h;
+	}
+
+	/* each sample of the plane is the expected value or the background, within the tolerance */
+	void expectPlane(int index, const std::function<bool(int, int)>& painted, int value, int tolerance = 0) {
+		for (int y = 0; y < height(index); y++) {
+			for (int x = 0; x < width(index); x++) {
+				int actual = _frame->data[index][y * _frame->linesize[index] + x];
+				int expected = painted(x, y) ? value : BACKGROUND_YUV[index];
+				ASSERT_LE(std::abs(actual - expected), tolerance) << "plane " << index << " at " << x << "," << y;
+			}
+		}
+	}
+
+	/* a binary PPM of one color */
+	std::string writeSticker(int size, const uint8_t rgb[3]) {
+		_sticker = (std::filesystem::temp_directory_path() / ("ovi_sticker_ut_" + std::to_string(getpid()) + ".ppm")).string();
+
+		std::ofstream file(_sticker, std::ios::binary);
+		file << "P6\n" << size << " " << size << "\n255\n";
+		for (int i = 0; i < size * size; i++)
+			file.write(reinterpret_cast<const char*>(rgb), 3);
+
+		return _sticker;
+	}
+
+	FramePtr _frame;
+	std::string _sticker;
+};
+
+TEST_F(FFmpegEffectEngineTest, drawBox_check_plane_placement)
+{
+	FFmpegEffectEngine engine;
+	engine.addBox("red", 2, { coord(3.2, 4.6, 20, 10) });
+	engine.process(_frame.get(), 0.5);
+
+	// the luma box is rounded to (3, 5) 20x10, the chroma one covers the luma samples touched
+	const Region boxes[3] = { { 3, 5, 20, 10 }, { 1, 2, 11, 6 }, { 1, 2, 11, 6 } };
+	const int thickness[3] = { 2, 1, 1 };
+
+	for (int i = 0; i < 3; i++) {
+		const auto& box = boxes[i];
+		int t = thickness[i];
+		expectPlane(i, [&](int x, int y) {
+			return inside(box, x, y) && !inside({ box.x + t, box.y + t, box.w - 2 * t, box.h - 2 * t }, x, y);
+		}, RED_YUV[i]);
+	}
+}
+
+TEST_F(FFmpegEffectEngineTest, drawBox_check_clipped_translucent)
+{
+	FFmpegEffectEngine engine;
+	engine.addBox("red@0x80", 100, { coord(30, -3, 20, 8) });
+	engine.process(_frame.get(), 0.5);
+
+	// the sides overlap, the whole box is blended once and clipped to the picture
+	const Region boxes[3] = { { 30, 0, 7, 5 }, { 15, 0, 4, 3 }, { 15, 0, 4, 3 } };
+	// half of 0x80 over the background, rounded
+	for (int i = 0; i < 3; i++) {
+		int blended = (RED_YUV[i] * 128 + BACKGROUND_YUV[i] * 127 + 127) / 255;
+		expectPlane(i, [&](int x, int y) { return inside(boxes[i], x, y); }, blended, 1);
+	}
+}
+
+TEST_F(FFmpegEffectEngineTest, drawSticker_check_plane_placement)
+{
+	const uint8_t red[3] = { 255, 0, 0 };
+
+	FFmpegEffectEngine engine;
+	engine.addSticker(writeSticker(16, red), { coord(6, 3, 8, 8) });
+	engine.process(_frame.get(), 0.5);
+
+	// scaled to 8x8 on the luma plane and to 4x4 at the half position on the chroma planes
+	const Region stickers[3] = { { 6, 3, 8, 8 }, { 3, 1, 4, 4 }, { 3, 1, 4, 4 } };
+	for (int i = 0; i < 3; i++)
+		expectPlane(i, [&](int x, int y) { return inside(stickers[i], x, y); }, RED_YUV[i], 3);
+}
+
+TEST_F(FFmpegEffectEngineTest, mosaic_check_chroma_regions)
+{
+	for (int i = 0; i < 3; i++) {
+		for (int y = 0; y < height(i); y++) {
+			for (int x = 0; x < width(i); x++)
+				_frame->data[i][y * _frame->linesize[i] + x] = static_cast<uint8_t>((x * 29 + y * 53 + i * 7) & 0xff);
+		}
+	}
+
+	// (5.4, 2.5) 16x9 rounds to (5, 3) 16x9, the chroma regions cover it with blocks of half the size
+	const Region regions[3] = { { 5, 3, 16, 9 }, { 2, 1, 9, 5 }, { 2, 1, 9, 5 } };
+	const int sizes[3] = { 4, 2, 2 };
+
+	std::vector<uint8_t> expected[3];
+	for (int i = 0; i < 3; i++) {
+		for (int y = 0; y < height(i); y++)
+			expected[i].insert(expected[i].end(), _frame->data[i] + y * _frame->linesize[i], _frame->data[i] + y * _frame->linesize[i] + width(i));
+		FFmpegKernels::mosaic({ expected[i].data(), width(i), width(i), height(i) }, regions[i], sizes[i]);
+	}
+
+	FFmpegEffectEngine engine;
+	engine.addMosaic(4, { coord(5.4, 2.5, 16, 9) });
+	engine.process(_frame.get(), 0.5);
+
+	for (int i = 0; i < 3; i++) {
+		for (int y = 0; y < height(i); y++) {
+			const uint8_t* row = _frame->data[i] + y * _frame->linesize[i];
+			ASSERT_TRUE(std::equal(row, row + width(i), expected[i].begin() + y * width(i))) << "plane " << i << " row " << y;
+		}
+	}
+}
+
+#endif /* ENABLE_FFMPEGRENDER */
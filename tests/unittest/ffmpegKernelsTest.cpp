@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef ENABLE_FFMPEGRENDER
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "utBase.h"
+#include "ffmpegKernels.h"
+
+/* A plane of odd sizes, its rows padded, with a pattern that changes in both directions */
+struct TestPlane {
+	TestPlane(int width, int height)
+		: width(width), height(height), linesize(width + 11), pixels(static_cast<size_t>(linesize) * height)
+	{
+		for (size_t i = 0; i < pixels.size(); i++)
+			pixels[i] = static_cast<uint8_t>((i * 37 + (i / linesize) * 91 + (i * i) % 13) & 0xff);
+	}
+
+	Plane plane() { return { pixels.data(), linesize, width, height }; }
+	uint8_t& at(int x, int y) { return pixels[static_cast<size_t>(y) * linesize + x]; }
+
+	int width;
+	int height;
+	int linesize;
+	std::vector<uint8_t> pixels;
+};
+
+/* The scalar references of the kernels, the samples outside of the clipped region are not read */
+struct Reference {
+	static bool clip(const TestPlane& plane, Region* region) {
+		int left = std::max(region->x, 0);
+		int top = std::max(region->y, 0);
+		int right = std::min(region->x + region->w, plane.width);
+		int bottom = std::min(region->y + region->h, plane.height);
+		if (right <= left || bottom <= top)
+			return false;
+
+		*region = { left, top, right - left, bottom - top };
+		return true;
+	}
+
+	/* the box average in the 8.24 fixed point of the kernels */
+	static uint32_t average(uint64_t sum, int radius) {
+		uint64_t scale = (1u << 24) / (2 * radius + 1);
+		return static_cast<uint32_t>((sum * scale + (1u << 23)) >> 24);
+	}
+
+	/* the columns with every radius, then the rows with every radius */
+	static void blur(TestPlane& plane, Region region, const std::vector<int>& radii) {
+		if (!clip(plane, &region))
+			return;
+
+		std::vector<uint32_t> crop(static_cast<size_t>(region.w) * region.h);
+		auto pixel = [&](int x, int y) -> uint32_t& { return crop[static_cast<size_t>(y) * region.w + x]; };
+		for (int y = 0; y < region.h; y++) {
+			for (int x = 0; x < region.w; x++)
+				pixel(x, y) = plane.at(region.x + x, region.y + y);
+		}
+
+		for (int vertical = 1; vertical >= 0; vertical--) {
+			for (int radius : radii) {
+				auto input = crop;
+				auto in = [&](int x, int y) { return input[static_cast<size_t>(y) * region.w + x]; };
+				for (int y = 0; y < region.h; y++) {
+					for (int x = 0; x < region.w; x++) {
+						uint64_t sum = 0;
+						for (int k = -radius; k <= radius; k++) {
+							sum += vertical ? in(x, std::clamp(y + k, 0, region.h - 1))
+											: in(std::clamp(x + k, 0, region.w - 1), y);
+						}
+						pixel(x, y) = average(sum, radius);
+					}
+				}
+			}
+		}
+
+		for (int y = 0; y < region.h; y++) {
+			for (int x = 0; x < region.w; x++)
+				plane.at(region.x + x, region.y + y) = pixel(x, y);
+		}
+	}
+
+	/* the sizes of three boxes whose variances add up to sigma² */
+	static std::vector<int> gaussianRadii(double sigma) {
+		double ideal = std::sqrt(12 * sigma * sigma / 3 + 1);
+		int lower = static_cast<int>(ideal);
+		if (lower % 2 == 0)
+			lower--;
+		int upper = lower + 2;
+		int lowerBoxes = std::lround((12 * sigma * sigma - 3 * lower * lower - 12 * lower - 9) / (-4.0 * lower - 4));
+
+		std::vector<int> radii;
+		for (int i = 0; i < 3; i++) {
+			int radius = ((i < lowerBoxes) ? lower : upper) / 2;
+			if (radius > 0)
+				radii.push_back(radius);
+		}
+		return radii;
+	}
+
+	static void mosaic(TestPlane& plane, Region region, int size) {
+		if (!clip(plane, &region))
+			return;
+
+		for (int top = 0; top < region.h; top += size) {
+			for (int left = 0; left < region.w; left += size) {
+				int rows = std::min(size, region.h - top);
+				int cols = std::min(size, region.w - left);
+				uint32_t sum = 0;
+				for (int y = 0; y < rows; y++) {
+					for (int x = 0; x < cols; x++)
+						sum += plane.at(region.x + left + x, region.y + top + y);
+				}
+
+				uint32_t pixels = rows * cols;
+				for (int y = 0; y < rows; y++) {
+					for (int x = 0; x < cols; x++)
+						plane.at(region.x + left + x, region.y + top + y) = (sum + pixels / 2) / pixels;
+				}
+			}
+		}
+	}
+
+	static uint8_t mix(uint8_t dst, uint8_t src, uint8_t alpha) {
+		return static_cast<uint8_t>(std::lround((src * alpha + dst * (255 - alpha)) / 255.0));
+	}
+
+	static void fill(TestPlane& plane, Region region, uint8_t value, uint8_t alpha) {
+		if (!clip(plane, &region))
+			return;
+
+		for (int y = region.y; y < region.y + region.h; y++) {
+			for (int x = region.x; x < region.x + region.w; x++)
+				plane.at(x, y) = mix(plane.at(x, y), value, alpha);
+		}
+	}
+
+	static void blend(TestPlane& plane, int left, int top, TestPlane& source, TestPlane& alpha) {
+		for (int y = 0; y < source.height; y++) {
+			for (int x = 0; x < source.width; x++) {
+				if (left + x < 0 || left + x >= plane.width || top + y < 0 || top + y >= plane.height)
+					continue;
+
+				auto& out = plane.at(left + x, top + y);
+				out = mix(out, source.at(x, y), alpha.at(x, y));
+			}
+		}
+	}
+};
+
+class FFmpegKernelsTest : public UtBase {
+protected:
+	/* of the luma and of the 4:2:0 chroma planes of a 37x23 picture */
+	const std::vector<std::pair<int, int>> _sizes { { 37, 23 }, { 19, 12 } };
+	/* inside, clipped on two sides, the whole plane, one pixel and outside of it */
+	const std::vector<Region> _regions { { 3, 5, 13, 9 }, { -4, 7, 20, 20 }, { 0, 0, 37, 23 }, { 10, 10, 1, 1 }, { 50, 50, 4, 4 } };
+
+	/* the whole buffer is compared, the padding and the pixels out of the region are left as they are */
+	template <typename Kernel, typename Expected>
+	void expectSame(Kernel kernel, Expected expected) {
+		for (const auto& [ width, height ] : _sizes) {
+			for (const auto& region : _regions) {
+				TestPlane actual(width, height);
+				TestPlane reference(width, height);
+
+				kernel(actual.plane(), region);
+				expected(reference, region);
+
+				ASSERT_EQ(actual.pixels, reference.pixels)
+					<< width << "x" << height << " region " << region.x << "," << region.y << " " << region.w << "x" << region.h;
+			}
+		}
+	}
+};
+
+TEST_F(FFmpegKernelsTest, boxBlur_check_reference)
+{
+	for (int radius : { 1, 2, 7, 30 }) {
+		for (int passes : { 1, 2 }) {
+			SCOPED_TRACE("radius " + std::to_string(radius) + " passes " + std::to_string(passes));
+			expectSame([&](const Plane& plane, const Region& region) { FFmpegKernels::boxBlur(plane, region, radius, passes); },
+					[&](TestPlane& plane, const Region& region) { Reference::blur(plane, region, std::vector<int>(passes, radius)); });
+		}
+	}
+}
+
+TEST_F(FFmpegKernelsTest, gaussianBlur_check_reference)
+{
+	for (double sigma : { 0.8, 2.0, 5.5 }) {
+		SCOPED_TRACE("sigma " + std::to_string(sigma));
+		expectSame([&](const Plane& plane, const Region& region) { FFmpegKernels::gaussianBlur(plane, region, sigma); },
+				[&](TestPlane& plane, const Region& region) { Reference::blur(plane, region, Reference::gaussianRadii(sigma)); });
+	}
+}
+
+TEST_F(FFmpegKernelsTest, mosaic_check_reference)
+{
+	for (int size : { 2, 4, 5, 16 }) {
+		SCOPED_TRACE("size " + std::to_string(size));
+		expectSame([&](const Plane& plane, const Region& region) { FFmpegKernels::mosaic(plane, region, size); },
+				[&](TestPlane& plane, const Region& region) { Reference::mosaic(plane, region, size); });
+	}
+}
+
+TEST_F(FFmpegKernelsTest, fill_check_reference)
+{
+	for (int alpha : { 255, 128, 37, 0 }) {
+		SCOPED_TRACE("alpha " + std::to_string(alpha));
+		expectSame([&](const Plane& plane, const Region& region) { FFmpegKernels::fill(plane, region, 200, alpha); },
+				[&](TestPlane& plane, const Region& region) { Reference::fill(plane, region, 200, alpha); });
+	}
+}
+
+TEST_F(FFmpegKernelsTest, blend_check_reference)
+{
+	TestPlane source(9, 7);
+	TestPlane alpha(9, 7);
+	for (int y = 0; y < alpha.height; y++) {
+		for (int x = 0; x < alpha.width; x++)
+			alpha.at(x, y) = static_cast<uint8_t>((x * 31 + y * 17) % 256);
+	}
+	alpha.at(0, 0) = 0;
+	alpha.at(1, 0) = 255;
+
+	for (const auto& [ width, height ] : _sizes) {
+		for (const auto& [ x, y ] : std::vector<std::pair<int, int>> { { 3, 2 }, { -4, -3 }, { width - 5, height - 2 }, { width, 0 } }) {
+			TestPlane actual(width, height);
+			TestPlane reference(width, height);
+
+			FFmpegKernels::blend(actual.plane(), x, y, source.plane(), alpha.plane());
+			Reference::blend(reference, x, y, source, alpha);
+
+			ASSERT_EQ(actual.pixels, reference.pixels) << width << "x" << height << " at " << x << "," << y;
+		}
+	}
+}
+
+#endif /* ENABLE_FFMPEGRENDER */
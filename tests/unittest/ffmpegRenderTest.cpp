@@ -0,0 +1,730 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifdef ENABLE_FFMPEGRENDER
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/opt.h>
+}
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+#include "utBase.h"
+#include "TimelineHelper.h"
+#include "ffmpegEffect.h"
+#include "ffmpegRemuxer.h"
+#include "ffmpegTranscoder.h"
+#include "ffmpegWorkerPool.h"
+
+#define NEW_CHANNEL_LAYOUT (LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100))
+
+static const int FPS = 25;
+static const int CLIP_SECONDS = 4;
+static const int SAMPLE_RATE = 44100;
+static const double FRAME_SEC = 1.0 / FPS;
+
+/* What the tests read back from a media */
+struct MediaProbe {
+	int streams {};
+	int videoFrames {};
+	int decodedFrames {};
+	double duration {};	// of the video, from its first picture to the end of its last one
+	std::vector<double> keyFrames;	// of the video, from its first picture
+	bool monotonic = true;	// the decoding timestamps of each stream increase
+};
+
+static void __check(int ret, const std::string& function)
+{
+	if (ret < 0)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to " + function + ". err:" + std::to_string(ret));
+}
+
+struct Encoder {
+	~Encoder() { avcodec_free_context(&context); }
+
+	AVCodecContext* context {};
+	AVStream* stream {};
+};
+
+static void __encode(AVFormatContext* output, Encoder& encoder, AVFrame* frame, AVPacket* packet)
+{
+	__check(avcodec_send_frame(encoder.context, frame), "avcodec_send_frame()");
+
+	while (avcodec_receive_packet(encoder.context, packet) >= 0) {
+		av_packet_rescale_ts(packet, encoder.context->time_base, encoder.stream->time_base);
+		packet->stream_index = encoder.stream->index;
+		__check(av_interleaved_write_frame(output, packet), "av_interleaved_write_frame()");
+	}
+}
+
+static void __openEncoder(AVFormatContext* output, Encoder& encoder, const AVCodec* codec)
+{
+	if (output->oformat->flags & AVFMT_GLOBALHEADER)
+		encoder.context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+	__check(avcodec_open2(encoder.context, codec, nullptr), "avcodec_open2()");
+
+	encoder.stream = avformat_new_stream(output, nullptr);
+	if (!encoder.stream)
+		throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to add a stream");
+
+	__check(avcodec_parameters_from_context(encoder.stream->codecpar, encoder.context), "avcodec_parameters_from_context()");
+	encoder.stream->time_base = encoder.context->time_base;
+}
+
+/* Keeps the times of the pictures it is given */
+class PictureRecorder : public IFrameProcessor
+{
+public:
+	bool supported(int pixelFormat) const override { return pixelFormat == AV_PIX_FMT_YUV420P; }
+	void process(AVFrame* frame, double sec) override { secs.push_back(sec); }
+
+	std::vector<double> secs;
+};
+
+class FFmpegRenderTest : public UtBase {
+protected:
+	void SetUp() override {
+		Start();
+
+		_dir = std::filesystem::temp_directory_path() / ("ovi_ffmpeg_render_ut_" + std::to_string(getpid()));
+		std::filesystem::remove_all(_dir);
+		std::filesystem::create_directories(_dir);
+
+		// the smart cut re-encodes H.264 only, the other tests copy the packets of any codec
+		_codec = avcodec_find_encoder(AV_CODEC_ID_H264) ? AV_CODEC_ID_H264 : AV_CODEC_ID_MPEG4;
+		_clip = path("clip.mp4");
+		generateClip(_clip, _codec, 160, 120);
+	}
+
+	void TearDown() override {
+		std::filesystem::remove_all(_dir);
+
+		End();
+	}
+
+	std::string path(const std::string& name) const {
+		return (_dir / name).string();
+	}
+
+	/* CLIP_SECONDS of moving gray levels with a key frame every second, and a tone */
+	static void generateClip(const std::string& path, AVCodecID codecId, int width, int height) {
+		AVFormatContext* formatCtx = nullptr;
+		__check(avformat_alloc_output_context2(&formatCtx, nullptr, nullptr, path.c_str()), "avformat_alloc_output_context2()");
+
+		auto closeOutput = [](AVFormatContext* ctx) {
+			if (ctx->pb)
+				avio_closep(&ctx->pb);
+			avformat_free_context(ctx);
+		};
+		std::unique_ptr<AVFormatContext, decltype(closeOutput)> output(formatCtx, closeOutput);
+
+		const AVCodec* videoCodec = avcodec_find_encoder(codecId);
+		const AVCodec* audioCodec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+		if (!videoCodec || !audioCodec)
+			throw Exception(OVI_ERROR_NOT_SUPPORTED_MEDIA, "no encoder for the clip");
+
+		Encoder video;
+		video.context = avcodec_alloc_context3(videoCodec);
+		video.context->width = width;
+		video.context->height = height;
+		video.context->pix_fmt = AV_PIX_FMT_YUV420P;
+		video.context->time_base = { 1, FPS };
+		video.context->framerate = { FPS, 1 };
+		video.context->gop_size = FPS;
+		video.context->keyint_min = FPS;
+		video.context->max_b_frames = 2;
+		video.context->flags |= AV_CODEC_FLAG_CLOSED_GOP;
+		// the key frames only every second, not at the scene changes
+		av_opt_set(video.context->priv_data, "x264-params", "scenecut=0", 0);
+		av_opt_set(video.context, "sc_threshold", "1000000000", AV_OPT_SEARCH_CHILDREN);
+		__openEncoder(output.get(), video, videoCodec);
+
+		Encoder audio;
+		audio.context = avcodec_alloc_context3(audioCodec);
+		audio.context->sample_fmt = AV_SAMPLE_FMT_FLTP;
+		audio.context->sample_rate = SAMPLE_RATE;
+		audio.context->time_base = { 1, SAMPLE_RATE };
+		audio.context->bit_rate = 64000;
+#if NEW_CHANNEL_LAYOUT
+		av_channel_layout_default(&audio.context->ch_layout, 2);
+#else
+		audio.context->channel_layout = AV_CH_LAYOUT_STEREO;
+		audio.context->channels = 2;
+#endif
+		__openEncoder(output.get(), audio, audioCodec);
+
+		__check(avio_open(&output->pb, path.c_str(), AVIO_FLAG_WRITE), "avio_open()");
+		__check(avformat_write_header(output.get(), nullptr), "avformat_write_header()");
+
+		auto freeFrame = [](AVFrame* frame) { av_frame_free(&frame); };
+		auto freePacket = [](AVPacket* packet) { av_packet_free(&packet); };
+		std::unique_ptr<AVFrame, decltype(freeFrame)> picture(av_frame_alloc(), freeFrame);
+		std::unique_ptr<AVFrame, decltype(freeFrame)> sound(av_frame_alloc(), freeFrame);
+		std::unique_ptr<AVPacket, decltype(freePacket)> packet(av_packet_alloc(), freePacket);
+		if (!picture || !sound || !packet)
+			throw Exception(OVI_ERROR_INVALID_OPERATION, "failed to allocate the frames");
+
+		picture->format = video.context->pix_fmt;
+		picture->width = width;
+		picture->height = height;
+		__check(av_frame_get_buffer(picture.get(), 0), "av_frame_get_buffer()");
+
+		sound->format = audio.context->sample_fmt;
+		sound->sample_rate = SAMPLE_RATE;
+		sound->nb_samples = audio.context->frame_size;
+#if NEW_CHANNEL_LAYOUT
+		__check(av_channel_layout_copy(&sound->ch_layout, &audio.context->ch_layout), "av_channel_layout_copy()");
+#else
+		sound->channel_layout = audio.context->channel_layout;
+		sound->channels = audio.context->channels;
+#endif
+		__check(av_frame_get_buffer(sound.get(), 0), "av_frame_get_buffer()");
+
+		int64_t samples = 0;
+		for (int i = 0; i < CLIP_SECONDS * FPS; i++) {
+			__check(av_frame_make_writable(picture.get()), "av_frame_make_writable()");
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++)
+					picture->data[0][y * picture->linesize[0] + x] = static_cast<uint8_t>(x + y + i * 3);
+			}
+			for (int plane = 1; plane < 3; plane++) {
+				for (int y = 0; y < height / 2; y++)
+					memset(picture->data[plane] + y * picture->linesize[plane], 128, width / 2);
+			}
+			picture->pts = i;
+			__encode(output.get(), video, picture.get(), packet.get());
+
+			// the sound up to the end of the picture
+			while (samples * FPS < static_cast<int64_t>(i + 1) * SAMPLE_RATE) {
+				__check(av_frame_make_writable(sound.get()), "av_frame_make_writable()");
+				for (int channel = 0; channel < 2; channel++) {
+					auto data = reinterpret_cast<float*>(sound->data[channel]);
+					for (int s = 0; s < sound->nb_samples; s++)
+						data[s] = 0.2f * std::sin(2 * M_PI * 440 * (samples + s) / SAMPLE_RATE);
+				}
+				sound->pts = samples;
+				__encode(output.get(), audio, sound.get(), packet.get());
+				samples += sound->nb_samples;
+			}
+		}
+
+		__encode(output.get(), video, nullptr, packet.get());
+		__encode(output.get(), audio, nullptr, packet.get());
+		__check(av_write_trailer(output.get()), "av_write_trailer()");
+	}
+
+	/* reads all the packets and decodes the video */
+	static MediaProbe probe(const std::string& path) {
+		MediaProbe result;
+
+		AVFormatContext* formatCtx = nullptr;
+		__check(avformat_open_input(&formatCtx, path.c_str(), nullptr, nullptr), "avformat_open_input()");
+
+		auto closeInput = [](AVFormatContext* ctx) { avformat_close_input(&ctx); };
+		std::unique_ptr<AVFormatContext, decltype(closeInput)> input(formatCtx, closeInput);
+		__check(avformat_find_stream_info(input.get(), nullptr), "avformat_find_stream_info()");
+
+		result.streams = input->nb_streams;
+		int video = av_find_best_stream(input.get(), AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+		if (video < 0)
+			return result;
+
+		const AVStream* stream = input->streams[video];
+		const AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
+		auto freeDecoder = [](AVCodecContext* ctx) { avcodec_free_context(&ctx); };
+		std::unique_ptr<AVCodecContext, decltype(freeDecoder)> decoder(avcodec_alloc_context3(codec), freeDecoder);
+		__check(avcodec_parameters_to_context(decoder.get(), stream->codecpar), "avcodec_parameters_to_context()");
+		__check(avcodec_open2(decoder.get(), codec, nullptr), "avcodec_open2()");
+
+		auto freeFrame = [](AVFrame* frame) { av_frame_free(&frame); };
+		auto freePacket = [](AVPacket* packet) { av_packet_free(&packet); };
+		std::unique_ptr<AVFrame, decltype(freeFrame)> frame(av_frame_alloc(), freeFrame);
+		std::unique_ptr<AVPacket, decltype(freePacket)> packet(av_packet_alloc(), freePacket);
+
+		auto decode = [&](const AVPacket* pkt) {
+			if (avcodec_send_packet(decoder.get(), pkt) < 0)
+				return;
+			while (avcodec_receive_frame(decoder.get(), frame.get()) >= 0) {
+				result.decodedFrames++;
+				av_frame_unref(frame.get());
+			}
+		};
+
+		std::vector<int64_t> lastDts(input->nb_streams, AV_NOPTS_VALUE);
+		std::vector<int64_t> keyFrames;
+		int64_t first = INT64_MAX;
+		int64_t end = INT64_MIN;
+
+		while (av_read_frame(input.get(), packet.get()) >= 0) {
+			auto& last = lastDts[packet->stream_index];
+			if (packet->dts != AV_NOPTS_VALUE) {
+				if (last != AV_NOPTS_VALUE && packet->dts <= last)
+					result.monotonic = false;
+				last = packet->dts;
+			}
+
+			if (packet->stream_index == video) {
+				result.videoFrames++;
+				if (packet->pts != AV_NOPTS_VALUE) {
+					first = std::min(first, packet->pts);
+					end = std::max(end, packet->pts + packet->duration);
+					if (packet->flags & AV_PKT_FLAG_KEY)
+						keyFrames.push_back(packet->pts);
+				}
+				decode(packet.get());
+			}
+
+			av_packet_unref(packet.get());
+		}
+		decode(nullptr);
+
+		if (first != INT64_MAX) {
+			result.duration = (end - first) * av_q2d(stream->time_base);
+			for (auto pts : keyFrames)
+				result.keyFrames.push_back((pts - first) * av_q2d(stream->time_base));
+		}
+
+		return result;
+	}
+
+	/* the whole clip on a timeline, brightened at the frames */
+	timelineRetainer makeTimeline(const std::vector<int>& frames) {
+		otio::AnyDictionary metadata { { "value", std::string("0.5") } };
+		for (int frame : frames)
+			metadata[std::to_string(frame)] = otio::AnyVector {};
+
+		auto effect = _timeline.makeEffect("brightness", "brightness", metadata);
+		_timeline.appendTrack("Track-001");
+		_timeline.makeMediaRef(_clip, FPS, CLIP_SECONDS * FPS);
+		_timeline.appendClip("Track-001", "clip", { 0, CLIP_SECONDS * FPS }, _clip, { effect });
+
+		return _timeline.getTimeline();
+	}
+
+	/* the directories of the renders in progress */
+	static std::set<std::string> renderDirectories() {
+		std::set<std::string> directories;
+		for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::temp_directory_path())) {
+			if (entry.path().filename().string().rfind("ovi_render_", 0) == 0)
+				directories.insert(entry.path().string());
+		}
+
+		return directories;
+	}
+
+	static void expectSegment(const Segment& segment, const std::string& path, double startSec, double endSec) {
+		EXPECT_EQ(segment.path, path);
+		EXPECT_NEAR(segment.startSec, startSec, FRAME_SEC / 2);
+		EXPECT_NEAR(segment.endSec, endSec, FRAME_SEC / 2);
+	}
+
+	std::filesystem::path _dir;
+	std::string _clip;
+	TimelineHelper _timeline { FPS };
+	AVCodecID _codec {};
+};
+
+TEST_F(FFmpegRenderTest, generateClip_check_probe)
+{
+	auto media = probe(_clip);
+
+	EXPECT_EQ(media.streams, 2);
+	EXPECT_EQ(media.videoFrames, CLIP_SECONDS * FPS);
+	EXPECT_EQ(media.decodedFrames, media.videoFrames);
+	EXPECT_NEAR(media.duration, CLIP_SECONDS, FRAME_SEC / 2);
+	EXPECT_TRUE(media.monotonic);
+	ASSERT_EQ(media.keyFrames.size(), static_cast<size_t>(CLIP_SECONDS));
+	for (int i = 0; i < CLIP_SECONDS; i++)
+		EXPECT_NEAR(media.keyFrames[i], i, FRAME_SEC / 2);
+}
+
+TEST_F(FFmpegRenderTest, remuxer_check_range_from_key_frame)
+{
+	const std::string output = path("output.mp4");
+
+	{
+		FFmpegRemuxer remuxer(output);
+		remuxer.append(_clip, 1.5, 3.0);
+		remuxer.finish();
+	}
+
+	// copied from the key frame at 1 second
+	auto media = probe(output);
+	EXPECT_EQ(media.streams, 2);
+	EXPECT_EQ(media.videoFrames, 2 * FPS);
+	EXPECT_EQ(media.decodedFrames, media.videoFrames);
+	EXPECT_NEAR(media.duration, 2.0, FRAME_SEC / 2);
+	EXPECT_TRUE(media.monotonic);
+	ASSERT_EQ(media.keyFrames.size(), 1u);
+	EXPECT_NEAR(media.keyFrames[0], 0, FRAME_SEC / 2);
+}
+
+TEST_F(FFmpegRenderTest, remuxer_check_ranges_joined)
+{
+	const std::string output = path("output.mp4");
+
+	{
+		FFmpegRemuxer remuxer(output);
+		remuxer.append(_clip, 1.0, 2.0);
+		remuxer.append(_clip, 3.0, CLIP_SECONDS);
+		EXPECT_EQ(remuxer.ranges(), 2);
+		remuxer.finish();
+	}
+
+	auto media = probe(output);
+	EXPECT_EQ(media.videoFrames, 2 * FPS);
+	EXPECT_EQ(media.decodedFrames, media.videoFrames);
+	EXPECT_TRUE(media.monotonic);
+
+	/* the second range follows the first one, after the audio across the cut
+	 * and the reordering delay of its pictures at most */
+	EXPECT_GE(media.duration, 2.0 - FRAME_SEC / 2);
+	EXPECT_LT(media.duration, 2.0 + 0.25);
+	ASSERT_EQ(media.keyFrames.size(), 2u);
+	EXPECT_NEAR(media.keyFrames[0], 0, FRAME_SEC / 2);
+	EXPECT_GE(media.keyFrames[1], 1.0 - FRAME_SEC / 2);
+	EXPECT_LT(media.keyFrames[1], 1.0 + 0.25);
+}
+
+TEST_F(FFmpegRenderTest, remuxer_check_discard)
+{
+	const std::string output = path("output.mp4");
+
+	FFmpegRemuxer remuxer(output);
+	remuxer.append(_clip, 0, 1.0);
+	EXPECT_TRUE(std::filesystem::exists(output));
+
+	remuxer.discard();
+	EXPECT_FALSE(std::filesystem::exists(output));
+	EXPECT_EQ(remuxer.ranges(), 0);
+}
+
+TEST_F(FFmpegRenderTest, joinable_check_codec_parameters)
+{
+	const std::string other = path("other.mp4");
+	generateClip(other, _codec, 320, 240);
+
+	EXPECT_TRUE(FFmpegRemuxer::joinable(_clip, _clip));
+	EXPECT_FALSE(FFmpegRemuxer::joinable(_clip, other));
+
+	FFmpegRemuxer remuxer(path("output.mp4"));
+	EXPECT_TRUE(remuxer.compatible(other));
+
+	remuxer.append(_clip, 0, 1.0);
+	EXPECT_TRUE(remuxer.compatible(_clip));
+	EXPECT_FALSE(remuxer.compatible(other));
+
+	try {
+		remuxer.append(other, 0, 1.0);
+		FAIL() << "appended a clip of another size";
+	} catch (const Exception& e) {
+		EXPECT_EQ(e.error(), OVI_ERROR_NOT_SUPPORTED_MEDIA);
+	}
+
+	// the output is still made of the ranges that match
+	remuxer.append(_clip, 2.0, 3.0);
+	EXPECT_EQ(remuxer.ranges(), 2);
+	remuxer.finish();
+
+	auto media = probe(path("output.mp4"));
+	EXPECT_EQ(media.videoFrames, 2 * FPS);
+	EXPECT_EQ(media.decodedFrames, media.videoFrames);
+	EXPECT_TRUE(media.monotonic);
+}
+
+TEST_F(FFmpegRenderTest, smartCut_check_frame_accurate_range)
+{
+	if (_codec != AV_CODEC_ID_H264)
+		GTEST_SKIP() << "no H.264 encoder";
+
+	const std::string output = path("output.mp4");
+
+	{
+		FFmpegRemuxer remuxer(output, true);
+		remuxer.append(_clip, 1.5, 2.5);
+		remuxer.finish();
+	}
+
+	// the pictures from 1.52 to 2.48 seconds, the partial GOPs are encoded again
+	auto media = probe(output);
+	EXPECT_EQ(media.videoFrames, FPS);
+	EXPECT_EQ(media.decodedFrames, media.videoFrames);
+	EXPECT_NEAR(media.duration, 1.0, FRAME_SEC / 2);
+	EXPECT_TRUE(media.monotonic);
+	ASSERT_FALSE(media.keyFrames.empty());
+	EXPECT_NEAR(media.keyFrames[0], 0, FRAME_SEC / 2);
+}
+
+TEST_F(FFmpegRenderTest, smartCut_check_copied_gops)
+{
+	if (_codec != AV_CODEC_ID_H264)
+		GTEST_SKIP() << "no H.264 encoder";
+
+	const std::string output = path("output.mp4");
+
+	{
+		FFmpegRemuxer remuxer(output, true);
+		remuxer.append(_clip, 0.5, 3.5);
+		remuxer.finish();
+	}
+
+	auto media = probe(output);
+	EXPECT_EQ(media.videoFrames, 3 * FPS);
+	// the copied GOPs are decoded with the parameter sets of the stream, after the encoded ones
+	EXPECT_EQ(media.decodedFrames, media.videoFrames);
+	EXPECT_NEAR(media.duration, 3.0, FRAME_SEC / 2);
+	EXPECT_TRUE(media.monotonic);
+
+	// the key frames of the source at 1 and 2 seconds are kept
+	for (double sec : { 1.0 - 0.52, 2.0 - 0.52 }) {
+		EXPECT_TRUE(std::any_of(media.keyFrames.begin(), media.keyFrames.end(), [sec](double key) {
+			return std::fabs(key - sec) < FRAME_SEC / 2;
+		})) << sec;
+	}
+}
+
+TEST_F(FFmpegRenderTest, smartCut_check_ranges_joined)
+{
+	if (_codec != AV_CODEC_ID_H264)
+		GTEST_SKIP() << "no H.264 encoder";
+
+	const std::string output = path("output.mp4");
+
+	{
+		FFmpegRemuxer remuxer(output, true);
+		remuxer.append(_clip, 0.5, 1.5);
+		remuxer.append(_clip, 2.2, 3.6);
+		remuxer.finish();
+	}
+
+	// 0.52 to 1.48 and 2.2 to 3.56 seconds
+	auto media = probe(output);
+	EXPECT_EQ(media.videoFrames, 25 + 35);
+	EXPECT_EQ(media.decodedFrames, media.videoFrames);
+	EXPECT_TRUE(media.monotonic);
+	EXPECT_GE(media.duration, 2.4 - FRAME_SEC / 2);
+	EXPECT_LT(media.duration, 2.4 + 0.25);
+}
+
+TEST_F(FFmpegRenderTest, transcode_check_range)
+{
+	const std::string output = path("output.mp4");
+	PictureRecorder recorder;
+
+	FFmpegTranscoder transcoder(_clip, output);
+	transcoder.setRange(1.5, 2.5);
+	transcoder.setThreads(1);
+	transcoder.transcode("[in]hflip[out]", "[in]volume=0.5[out]", &recorder);
+
+	// the processor sees the times of the media, the output starts at 0
+	ASSERT_EQ(recorder.secs.size(), static_cast<size_t>(FPS));
+	EXPECT_GE(recorder.secs.front(), 1.5);
+	EXPECT_LT(recorder.secs.back(), 2.5);
+	EXPECT_TRUE(std::is_sorted(recorder.secs.begin(), recorder.secs.end()));
+
+	auto media = probe(output);
+	EXPECT_EQ(media.streams, 2);
+	EXPECT_EQ(media.videoFrames, FPS);
+	EXPECT_EQ(media.decodedFrames, media.videoFrames);
+	EXPECT_NEAR(media.duration, 1.0, FRAME_SEC / 2);
+	EXPECT_TRUE(media.monotonic);
+	ASSERT_FALSE(media.keyFrames.empty());
+	EXPECT_NEAR(media.keyFrames[0], 0, FRAME_SEC / 2);
+}
+
+TEST_F(FFmpegRenderTest, transcode_check_copied_audio)
+{
+	const std::string output = path("output.mp4");
+
+	FFmpegTranscoder transcoder(_clip, output);
+	transcoder.transcode("[in]negate[out]", "");
+
+	auto media = probe(output);
+	EXPECT_EQ(media.streams, 2);
+	EXPECT_EQ(media.videoFrames, CLIP_SECONDS * FPS);
+	EXPECT_EQ(media.decodedFrames, media.videoFrames);
+	EXPECT_NEAR(media.duration, CLIP_SECONDS, FRAME_SEC / 2);
+	EXPECT_TRUE(media.monotonic);
+}
+
+TEST_F(FFmpegRenderTest, effect_check_range_aligned_to_key_frames)
+{
+	if (_codec != AV_CODEC_ID_H264)
+		GTEST_SKIP() << "no H.264 encoder";
+
+	FFmpegWorkerPool pool(1);
+	FFmpegEffect effect(makeTimeline({ 40, 41 }), pool);
+
+	// the effect at 1.6 seconds is encoded from the key frame at 1 second to the one at 2 seconds
+	const auto& segments = effect.segments();
+	ASSERT_EQ(segments.size(), 3u);
+	expectSegment(segments[0], _clip, 0, 1.0);
+	EXPECT_NE(segments[1].path, _clip);
+	expectSegment(segments[1], segments[1].path, 0, 1.0);
+	expectSegment(segments[2], _clip, 2.0, CLIP_SECONDS);
+
+	auto media = probe(segments[1].path);
+	EXPECT_EQ(media.videoFrames, FPS);
+	EXPECT_EQ(media.decodedFrames, media.videoFrames);
+	EXPECT_NEAR(media.duration, 1.0, FRAME_SEC / 2);
+	EXPECT_TRUE(media.monotonic);
+	ASSERT_FALSE(media.keyFrames.empty());
+	EXPECT_NEAR(media.keyFrames[0], 0, FRAME_SEC / 2);
+}
+
+TEST_F(FFmpegRenderTest, effect_check_ranges_merged_and_clamped)
+{
+	if (_codec != AV_CODEC_ID_H264)
+		GTEST_SKIP() << "no H.264 encoder";
+
+	FFmpegWorkerPool pool(1);
+	FFmpegEffect effect(makeTimeline({ 10, 30, 95 }), pool);
+
+	/* the GOPs of the effects at 0.4 and 1.2 seconds touch, they are encoded together,
+	 * the one of the effect at 3.8 seconds ends with the clip */
+	const auto& segments = effect.segments();
+	ASSERT_EQ(segments.size(), 3u);
+	EXPECT_NE(segments[0].path, _clip);
+	expectSegment(segments[0], segments[0].path, 0, 2.0);
+	expectSegment(segments[1], _clip, 2.0, 3.0);
+	EXPECT_NE(segments[2].path, _clip);
+	expectSegment(segments[2], segments[2].path, 0, 1.0);
+
+	for (size_t i : { 0, 2 }) {
+		auto media = probe(segments[i].path);
+		EXPECT_NEAR(media.duration, segments[i].endSec, FRAME_SEC / 2);
+		EXPECT_EQ(media.videoFrames, static_cast<int>(std::lround(segments[i].endSec * FPS)));
+		EXPECT_TRUE(media.monotonic);
+	}
+}
+
+TEST_F(FFmpegRenderTest, workerPool_check_jobs_in_parallel)
+{
+	const size_t jobs = 16;
+	FFmpegWorkerPool pool(4);
+	EXPECT_EQ(pool.workers(), 4);
+
+	std::vector<int> runs(jobs);
+	std::vector<size_t> results(jobs, jobs);
+	std::atomic_int running {};
+	std::atomic_int maxRunning {};
+
+	pool.run(jobs, [&](size_t i) {
+		int now = ++running;
+		int max = maxRunning;
+		while (now > max && !maxRunning.compare_exchange_weak(max, now)) {}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		runs[i]++;
+		results[i] = i;
+		running--;
+	});
+
+	// each job runs once and its result lands in its own slot, whatever the order they ran in
+	for (size_t i = 0; i < jobs; i++) {
+		EXPECT_EQ(runs[i], 1) << "job " << i;
+		EXPECT_EQ(results[i], i);
+	}
+	EXPECT_GT(maxRunning, 1);
+	EXPECT_LE(maxRunning, 4);
+}
+
+TEST_F(FFmpegRenderTest, workerPool_check_first_error_rethrown)
+{
+	const size_t jobs = 100;
+	FFmpegWorkerPool pool(2);
+	std::atomic_int started {};
+
+	EXPECT_THROW(pool.run(jobs, [&](size_t i) {
+		started++;
+		if (i == 1)
+			throw std::runtime_error("job failed");
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}), std::runtime_error);
+
+	// the jobs not started when the job failed are skipped
+	EXPECT_LT(started, static_cast<int>(jobs));
+}
+
+TEST_F(FFmpegRenderTest, effect_check_segments_in_timeline_order)
+{
+	if (_codec != AV_CODEC_ID_H264)
+		GTEST_SKIP() << "no H.264 encoder";
+
+	auto before = renderDirectories();
+
+	// the whole clip three times, brightened at 0.4, 2.4 and 3.8 seconds
+	_timeline.appendTrack("Track-001");
+	_timeline.makeMediaRef(_clip, FPS, CLIP_SECONDS * FPS);
+	int clip = 0;
+	for (int frame : { 10, 60, 95 }) {
+		otio::AnyDictionary metadata { { "value", std::string("0.5") }, { std::to_string(frame), otio::AnyVector {} } };
+		auto effect = _timeline.makeEffect("brightness", "brightness", metadata);
+		_timeline.appendClip("Track-001", "clip" + std::to_string(clip++), { 0, CLIP_SECONDS * FPS }, _clip, { effect });
+	}
+
+	std::string directory;
+	{
+		FFmpegWorkerPool pool(3);
+		FFmpegEffect effect(_timeline.getTimeline(), pool);
+
+		// the clips are encoded in parallel, their segments follow the timeline
+		const auto& segments = effect.segments();
+		ASSERT_EQ(segments.size(), 7u);
+		expectSegment(segments[0], segments[0].path, 0, 1.0);
+		expectSegment(segments[1], _clip, 1.0, CLIP_SECONDS);
+		expectSegment(segments[2], _clip, 0, 2.0);
+		expectSegment(segments[3], segments[3].path, 0, 1.0);
+		expectSegment(segments[4], _clip, 3.0, CLIP_SECONDS);
+		expectSegment(segments[5], _clip, 0, 3.0);
+		expectSegment(segments[6], segments[6].path, 0, 1.0);
+
+		std::filesystem::path first(segments[0].path);
+		directory = first.parent_path().string();
+		EXPECT_EQ(first.filename(), "clip_0_0.mp4");
+		EXPECT_EQ(std::filesystem::path(segments[3].path).filename(), "clip_1_0.mp4");
+		EXPECT_EQ(std::filesystem::path(segments[6].path).filename(), "clip_2_0.mp4");
+
+		for (size_t i : { 0, 3, 6 }) {
+			EXPECT_EQ(std::filesystem::path(segments[i].path).parent_path(), directory);
+			auto media = probe(segments[i].path);
+			EXPECT_EQ(media.videoFrames, FPS);
+			EXPECT_TRUE(media.monotonic);
+		}
+		EXPECT_EQ(renderDirectories().count(directory), 1u);
+	}
+
+	// the directory of the render is removed with it
+	EXPECT_FALSE(std::filesystem::exists(directory));
+	EXPECT_EQ(renderDirectories(), before);
+}
+
+#endif /* ENABLE_FFMPEGRENDER */
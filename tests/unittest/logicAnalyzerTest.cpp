@@ -14,6 +14,8 @@
 * limitations under the License.
 */
 
+#include <random>
+
 #include "utBase.h"
 #include "LogicAnalyzer.h"
 #include "PluginManager.h"
@@ -262,3 +264,97 @@ TEST_F(LogicAnalyzerTest, include_check_return_value_if_many_uncut)
 	EXPECT_EQ(logicAnalyzer.nextPlugin(false), OVI_EOP);
 	EXPECT_TRUE(logicAnalyzer.include());
 }
+
+/* The walk over the pipelines, as LogicAnalyzer did before compiling them */
+class ReferenceAnalyzer
+{
+public:
+	explicit ReferenceAnalyzer(const std::vector<PluginPipelinePtr>& pipelines)
+		: _pipelines(pipelines) {}
+
+	void reset() {
+		_pos = 0;
+		for (auto& pipeline : _pipelines)
+			pipeline->reset();
+	}
+
+	PluginId nextPluginId(bool result) {
+		_include = _pipelines[_pos]->current()->post(result);
+
+		PluginId next = _pipelines[_pos]->pop(_include);
+		if (next >= 0)
+			return next;
+
+		if (_pipelines[_pos]->current() == nullptr) {
+			// end of the pipeline, goes to the next essential one
+			for (_pos = _pos + 1; _pos < _pipelines.size(); _pos++) {
+				if (_pipelines[_pos]->isEssential())
+					break;
+			}
+		} else {
+			_pos++;
+		}
+
+		if (_pos >= _pipelines.size())
+			return OVI_EOP_ID;
+		_pipelines[_pos]->reset();
+		return nextPluginId(true);
+	}
+
+	bool include() const { return _include; }
+
+private:
+	std::vector<PluginPipelinePtr> _pipelines;
+	size_t _pos {};
+	bool _include {};
+};
+
+TEST_F(LogicAnalyzerTest, nextPlugin_compare_with_reference_for_random_requests)
+{
+	std::mt19937 rng(20230713);
+	auto pick = [&](int n) { return static_cast<int>(rng() % n); };
+
+	int tested = 0;
+	while (tested < 300) {
+		std::vector<std::string> request;
+		int terms = 1 + pick(5);
+		for (int t = 0; t < terms; t++) {
+			if (t > 0)
+				request.push_back(pick(2) ? OVI_OP_AND : OVI_OP_OR);
+			if (pick(4) == 0)
+				request.push_back(OVI_OP_UNCUT);
+			request.push_back(pick(4) ? _plugin[pick(PluginNum)] : _effect[pick(PluginNum)]);
+			for (int e = pick(3); e > 0; e--) {
+				request.push_back(OVI_OP_COLON);
+				request.push_back(_effect[pick(PluginNum)]);
+			}
+		}
+
+		if (!validate_logic(request, _pm.get()))
+			continue;
+		tested++;
+
+		LogicAnalyzer logicAnalyzer(request, _pm.get());
+		LogicAnalyzer pipelines(request, _pm.get());
+		ReferenceAnalyzer reference(pipelines.pipelines());
+
+		for (int frame = 0; frame < 20; frame++) {
+			logicAnalyzer.reset();
+			reference.reset();
+
+			// the first call always gets 'true' as DataFlow does, but try the other too
+			bool result = (frame != 0);
+			for (int step = 0; step < 100; step++) {
+				PluginId expected = reference.nextPluginId(result);
+				PluginId actual = logicAnalyzer.nextPluginId(result);
+				ASSERT_EQ(expected, actual) << "request #" << tested << " frame " << frame << " step " << step;
+
+				if (expected == OVI_EOP_ID) {
+					EXPECT_EQ(reference.include(), logicAnalyzer.include());
+					break;
+				}
+				result = pick(2);
+			}
+		}
+	}
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <filesystem>
+
+#include "utBase.h"
+#include "ModelCache.h"
+
+struct TestModel {
+	explicit TestModel(int value) : value(value) {}
+	int value;
+};
+
+TEST(ModelCacheTest, shared_test)
+{
+	int loaded = 0;
+	auto loader = [&]() { loaded++; return std::make_shared<TestModel>(42); };
+
+	auto first = ModelCache::instance().get<TestModel>("shared_test", loader);
+	auto second = ModelCache::instance().get<TestModel>("shared_test", loader);
+
+	EXPECT_EQ(1, loaded);
+	EXPECT_EQ(first.get(), second.get());
+	EXPECT_EQ(42, second->value);
+}
+
+TEST(ModelCacheTest, release_test)
+{
+	int loaded = 0;
+	auto loader = [&]() { loaded++; return std::make_shared<TestModel>(loaded); };
+	auto before = ModelCache::instance().size();
+
+	{
+		auto model = ModelCache::instance().get<TestModel>("release_test", loader);
+		EXPECT_EQ(before + 1, ModelCache::instance().size());
+	}
+	EXPECT_EQ(before, ModelCache::instance().size());
+
+	auto reloaded = ModelCache::instance().get<TestModel>("release_test", loader);
+	EXPECT_EQ(2, loaded);
+	EXPECT_EQ(2, reloaded->value);
+}
+
+TEST(ModelCacheTest, pool_test)
+{
+	int parsed = 0;
+	auto loader = [&]() {
+		parsed++;
+		auto source = std::make_shared<int>(7);
+		return std::make_shared<ModelPool<TestModel>>([source]() { return std::make_unique<TestModel>(*source); });
+	};
+
+	// as a plugin instance keeps the pool of its model
+	struct Instance {
+		std::shared_ptr<const ModelPool<TestModel>> model;
+	};
+
+	Instance first { ModelCache::instance().get<ModelPool<TestModel>>("pool_test", loader) };
+	Instance second { ModelCache::instance().get<ModelPool<TestModel>>("pool_test", loader) };
+
+	EXPECT_EQ(1, parsed);
+	EXPECT_EQ(first.model.get(), second.model.get());
+
+	{
+		auto firstModel = first.model->lease();
+		auto secondModel = second.model->lease();
+
+		EXPECT_NE(&*firstModel, &*secondModel);
+		EXPECT_EQ(7, secondModel->value);
+	}
+	EXPECT_EQ(2, first.model->built());
+
+	// the models are kept for the next uses
+	{
+		auto model = second.model->lease();
+	}
+	EXPECT_EQ(2, second.model->built());
+	EXPECT_EQ(1, parsed);
+}
+
+TEST(ModelCacheTest, loadFailed_test)
+{
+	EXPECT_THROW(ModelCache::instance().get<TestModel>("failed_test",
+				[]() { return std::shared_ptr<TestModel>(); }), Exception);
+
+	EXPECT_THROW(ModelCache::instance().map("/nonexistent/model.tflite"), Exception);
+}
+
+TEST(ModelCacheTest, map_test)
+{
+	auto path = std::filesystem::temp_directory_path() / "ovi_model_cache_test.bin";
+	std::ofstream(path, std::ios::binary) << "model bytes";
+
+	{
+		auto first = ModelCache::instance().map(path);
+		auto second = ModelCache::instance().map(path);
+
+		EXPECT_EQ(first.get(), second.get());
+		ASSERT_EQ(11u, first->size());
+		EXPECT_EQ(0, memcmp(first->data(), "model bytes", first->size()));
+	}
+
+	std::filesystem::remove(path);
+}
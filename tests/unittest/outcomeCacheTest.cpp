@@ -21,32 +21,32 @@ class OutcomeCacheTest : public UtBase {
 protected:
 
 	OutcomeCache _outcomeCache;
-	const std::vector<std::tuple<std::string, Outcome>> TEST_ARGS = {
-		{ "test1", {true, {}}},
-		{ "test2", {false, {}}},
-		{ "test3", {true, {}}},
-		{ "test4", {false, {}}},
-		{ "test5", {true, {}}},
+	const std::vector<std::tuple<PluginId, Outcome>> TEST_ARGS = {
+		{ 0, {true, {}}},
+		{ 1, {false, {}}},
+		{ 2, {true, {}}},
+		{ 3, {false, {}}},
+		{ 4, {true, {}}},
 	};
 
-	const std::string INVALID_UID = "test100";
+	const PluginId INVALID_ID = 100;
 };
 
 TEST_F(OutcomeCacheTest, hit_check_return_value)
 {
-	for (const auto& [ uid, outcome ] : TEST_ARGS)
-		_outcomeCache.write(uid, outcome);
+	for (const auto& [ id, outcome ] : TEST_ARGS)
+		_outcomeCache.write(id, outcome);
 
-	for (const auto& [ uid, outcome ] : TEST_ARGS)
-		EXPECT_TRUE(_outcomeCache.hit(uid));
+	for (const auto& [ id, outcome ] : TEST_ARGS)
+		EXPECT_TRUE(_outcomeCache.hit(id));
 
-	EXPECT_FALSE(_outcomeCache.hit(INVALID_UID));
+	EXPECT_FALSE(_outcomeCache.hit(INVALID_ID));
 }
 
 TEST_F(OutcomeCacheTest, write_check)
 {
-	for (const auto& [ uid, outcome ] : TEST_ARGS) {
-		_outcomeCache.write(uid, outcome);
+	for (const auto& [ id, outcome ] : TEST_ARGS) {
+		_outcomeCache.write(id, outcome);
 		EXPECT_EQ(_outcomeCache.result().detect, outcome.detect);
 	}
 }
@@ -56,21 +56,37 @@ TEST_F(OutcomeCacheTest, result_check_return_value)
 	// if empty, result is true
 	EXPECT_TRUE(_outcomeCache.result().detect);
 
-	for (const auto& [ uid, outcome ] : TEST_ARGS)
-		_outcomeCache.write(uid, outcome);
+	for (const auto& [ id, outcome ] : TEST_ARGS)
+		_outcomeCache.write(id, outcome);
 
-	for (const auto& [ uid, outcome ] : TEST_ARGS) {
-		_outcomeCache.setResultUid(uid);
+	for (const auto& [ id, outcome ] : TEST_ARGS) {
+		_outcomeCache.setResultId(id);
 		EXPECT_EQ(_outcomeCache.result().detect, outcome.detect);
 	}
 }
 
 TEST_F(OutcomeCacheTest, detected_check_return_value)
 {
-	for (const auto& [ uid, outcome ] : TEST_ARGS) {
-		_outcomeCache.write(uid, outcome);
-		_outcomeCache.setDetected(uid);
+	for (const auto& [ id, outcome ] : TEST_ARGS) {
+		_outcomeCache.write(id, outcome);
+		_outcomeCache.setDetected(id);
 		DetectedData detected = _outcomeCache.detected();
-		EXPECT_TRUE(detected.find(uid) != detected.end());
+		EXPECT_TRUE(std::any_of(detected.begin(), detected.end(),
+								[id = id](const auto& item) { return item.first == id; }));
 	}
+}
+
+TEST_F(OutcomeCacheTest, clear_check)
+{
+	for (const auto& [ id, outcome ] : TEST_ARGS) {
+		_outcomeCache.write(id, outcome);
+		_outcomeCache.setDetected(id);
+	}
+
+	_outcomeCache.clear();
+
+	for (const auto& [ id, outcome ] : TEST_ARGS)
+		EXPECT_FALSE(_outcomeCache.hit(id));
+	EXPECT_TRUE(_outcomeCache.detected().empty());
+	EXPECT_TRUE(_outcomeCache.result().detect);
 }
\ No newline at end of file
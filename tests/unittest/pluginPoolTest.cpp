@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <thread>
+
+#include "utBase.h"
+#include "PluginPool.h"
+
+class PoolTestPlugin : public IPlugin
+{
+public:
+	int setAttrs(const std::map<std::string, std::string>&) override { return OVI_ERROR_NONE; }
+};
+
+class PluginPoolTest : public ::testing::Test {
+protected:
+	PluginPool makePool(size_t maxIdle, std::chrono::seconds idleTimeout = std::chrono::seconds(300)) {
+		return PluginPool(maxIdle, idleTimeout, [this](Plugin& plugin) {
+			delete plugin.plugin;
+			_destroyed++;
+		});
+	}
+
+	static Plugin makePlugin(const std::string& name, PluginType type = PLUGIN_TYPE_VIDEO_DETECT) {
+		Plugin plugin {};
+		plugin.type = type;
+		plugin.plugin = new PoolTestPlugin();
+		plugin.name = name;
+		return plugin;
+	}
+
+	int _destroyed {};
+};
+
+TEST_F(PluginPoolTest, reuse_test)
+{
+	auto pool = makePool(4);
+
+	auto plugin = makePlugin("FaceDetect");
+	auto instance = plugin.plugin;
+	plugin.attrs = { { "scale", "1.2" } };
+	plugin.appliedAttrs = plugin.attrs;
+
+	EXPECT_TRUE(pool.checkin(std::move(plugin)));
+	EXPECT_EQ(1u, pool.idle());
+
+	EXPECT_FALSE(pool.checkout("AudioDetect"));
+
+	auto reused = pool.checkout("FaceDetect");
+	ASSERT_TRUE(reused);
+	EXPECT_EQ(instance, reused->plugin);
+	EXPECT_TRUE(reused->attrs.empty());
+	EXPECT_EQ("1.2", reused->appliedAttrs.at("scale"));
+	EXPECT_EQ(0u, pool.idle());
+
+	delete reused->plugin;
+}
+
+TEST_F(PluginPoolTest, notPoolable_test)
+{
+	auto pool = makePool(4);
+
+	auto render = makePlugin("FFmpegRender", PLUGIN_TYPE_RENDER);
+	EXPECT_FALSE(pool.checkin(std::move(render)));
+	delete render.plugin;
+
+	auto disabled = makePool(0);
+	auto detect = makePlugin("FaceDetect");
+	EXPECT_FALSE(disabled.checkin(std::move(detect)));
+	delete detect.plugin;
+
+	EXPECT_EQ(0, _destroyed);
+}
+
+TEST_F(PluginPoolTest, exchange_test)
+{
+	auto pool = makePool(4);
+
+	auto idle = makePlugin("FaceDetect");
+	auto matching = idle.plugin;
+	idle.appliedAttrs = { { "inverse", "1" } };
+	pool.checkin(std::move(idle));
+
+	auto plugin = makePlugin("FaceDetect");
+	auto original = plugin.plugin;
+	plugin.attrs = { { "inverse", "0" } };
+	EXPECT_FALSE(pool.exchange(plugin));
+
+	plugin.attrs = { { "inverse", "1" } };
+	ASSERT_TRUE(pool.exchange(plugin));
+	EXPECT_EQ(matching, plugin.plugin);
+	EXPECT_EQ(plugin.attrs, plugin.appliedAttrs);
+
+	auto swapped = pool.checkout("FaceDetect");
+	ASSERT_TRUE(swapped);
+	EXPECT_EQ(original, swapped->plugin);
+	EXPECT_TRUE(swapped->appliedAttrs.empty());
+
+	delete swapped->plugin;
+	delete plugin.plugin;
+}
+
+TEST_F(PluginPoolTest, evictOverCap_test)
+{
+	auto pool = makePool(2);
+
+	for (int i = 0; i < 3; i++)
+		pool.checkin(makePlugin("FaceDetect"));
+
+	EXPECT_EQ(2u, pool.idle());
+	EXPECT_EQ(1, _destroyed);
+
+	pool.clear();
+	EXPECT_EQ(0u, pool.idle());
+	EXPECT_EQ(3, _destroyed);
+}
+
+TEST_F(PluginPoolTest, evictIdle_test)
+{
+	auto pool = makePool(4, std::chrono::seconds(0));
+
+	pool.checkin(makePlugin("FaceDetect"));
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	EXPECT_FALSE(pool.checkout("FaceDetect"));
+	EXPECT_EQ(1, _destroyed);
+}
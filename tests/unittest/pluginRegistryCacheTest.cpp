@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <filesystem>
+
+#include "utBase.h"
+#include "PluginRegistryCache.h"
+
+class PluginRegistryCacheTest : public ::testing::Test {
+protected:
+	void SetUp() override {
+		_dir = std::filesystem::temp_directory_path() /
+			("ovi_registry_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+			"_" + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+		std::filesystem::create_directories(_dir);
+
+		_pluginPath = (_dir / "plugin.py").string();
+		writePlugin("print('plugin')\n");
+	}
+
+	void TearDown() override {
+		std::error_code ec {};
+		std::filesystem::remove_all(_dir, ec);
+	}
+
+	void writePlugin(const std::string& contents) {
+		std::ofstream os(_pluginPath, std::ios::trunc);
+		os << contents;
+	}
+
+	std::string cachePath() const { return (_dir / "cache" / "registry").string(); }
+
+	static PluginInfo sampleInfo() {
+		return { LANG_PYTHON, "Sample", PLUGIN_TYPE_VIDEO_DETECT, { VIDEO_FORMAT_RGB24, VIDEO_FORMAT_YUV420P },
+				METAFORM_RECT, "multi\nline description", "plugin",
+				{ { "threshold", "float", "detection threshold" }, { "empty", "", "" } } };
+	}
+
+	std::filesystem::path _dir;
+	std::string _pluginPath;
+};
+
+TEST_F(PluginRegistryCacheTest, roundTrip_test)
+{
+	{
+		PluginRegistryCache cache(cachePath());
+		cache.load();
+		EXPECT_FALSE(cache.find(_pluginPath));
+
+		cache.update(_pluginPath, sampleInfo());
+		EXPECT_TRUE(cache.dirty());
+		cache.save();
+		EXPECT_FALSE(cache.dirty());
+	}
+
+	PluginRegistryCache cache(cachePath());
+	cache.load();
+
+	auto info = cache.find(_pluginPath);
+	ASSERT_TRUE(info);
+
+	auto expected = sampleInfo();
+	EXPECT_EQ(expected.lang, info->lang);
+	EXPECT_EQ(expected.name, info->name);
+	EXPECT_EQ(expected.type, info->type);
+	EXPECT_EQ(expected.formats, info->formats);
+	EXPECT_EQ(expected.metaForm, info->metaForm);
+	EXPECT_EQ(expected.description, info->description);
+	EXPECT_EQ(expected.libraryPath, info->libraryPath);
+	ASSERT_EQ(expected.attrs.size(), info->attrs.size());
+	for (size_t i = 0; i < expected.attrs.size(); i++) {
+		EXPECT_EQ(expected.attrs[i].key, info->attrs[i].key);
+		EXPECT_EQ(expected.attrs[i].type, info->attrs[i].type);
+		EXPECT_EQ(expected.attrs[i].description, info->attrs[i].description);
+	}
+}
+
+TEST_F(PluginRegistryCacheTest, invalidateOnChange_test)
+{
+	PluginRegistryCache cache(cachePath());
+	cache.update(_pluginPath, sampleInfo());
+	EXPECT_TRUE(cache.find(_pluginPath));
+
+	writePlugin("print('changed plugin')\n");
+	EXPECT_FALSE(cache.find(_pluginPath));
+
+	cache.update(_pluginPath, sampleInfo());
+	EXPECT_TRUE(cache.find(_pluginPath));
+
+	std::filesystem::remove(_pluginPath);
+	EXPECT_FALSE(cache.find(_pluginPath));
+}
+
+TEST_F(PluginRegistryCacheTest, failedPlugin_test)
+{
+	PluginRegistryCache cache(cachePath());
+	cache.update(_pluginPath, sampleInfo());
+	cache.save();
+
+	/* a plugin failing after a success is forgotten */
+	cache.update(_pluginPath, {});
+	EXPECT_TRUE(cache.dirty());
+	EXPECT_FALSE(cache.find(_pluginPath));
+	cache.save();
+
+	PluginRegistryCache reloaded(cachePath());
+	reloaded.load();
+
+	EXPECT_FALSE(reloaded.find(_pluginPath));
+}
+
+TEST_F(PluginRegistryCacheTest, retain_test)
+{
+	PluginRegistryCache cache(cachePath());
+	cache.update(_pluginPath, sampleInfo());
+	cache.save();
+
+	cache.retain({ _pluginPath });
+	EXPECT_FALSE(cache.dirty());
+
+	cache.retain({});
+	EXPECT_TRUE(cache.dirty());
+	EXPECT_FALSE(cache.find(_pluginPath));
+}
+
+TEST_F(PluginRegistryCacheTest, corruptedCache_test)
+{
+	std::filesystem::create_directories(_dir / "cache");
+	std::ofstream(cachePath()) << "OVI_PLUGIN_REGISTRY 1 3\n5:abc";
+
+	PluginRegistryCache cache(cachePath());
+	cache.load();
+	EXPECT_FALSE(cache.find(_pluginPath));
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(OVI_ENABLE_PYTHON) && defined(ENABLE_AUDIODETECTPY)
+
+#include "utBase.h"
+#include "PyWorkerPool.h"
+#include "PyPluginProcess.h"
+#include "FramePack.h"
+
+class PyWorkerPoolTest : public UtBase
+{
+protected:
+	void SetUp(void) override {
+		Start();
+
+		auto frame = new AudioFramePack(2, 44100, AUDIO_FORMAT_FLTP, 1024);
+		frame->assign(readFile(_audioRaw), 1, 0, 1, 1);
+		_frame = FramePackPtr(frame);
+	}
+
+	void TearDown(void) override {
+		End();
+	}
+
+	const std::string _audioRaw = "audio_fltp_2_44100_1024.raw";
+	const std::string _moduleName = "audioDetect";
+	FramePackPtr _frame;
+};
+
+TEST_F(PyWorkerPoolTest, process_check_attrs_per_instance)
+{
+	/* one replica, still each attribute set gets its own worker, which is not reconfigured */
+	auto pool = std::make_shared<PyWorkerPool>(PYTHON_EXECUTABLE_PATH, 1);
+
+	try {
+		PyWorkerPlugin normal(pool, _moduleName);
+		PyWorkerPlugin inverse(pool, _moduleName);
+
+		EXPECT_EQ(normal.setAttrs({ { "threshold", "60.0" } }), OVI_ERROR_NONE);
+		EXPECT_EQ(inverse.setAttrs({ { "inverse", "1" } }), OVI_ERROR_NONE);
+
+		auto first = normal.process(_frame.get());
+		auto inverted = inverse.process(_frame.get());
+		auto second = normal.process(_frame.get());
+
+		EXPECT_EQ(first.detect, second.detect);
+		EXPECT_NE(first.detect, inverted.detect);
+		EXPECT_EQ(pool->workers(), 2);
+	} catch (const Exception& e) {
+		std::cout << "Error: " << e.what() << std::endl;
+		EXPECT_TRUE(false);
+	}
+}
+
+TEST_F(PyWorkerPoolTest, setAttrs_check_keeps_previous_attrs)
+{
+	auto pool = std::make_shared<PyWorkerPool>(PYTHON_EXECUTABLE_PATH, 1);
+
+	try {
+		PyWorkerPlugin inverse(pool, _moduleName);
+		PyWorkerPlugin normal(pool, _moduleName);
+
+		EXPECT_EQ(inverse.setAttrs({ { "inverse", "1" } }), OVI_ERROR_NONE);
+		EXPECT_EQ(normal.setAttrs({}), OVI_ERROR_NONE);
+		auto expected = inverse.process(_frame.get());
+
+		/* a later subset does not drop the attributes set before */
+		EXPECT_EQ(inverse.setAttrs({ { "threshold", "60.0" } }), OVI_ERROR_NONE);
+		normal.process(_frame.get());
+
+		EXPECT_EQ(inverse.process(_frame.get()).detect, expected.detect);
+	} catch (const Exception& e) {
+		std::cout << "Error: " << e.what() << std::endl;
+		EXPECT_TRUE(false);
+	}
+}
+
+TEST_F(PyWorkerPoolTest, detach_check_workers_stopped)
+{
+	auto pool = std::make_shared<PyWorkerPool>(PYTHON_EXECUTABLE_PATH, 2);
+
+	try {
+		PyWorkerPlugin normal(pool, _moduleName);
+		normal.process(_frame.get());
+
+		{
+			PyWorkerPlugin inverse(pool, _moduleName);
+			PyWorkerPlugin same(pool, _moduleName);
+
+			EXPECT_EQ(inverse.setAttrs({ { "inverse", "1" } }), OVI_ERROR_NONE);
+			EXPECT_EQ(same.setAttrs({ { "inverse", "1" } }), OVI_ERROR_NONE);
+			inverse.process(_frame.get());
+			same.process(_frame.get());
+			EXPECT_EQ(pool->workers(), 2);
+		}
+
+		/* the workers of a set go away with its last instance */
+		EXPECT_EQ(pool->workers(), 1);
+	} catch (const Exception& e) {
+		std::cout << "Error: " << e.what() << std::endl;
+		EXPECT_TRUE(false);
+	}
+}
+
+#endif /* OVI_ENABLE_PYTHON && ENABLE_AUDIODETECTPY */
@@ -0,0 +1,260 @@
+/*
+* Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <filesystem>
+#include <unistd.h>
+
+#include "utBase.h"
+#include "ResultCache.h"
+
+class ResultCacheTest : public UtBase {
+protected:
+	void SetUp() override {
+		_dir = "/tmp/ovi_result_cache_ut_" + std::to_string(getpid());
+		std::filesystem::remove_all(_dir);
+	}
+
+	void TearDown() override {
+		std::filesystem::remove_all(_dir);
+	}
+
+	std::string _dir;
+	const Outcome _outcome { true, { OVIRectTag { 1, 2, 3, 4, "face" }, 0.5 } };
+};
+
+TEST_F(ResultCacheTest, find_check_after_save)
+{
+	{
+		ResultCache cache(_dir, "media");
+		cache.add(0, "FaceDetect threshold=1");
+		cache.add(2, "AudioDetect");
+
+		EXPECT_FALSE(cache.find(0, { 1, 1 }));
+		cache.store(0, { 1, 1 }, _outcome);
+		cache.store(2, { 3, 5 }, { false, {} });
+		cache.save();
+	}
+
+	ResultCache cache(_dir, "media");
+	cache.add(0, "FaceDetect threshold=1");
+	cache.add(1, "AudioDetect");
+
+	auto outcome = cache.find(0, { 1, 1 });
+	ASSERT_TRUE(outcome);
+	EXPECT_TRUE(outcome->detect);
+	ASSERT_EQ(outcome->list.size(), 2);
+	EXPECT_EQ(std::get<OVIRectTag>(outcome->list[0]).tag, "face");
+	EXPECT_EQ(std::get<double>(outcome->list[1]), 0.5);
+	EXPECT_FALSE(cache.find(0, { 2, 2 }));
+
+	// the id doesn't matter, only the configuration
+	outcome = cache.find(1, { 3, 5 });
+	ASSERT_TRUE(outcome);
+	EXPECT_FALSE(outcome->detect);
+	EXPECT_FALSE(cache.find(2, { 3, 5 }));
+}
+
+TEST_F(ResultCacheTest, find_check_other_configuration)
+{
+	{
+		ResultCache cache(_dir, "media");
+		cache.add(0, "FaceDetect threshold=1");
+		cache.store(0, { 1, 1 }, _outcome);
+		cache.save();
+	}
+
+	ResultCache otherAttrs(_dir, "media");
+	otherAttrs.add(0, "FaceDetect threshold=2");
+	EXPECT_FALSE(otherAttrs.find(0, { 1, 1 }));
+
+	ResultCache otherMedia(_dir, "other media");
+	otherMedia.add(0, "FaceDetect threshold=1");
+	EXPECT_FALSE(otherMedia.find(0, { 1, 1 }));
+}
+
+TEST_F(ResultCacheTest, find_check_broken_file)
+{
+	{
+		ResultCache cache(_dir, "media");
+		cache.add(0, "FaceDetect");
+		cache.store(0, { 1, 1 }, _outcome);
+		cache.save();
+	}
+
+	for (const auto& entry : std::filesystem::directory_iterator(_dir))
+		std::filesystem::resize_file(entry.path(), std::filesystem::file_size(entry.path()) - 3);
+
+	ResultCache cache(_dir, "media");
+	cache.add(0, "FaceDetect");
+	EXPECT_FALSE(cache.find(0, { 1, 1 }));
+}
+
+TEST_F(ResultCacheTest, find_check_merged_with_new_outcomes)
+{
+	{
+		ResultCache cache(_dir, "media");
+		cache.add(0, "FaceDetect");
+		for (int i = 0; i < 10; i += 2)
+			cache.store(0, { i, i }, { true, {} });
+		cache.save();
+	}
+
+	{
+		// the odd frames are new, the even ones are skipped or found
+		ResultCache cache(_dir, "media");
+		cache.add(0, "FaceDetect");
+		for (int i = 3; i < 10; i++) {
+			if (i % 2 == 0) {
+				EXPECT_TRUE(cache.find(0, { i, i }));
+				continue;
+			}
+
+			EXPECT_FALSE(cache.find(0, { i, i }));
+			cache.store(0, { i, i }, { false, {} });
+		}
+		cache.save();
+	}
+
+	ResultCache cache(_dir, "media");
+	cache.add(0, "FaceDetect");
+	for (int i = 0; i < 10; i++) {
+		auto outcome = cache.find(0, { i, i });
+		if (i == 1) {
+			EXPECT_FALSE(outcome);
+			continue;
+		}
+
+		ASSERT_TRUE(outcome) << i;
+		EXPECT_EQ(outcome->detect, i % 2 == 0);
+	}
+}
+
+TEST_F(ResultCacheTest, store_check_out_of_order)
+{
+	{
+		ResultCache cache(_dir, "media");
+		cache.add(0, "FaceDetect");
+		cache.store(0, { 5, 5 }, _outcome);
+		cache.store(0, { 2, 2 }, _outcome);
+		cache.save();
+	}
+
+	ResultCache cache(_dir, "media");
+	cache.add(0, "FaceDetect");
+	EXPECT_FALSE(cache.find(0, { 2, 2 }));
+	EXPECT_TRUE(cache.find(0, { 5, 5 }));
+}
+
+TEST_F(ResultCacheTest, save_check_without_new_outcomes)
+{
+	{
+		ResultCache cache(_dir, "media");
+		cache.add(0, "FaceDetect");
+		cache.store(0, { 1, 1 }, _outcome);
+		cache.save();
+	}
+
+	{
+		ResultCache cache(_dir, "media");
+		cache.add(0, "FaceDetect");
+		EXPECT_TRUE(cache.find(0, { 1, 1 }));
+		cache.save();
+
+		// looked up from the first frames again
+		EXPECT_TRUE(cache.find(0, { 1, 1 }));
+	}
+
+	ResultCache cache(_dir, "media");
+	cache.add(0, "FaceDetect");
+	EXPECT_TRUE(cache.find(0, { 1, 1 }));
+}
+
+TEST_F(ResultCacheTest, find_check_corrupted_record)
+{
+	{
+		ResultCache cache(_dir, "media");
+		cache.add(0, "FaceDetect");
+		for (int i = 0; i < 3; i++)
+			cache.store(0, { i, i }, _outcome);
+		cache.save();
+	}
+
+	// a byte of the last record
+	for (const auto& entry : std::filesystem::directory_iterator(_dir)) {
+		std::fstream file(entry.path(), std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(-9, std::ios::end);
+		file.put('x');
+	}
+
+	ResultCache cache(_dir, "media");
+	cache.add(0, "FaceDetect");
+	EXPECT_TRUE(cache.find(0, { 0, 0 }));
+	EXPECT_TRUE(cache.find(0, { 1, 1 }));
+	EXPECT_FALSE(cache.find(0, { 2, 2 }));
+}
+
+TEST_F(ResultCacheTest, save_check_concurrent_writers)
+{
+	// two sessions of one process write the results of the same media
+	ResultCache first(_dir, "media");
+	ResultCache second(_dir, "media");
+	first.add(0, "FaceDetect");
+	second.add(0, "FaceDetect");
+
+	for (int i = 0; i < 100; i++) {
+		first.store(0, { i, i }, _outcome);
+		second.store(0, { i, i }, { false, {} });
+	}
+	first.save();
+	second.save();
+
+	ResultCache cache(_dir, "media");
+	cache.add(0, "FaceDetect");
+	for (int i = 0; i < 100; i++) {
+		auto outcome = cache.find(0, { i, i });
+		ASSERT_TRUE(outcome) << i;
+		EXPECT_FALSE(outcome->detect);
+	}
+
+	size_t files = 0;
+	for ([[maybe_unused]] const auto& entry : std::filesystem::directory_iterator(_dir))
+		files++;
+	EXPECT_EQ(files, 1);
+}
+
+TEST_F(ResultCacheTest, remove_check_outcomes_dropped)
+{
+	{
+		ResultCache cache(_dir, "media");
+		cache.add(0, "FaceDetect");
+		cache.store(0, { 1, 1 }, _outcome);
+		cache.save();
+	}
+
+	{
+		ResultCache cache(_dir, "media");
+		cache.add(0, "FaceDetect");
+		cache.store(0, { 2, 2 }, _outcome);
+		cache.remove(0);
+
+		EXPECT_FALSE(cache.contains(0));
+		EXPECT_FALSE(cache.find(0, { 3, 3 }));
+		cache.save();
+	}
+
+	EXPECT_TRUE(std::filesystem::is_empty(_dir));
+}
@@ -0,0 +1,101 @@
+/*
+* Copyright (c) 2023 Samsung Electronics Co., Ltd All Rights Reserved
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "utBase.h"
+#include "RunStore.h"
+
+class RunStoreTest : public UtBase {
+protected:
+	static FrameRun makeRun(size_t i) {
+		return { static_cast<double>(i * 2), i % 3 + 1, i % 2 == 0, static_cast<int>(i) };
+	}
+
+	static void expectRun(const FrameRun& run, size_t i) {
+		EXPECT_EQ(run.firstFrame, i * 2);
+		EXPECT_EQ(run.frames, i % 3 + 1);
+		EXPECT_EQ(run.include, i % 2 == 0);
+		EXPECT_EQ(run.detection, static_cast<int>(i));
+	}
+};
+
+TEST_F(RunStoreTest, memory_test)
+{
+	RunStore runs;
+
+	for (size_t i = 0; i < RunStore::PAGE_RUNS * 2; i++)
+		runs.push_back(makeRun(i));
+
+	EXPECT_FALSE(runs.spilled());
+	EXPECT_EQ(runs.size(), RunStore::PAGE_RUNS * 2);
+	expectRun(runs[RunStore::PAGE_RUNS], RunStore::PAGE_RUNS);
+}
+
+TEST_F(RunStoreTest, spill_test)
+{
+	constexpr size_t count = RunStore::PAGE_RUNS * 3 + 10;
+	RunStore runs("/tmp");
+
+	for (size_t i = 0; i < count; i++)
+		runs.push_back(makeRun(i));
+
+	EXPECT_TRUE(runs.spilled());
+	EXPECT_EQ(runs.size(), count);
+	EXPECT_LE(runs.residentBytes(), RunStore::PAGE_RUNS * sizeof(FrameRun));
+
+	size_t i = 0;
+	for (const auto& run : runs)
+		expectRun(run, i++);
+	EXPECT_EQ(i, count);
+
+	runs.back().frames = 100;
+	EXPECT_EQ(runs[count - 1].frames, 100);
+	EXPECT_THROW(runs[count], ovi::Exception);
+}
+
+TEST_F(RunStoreTest, resize_test)
+{
+	RunStore runs("/tmp");
+
+	for (size_t i = 0; i < RunStore::PAGE_RUNS * 3; i++)
+		runs.push_back(makeRun(i));
+
+	// the last page kept comes back to memory so that back() can change it
+	runs.resize(RunStore::PAGE_RUNS);
+	EXPECT_EQ(runs.size(), RunStore::PAGE_RUNS);
+	expectRun(runs.back(), RunStore::PAGE_RUNS - 1);
+
+	runs.back().frames = 100;
+	runs.push_back(makeRun(7));
+	EXPECT_EQ(runs[RunStore::PAGE_RUNS - 1].frames, 100);
+	expectRun(runs[RunStore::PAGE_RUNS], 7);
+	expectRun(runs[10], 10);
+
+	runs.resize(0);
+	EXPECT_TRUE(runs.empty());
+	EXPECT_THROW(runs.resize(1), ovi::Exception);
+}
+
+TEST_F(RunStoreTest, shared_copy_test)
+{
+	RunStore runs("/tmp");
+	RunStore copy = runs;
+
+	for (size_t i = 0; i < RunStore::PAGE_RUNS + 1; i++)
+		runs.push_back(makeRun(i));
+
+	EXPECT_EQ(copy.size(), RunStore::PAGE_RUNS + 1);
+	expectRun(copy[5], 5);
+}
@@ -14,7 +14,9 @@
 * limitations under the License.
 */
 
+#include <atomic>
 #include <chrono>
+#include <filesystem>
 #include <thread>
 
 #include "utBase.h"
@@ -122,6 +124,19 @@ static void __render_complete_cb(void* handle, ovi_state_e previous, ovi_state_e
 		*invoked = true;
 }
 
+static void __render_cb(void* handle, const char* output_path, ovi_error_e error, void* user_data)
+{
+	std::cout << "__render_cb() is invoked: output:" << output_path << " error:" << error << std::endl;
+
+	if (!user_data)
+		return;
+
+	auto rendered = static_cast<std::atomic<int>*>(user_data);
+
+	if (error == OVI_ERROR_NONE)
+		(*rendered)++;
+}
+
 std::string SessionTest::getDetectPlugin()
 {
 	if (!_detectPlugin.empty())
@@ -341,6 +356,66 @@ TEST_F(SessionTest, setRender_check_invalid_parameter_exception)
 	}
 }
 
+TEST_F(SessionTest, addRender_check)
+{
+	try {
+		_session.addRender(_session.appendPlugin(getRenderPlugin()), "./result.otio", {});
+		_session.addRender(_session.appendPlugin(getRenderPlugin()), "./result_2.otio", {});
+	} catch (const Exception& e) {
+		std::cout << "Error: " << e.what() << std::endl;
+		EXPECT_TRUE(false);
+	}
+}
+
+TEST_F(SessionTest, addRender_check_invalid_parameter_exception)
+{
+	const std::string render = _session.appendPlugin(getRenderPlugin());
+	_session.addRender(render, "./result.otio", {});
+
+	const std::vector<std::tuple<std::string, std::string, std::vector<std::string>>> params {
+		// the same render
+		{ render, "./result_2.otio", {} },
+		// the same path
+		{ _session.appendPlugin(getRenderPlugin()), "./result.otio", {} },
+		// invalid effects
+		{ _session.appendPlugin(getRenderPlugin()), "./result_2.otio", { "testUid" } },
+		{ _session.appendPlugin(getRenderPlugin()), "./result_2.otio", { _session.appendPlugin(getDetectPlugin()) } },
+	};
+
+	for (const auto& [uid, path, effects] : params) {
+		try {
+			_session.addRender(uid, path, effects);
+			EXPECT_TRUE(false);
+		} catch (const Exception& e) {
+			std::cout << "[EXPECTED] Error: " << e.what() << std::endl;
+			EXPECT_EQ(e.error(), OVI_ERROR_INVALID_PARAMETER);
+		}
+	}
+}
+
+TEST_F(SessionTest, addRender_check_rendered)
+{
+	prepare();
+
+	std::atomic<int> rendered {};
+
+	try {
+		_session.addRender(_session.appendPlugin(getRenderPlugin()), "./result_2.otio", {});
+		_session.setRenderCb(__render_cb, &rendered);
+		_session.setStateChangedCb(__render_complete_cb, &_invoked);
+		_session.start();
+
+		while (!_invoked)
+			std::this_thread::sleep_for(2s);
+
+		EXPECT_EQ(rendered, 2);
+		_session.destroy();
+	} catch (const Exception& e) {
+		std::cout << "Error: " << e.what() << std::endl;
+		EXPECT_TRUE(false);
+	}
+}
+
 TEST_F(SessionTest, appendPlugin_check)
 {
 	EXPECT_NE(_session.appendPlugin(getDetectPlugin()), "");
@@ -570,3 +645,99 @@ TEST_F(SessionTest, unsetStateChangedCb_check_invalid_operation_exception)
 		EXPECT_EQ(e.error(), OVI_ERROR_INVALID_OPERATION);
 	}
 }
+
+TEST_F(SessionTest, setRenderCb_check_invalid_parameter_exception)
+{
+	try {
+		_session.setRenderCb(nullptr, nullptr);
+		EXPECT_TRUE(false);
+	} catch (const Exception& e) {
+		std::cout << "[EXPECTED] Error: " << e.what() << std::endl;
+		EXPECT_EQ(e.error(), OVI_ERROR_INVALID_PARAMETER);
+	}
+}
+
+TEST_F(SessionTest, unsetRenderCb_check_invalid_operation_exception)
+{
+	try {
+		_session.unsetRenderCb();
+		EXPECT_TRUE(false);
+	} catch (const Exception& e) {
+		std::cout << "[EXPECTED] Error: " << e.what() << std::endl;
+		EXPECT_EQ(e.error(), OVI_ERROR_INVALID_OPERATION);
+	}
+}
+
+TEST_F(SessionTest, setStreamingRender_check)
+{
+	prepare();
+
+	try {
+		_session.setStreamingRender(true);
+		_session.setStateChangedCb(__render_complete_cb, &_invoked);
+		_session.start();
+
+		while (!_invoked)
+			std::this_thread::sleep_for(2s);
+
+		_session.destroy();
+	} catch (const Exception& e) {
+		std::cout << "Error: " << e.what() << std::endl;
+		EXPECT_TRUE(false);
+	}
+}
+
+TEST_F(SessionTest, setStreamingRender_check_stop_while_analyzing)
+{
+	prepare();
+
+	try {
+		_session.setStreamingRender(true);
+		_session.start();
+		_session.stop();
+		EXPECT_EQ(_session.state(), OVI_STATE_IDLE);
+	} catch (const Exception& e) {
+		std::cout << "Error: " << e.what() << std::endl;
+		EXPECT_TRUE(false);
+	}
+}
+
+TEST_F(SessionTest, setTimeline_check_rendered)
+{
+	prepare();
+
+	try {
+		_session.setStateChangedCb(__render_complete_cb, &_invoked);
+		_session.start();
+
+		while (!_invoked)
+			std::this_thread::sleep_for(2s);
+
+		_invoked = false;
+		std::filesystem::remove("./result_timeline.otio");
+
+		_session.setTimeline("./result.otio");
+		_session.setRender(_session.appendPlugin(getRenderPlugin()), "./result_timeline.otio");
+		_session.start();
+
+		while (!_invoked)
+			std::this_thread::sleep_for(2s);
+
+		EXPECT_TRUE(std::filesystem::exists("./result_timeline.otio"));
+		_session.destroy();
+	} catch (const Exception& e) {
+		std::cout << "Error: " << e.what() << std::endl;
+		EXPECT_TRUE(false);
+	}
+}
+
+TEST_F(SessionTest, setTimeline_check_no_such_file_exception)
+{
+	try {
+		_session.setTimeline("nosuchfile.otio");
+		EXPECT_TRUE(false);
+	} catch (const Exception& e) {
+		std::cout << "[EXPECTED] Error: " << e.what() << std::endl;
+		EXPECT_EQ(e.error(), OVI_ERROR_NO_SUCH_FILE);
+	}
+}